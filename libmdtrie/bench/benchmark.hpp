@@ -70,6 +70,191 @@ public:
     infile.close();
   }
 
+  void bulk_load(std::string data_addr,
+                 std::string outfile_name,
+                 point_t total_points_count,
+                 std::vector<int32_t> (*parse_line)(std::string line))
+  {
+
+    std::ifstream infile(data_addr);
+    point_t has_skipped = 0;
+    std::vector<data_point<DIMENSION>> points;
+    points.reserve(total_points_count);
+
+    std::string line;
+    while (points.size() < total_points_count && std::getline(infile, line))
+    {
+      if (has_skipped < skip_size_count)
+      {
+        has_skipped++;
+        continue;
+      }
+
+      std::vector<int32_t> vect = parse_line(line);
+      data_point<DIMENSION> leaf_point;
+      for (dimension_t i = 0; i < DIMENSION; i++)
+      {
+        leaf_point.set_coordinate(i, vect[i]);
+      }
+      leaf_point.set_primary(points.size());
+      points.push_back(leaf_point);
+    }
+    infile.close();
+
+    TimeStamp start = GetTimestamp();
+    mdtrie_->bulk_load(points.begin(), points.end(), p_key_to_treeblock_compact);
+    TimeStamp diff = GetTimestamp() - start;
+
+    std::cout << "Bulk Load Time (ms): " << diff / 1000
+              << ", Latency per point: " << (float)diff / points.size()
+              << std::endl;
+    flush_string_to_file(
+        std::to_string(diff) + "," + std::to_string(points.size()),
+        results_folder_addr + outfile_name);
+  }
+
+  // Inserts the first total_points_count points batch_size at a time with
+  // insert_batch.
+  void insert_batch(std::string data_addr,
+                    std::string outfile_name,
+                    point_t total_points_count,
+                    point_t batch_size,
+                    std::vector<int32_t> (*parse_line)(std::string line))
+  {
+
+    std::ifstream infile(data_addr);
+    point_t has_skipped = 0;
+    std::vector<data_point<DIMENSION>> points;
+    points.reserve(total_points_count);
+
+    std::string line;
+    while (points.size() < total_points_count && std::getline(infile, line))
+    {
+      if (has_skipped < skip_size_count)
+      {
+        has_skipped++;
+        continue;
+      }
+
+      std::vector<int32_t> vect = parse_line(line);
+      data_point<DIMENSION> leaf_point;
+      for (dimension_t i = 0; i < DIMENSION; i++)
+      {
+        leaf_point.set_coordinate(i, vect[i]);
+      }
+      points.push_back(leaf_point);
+    }
+    infile.close();
+
+    TimeStamp diff = 0;
+    for (point_t i = 0; i < points.size(); i += batch_size)
+    {
+      std::vector<data_point<DIMENSION> *> batch;
+      std::vector<n_leaves_t> keys;
+      for (point_t j = i; j < points.size() && j < i + batch_size; j++)
+      {
+        batch.push_back(&points[j]);
+        keys.push_back(j);
+      }
+      TimeStamp start = GetTimestamp();
+      mdtrie_->insert_batch(batch, keys, p_key_to_treeblock_compact);
+      diff += GetTimestamp() - start;
+    }
+
+    std::cout << "Batch Insertion Time (ms): " << diff / 1000
+              << ", Latency per point: " << (float)diff / points.size()
+              << std::endl;
+    flush_string_to_file(
+        std::to_string(diff) + "," + std::to_string(points.size()),
+        results_folder_addr + outfile_name);
+  }
+
+  // Times leaf_to_symbol over every level of the first total_points_count
+  // points against extracting the symbols bit by bit from dim_off_table, and
+  // symbol_to_leaf over the resulting symbols.
+  void symbol_extraction(std::string data_addr,
+                         std::string outfile_name,
+                         point_t total_points_count,
+                         std::vector<int32_t> (*parse_line)(std::string line))
+  {
+
+    std::ifstream infile(data_addr);
+    point_t has_skipped = 0;
+    std::vector<data_point<DIMENSION>> points;
+    points.reserve(total_points_count);
+
+    std::string line;
+    while (points.size() < total_points_count && std::getline(infile, line))
+    {
+      if (has_skipped < skip_size_count)
+      {
+        has_skipped++;
+        continue;
+      }
+
+      std::vector<int32_t> vect = parse_line(line);
+      data_point<DIMENSION> leaf_point;
+      for (dimension_t i = 0; i < DIMENSION; i++)
+      {
+        leaf_point.set_coordinate(i, vect[i]);
+      }
+      points.push_back(leaf_point);
+    }
+    infile.close();
+
+    const trie_schema &schema = mdtrie_->schema();
+    std::vector<morton_t> symbols(points.size() * schema.max_depth_);
+
+    TimeStamp start = GetTimestamp();
+    for (point_t i = 0; i < points.size(); i++)
+    {
+      for (level_t level = 0; level < schema.max_depth_; level++)
+      {
+        morton_t result = 0;
+        for (auto [dim, off] : schema.dim_off_table[level])
+          result = (result << 1U) + GETBIT(points[i].get_coordinate(dim), off);
+        symbols[i * schema.max_depth_ + level] = result;
+      }
+    }
+    TimeStamp bitwise = GetTimestamp() - start;
+
+    point_t mismatches = 0;
+    start = GetTimestamp();
+    for (point_t i = 0; i < points.size(); i++)
+    {
+      for (level_t level = 0; level < schema.max_depth_; level++)
+      {
+        mismatches += points[i].leaf_to_symbol(level, &schema) !=
+                      symbols[i * schema.max_depth_ + level];
+      }
+    }
+    TimeStamp gathered = GetTimestamp() - start;
+
+    start = GetTimestamp();
+    for (point_t i = 0; i < points.size(); i++)
+    {
+      data_point<DIMENSION> point;
+      for (level_t level = 0; level < schema.max_depth_; level++)
+        point.symbol_to_leaf(
+            symbols[i * schema.max_depth_ + level], level, &schema);
+      for (dimension_t j = 0; j < DIMENSION; j++)
+        mismatches += point.get_coordinate(j) != points[i].get_coordinate(j);
+    }
+    TimeStamp scattered = GetTimestamp() - start;
+
+    point_t n_points = points.empty() ? 1 : points.size();
+    std::cout << "Symbol extraction per point (ns): bit by bit "
+              << (float)bitwise / n_points * 1000 << ", gather plan "
+              << (float)gathered / n_points * 1000 << ", inverse "
+              << (float)scattered / n_points * 1000
+              << ", mismatches: " << mismatches << std::endl;
+    flush_string_to_file(std::to_string(bitwise) + "," +
+                             std::to_string(gathered) + "," +
+                             std::to_string(scattered) + "," +
+                             std::to_string(points.size()),
+                         results_folder_addr + outfile_name);
+  }
+
   void lookup(std::string outfile_name)
   {
 
@@ -91,6 +276,55 @@ public:
               << (float)cumulative / points_to_lookup << std::endl;
   }
 
+  // Looks up the same keys as lookup, batch_size keys per
+  // md_trie::lookup_batch call; reports the latency per key.
+  void lookup_batch(std::string outfile_name, point_t batch_size)
+  {
+
+    TimeStamp cumulative = 0, start = 0;
+    std::vector<TimeStamp> latency_vect;
+    std::vector<n_leaves_t> keys;
+    std::vector<data_point<DIMENSION>> points;
+
+    for (point_t i = 0; i < points_to_lookup; i += batch_size)
+    {
+      keys.clear();
+      for (point_t j = i; j < std::min(i + batch_size, points_to_lookup); j++)
+        keys.push_back(j);
+      start = GetTimestamp();
+      mdtrie_->lookup_batch(keys, points, p_key_to_treeblock_compact);
+      TimeStamp temp_diff = GetTimestamp() - start;
+      cumulative += temp_diff;
+      latency_vect.push_back(temp_diff / keys.size() + SERVER_TO_SERVER_IN_NS);
+    }
+    flush_vector_to_file(latency_vect, results_folder_addr + outfile_name);
+    std::cout << "Done! "
+              << "Batched Lookup Latency per point: "
+              << (float)cumulative / points_to_lookup << std::endl;
+  }
+
+  // Deletes the points with primary keys [0, n_points).
+  void delete_points(std::string outfile_name, point_t n_points)
+  {
+
+    TimeStamp cumulative = 0, start = 0;
+
+    for (point_t i = 0; i < n_points; i++)
+    {
+      start = GetTimestamp();
+      mdtrie_->delete_trie(i, p_key_to_treeblock_compact);
+      TimeStamp temp_diff = GetTimestamp() - start;
+      cumulative += temp_diff;
+      deletion_latency_vect_.push_back(temp_diff + SERVER_TO_SERVER_IN_NS);
+    }
+    flush_vector_to_file(deletion_latency_vect_,
+                         results_folder_addr +
+                             outfile_name);
+    std::cout << "Done! "
+              << "Deletion Latency per point: "
+              << (float)cumulative / n_points << std::endl;
+  }
+
   void range_search(std::string query_addr,
                     std::string outfile_name,
                     void (*get_query)(std::string,
@@ -106,7 +340,8 @@ public:
     for (int i = 0; i < QUERY_NUM; i++)
     {
 
-      std::vector<int32_t> found_points;
+      // Matches are only counted, so they are streamed rather than collected.
+      n_leaves_t found_count = 0;
       // data_point<DIMENSION> start_range(mdtrie_->get_width());
       // data_point<DIMENSION> end_range(mdtrie_->get_width());
       data_point<DIMENSION> start_range;
@@ -118,13 +353,104 @@ public:
 
       start = GetTimestamp();
       mdtrie_->range_search_trie(
-          &start_range, &end_range, mdtrie_->root(), 0, found_points);
+          &start_range,
+          &end_range,
+          mdtrie_->root(),
+          0,
+          [&found_count](const data_point<DIMENSION> &, n_leaves_t) {
+            found_count++;
+            return true;
+          });
       diff = GetTimestamp() - start;
       outfile << "Query " << i << " end to end latency (ms): " << diff / 1000
+              << ", found points count: " << found_count << std::endl;
+    }
+  }
+
+  // Runs the queries as aggregates: COUNT, plus SUM / MIN / MAX over
+  // dimensions, computed inside the search.
+  void range_aggregate(std::string query_addr,
+                       std::string outfile_name,
+                       void (*get_query)(std::string,
+                                         data_point<DIMENSION> *,
+                                         data_point<DIMENSION> *),
+                       const std::vector<dimension_t> &dimensions)
+  {
+
+    std::ifstream file(query_addr);
+    std::ofstream outfile(results_folder_addr +
+                          outfile_name);
+    TimeStamp diff = 0, start = 0, cumulative = 0;
+
+    for (int i = 0; i < QUERY_NUM; i++)
+    {
+
+      data_point<DIMENSION> start_range;
+      data_point<DIMENSION> end_range;
+      ::range_aggregate aggregate(dimensions);
+
+      std::string line;
+      std::getline(file, line);
+      get_query(line, &start_range, &end_range);
+
+      start = GetTimestamp();
+      mdtrie_->range_aggregate_trie(
+          &start_range, &end_range, mdtrie_->root(), 0, aggregate);
+      diff = GetTimestamp() - start;
+      cumulative += diff;
+      outfile << "Query " << i << " end to end latency (ms): " << diff / 1000
+              << ", found points count: " << aggregate.count_ << std::endl;
+    }
+    std::cout << "Aggregate latency (ms): "
+              << (float)cumulative / QUERY_NUM / 1000 << std::endl;
+  }
+
+  void range_search_parallel(std::string query_addr,
+                             std::string outfile_name,
+                             void (*get_query)(std::string,
+                                               data_point<DIMENSION> *,
+                                               data_point<DIMENSION> *),
+                             work_stealing_pool *pool)
+  {
+
+    std::ifstream file(query_addr);
+    std::ofstream outfile(results_folder_addr +
+                          outfile_name);
+    TimeStamp diff = 0, start = 0, first_result = 0;
+    TimeStamp cumulative = 0, cumulative_first_result = 0;
+
+    for (int i = 0; i < QUERY_NUM; i++)
+    {
+
+      std::vector<int32_t> found_points;
+      data_point<DIMENSION> start_range;
+      data_point<DIMENSION> end_range;
+
+      std::string line;
+      std::getline(file, line);
+      get_query(line, &start_range, &end_range);
+
+      start = GetTimestamp();
+      first_result = 0;
+      mdtrie_->range_search_trie_parallel(
+          &start_range, &end_range, pool, found_points, &first_result);
+      diff = GetTimestamp() - start;
+      if (first_result == 0)
+        first_result = start + diff;
+      cumulative += diff;
+      cumulative_first_result += first_result - start;
+      outfile << "Query " << i << " end to end latency (ms): " << diff / 1000
+              << ", first result latency (ms): " << (first_result - start) / 1000
               << ", found points count: " << found_points.size() / DIMENSION
               << std::endl;
       found_points.clear();
     }
+    std::cout << "Threads: " << pool->num_threads()
+              << ", range search latency (ms): "
+              << (float)cumulative / QUERY_NUM / 1000
+              << ", first result latency (ms): "
+              << (float)cumulative_first_result / QUERY_NUM / 1000
+              << std::endl;
   }
 
   void range_search_random(std::string outfile_name,
@@ -142,7 +468,7 @@ public:
     while (i < QUERY_NUM * 10)
     {
 
-      std::vector<int32_t> found_points;
+      n_leaves_t found_count = 0;
       // data_point<DIMENSION> start_range(mdtrie_->get_width());
       // data_point<DIMENSION> end_range(mdtrie_->get_width());
       data_point<DIMENSION> start_range;
@@ -150,28 +476,81 @@ public:
 
       get_query(&start_range, &end_range);
 
+      // A query past upper_bound is thrown away, so it is cut short there.
       start = GetTimestamp();
       mdtrie_->range_search_trie(
-          &start_range, &end_range, mdtrie_->root(), 0, found_points);
+          &start_range,
+          &end_range,
+          mdtrie_->root(),
+          0,
+          [&found_count, upper_bound](const data_point<DIMENSION> &,
+                                      n_leaves_t) {
+            return ++found_count <= upper_bound;
+          });
       diff = GetTimestamp() - start;
 
-      if (found_points.size() / DIMENSION > upper_bound ||
-          found_points.size() / DIMENSION < lower_bound)
+      if (found_count > upper_bound || found_count < lower_bound)
         continue;
 
       outfile << "Query " << i << " end to end latency (ms): " << diff / 1000
-              << ", found points count: " << found_points.size() / DIMENSION
-              << std::endl;
-      found_points.clear();
+              << ", found points count: " << found_count << std::endl;
       i += 1;
     }
   }
 
+  // Saves the trie to snapshot_path and reopens it with open_mmap; the
+  // benchmarks that follow run on the mapped trie.
+  void save_and_reopen(std::string snapshot_path, std::string outfile_name)
+  {
+
+    TimeStamp start = GetTimestamp();
+    if (!mdtrie_->save(snapshot_path, p_key_to_treeblock_compact))
+    {
+      std::cerr << "Cannot save snapshot to " << snapshot_path << std::endl;
+      exit(-1);
+    }
+    TimeStamp save_time = GetTimestamp() - start;
+
+    start = GetTimestamp();
+    md_trie<DIMENSION> *mapped_trie =
+        md_trie<DIMENSION>::open_mmap(snapshot_path, &p_key_to_treeblock_compact);
+    TimeStamp open_time = GetTimestamp() - start;
+    if (!mapped_trie)
+    {
+      std::cerr << "Cannot open snapshot " << snapshot_path << std::endl;
+      exit(-1);
+    }
+    mdtrie_ = mapped_trie;
+
+    struct stat st;
+    stat(snapshot_path.c_str(), &st);
+    std::cout << "Snapshot Save Time (ms): " << save_time / 1000
+              << ", Open Time (us): " << open_time
+              << ", Size: " << st.st_size << std::endl;
+    flush_string_to_file(std::to_string(save_time) + "," +
+                             std::to_string(open_time) + "," +
+                             std::to_string(st.st_size),
+                         results_folder_addr + outfile_name);
+  }
+
   void get_storage(std::string outfile_name)
   {
 
     uint64_t size = mdtrie_->size(p_key_to_treeblock_compact);
     std::cout << "mdtrie storage: " << size << std::endl;
+    node_arena_stats arena = mdtrie_->arena_stats();
+    std::cout << "node arena: slabs " << arena.slab_bytes_ << ", live "
+              << arena.live_bytes_ << " in " << arena.live_objects_
+              << " objects, free lists " << arena.free_list_bytes_
+              << ", large " << arena.large_bytes_ << ", fragmentation "
+              << arena.fragmentation() << ", rounding "
+              << arena.rounding_overhead() << std::endl;
+    memory_usage usage = mdtrie_->memory(p_key_to_treeblock_compact);
+    std::cout << "memory usage:";
+    for (int32_t c = 0; c < num_memory_components; c++)
+      std::cout << " " << memory_component_names[c] << " "
+                << usage.get((memory_component)c);
+    std::cout << ", total " << usage.total() << std::endl;
     flush_string_to_file(
         std::to_string(size) + "," + std::to_string(total_points_count),
         results_folder_addr + outfile_name);
@@ -180,6 +559,7 @@ public:
 protected:
   std::vector<TimeStamp> insertion_latency_vect_;
   std::vector<TimeStamp> lookup_latency_vect_;
+  std::vector<TimeStamp> deletion_latency_vect_;
   md_trie<DIMENSION> *mdtrie_;
 };
 
@@ -99,6 +99,30 @@ std::vector<int32_t> nyc_max_values = {20160630, 20221220, 899, 898,
 std::vector<int32_t> nyc_min_values = {20090101, 19700101, 0, 0, 0, 0, 0, 0,
                                        0, 0, 0, 0, 0, 0, 0};
 
+/* Layout of the trie a benchmark builds, filled in by the use_*_setting
+ * helpers and turned into a trie_schema by bench_trie_schema. */
+std::vector<level_t> schema_bit_widths;
+std::vector<level_t> schema_start_bits;
+bool no_dynamic_sizing = false;
+bool is_collapsed_node_exp = false;
+bool use_primary_key_index = false;
+bool use_subtree_directory = false;
+
+trie_schema bench_trie_schema(dimension_t width, preorder_t max_tree_nodes)
+{
+  if (width == (dimension_t)-1)
+    width = schema_bit_widths.size();
+  return trie_schema(schema_bit_widths,
+                     schema_start_bits,
+                     width,
+                     trie_depth,
+                     max_tree_nodes,
+                     no_dynamic_sizing,
+                     is_collapsed_node_exp,
+                     use_primary_key_index,
+                     use_subtree_directory);
+}
+
 int gen_rand(int start, int end)
 {
   return start + (std::rand() % (end - start + 1));
@@ -163,7 +187,8 @@ void use_nyc_setting(int dimensions, int _total_points_count)
 
   // add one to depth if there's a remainder
 
-  create_level_to_num_children(bit_widths, start_bits, max_depth, trie_width);
+  schema_bit_widths = bit_widths;
+  schema_start_bits = start_bits;
 }
 
 void use_github_setting(int dimensions, int _total_points_count)
@@ -221,7 +246,8 @@ void use_github_setting(int dimensions, int _total_points_count)
     max_depth++;
   }
 
-  create_level_to_num_children(bit_widths, start_bits, max_depth, trie_width);
+  schema_bit_widths = bit_widths;
+  schema_start_bits = start_bits;
 }
 
 void use_tpch_setting(int dimensions, int _total_points_count)
@@ -291,7 +317,8 @@ void use_tpch_setting(int dimensions, int _total_points_count)
     max_depth++;
   }
 
-  create_level_to_num_children(bit_widths, start_bits, max_depth, trie_width);
+  schema_bit_widths = bit_widths;
+  schema_start_bits = start_bits;
 }
 
 void flush_vector_to_file(std::vector<TimeStamp> vect, std::string filename)
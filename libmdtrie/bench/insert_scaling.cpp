@@ -0,0 +1,117 @@
+#include "benchmark.hpp"
+#include "common.hpp"
+#include "parser.hpp"
+#include "trie.h"
+#include <climits>
+#include <fstream>
+#include <sys/time.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include <random>
+
+/**
+ * Insert throughput of md_trie::insert_trie_concurrent versus the number of
+ * inserting threads. Every run builds a fresh trie from the same points and
+ * checks it with a lookup of every primary key afterwards.
+ */
+
+int random_int(std::mt19937 &gen, int min, int max)
+{
+    std::uniform_int_distribution<> distrib(min, max);
+    return distrib(gen);
+}
+
+void run_scaling(std::vector<data_point<10>> &points, unsigned int num_threads, const trie_schema &schema)
+{
+    int total_count = points.size();
+    md_trie<10> mdtrie(schema);
+    bitmap::CompactPtrVector primary_key_to_treeblock_mapping(total_count);
+
+    /* ----------- INSERT ----------- */
+    std::vector<std::thread> threads;
+    TimeStamp start = GetTimestamp();
+    for (unsigned int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&, t]() {
+            for (int primary_key = t; primary_key < total_count; primary_key += num_threads)
+                mdtrie.insert_trie_concurrent(&points[primary_key], primary_key, &primary_key_to_treeblock_mapping);
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+    TimeStamp diff = GetTimestamp() - start;
+
+    /* ---------- LOOKUP ------------ */
+    int wrong_points = 0;
+    for (int primary_key = 0; primary_key < total_count; primary_key++)
+    {
+        data_point<10> *pt = mdtrie.lookup_trie(primary_key, &primary_key_to_treeblock_mapping);
+        for (int i = 0; i < 10; i++) {
+            if ((int) pt->get_coordinate(i) != (int) points[primary_key].get_coordinate(i)) {
+                wrong_points++;
+                break;
+            }
+        }
+    }
+
+    std::cout << "Threads: " << num_threads
+              << ", insertion time (ms): " << diff / 1000
+              << ", throughput (points/s): " << (double)total_count * 1000000 / diff
+              << ", wrong points: " << wrong_points << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    int total_count = 1000000;
+    unsigned int max_threads = std::thread::hardware_concurrency();
+    dimension_t width = 6;
+    trie_depth = 6;
+    max_tree_node = 512;
+
+    int arg;
+
+    while ((arg = getopt(argc, argv, "n:p:w:t:d:")) != -1)
+    switch (arg)
+    {
+    case 'n':
+      total_count = atoi(optarg);
+      break;
+    case 'p':
+      max_threads = atoi(optarg);
+      break;
+    case 'w':
+      width = atoi(optarg);
+      break;
+    case 't':
+      max_tree_node = atoi(optarg);
+      break;
+    case 'd':
+      trie_depth = atoi(optarg);
+      break;
+    default:
+      abort();
+    }
+    if (max_threads == 0)
+      max_threads = 1;
+
+    /* ---------- Initialization ------------ */
+    std::vector<level_t> bit_widths = {
+        24, 24, 24, 24, 24, 24, 24, 24, 24, 24};
+    std::vector<level_t> start_bits = {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    trie_schema schema(bit_widths, start_bits, width, trie_depth, max_tree_node, true);
+
+    std::mt19937 gen(0);
+    std::vector<data_point<10>> points(total_count);
+    for (int primary_key = 0; primary_key < total_count; primary_key++) {
+        for (dimension_t i = 0; i < 10; ++i) {
+            points[primary_key].set_coordinate(i, random_int(gen, 1, (int)1 << 16));
+        }
+    }
+
+    for (unsigned int num_threads = 1; num_threads < max_threads; num_threads *= 2)
+        run_scaling(points, num_threads, schema);
+    run_scaling(points, max_threads, schema);
+
+    return 0;
+}
@@ -4,7 +4,9 @@
 #include "trie.h"
 #include <climits>
 #include <fstream>
+#include <random>
 #include <sys/time.h>
+#include <thread>
 #include <unistd.h>
 #include <vector>
 
@@ -20,7 +22,7 @@ void github_bench(void)
     identification_string += "_FLEX_" + std::to_string(trie_width) + "_" + std::to_string(max_tree_node);
   }
 
-  md_trie<GITHUB_DIMENSION> mdtrie(trie_width, max_depth, trie_depth, max_tree_node);
+  md_trie<GITHUB_DIMENSION> mdtrie(bench_trie_schema(trie_width, max_tree_node));
   MdTrieBench<GITHUB_DIMENSION> bench(&mdtrie);
   p_key_to_treeblock_compact = new bitmap::CompactPtrVector(total_points_count);
   std::string folder_name = "microbenchmark/";
@@ -51,7 +53,7 @@ void nyc_bench(void)
     identification_string += "_FLEX_" + std::to_string(trie_width) + "_" + std::to_string(max_tree_node);
   }
 
-  md_trie<NYC_DIMENSION> mdtrie(trie_width, max_depth, trie_depth, max_tree_node);
+  md_trie<NYC_DIMENSION> mdtrie(bench_trie_schema(trie_width, max_tree_node));
   MdTrieBench<NYC_DIMENSION> bench(&mdtrie);
   p_key_to_treeblock_compact = new bitmap::CompactPtrVector(total_points_count);
   std::string folder_name = "microbenchmark/";
@@ -70,6 +72,279 @@ void nyc_bench(void)
                      get_query_nyc<NYC_DIMENSION>);
 }
 
+void nyc_parallel_search_bench(unsigned int max_threads)
+{
+
+  use_nyc_setting(NYC_DIMENSION, micro_nyc_size);
+
+  if (trie_width == (dimension_t) -1) {
+    trie_width = NYC_DIMENSION;
+  }
+
+  md_trie<NYC_DIMENSION> mdtrie(bench_trie_schema(trie_width, max_tree_node));
+  MdTrieBench<NYC_DIMENSION> bench(&mdtrie);
+  p_key_to_treeblock_compact = new bitmap::CompactPtrVector(total_points_count);
+  std::string folder_name = "microbenchmark/";
+  bench.insert(NYC_DATA_ADDR,
+               folder_name + "nyc_insert_parallel_search" + identification_string,
+               total_points_count,
+               parse_line_nyc);
+  for (unsigned int num_threads = 1; ; num_threads *= 2)
+  {
+    if (num_threads > max_threads)
+      num_threads = max_threads;
+    work_stealing_pool pool(num_threads);
+    bench.range_search_parallel(NYC_QUERY_ADDR,
+                                folder_name + "nyc_query_parallel_" +
+                                    std::to_string(num_threads) +
+                                    identification_string,
+                                get_query_nyc<NYC_DIMENSION>,
+                                &pool);
+    if (num_threads == max_threads)
+      break;
+  }
+}
+
+void nyc_bulk_load_bench(void)
+{
+
+  use_nyc_setting(NYC_DIMENSION, micro_nyc_size);
+
+  if (trie_width == (dimension_t) -1) {
+    trie_width = NYC_DIMENSION;
+  }
+
+  md_trie<NYC_DIMENSION> mdtrie(bench_trie_schema(trie_width, max_tree_node));
+  MdTrieBench<NYC_DIMENSION> bench(&mdtrie);
+  p_key_to_treeblock_compact = new bitmap::CompactPtrVector(total_points_count);
+  std::string folder_name = "microbenchmark/";
+  bench.bulk_load(NYC_DATA_ADDR,
+                  folder_name + "nyc_bulk_load" + identification_string,
+                  total_points_count,
+                  parse_line_nyc);
+  bench.get_storage(folder_name + "nyc_bulk_load_storage" + identification_string);
+  bench.lookup(folder_name + "nyc_bulk_load_lookup" + identification_string);
+  bench.range_search(NYC_QUERY_ADDR,
+                     folder_name + "nyc_bulk_load_query" + identification_string,
+                     get_query_nyc<NYC_DIMENSION>);
+}
+
+void nyc_insert_batch_bench(void)
+{
+
+  use_nyc_setting(NYC_DIMENSION, micro_nyc_size);
+
+  if (trie_width == (dimension_t) -1) {
+    trie_width = NYC_DIMENSION;
+  }
+
+  std::string folder_name = "microbenchmark/";
+  for (point_t batch_size : {100, 1000, 10000})
+  {
+    md_trie<NYC_DIMENSION> mdtrie(bench_trie_schema(trie_width, max_tree_node));
+    MdTrieBench<NYC_DIMENSION> bench(&mdtrie);
+    p_key_to_treeblock_compact =
+        new bitmap::CompactPtrVector(total_points_count);
+    bench.insert_batch(NYC_DATA_ADDR,
+                       folder_name + "nyc_insert_batch_" +
+                           std::to_string(batch_size) + identification_string,
+                       total_points_count,
+                       batch_size,
+                       parse_line_nyc);
+  }
+}
+
+void nyc_symbol_bench(void)
+{
+
+  use_nyc_setting(NYC_DIMENSION, micro_nyc_size);
+
+  if (trie_width == (dimension_t) -1) {
+    trie_width = NYC_DIMENSION;
+  }
+
+  md_trie<NYC_DIMENSION> mdtrie(bench_trie_schema(trie_width, max_tree_node));
+  MdTrieBench<NYC_DIMENSION> bench(&mdtrie);
+  std::string folder_name = "microbenchmark/";
+  bench.symbol_extraction(NYC_DATA_ADDR,
+                          folder_name + "nyc_symbol" + identification_string,
+                          points_to_lookup * 1000,
+                          parse_line_nyc);
+}
+
+void nyc_delete_bench(void)
+{
+
+  use_nyc_setting(NYC_DIMENSION, micro_nyc_size);
+
+  if (trie_width == (dimension_t) -1) {
+    trie_width = NYC_DIMENSION;
+  }
+
+  md_trie<NYC_DIMENSION> mdtrie(bench_trie_schema(trie_width, max_tree_node));
+  MdTrieBench<NYC_DIMENSION> bench(&mdtrie);
+  p_key_to_treeblock_compact = new bitmap::CompactPtrVector(total_points_count);
+  std::string folder_name = "microbenchmark/";
+  bench.insert(NYC_DATA_ADDR,
+               folder_name + "nyc_delete_insert" + identification_string,
+               total_points_count,
+               parse_line_nyc);
+  bench.get_storage(folder_name + "nyc_delete_storage_before" + identification_string);
+  bench.delete_points(folder_name + "nyc_delete" + identification_string,
+                      total_points_count / 2);
+  bench.get_storage(folder_name + "nyc_delete_storage_after" + identification_string);
+  bench.range_search(NYC_QUERY_ADDR,
+                     folder_name + "nyc_delete_query" + identification_string,
+                     get_query_nyc<NYC_DIMENSION>);
+}
+
+void nyc_snapshot_bench(void)
+{
+
+  use_nyc_setting(NYC_DIMENSION, micro_nyc_size);
+
+  if (trie_width == (dimension_t) -1) {
+    trie_width = NYC_DIMENSION;
+  }
+
+  md_trie<NYC_DIMENSION> mdtrie(bench_trie_schema(trie_width, max_tree_node));
+  MdTrieBench<NYC_DIMENSION> bench(&mdtrie);
+  p_key_to_treeblock_compact = new bitmap::CompactPtrVector(total_points_count);
+  std::string folder_name = "microbenchmark/";
+  bench.insert(NYC_DATA_ADDR,
+               folder_name + "nyc_snapshot_insert" + identification_string,
+               total_points_count,
+               parse_line_nyc);
+  bench.save_and_reopen(results_folder_addr + folder_name + "nyc_snapshot.img",
+                        folder_name + "nyc_snapshot" + identification_string);
+  bench.lookup(folder_name + "nyc_snapshot_lookup" + identification_string);
+  bench.range_search(NYC_QUERY_ADDR,
+                     folder_name + "nyc_snapshot_query" + identification_string,
+                     get_query_nyc<NYC_DIMENSION>);
+}
+
+void nyc_aggregate_bench(void)
+{
+
+  use_nyc_setting(NYC_DIMENSION, micro_nyc_size);
+
+  if (trie_width == (dimension_t) -1) {
+    trie_width = NYC_DIMENSION;
+  }
+
+  md_trie<NYC_DIMENSION> mdtrie(bench_trie_schema(trie_width, max_tree_node));
+  MdTrieBench<NYC_DIMENSION> bench(&mdtrie);
+  p_key_to_treeblock_compact = new bitmap::CompactPtrVector(total_points_count);
+  std::string folder_name = "microbenchmark/";
+  bench.insert(NYC_DATA_ADDR,
+               folder_name + "nyc_aggregate_insert" + identification_string,
+               total_points_count,
+               parse_line_nyc);
+  bench.range_search(NYC_QUERY_ADDR,
+                     folder_name + "nyc_aggregate_query" + identification_string,
+                     get_query_nyc<NYC_DIMENSION>);
+  std::vector<dimension_t> dimensions;
+  for (dimension_t i = 0; i < NYC_DIMENSION; i++)
+    dimensions.push_back(i);
+  bench.range_aggregate(NYC_QUERY_ADDR,
+                        folder_name + "nyc_aggregate" + identification_string,
+                        get_query_nyc<NYC_DIMENSION>,
+                        dimensions);
+}
+
+void nyc_lookup_batch_bench(void)
+{
+
+  use_nyc_setting(NYC_DIMENSION, micro_nyc_size);
+
+  if (trie_width == (dimension_t) -1) {
+    trie_width = NYC_DIMENSION;
+  }
+
+  md_trie<NYC_DIMENSION> mdtrie(bench_trie_schema(trie_width, max_tree_node));
+  MdTrieBench<NYC_DIMENSION> bench(&mdtrie);
+  p_key_to_treeblock_compact = new bitmap::CompactPtrVector(total_points_count);
+  std::string folder_name = "microbenchmark/";
+  bench.insert(NYC_DATA_ADDR,
+               folder_name + "nyc_lookup_batch_insert" + identification_string,
+               total_points_count,
+               parse_line_nyc);
+  bench.lookup(folder_name + "nyc_lookup_batch_single" + identification_string);
+  for (point_t batch_size : {16, 256, 4096})
+    bench.lookup_batch(folder_name + "nyc_lookup_batch_" +
+                           std::to_string(batch_size) + identification_string,
+                       batch_size);
+}
+
+// Lookups through the per-treeblock primary key index, against the same
+// trie without it.
+void nyc_lookup_index_bench(void)
+{
+
+  use_nyc_setting(NYC_DIMENSION, micro_nyc_size);
+
+  if (trie_width == (dimension_t) -1) {
+    trie_width = NYC_DIMENSION;
+  }
+
+  std::string folder_name = "microbenchmark/";
+  for (bool use_index : {false, true})
+  {
+    use_primary_key_index = use_index;
+    std::string suffix = use_index ? "_index" : "_scan";
+    md_trie<NYC_DIMENSION> mdtrie(bench_trie_schema(trie_width, max_tree_node));
+    MdTrieBench<NYC_DIMENSION> bench(&mdtrie);
+    p_key_to_treeblock_compact = new bitmap::CompactPtrVector(total_points_count);
+    bench.insert(NYC_DATA_ADDR,
+                 folder_name + "nyc_lookup_index_insert" + suffix +
+                     identification_string,
+                 total_points_count,
+                 parse_line_nyc);
+    bench.lookup(folder_name + "nyc_lookup_index_lookup" + suffix +
+                 identification_string);
+    bench.get_storage(folder_name + "nyc_lookup_index_storage" + suffix +
+                      identification_string);
+  }
+  use_primary_key_index = false;
+}
+
+// Lookups and range searches skipping subtrees through the per-treeblock
+// subtree directory, against the same trie walking them. The gap widens with
+// max_tree_node, as the subtrees a skip passes grow with the treeblocks.
+void nyc_subtree_directory_bench(void)
+{
+
+  use_nyc_setting(NYC_DIMENSION, micro_nyc_size);
+
+  if (trie_width == (dimension_t) -1) {
+    trie_width = NYC_DIMENSION;
+  }
+
+  std::string folder_name = "microbenchmark/";
+  for (bool use_directory : {false, true})
+  {
+    use_subtree_directory = use_directory;
+    std::string suffix = use_directory ? "_directory" : "_walk";
+    md_trie<NYC_DIMENSION> mdtrie(bench_trie_schema(trie_width, max_tree_node));
+    MdTrieBench<NYC_DIMENSION> bench(&mdtrie);
+    p_key_to_treeblock_compact = new bitmap::CompactPtrVector(total_points_count);
+    bench.insert(NYC_DATA_ADDR,
+                 folder_name + "nyc_subtree_directory_insert" + suffix +
+                     identification_string,
+                 total_points_count,
+                 parse_line_nyc);
+    bench.lookup(folder_name + "nyc_subtree_directory_lookup" + suffix +
+                 identification_string);
+    bench.range_search(NYC_QUERY_ADDR,
+                       folder_name + "nyc_subtree_directory_query" + suffix +
+                           identification_string,
+                       get_query_nyc<NYC_DIMENSION>);
+    bench.get_storage(folder_name + "nyc_subtree_directory_storage" + suffix +
+                      identification_string);
+  }
+  use_subtree_directory = false;
+}
+
 void tpch_bench(void)
 {
 
@@ -82,7 +357,7 @@ void tpch_bench(void)
     identification_string += "_FLEX_" + std::to_string(trie_width) + "_" + std::to_string(max_tree_node);
   }
 
-  md_trie<TPCH_DIMENSION> mdtrie(trie_width, max_depth, trie_depth, max_tree_node);
+  md_trie<TPCH_DIMENSION> mdtrie(bench_trie_schema(trie_width, max_tree_node));
   MdTrieBench<TPCH_DIMENSION> bench(&mdtrie);
   p_key_to_treeblock_compact = new bitmap::CompactPtrVector(total_points_count);
   std::string folder_name = "microbenchmark/";
@@ -105,7 +380,7 @@ void sensitivity_num_dimensions_9(void)
 {
 
   use_tpch_setting(9, micro_tpch_size);
-  md_trie<9> mdtrie(9, max_depth, trie_depth, max_tree_node);
+  md_trie<9> mdtrie(bench_trie_schema(9, max_tree_node));
   MdTrieBench<9> bench(&mdtrie);
   p_key_to_treeblock_compact = new bitmap::CompactPtrVector(total_points_count);
 
@@ -127,7 +402,7 @@ void sensitivity_num_dimensions_8(void)
 {
 
   use_tpch_setting(8, micro_tpch_size);
-  md_trie<8> mdtrie(8, max_depth, trie_depth, max_tree_node);
+  md_trie<8> mdtrie(bench_trie_schema(8, max_tree_node));
   MdTrieBench<8> bench(&mdtrie);
   p_key_to_treeblock_compact = new bitmap::CompactPtrVector(total_points_count);
 
@@ -149,7 +424,7 @@ void sensitivity_num_dimensions_7(void)
 {
 
   use_tpch_setting(7, micro_tpch_size);
-  md_trie<7> mdtrie(7, max_depth, trie_depth, max_tree_node);
+  md_trie<7> mdtrie(bench_trie_schema(7, max_tree_node));
   MdTrieBench<7> bench(&mdtrie);
   p_key_to_treeblock_compact = new bitmap::CompactPtrVector(total_points_count);
 
@@ -171,7 +446,7 @@ void sensitivity_num_dimensions_6(void)
 {
 
   use_tpch_setting(6, micro_tpch_size);
-  md_trie<6> mdtrie(6, max_depth, trie_depth, max_tree_node);
+  md_trie<6> mdtrie(bench_trie_schema(6, max_tree_node));
   MdTrieBench<6> bench(&mdtrie);
   p_key_to_treeblock_compact = new bitmap::CompactPtrVector(total_points_count);
   bench.insert(TPCH_DATA_ADDR,
@@ -192,7 +467,7 @@ void sensitivity_num_dimensions_5(void)
 {
 
   use_tpch_setting(5, micro_tpch_size);
-  md_trie<5> mdtrie(5, max_depth, trie_depth, max_tree_node);
+  md_trie<5> mdtrie(bench_trie_schema(5, max_tree_node));
   MdTrieBench<5> bench(&mdtrie);
   p_key_to_treeblock_compact = new bitmap::CompactPtrVector(total_points_count);
 
@@ -214,7 +489,7 @@ void sensitivity_num_dimensions_4(void)
 {
 
   use_tpch_setting(4, micro_tpch_size);
-  md_trie<4> mdtrie(4, max_depth, trie_depth, max_tree_node);
+  md_trie<4> mdtrie(bench_trie_schema(4, max_tree_node));
   MdTrieBench<4> bench(&mdtrie);
   p_key_to_treeblock_compact = new bitmap::CompactPtrVector(total_points_count);
 
@@ -235,7 +510,7 @@ void sensitivity_num_dimensions_4(void)
 void sensitivity_num_dimensions_20(void)
 {
   use_tpch_setting(20, micro_tpch_size);
-  md_trie<20> mdtrie(20, max_depth, trie_depth, max_tree_node);
+  md_trie<20> mdtrie(bench_trie_schema(20, max_tree_node));
   MdTrieBench<20> bench(&mdtrie);
   p_key_to_treeblock_compact = new bitmap::CompactPtrVector(total_points_count);
   // Use fewer points.
@@ -259,7 +534,7 @@ void sensitivity_selectivity(void)
 {
 
   use_tpch_setting(TPCH_DIMENSION, micro_tpch_size);
-  md_trie<TPCH_DIMENSION> mdtrie((dimension_t) TPCH_DIMENSION, max_depth, trie_depth, max_tree_node);
+  md_trie<TPCH_DIMENSION> mdtrie(bench_trie_schema((dimension_t) TPCH_DIMENSION, max_tree_node));
   MdTrieBench<TPCH_DIMENSION> bench(&mdtrie);
   p_key_to_treeblock_compact = new bitmap::CompactPtrVector(total_points_count);
 
@@ -277,7 +552,7 @@ void sensitivity_selectivity(void)
 void sensitivity_treeblock_sizes(int treeblock_size)
 {
   use_tpch_setting(TPCH_DIMENSION, micro_tpch_size);
-  md_trie<TPCH_DIMENSION> mdtrie((dimension_t) TPCH_DIMENSION, max_depth, trie_depth, treeblock_size);
+  md_trie<TPCH_DIMENSION> mdtrie(bench_trie_schema((dimension_t) TPCH_DIMENSION, treeblock_size));
   MdTrieBench<TPCH_DIMENSION> bench(&mdtrie);
   p_key_to_treeblock_compact = new bitmap::CompactPtrVector(total_points_count);
   bench.insert(TPCH_DATA_ADDR,
@@ -292,6 +567,82 @@ void sensitivity_treeblock_sizes(int treeblock_size)
                      get_query_tpch<TPCH_DIMENSION>);
 }
 
+// The bitmap kernels compressed_bitmap runs over wide nodes, per kernel set
+// the CPU supports, on nodes of 2^4 to 2^15 bits with 8 children each, laid
+// end to end at unaligned offsets as in a DFUDS.
+void bitmap_kernels_bench(void)
+{
+
+  const uint64_t num_nodes = 64;
+  const uint64_t num_calls = 1 << 20;
+  std::mt19937_64 generator(7);
+  std::string results;
+  const bitmap_kernels::word_kernels *detected = bitmap_kernels::active;
+
+  for (uint64_t log_width = 4; log_width <= 15; log_width++)
+  {
+    uint64_t width = 1ULL << log_width;
+    uint64_t stride = width + 7;
+    std::vector<uint64_t> words(num_nodes * stride / 64 + 2);
+    for (uint64_t node = 0; node < num_nodes; node++)
+      for (int child = 0; child < 8; child++)
+      {
+        uint64_t bit = node * stride + generator() % width;
+        words[bit / 64] |= 1ULL << (bit % 64);
+      }
+
+    std::vector<uint64_t> symbols(num_calls), ranks(num_calls);
+    for (uint64_t i = 0; i < num_calls; i++)
+    {
+      uint64_t pos = i % num_nodes * stride;
+      symbols[i] = generator() % width;
+      uint64_t count = bitmap_kernels::popcount(words.data(), pos, width);
+      ranks[i] = count ? generator() % count : 0;
+    }
+
+    for (const bitmap_kernels::word_kernels *kernels :
+         {&bitmap_kernels::scalar_kernels,
+          &bitmap_kernels::avx2_kernels,
+          &bitmap_kernels::avx512_kernels})
+    {
+      if (!bitmap_kernels::supported(kernels))
+        continue;
+      bitmap_kernels::active = kernels;
+      uint64_t checksum = 0;
+
+      TimeStamp start = GetTimestamp();
+      for (uint64_t i = 0; i < num_calls; i++)
+        checksum += bitmap_kernels::popcount(
+            words.data(), i % num_nodes * stride, width);
+      TimeStamp popcount_time = GetTimestamp() - start;
+
+      start = GetTimestamp();
+      for (uint64_t i = 0; i < num_calls; i++)
+        checksum += bitmap_kernels::find_set(words.data(),
+                                             i % num_nodes * stride + symbols[i],
+                                             width - symbols[i]);
+      TimeStamp find_set_time = GetTimestamp() - start;
+
+      start = GetTimestamp();
+      for (uint64_t i = 0; i < num_calls; i++)
+        checksum += bitmap_kernels::select(
+            words.data(), i % num_nodes * stride, width, ranks[i]);
+      TimeStamp select_time = GetTimestamp() - start;
+
+      std::string line =
+          std::string(kernels->name_) + "," + std::to_string(width) + "," +
+          std::to_string((double)popcount_time * 1000 / num_calls) + "," +
+          std::to_string((double)find_set_time * 1000 / num_calls) + "," +
+          std::to_string((double)select_time * 1000 / num_calls);
+      std::cout << line << " (checksum " << checksum << ")" << std::endl;
+      results += line + "\n";
+    }
+  }
+  bitmap_kernels::active = detected;
+  flush_string_to_file(results,
+                       results_folder_addr + "microbenchmark/bitmap_kernels");
+}
+
 int main(int argc, char *argv[])
 {
 
@@ -300,9 +651,10 @@ int main(int argc, char *argv[])
   int arg;
   int sensitivity_dimensions = -1;
   int treeblock_size = -1;
+  unsigned int max_threads = std::thread::hardware_concurrency();
   is_microbenchmark = true;
 
-  while ((arg = getopt(argc, argv, "b:o:d:t:w:m:")) != -1)
+  while ((arg = getopt(argc, argv, "b:o:d:t:w:m:p:")) != -1)
     switch (arg)
     {
     case 'b':
@@ -331,6 +683,9 @@ int main(int argc, char *argv[])
     case 'm':
       max_tree_node = (preorder_t) atoi(optarg);
       break;
+    case 'p':
+      max_threads = atoi(optarg);
+      break;
     default:
       abort();
     }
@@ -346,6 +701,28 @@ int main(int argc, char *argv[])
     github_bench();
   else if (argvalue == "nyc")
     nyc_bench();
+  else if (argvalue == "nyc_parallel_search")
+    nyc_parallel_search_bench(max_threads == 0 ? 1 : max_threads);
+  else if (argvalue == "nyc_bulk_load")
+    nyc_bulk_load_bench();
+  else if (argvalue == "nyc_insert_batch")
+    nyc_insert_batch_bench();
+  else if (argvalue == "nyc_symbol")
+    nyc_symbol_bench();
+  else if (argvalue == "nyc_delete")
+    nyc_delete_bench();
+  else if (argvalue == "nyc_snapshot")
+    nyc_snapshot_bench();
+  else if (argvalue == "nyc_aggregate")
+    nyc_aggregate_bench();
+  else if (argvalue == "nyc_lookup_batch")
+    nyc_lookup_batch_bench();
+  else if (argvalue == "nyc_lookup_index")
+    nyc_lookup_index_bench();
+  else if (argvalue == "nyc_subtree_directory")
+    nyc_subtree_directory_bench();
+  else if (argvalue == "bitmap_kernels")
+    bitmap_kernels_bench();
   else if (argvalue == "sensitivity_num_dimensions")
   {
     switch (sensitivity_dimensions)
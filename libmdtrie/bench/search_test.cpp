@@ -35,18 +35,8 @@ int random_int(int min, int max)
 
 void run_example(std::vector<level_t> bit_widths, std::vector<level_t> start_bits, int total_count, dimension_t width) {
 
-    max_depth = (24 * 10) / width;
-    if ((24 * 10) % width != 0) {
-        max_depth++;
-    }
-
-    create_level_to_num_children(bit_widths, start_bits, max_depth, width);
-
-    // std::cout << "Level to num children (width = " << std::to_string(width) << "): ";
-    // printArray<morton_t>(level_to_num_children, max_depth);
-
-    md_trie<10> mdtrie(width, max_depth, trie_depth, max_tree_node);
-    // md_trie<10> mdtrie(max_depth, trie_depth, max_tree_node);
+    trie_schema schema(bit_widths, start_bits, width, trie_depth, max_tree_node, no_dynamic_sizing);
+    md_trie<10> mdtrie(schema);
     bitmap::CompactPtrVector primary_key_to_treeblock_mapping(total_count);
 
     // Reserve space in a vector for total_count data_point<10> objects
@@ -156,6 +156,14 @@ namespace bitmap
 
     void Realloc_increase(size_type num_bits) { Resize(size_ + num_bits); }
 
+    // Frees the bits; copies share them, so only their owner may.
+    void Free()
+    {
+      free(data_);
+      data_ = nullptr;
+      size_ = 0;
+    }
+
     virtual ~Bitmap() = default;
 
     size_type GetSizeInBits() { return size_; }
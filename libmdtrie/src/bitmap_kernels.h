@@ -0,0 +1,296 @@
+#ifndef MD_TRIE_BITMAP_KERNELS_H
+#define MD_TRIE_BITMAP_KERNELS_H
+
+#include <cstdint>
+#include <x86intrin.h>
+
+/**
+ * bitmap_kernels: popcount, find-first-set and select over a run of bits of
+ * a word array, the loops compressed_bitmap runs over the 1 << num_children
+ * bits of a wide node. The partial words at either end of a run are handled
+ * inline; the whole words between them go to a word_kernels, picked once at
+ * startup as the widest of the scalar, AVX2 and AVX-512 versions the CPU
+ * supports. The vector versions are compiled with target attributes, so the
+ * library still builds with -mbmi2 alone and runs on CPUs without AVX.
+ */
+namespace bitmap_kernels
+{
+
+  // The kernels over n whole words. select_word returns the index of the
+  // word holding the k-th (0-indexed) set bit, with k reduced to its rank in
+  // that word, or n with k reduced by every set bit if there are not enough.
+  struct word_kernels
+  {
+    const char *name_;
+    uint64_t (*popcount_)(const uint64_t *words, uint64_t n);
+    uint64_t (*find_nonzero_)(const uint64_t *words, uint64_t n);
+    uint64_t (*select_word_)(const uint64_t *words, uint64_t n, uint64_t &k);
+  };
+
+  // Runs of fewer whole words stay on the inline scalar loops.
+  const uint64_t min_dispatch_words = 4;
+
+  inline uint64_t scalar_popcount(const uint64_t *words, uint64_t n)
+  {
+    uint64_t count = 0;
+    for (uint64_t i = 0; i < n; i++)
+      count += __builtin_popcountll(words[i]);
+    return count;
+  }
+
+  inline uint64_t scalar_find_nonzero(const uint64_t *words, uint64_t n)
+  {
+    uint64_t i = 0;
+    while (i < n && !words[i])
+      i++;
+    return i;
+  }
+
+  inline uint64_t scalar_select_word(const uint64_t *words,
+                                     uint64_t n,
+                                     uint64_t &k)
+  {
+    for (uint64_t i = 0; i < n; i++)
+    {
+      uint64_t count = __builtin_popcountll(words[i]);
+      if (k < count)
+        return i;
+      k -= count;
+    }
+    return n;
+  }
+
+  // Popcount of each 64-bit lane (Mula's nibble lookup, summed by vpsadbw).
+  __attribute__((target("avx2"))) inline __m256i avx2_lane_popcount(__m256i v)
+  {
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2,
+                                            3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2,
+                                            2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_mask = _mm256_set1_epi8(0x0f);
+    __m256i lo = _mm256_and_si256(v, low_mask);
+    __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+    __m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo),
+                                    _mm256_shuffle_epi8(lookup, hi));
+    return _mm256_sad_epu8(bytes, _mm256_setzero_si256());
+  }
+
+  __attribute__((target("avx2"))) inline uint64_t
+  avx2_popcount(const uint64_t *words, uint64_t n)
+  {
+    __m256i total = _mm256_setzero_si256();
+    uint64_t i = 0;
+    for (; i + 4 <= n; i += 4)
+      total = _mm256_add_epi64(
+          total,
+          avx2_lane_popcount(_mm256_loadu_si256((const __m256i *)(words + i))));
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, total);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+           scalar_popcount(words + i, n - i);
+  }
+
+  __attribute__((target("avx2"))) inline uint64_t
+  avx2_find_nonzero(const uint64_t *words, uint64_t n)
+  {
+    uint64_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+      __m256i v = _mm256_loadu_si256((const __m256i *)(words + i));
+      if (!_mm256_testz_si256(v, v))
+        break;
+    }
+    return i + scalar_find_nonzero(words + i, n - i);
+  }
+
+  __attribute__((target("avx2"))) inline uint64_t
+  avx2_select_word(const uint64_t *words, uint64_t n, uint64_t &k)
+  {
+    uint64_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+      uint64_t lanes[4];
+      _mm256_storeu_si256(
+          (__m256i *)lanes,
+          avx2_lane_popcount(_mm256_loadu_si256((const __m256i *)(words + i))));
+      uint64_t count = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+      if (k < count)
+        break;
+      k -= count;
+    }
+    return i + scalar_select_word(words + i, n - i, k);
+  }
+
+  // Sum of the lanes; spilled rather than _mm512_reduce_add_epi64, whose
+  // GCC expansion trips -Wuninitialized.
+  __attribute__((target("avx512f"))) inline uint64_t avx512_sum(__m512i v)
+  {
+    uint64_t lanes[8];
+    _mm512_storeu_si512(lanes, v);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + lanes[4] + lanes[5] +
+           lanes[6] + lanes[7];
+  }
+
+  __attribute__((target("avx512f,avx512vpopcntdq"))) inline uint64_t
+  avx512_popcount(const uint64_t *words, uint64_t n)
+  {
+    __m512i total = _mm512_setzero_si512();
+    uint64_t i = 0;
+    for (; i + 8 <= n; i += 8)
+      total = _mm512_add_epi64(
+          total, _mm512_popcnt_epi64(_mm512_loadu_si512(words + i)));
+    if (i < n)
+    {
+      __mmask8 tail = (__mmask8)((1u << (n - i)) - 1);
+      total = _mm512_add_epi64(
+          total, _mm512_popcnt_epi64(_mm512_maskz_loadu_epi64(tail, words + i)));
+    }
+    return avx512_sum(total);
+  }
+
+  __attribute__((target("avx512f"))) inline uint64_t
+  avx512_find_nonzero(const uint64_t *words, uint64_t n)
+  {
+    uint64_t i = 0;
+    for (; i < n; i += 8)
+    {
+      __mmask8 in_range =
+          n - i >= 8 ? (__mmask8)0xff : (__mmask8)((1u << (n - i)) - 1);
+      __m512i v = _mm512_maskz_loadu_epi64(in_range, words + i);
+      __mmask8 nonzero = _mm512_test_epi64_mask(v, v);
+      if (nonzero)
+        return i + __builtin_ctz(nonzero);
+    }
+    return n;
+  }
+
+  __attribute__((target("avx512f,avx512vpopcntdq"))) inline uint64_t
+  avx512_select_word(const uint64_t *words, uint64_t n, uint64_t &k)
+  {
+    uint64_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+      uint64_t count =
+          avx512_sum(_mm512_popcnt_epi64(_mm512_loadu_si512(words + i)));
+      if (k < count)
+        break;
+      k -= count;
+    }
+    return i + scalar_select_word(words + i, n - i, k);
+  }
+
+  const word_kernels scalar_kernels = {
+      "scalar", scalar_popcount, scalar_find_nonzero, scalar_select_word};
+  const word_kernels avx2_kernels = {
+      "avx2", avx2_popcount, avx2_find_nonzero, avx2_select_word};
+  const word_kernels avx512_kernels = {
+      "avx512", avx512_popcount, avx512_find_nonzero, avx512_select_word};
+
+  inline bool supported(const word_kernels *kernels)
+  {
+    __builtin_cpu_init();
+    if (kernels == &avx512_kernels)
+      return __builtin_cpu_supports("avx512f") &&
+             __builtin_cpu_supports("avx512vpopcntdq");
+    if (kernels == &avx2_kernels)
+      return __builtin_cpu_supports("avx2");
+    return true;
+  }
+
+  inline const word_kernels *detect_kernels()
+  {
+    if (supported(&avx512_kernels))
+      return &avx512_kernels;
+    if (supported(&avx2_kernels))
+      return &avx2_kernels;
+    return &scalar_kernels;
+  }
+
+  // The kernels in use; benchmarks may point it at another supported set.
+  inline const word_kernels *active = detect_kernels();
+
+  // Set bits of the width bits of words starting at bit pos.
+  inline uint64_t popcount(const uint64_t *words, uint64_t pos, uint64_t width)
+  {
+    uint64_t s_idx = pos / 64;
+    uint64_t s_off = pos % 64;
+    uint64_t end = pos + width;
+    uint64_t e_idx = end / 64;
+    uint64_t e_off = end % 64;
+    if (s_idx == e_idx)
+      return __builtin_popcountll((words[s_idx] >> s_off) &
+                                  ((1ULL << (e_off - s_off)) - 1));
+    uint64_t count = __builtin_popcountll(words[s_idx] >> s_off);
+    uint64_t n = e_idx - s_idx - 1;
+    count += n < min_dispatch_words ? scalar_popcount(words + s_idx + 1, n)
+                                    : active->popcount_(words + s_idx + 1, n);
+    if (e_off)
+      count += __builtin_popcountll(words[e_idx] & ((1ULL << e_off) - 1));
+    return count;
+  }
+
+  // Offset from pos of the first set bit of the width bits of words starting
+  // at bit pos, or width if there is none.
+  inline uint64_t find_set(const uint64_t *words, uint64_t pos, uint64_t width)
+  {
+    if (width == 0)
+      return 0;
+    uint64_t s_idx = pos / 64;
+    uint64_t s_off = pos % 64;
+    uint64_t end = pos + width;
+    uint64_t e_idx = end / 64;
+    uint64_t e_off = end % 64;
+    uint64_t head = words[s_idx] >> s_off;
+    if (s_idx == e_idx)
+    {
+      head &= (1ULL << (e_off - s_off)) - 1;
+      return head ? __builtin_ctzll(head) : width;
+    }
+    if (head)
+      return __builtin_ctzll(head);
+    uint64_t n = e_idx - s_idx - 1;
+    uint64_t i = n < min_dispatch_words
+                     ? scalar_find_nonzero(words + s_idx + 1, n)
+                     : active->find_nonzero_(words + s_idx + 1, n);
+    if (i < n)
+      return (s_idx + 1 + i) * 64 + __builtin_ctzll(words[s_idx + 1 + i]) - pos;
+    uint64_t tail = e_off ? words[e_idx] & ((1ULL << e_off) - 1) : 0;
+    return tail ? e_idx * 64 + __builtin_ctzll(tail) - pos : width;
+  }
+
+  // Offset from pos of the k-th (0-indexed) set bit of the width bits of
+  // words starting at bit pos, or width if there are not that many.
+  inline uint64_t select(const uint64_t *words,
+                         uint64_t pos,
+                         uint64_t width,
+                         uint64_t k)
+  {
+    uint64_t s_idx = pos / 64;
+    uint64_t s_off = pos % 64;
+    uint64_t end = pos + width;
+    uint64_t e_idx = end / 64;
+    uint64_t e_off = end % 64;
+    uint64_t head = words[s_idx] >> s_off;
+    if (s_idx == e_idx)
+      head &= (1ULL << (e_off - s_off)) - 1;
+    uint64_t count = __builtin_popcountll(head);
+    if (k < count)
+      return __builtin_ctzll(_pdep_u64(1ULL << k, head));
+    if (s_idx == e_idx)
+      return width;
+    k -= count;
+    uint64_t n = e_idx - s_idx - 1;
+    uint64_t i = n < min_dispatch_words
+                     ? scalar_select_word(words + s_idx + 1, n, k)
+                     : active->select_word_(words + s_idx + 1, n, k);
+    if (i < n)
+      return (s_idx + 1 + i) * 64 +
+             __builtin_ctzll(_pdep_u64(1ULL << k, words[s_idx + 1 + i])) - pos;
+    uint64_t tail = e_off ? words[e_idx] & ((1ULL << e_off) - 1) : 0;
+    if (k < (uint64_t)__builtin_popcountll(tail))
+      return e_idx * 64 + __builtin_ctzll(_pdep_u64(1ULL << k, tail)) - pos;
+    return width;
+  }
+
+} // namespace bitmap_kernels
+
+#endif // MD_TRIE_BITMAP_KERNELS_H
@@ -2,8 +2,11 @@
 #define COMPACT_PTR_H
 
 #include "delta_encoded_array.h"
+#include "node_arena.h"
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <vector>
 
 // Disable in most cases.
@@ -12,6 +15,44 @@ const uint64_t compact_pointer_vector_size_limit = 1000000;
 namespace bits
 {
 
+  /**
+   * small_key_list: a short sorted list of the primary keys sharing a leaf,
+   * held in the trie's node_arena right after its header, so looking a list
+   * up or scanning it touches one allocation rather than a std::vector and
+   * its separate buffer. Its capacity grows by half, through 3, 5, 9, 15, 23
+   * keys and so on; being odd, it fills a node_arena size class exactly.
+   */
+  struct small_key_list
+  {
+    uint32_t size_;
+    uint32_t capacity_;
+
+    static size_t alloc_size(uint32_t capacity)
+    {
+      return sizeof(small_key_list) + capacity * sizeof(n_leaves_t);
+    }
+
+    static small_key_list *create(node_arena *arena, uint32_t capacity)
+    {
+      auto *list = (small_key_list *)arena->allocate(alloc_size(capacity));
+      list->size_ = 0;
+      list->capacity_ = capacity;
+      return list;
+    }
+
+    inline n_leaves_t *keys() { return (n_leaves_t *)(this + 1); }
+  };
+
+  /**
+   * compact_ptr: the primary keys of one leaf in 6 bytes. flag_ tells how
+   * ptr_ holds them: 0, a single key inline; 3, a small_key_list; 1, a
+   * std::vector; 2, an EliasGammaDeltaEncodedArray. A list starts inline and
+   * moves along as it grows. Given the node_arena of the trie the leaf
+   * belongs to, a list is a small_key_list until it is delta encoded, and
+   * the delta encoded array is made by the arena too, so that releasing the
+   * arena frees every list. Without one (as in a snapshot image), lists are
+   * vectors instead.
+   */
   class compact_ptr
   {
   public:
@@ -29,12 +70,47 @@ namespace bits
       return (std::vector<n_leaves_t> *)(ptr_ << 4ULL);
     }
 
+    // Makes this a list held in vect, e.g. a copy of the list placed in a
+    // snapshot image.
+    void set_vector_pointer(std::vector<n_leaves_t> *vect)
+    {
+      ptr_ = ((uintptr_t)vect) >> 4ULL;
+      flag_ = 1;
+    }
+
     bitmap::EliasGammaDeltaEncodedArray<n_leaves_t> *
     get_delta_encoded_array_pointer()
     {
       return (bitmap::EliasGammaDeltaEncodedArray<n_leaves_t> *)(ptr_ << 4ULL);
     }
 
+    small_key_list *get_small_list_pointer()
+    {
+      return (small_key_list *)(ptr_ << 4ULL);
+    }
+
+    static bitmap::EliasGammaDeltaEncodedArray<n_leaves_t> *
+    create_delta_encoded_array(std::vector<n_leaves_t> &keys,
+                               node_arena *arena)
+    {
+      if (!arena)
+        return new bitmap::EliasGammaDeltaEncodedArray<n_leaves_t>(
+            keys, keys.size());
+      return arena
+          ->create_owned<bitmap::EliasGammaDeltaEncodedArray<n_leaves_t>>(
+              keys, keys.size());
+    }
+
+    static void release_delta_encoded_array(
+        bitmap::EliasGammaDeltaEncodedArray<n_leaves_t> *enc_array,
+        node_arena *arena)
+    {
+      if (!arena)
+        delete enc_array;
+      else
+        arena->destroy_owned(enc_array);
+    }
+
     bool scan_if_present(std::vector<n_leaves_t> *vect, n_leaves_t primary_key)
     {
       int vect_size = vect->size();
@@ -80,10 +156,15 @@ namespace bits
       {
         return sizeof(compact_ptr);
       }
+      if (flag_ == 3)
+      {
+        return small_key_list::alloc_size(get_small_list_pointer()->capacity_) +
+               sizeof(compact_ptr);
+      }
       if (flag_ == 1)
       {
         std::vector<n_leaves_t> *vect_ptr = get_vector_pointer();
-        return sizeof(*vect_ptr) + sizeof(n_leaves_t) /*primary key size*/ * vect_ptr->size() + sizeof(compact_ptr);
+        return sizeof(*vect_ptr) + sizeof(n_leaves_t) /*primary key size*/ * vect_ptr->capacity() + sizeof(compact_ptr);
       }
       else
       {
@@ -93,37 +174,94 @@ namespace bits
       }
     }
 
-    void push(n_leaves_t primary_key)
+    void push(n_leaves_t primary_key, node_arena *arena = nullptr)
     {
 
+      if (flag_ == 0 && arena)
+      {
+        small_key_list *list = small_key_list::create(arena, 3);
+        list->keys()[0] = std::min((n_leaves_t)ptr_, primary_key);
+        list->keys()[1] = std::max((n_leaves_t)ptr_, primary_key);
+        list->size_ = 2;
+        ptr_ = ((uintptr_t)list) >> 4ULL;
+        flag_ = 3;
+        return;
+      }
       if (flag_ == 0)
       {
         auto array = new std::vector<n_leaves_t>;
-        array->push_back((n_leaves_t)ptr_);
-        array->push_back(primary_key);
+        array->push_back(std::min((n_leaves_t)ptr_, primary_key));
+        array->push_back(std::max((n_leaves_t)ptr_, primary_key));
         ptr_ = ((uintptr_t)array) >> 4ULL;
         flag_ = 1;
         return;
       }
       else if (size() == compact_pointer_vector_size_limit + 1)
       {
-
-        std::vector<n_leaves_t> *vect_ptr = get_vector_pointer();
-
-        auto enc_array = new bitmap::EliasGammaDeltaEncodedArray<n_leaves_t>(
-            *vect_ptr, vect_ptr->size());
-        delete vect_ptr;
-        ptr_ = ((uintptr_t)enc_array) >> 4ULL;
+        std::vector<n_leaves_t> keys;
+        if (flag_ == 3)
+        {
+          small_key_list *list = get_small_list_pointer();
+          keys.assign(list->keys(), list->keys() + list->size_);
+          arena->release(list, small_key_list::alloc_size(list->capacity_));
+        }
+        else
+        {
+          std::vector<n_leaves_t> *vect_ptr = get_vector_pointer();
+          keys.swap(*vect_ptr);
+          delete vect_ptr;
+        }
+        ptr_ = ((uintptr_t)create_delta_encoded_array(keys, arena)) >> 4ULL;
         flag_ = 2;
       }
+      // Keys are kept sorted for check_if_present. They mostly arrive in
+      // increasing order, but a key deleted and inserted again may not.
+      if (flag_ == 3)
+      {
+        small_key_list *list = get_small_list_pointer();
+        if (list->size_ == list->capacity_)
+        {
+          uint32_t capacity = (list->capacity_ + list->capacity_ / 2 + 1) | 1;
+          list = (small_key_list *)arena->reallocate(
+              list,
+              small_key_list::alloc_size(list->capacity_),
+              small_key_list::alloc_size(capacity));
+          list->capacity_ = capacity;
+          ptr_ = ((uintptr_t)list) >> 4ULL;
+        }
+        n_leaves_t *keys = list->keys();
+        n_leaves_t *at =
+            std::upper_bound(keys, keys + list->size_, primary_key);
+        memmove(at + 1, at, (keys + list->size_ - at) * sizeof(n_leaves_t));
+        *at = primary_key;
+        list->size_++;
+        return;
+      }
       if (flag_ == 1)
       {
-        get_vector_pointer()->push_back(primary_key);
+        std::vector<n_leaves_t> *vect_ptr = get_vector_pointer();
+        vect_ptr->insert(
+            std::upper_bound(vect_ptr->begin(), vect_ptr->end(), primary_key),
+            primary_key);
+        return;
       }
-      else
+
+      auto enc_array = get_delta_encoded_array_pointer();
+      n_leaves_t num_elements = enc_array->get_num_elements();
+      if ((*enc_array)[num_elements - 1] <= primary_key)
       {
-        get_delta_encoded_array_pointer()->Push(primary_key);
+        enc_array->Push(primary_key);
+        return;
       }
+      std::vector<n_leaves_t> keys;
+      for (n_leaves_t i = 0; i < num_elements; i++)
+      {
+        keys.push_back((*enc_array)[i]);
+      }
+      keys.insert(std::upper_bound(keys.begin(), keys.end(), primary_key),
+                  primary_key);
+      release_delta_encoded_array(enc_array, arena);
+      ptr_ = ((uintptr_t)create_delta_encoded_array(keys, arena)) >> 4ULL;
     }
 
     uint64_t get(n_leaves_t index)
@@ -135,6 +273,10 @@ namespace bits
       {
         return (uint64_t)ptr_;
       }
+      if (flag_ == 3)
+      {
+        return get_small_list_pointer()->keys()[index];
+      }
       if (flag_ == 1)
       {
         return (*get_vector_pointer())[index];
@@ -152,6 +294,12 @@ namespace bits
       {
         return primary_key == (uint64_t)ptr_;
       }
+      else if (flag_ == 3)
+      {
+        small_key_list *list = get_small_list_pointer();
+        return std::binary_search(
+            list->keys(), list->keys() + list->size_, primary_key);
+      }
       else if (flag_ == 1)
       {
         return binary_if_present(get_vector_pointer(), primary_key);
@@ -162,6 +310,89 @@ namespace bits
       }
     }
 
+    // Removes primary_key from a list of at least two keys (a single key goes
+    // away with its compact_ptr). A list left with one key is stored inline
+    // again. arena is the one the list was pushed with. Returns false if
+    // primary_key is not in the list.
+    bool remove(n_leaves_t primary_key, node_arena *arena)
+    {
+
+      if (flag_ == 0 || !check_if_present(primary_key))
+      {
+        return false;
+      }
+      if (flag_ == 2)
+      {
+        // Decode into a plain list to erase from.
+        auto enc_array = get_delta_encoded_array_pointer();
+        n_leaves_t num_elements = enc_array->get_num_elements();
+        if (arena)
+        {
+          small_key_list *list =
+              small_key_list::create(arena, num_elements | 1);
+          for (n_leaves_t i = 0; i < num_elements; i++)
+            list->keys()[i] = (*enc_array)[i];
+          list->size_ = num_elements;
+          ptr_ = ((uintptr_t)list) >> 4ULL;
+          flag_ = 3;
+        }
+        else
+        {
+          auto array = new std::vector<n_leaves_t>;
+          for (n_leaves_t i = 0; i < num_elements; i++)
+          {
+            array->push_back((*enc_array)[i]);
+          }
+          ptr_ = ((uintptr_t)array) >> 4ULL;
+          flag_ = 1;
+        }
+        release_delta_encoded_array(enc_array, arena);
+      }
+      if (flag_ == 3)
+      {
+        small_key_list *list = get_small_list_pointer();
+        n_leaves_t *keys = list->keys();
+        n_leaves_t *at = std::lower_bound(keys, keys + list->size_, primary_key);
+        memmove(at, at + 1, (keys + list->size_ - at - 1) * sizeof(n_leaves_t));
+        list->size_--;
+        if (list->size_ == 1)
+        {
+          ptr_ = (uintptr_t)keys[0];
+          flag_ = 0;
+          arena->release(list, small_key_list::alloc_size(list->capacity_));
+        }
+        return true;
+      }
+
+      std::vector<n_leaves_t> *vect_ptr = get_vector_pointer();
+      vect_ptr->erase(
+          std::find(vect_ptr->begin(), vect_ptr->end(), primary_key));
+      if (vect_ptr->size() == 1)
+      {
+        ptr_ = (uintptr_t)(*vect_ptr)[0];
+        flag_ = 0;
+        delete vect_ptr;
+      }
+      return true;
+    }
+
+    // Frees a list held out of line; arena is the one the list was pushed
+    // with. The compact_ptr holds no key afterwards and is only fit to be
+    // discarded.
+    void release(node_arena *arena)
+    {
+      if (flag_ == 3)
+        arena->release(get_small_list_pointer(),
+                       small_key_list::alloc_size(
+                           get_small_list_pointer()->capacity_));
+      else if (flag_ == 1)
+        delete get_vector_pointer();
+      else if (flag_ == 2)
+        release_delta_encoded_array(get_delta_encoded_array_pointer(), arena);
+      ptr_ = 0;
+      flag_ = 0;
+    }
+
     size_t size()
     {
 
@@ -169,6 +400,10 @@ namespace bits
       {
         return 1;
       }
+      else if (flag_ == 3)
+      {
+        return get_small_list_pointer()->size_;
+      }
       else if (flag_ == 1)
       {
         return get_vector_pointer()->size();
@@ -0,0 +1,421 @@
+#ifndef COMPACT_PTR_LIST_H
+#define COMPACT_PTR_LIST_H
+
+#include "compact_ptr.h"
+#include "snapshot.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <vector>
+
+namespace bits
+{
+
+  /**
+   * compact_ptr_list: the primary key list of a treeblock, one compact_ptr
+   * per leaf in preorder. Entries live in chunks of at most max_chunk_size,
+   * each grown geometrically like a vector, with a table of where each chunk
+   * ends. A positional insert or erase moves entries within one chunk only
+   * (splitting it when full) and then updates the ends of the chunks after
+   * it. move_range_to and splice_in hand whole chunks between lists by
+   * pointer, copying only the entries of the chunks cut at either end.
+   *
+   * Access looks the chunk up by binary search over the ends; a list of one
+   * chunk, as most are, goes to it directly. The chunks and both tables come
+   * from the trie's node_arena when the list has one.
+   */
+  class compact_ptr_list
+  {
+  public:
+    static constexpr uint32_t max_chunk_size = 128;
+
+    struct chunk
+    {
+      uint32_t size_;
+      uint32_t capacity_;
+
+      inline compact_ptr *entries() { return (compact_ptr *)(this + 1); }
+
+      static size_t alloc_size(uint32_t capacity)
+      {
+        return sizeof(chunk) + capacity * sizeof(compact_ptr);
+      }
+
+      static chunk *create(node_arena *arena, uint32_t capacity)
+      {
+        auto *c = (chunk *)node_arena::allocate_in(arena, alloc_size(capacity));
+        c->size_ = 0;
+        c->capacity_ = capacity;
+        return c;
+      }
+
+      static chunk *resize(node_arena *arena, chunk *c, uint32_t capacity)
+      {
+        c = (chunk *)node_arena::reallocate_in(
+            arena, c, alloc_size(c->capacity_), alloc_size(capacity));
+        c->capacity_ = capacity;
+        return c;
+      }
+
+      static void release(node_arena *arena, chunk *c)
+      {
+        node_arena::release_in(arena, c, alloc_size(c->capacity_));
+      }
+    };
+
+    class iterator
+    {
+    public:
+      typedef std::forward_iterator_tag iterator_category;
+      typedef compact_ptr value_type;
+      typedef std::ptrdiff_t difference_type;
+      typedef compact_ptr *pointer;
+      typedef compact_ptr &reference;
+
+      iterator(compact_ptr_list *list, size_t chunk, uint32_t entry)
+          : list_(list), chunk_(chunk), entry_(entry)
+      {
+      }
+
+      inline compact_ptr &operator*() const
+      {
+        return list_->chunks_[chunk_]->entries()[entry_];
+      }
+
+      inline iterator &operator++()
+      {
+        if (++entry_ == list_->chunks_[chunk_]->size_)
+        {
+          chunk_++;
+          entry_ = 0;
+        }
+        return *this;
+      }
+
+      inline bool operator==(const iterator &other) const
+      {
+        return chunk_ == other.chunk_ && entry_ == other.entry_;
+      }
+
+      inline bool operator!=(const iterator &other) const
+      {
+        return !(*this == other);
+      }
+
+    private:
+      compact_ptr_list *list_;
+      size_t chunk_;
+      uint32_t entry_;
+    };
+
+    // arena is that of the treeblock holding the list, if it has one; lists
+    // trading chunks must share it.
+    explicit compact_ptr_list(node_arena *arena = nullptr) : arena_(arena) {}
+    compact_ptr_list(const compact_ptr_list &) = delete;
+    compact_ptr_list &operator=(const compact_ptr_list &) = delete;
+
+    ~compact_ptr_list()
+    {
+      clear();
+      resize_tables(0);
+    }
+
+    inline size_t size() const { return size_; }
+
+    inline iterator begin() { return iterator(this, 0, 0); }
+    inline iterator end() { return iterator(this, num_chunks_, 0); }
+
+    inline compact_ptr &operator[](size_t index)
+    {
+      if (num_chunks_ == 1)
+        return chunks_[0]->entries()[index];
+      size_t c = chunk_of(index);
+      return chunks_[c]->entries()[index - chunk_start(c)];
+    }
+
+    // Entries the chunks have room for.
+    inline size_t capacity() const { return capacity_; }
+
+    // Bytes held by the chunks and the chunk tables.
+    inline size_t allocated_bytes() const
+    {
+      return capacity_ * sizeof(compact_ptr) + num_chunks_ * sizeof(chunk) +
+             table_capacity_ * (sizeof(chunk *) + sizeof(uint32_t));
+    }
+
+    void insert(size_t index, compact_ptr entry)
+    {
+      if (num_chunks_ == 0)
+        append_chunk(chunk::create(arena_, 4));
+      size_t c = index == size_ ? num_chunks_ - 1 : chunk_of(index);
+      chunk *target = chunks_[c];
+      if (target->size_ == target->capacity_)
+      {
+        if (target->capacity_ < max_chunk_size)
+        {
+          uint32_t grown = std::min(target->capacity_ * 2, max_chunk_size);
+          capacity_ += grown - target->capacity_;
+          target = chunks_[c] = chunk::resize(arena_, target, grown);
+        }
+        else
+        {
+          split_chunk(c, target->size_ / 2);
+          if (index >= ends_[c])
+            c++;
+          target = chunks_[c];
+        }
+      }
+      size_t local = index - chunk_start(c);
+      memmove(target->entries() + local + 1,
+              target->entries() + local,
+              (target->size_ - local) * sizeof(compact_ptr));
+      target->entries()[local] = entry;
+      target->size_++;
+      for (size_t i = c; i < num_chunks_; i++)
+        ends_[i]++;
+      size_++;
+    }
+
+    void erase(size_t index)
+    {
+      size_t c = chunk_of(index);
+      chunk *target = chunks_[c];
+      size_t local = index - chunk_start(c);
+      memmove(target->entries() + local,
+              target->entries() + local + 1,
+              (target->size_ - local - 1) * sizeof(compact_ptr));
+      target->size_--;
+      for (size_t i = c; i < num_chunks_; i++)
+        ends_[i]--;
+      size_--;
+      if (target->size_ == 0)
+        remove_chunks(c, c + 1, true);
+    }
+
+    // Appends entries [first, first + count) to dest and removes them from
+    // this list. Chunks entirely within the range change lists by pointer.
+    void move_range_to(size_t first, size_t count, compact_ptr_list &dest)
+    {
+      if (count == 0)
+        return;
+      size_t from = boundary_at(first);
+      size_t to = boundary_at(first + count);
+      for (size_t c = from; c < to; c++)
+        dest.append_chunk(chunks_[c]);
+      remove_chunks(from, to, false);
+    }
+
+    // Inserts every entry of src at index, leaving src empty. The chunks of
+    // src change lists by pointer.
+    void splice_in(size_t index, compact_ptr_list &src)
+    {
+      if (src.size_ == 0)
+        return;
+      size_t at = boundary_at(index);
+      open_slots(at, src.num_chunks_);
+      std::copy_n(src.chunks_, src.num_chunks_, chunks_ + at);
+      size_ += src.size_;
+      capacity_ += src.capacity_;
+      recompute_ends(at);
+      src.num_chunks_ = 0;
+      src.size_ = 0;
+      src.capacity_ = 0;
+    }
+
+    // Replaces the entries with entries[0, n), packed into full chunks.
+    void assign(const compact_ptr *entries, size_t n)
+    {
+      clear();
+      for (size_t done = 0; done < n;)
+      {
+        uint32_t size = std::min<size_t>(n - done, max_chunk_size);
+        chunk *c = chunk::create(arena_, size);
+        memcpy(c->entries(), entries + done, size * sizeof(compact_ptr));
+        c->size_ = size;
+        append_chunk(c);
+        done += size;
+      }
+    }
+
+    // Repacks the entries into full chunks, with nothing spare.
+    void shrink_to_fit()
+    {
+      std::vector<compact_ptr> entries(begin(), end());
+      assign(entries.data(), entries.size());
+      resize_tables(num_chunks_);
+    }
+
+    // Frees the chunks; the lists of duplicates the entries point to are
+    // left alone.
+    void clear()
+    {
+      for (size_t c = 0; c < num_chunks_; c++)
+        chunk::release(arena_, chunks_[c]);
+      num_chunks_ = 0;
+      size_ = 0;
+      capacity_ = 0;
+    }
+
+    // Turns this, a byte copy of a list placed in a snapshot image, into
+    // the image of a list of entries: one chunk written to the image, as
+    // mapped lists are only read.
+    void set_image(snapshot_writer &writer,
+                   const std::vector<compact_ptr> &entries)
+    {
+      arena_ = nullptr;
+      size_ = capacity_ = entries.size();
+      num_chunks_ = table_capacity_ = entries.empty() ? 0 : 1;
+      if (entries.empty())
+      {
+        chunks_ = nullptr;
+        ends_ = nullptr;
+        return;
+      }
+      uint32_t end = entries.size();
+      std::vector<char> bytes(sizeof(chunk) + end * sizeof(compact_ptr));
+      chunk *image = (chunk *)bytes.data();
+      image->size_ = image->capacity_ = end;
+      memcpy(image->entries(), entries.data(), end * sizeof(compact_ptr));
+      uintptr_t c = writer.append(bytes.data(), bytes.size());
+      chunks_ = (chunk **)writer.append(&c, sizeof(c));
+      ends_ = (uint32_t *)writer.append(&end, sizeof(end));
+    }
+
+  private:
+    inline size_t chunk_start(size_t c) const { return c ? ends_[c - 1] : 0; }
+
+    // Index of the chunk holding entry index.
+    inline size_t chunk_of(size_t index) const
+    {
+      return std::upper_bound(ends_, ends_ + num_chunks_, index) - ends_;
+    }
+
+    void recompute_ends(size_t from)
+    {
+      uint32_t end = chunk_start(from);
+      for (size_t i = from; i < num_chunks_; i++)
+      {
+        end += chunks_[i]->size_;
+        ends_[i] = end;
+      }
+    }
+
+    // Moves the entries of chunk c from local index at on to a new chunk
+    // after it.
+    void split_chunk(size_t c, uint32_t at)
+    {
+      chunk *left = chunks_[c];
+      uint32_t moved = left->size_ - at;
+      chunk *right = chunk::create(arena_, std::max<uint32_t>(moved, 4));
+      memcpy(right->entries(), left->entries() + at, moved * sizeof(compact_ptr));
+      right->size_ = moved;
+      left->size_ = at;
+      capacity_ += right->capacity_;
+      open_slots(c + 1, 1);
+      chunks_[c + 1] = right;
+      ends_[c] = chunk_start(c) + at;
+      ends_[c + 1] = ends_[c] + moved;
+    }
+
+    // Splits chunks so that one starts at entry index (or index is the end);
+    // returns that chunk's position.
+    size_t boundary_at(size_t index)
+    {
+      if (index == size_)
+        return num_chunks_;
+      size_t c = chunk_of(index);
+      size_t local = index - chunk_start(c);
+      if (local == 0)
+        return c;
+      split_chunk(c, local);
+      return c + 1;
+    }
+
+    void append_chunk(chunk *c)
+    {
+      open_slots(num_chunks_, 1);
+      chunks_[num_chunks_ - 1] = c;
+      size_ += c->size_;
+      capacity_ += c->capacity_;
+      ends_[num_chunks_ - 1] = size_;
+    }
+
+    // Inserts count slots into the tables at chunk position at, growing
+    // them geometrically; the new slots are left for the caller to fill.
+    void open_slots(size_t at, size_t count)
+    {
+      if (num_chunks_ + count > table_capacity_)
+        resize_tables(std::max(num_chunks_ + count, table_capacity_ * 2));
+      memmove(chunks_ + at + count,
+              chunks_ + at,
+              (num_chunks_ - at) * sizeof(chunk *));
+      memmove(ends_ + at + count,
+              ends_ + at,
+              (num_chunks_ - at) * sizeof(uint32_t));
+      num_chunks_ += count;
+    }
+
+    // Reallocates both tables to capacity slots (freeing them if 0).
+    void resize_tables(size_t capacity)
+    {
+      if (capacity == table_capacity_)
+        return;
+      if (capacity == 0)
+      {
+        node_arena::release_in(
+            arena_, chunks_, table_capacity_ * sizeof(chunk *));
+        node_arena::release_in(
+            arena_, ends_, table_capacity_ * sizeof(uint32_t));
+        chunks_ = nullptr;
+        ends_ = nullptr;
+      }
+      else
+      {
+        chunks_ = (chunk **)node_arena::reallocate_in(
+            arena_,
+            chunks_,
+            table_capacity_ * sizeof(chunk *),
+            capacity * sizeof(chunk *));
+        ends_ = (uint32_t *)node_arena::reallocate_in(
+            arena_,
+            ends_,
+            table_capacity_ * sizeof(uint32_t),
+            capacity * sizeof(uint32_t));
+      }
+      table_capacity_ = capacity;
+    }
+
+    // Drops chunks [from, to) from the list, freeing them if release.
+    void remove_chunks(size_t from, size_t to, bool release)
+    {
+      for (size_t c = from; c < to; c++)
+      {
+        size_ -= chunks_[c]->size_;
+        capacity_ -= chunks_[c]->capacity_;
+        if (release)
+          chunk::release(arena_, chunks_[c]);
+      }
+      memmove(chunks_ + from,
+              chunks_ + to,
+              (num_chunks_ - to) * sizeof(chunk *));
+      memmove(ends_ + from, ends_ + to, (num_chunks_ - to) * sizeof(uint32_t));
+      num_chunks_ -= to - from;
+      recompute_ends(from);
+    }
+
+    node_arena *arena_ = nullptr;
+    chunk **chunks_ = nullptr;
+    // ends_[c]: number of entries in chunks 0 to c.
+    uint32_t *ends_ = nullptr;
+    size_t num_chunks_ = 0;
+    // Slots in chunks_ and ends_.
+    size_t table_capacity_ = 0;
+    size_t size_ = 0;
+    size_t capacity_ = 0;
+  };
+
+} // namespace bits
+
+#endif // COMPACT_PTR_LIST_H
@@ -441,6 +441,28 @@ namespace bitmap
       num_elements_ = num_elements;
     }
 
+    // Wraps num_elements entries laid out in data, which the vector does not
+    // own (e.g. a snapshot mapping); Release() it before deleting it.
+    CompactPtrVector(data_type *data, size_type num_elements)
+        : CompactVector<uint64_t, 44>()
+    {
+      data_ = data;
+      size_ = num_elements * 44;
+      num_elements_ = num_elements;
+    }
+
+    void Release()
+    {
+      data_ = nullptr;
+      size_ = 0;
+      num_elements_ = 0;
+    }
+
+    static size_type DataWords(size_type num_elements)
+    {
+      return BITS2BLOCKS(num_elements * 44);
+    }
+
     // Accessors, Mutators
     void *At(pos_type idx)
     {
@@ -1,6 +1,7 @@
 #ifndef BITMAP_COMPRESSED_BITMAP_H_
 #define BITMAP_COMPRESSED_BITMAP_H_
 
+#include <algorithm>
 #include <bitset>
 #include <cassert>
 #include <cstddef>
@@ -8,6 +9,11 @@
 #include <cstdlib>
 #include <cstring>
 #include <defs.h>
+#include "bitmap_kernels.h"
+#include "memory_usage.h"
+#include "node_arena.h"
+#include "snapshot.h"
+#include "trie_schema.h"
 #include <iostream>
 #include <signal.h>
 #include <x86intrin.h>
@@ -132,78 +138,86 @@ namespace compressed_bitmap
     typedef uint64_t data_type;
     typedef uint64_t width_type;
 
-    explicit compressed_bitmap(width_type flag_size, width_type data_size)
+    // The words are allocated from arena, and counted in its memory usage,
+    // if one is given.
+    explicit compressed_bitmap(width_type flag_size,
+                               width_type data_size,
+                               const trie_schema *schema,
+                               node_arena *arena = nullptr)
     {
 
-      data_ = (data_type *)calloc(BITS2BLOCKS(data_size), sizeof(data_type));
-      flag_ = (data_type *)calloc(BITS2BLOCKS(flag_size), sizeof(data_type));
+      arena_ = arena;
       data_size_ = data_size;
       flag_size_ = flag_size;
+      data_capacity_ = BITS2BLOCKS(data_size);
+      flag_capacity_ = BITS2BLOCKS(flag_size);
+      data_ = allocate_words(data_capacity_, true);
+      flag_ = allocate_words(flag_capacity_, false);
+      schema_ = schema;
       SETBITVAL(flag_, 0);
     }
 
+    ~compressed_bitmap()
+    {
+      release_words(true);
+      release_words(false);
+    }
+
     inline uint64_t size() const
     {
       // if (!is_valid((void *) this))
       //   return 0;
 
       uint64_t total_size = 0;
-      total_size += sizeof(data_size_) + sizeof(flag_size_);
+      total_size += sizeof(data_size_) + sizeof(flag_size_) + sizeof(schema_);
+      total_size += sizeof(data_capacity_) + sizeof(flag_capacity_);
       total_size += sizeof(data_) + sizeof(flag_);
-      total_size +=
-          sizeof(data_type) * (BITS2BLOCKS(data_size_) + BITS2BLOCKS(flag_size_));
+      total_size += sizeof(data_type) * (data_capacity_ + flag_capacity_);
       return total_size;
     }
 
+    // Bytes allocated beyond the words the data and flag bits occupy.
+    inline uint64_t capacity_overhead() const
+    {
+      return sizeof(data_type) *
+             (data_capacity_ - BITS2BLOCKS(data_size_) + flag_capacity_ -
+              BITS2BLOCKS(flag_size_));
+    }
+
+    // The sizes below change the number of bits in use; the words behind
+    // them grow geometrically and only shrink once less than half of them
+    // is used, so tree_block::insert resizing on every insertion seldom
+    // reallocates. Bits added to the end read as 0.
     inline void increase_bits(width_type increase_width, bool is_on_data)
     {
 
       if (is_on_data)
-      {
-        data_ = (data_type *)realloc(
-            data_, BITS2BLOCKS(data_size_ + increase_width) * sizeof(data_type));
-        data_size_ += increase_width;
-      }
+        resize_bits(data_size_ + increase_width, true);
       else
-      {
-        flag_ = (data_type *)realloc(
-            flag_, BITS2BLOCKS(flag_size_ + increase_width) * sizeof(data_type));
-        flag_size_ += increase_width;
-      }
+        resize_bits(flag_size_ + increase_width, false);
     }
 
     inline void decrease_bits(width_type decrease_width, bool is_on_data)
     {
 
       if (is_on_data)
-      {
-        data_ = (data_type *)realloc(
-            data_, BITS2BLOCKS(data_size_ - decrease_width) * sizeof(data_type));
-        data_size_ -= decrease_width;
-      }
+        resize_bits(data_size_ - decrease_width, true);
       else
-      {
-        flag_ = (data_type *)realloc(
-            flag_, BITS2BLOCKS(flag_size_ - decrease_width) * sizeof(data_type));
-        flag_size_ -= decrease_width;
-      }
+        resize_bits(flag_size_ - decrease_width, false);
     }
 
     inline void keep_bits(width_type new_size, bool is_on_data)
     {
 
-      if (is_on_data)
-      {
-        data_ =
-            (data_type *)realloc(data_, BITS2BLOCKS(new_size) * sizeof(data_type));
-        data_size_ = new_size;
-      }
-      else
-      {
-        flag_ =
-            (data_type *)realloc(flag_, BITS2BLOCKS(new_size) * sizeof(data_type));
-        flag_size_ = new_size;
-      }
+      resize_bits(new_size, is_on_data);
+    }
+
+    // Gives back every word beyond the bits in use, for blocks that are no
+    // longer inserted into.
+    void shrink_to_fit()
+    {
+      reallocate_words(BITS2BLOCKS(data_size_), true);
+      reallocate_words(BITS2BLOCKS(flag_size_), false);
     }
 
     inline uint64_t popcount(pos_type pos, width_type width, bool is_on_data)
@@ -213,38 +227,7 @@ namespace compressed_bitmap
       {
         return __builtin_popcountll(GetValPos(pos, width, is_on_data));
       }
-
-      pos_type s_off = pos % 64;
-      pos_type s_idx = pos / 64;
-      uint64_t count =
-          __builtin_popcountll(GetValPos(pos, 64 - s_off, is_on_data));
-      width -= 64 - s_off;
-      s_idx += 1;
-
-      if (is_on_data)
-      {
-        while (width > 64)
-        {
-          count += __builtin_popcountll(data_[s_idx]);
-          width -= 64;
-          s_idx += 1;
-        }
-      }
-      else
-      {
-        while (width > 64)
-        {
-          count += __builtin_popcountll(flag_[s_idx]);
-          width -= 64;
-          s_idx += 1;
-        }
-      }
-      if (width > 0)
-      {
-        return count +
-               __builtin_popcountll(GetValPos(s_idx * 64, width, is_on_data));
-      }
-      return count;
+      return bitmap_kernels::popcount(is_on_data ? data_ : flag_, pos, width);
     }
 
     inline void SetValPos(pos_type pos,
@@ -358,46 +341,100 @@ namespace compressed_bitmap
 
       if (is_collapse(node))
       {
-        return level_to_num_children[level];
+        return schema_->level_to_num_children[level];
       }
       else
       {
-        return 1 << level_to_num_children[level];
+        return 1 << schema_->level_to_num_children[level];
       }
     }
 
+    // Writes num_words words to to, the i-th made of the 64 bits of words
+    // starting at bit from + 64 * i, lowest or highest word first.
+    static inline void funnel_words(data_type *to,
+                                    const data_type *words,
+                                    pos_type from,
+                                    pos_type num_words,
+                                    bool lowest_first)
+    {
+      const data_type *src = words + from / 64;
+      width_type s_off = from % 64;
+      if (s_off == 0)
+      {
+        memmove(to, src, num_words * sizeof(data_type));
+        return;
+      }
+      if (lowest_first)
+        for (pos_type i = 0; i < num_words; i++)
+          to[i] = (src[i] >> s_off) | (src[i + 1] << (64 - s_off));
+      else
+        for (pos_type i = num_words; i-- > 0;)
+          to[i] = (src[i] >> s_off) | (src[i + 1] << (64 - s_off));
+    }
+
+    // The bulk copies move whole destination words where they can: the
+    // partial words at either end go through GetValPos and SetValPos, and
+    // the aligned run between them is a memmove, or a funnel shift of the
+    // source words when source and destination are not equally aligned.
+
+    // Copies bits [from, from + bits) to [destination, ...), lowest word
+    // first, so the ranges may overlap if destination < from.
     inline void bulkcopy_forward(pos_type from,
                                  pos_type destination,
                                  width_type bits,
                                  bool is_on_data)
     {
-      while (bits > 64)
+      width_type head = std::min<width_type>((64 - destination % 64) % 64, bits);
+      if (head)
       {
-        SetValPos(destination, GetValPos(from, 64, is_on_data), 64, is_on_data);
-        from += 64;
-        destination += 64;
-        bits -= 64;
+        SetValPos(destination, GetValPos(from, head, is_on_data), head, is_on_data);
+        from += head;
+        destination += head;
+        bits -= head;
       }
-      SetValPos(destination, GetValPos(from, bits, is_on_data), bits, is_on_data);
+
+      data_type *words = is_on_data ? data_ : flag_;
+      pos_type num_words = bits / 64;
+      funnel_words(words + destination / 64, words, from, num_words, true);
+      from += num_words * 64;
+      destination += num_words * 64;
+      bits -= num_words * 64;
+
+      if (bits)
+        SetValPos(destination, GetValPos(from, bits, is_on_data), bits, is_on_data);
     }
 
+    // Copies bits [from - bits, from) to [destination - bits, destination),
+    // highest word first, so the ranges may overlap if destination > from.
     inline void bulkcopy_backward(pos_type from,
                                   pos_type destination,
                                   width_type bits,
                                   bool is_on_data)
     {
-      while (bits > 64)
-      {
-        SetValPos(
-            destination - 64, GetValPos(from - 64, 64, is_on_data), 64, is_on_data);
-        bits -= 64;
-        destination -= 64;
-        from -= 64;
-      }
-      SetValPos(destination - bits,
-                GetValPos(from - bits, bits, is_on_data),
-                bits,
-                is_on_data);
+      width_type head = std::min<width_type>(destination % 64, bits);
+      if (head)
+      {
+        SetValPos(destination - head,
+                  GetValPos(from - head, head, is_on_data),
+                  head,
+                  is_on_data);
+        from -= head;
+        destination -= head;
+        bits -= head;
+      }
+
+      data_type *words = is_on_data ? data_ : flag_;
+      pos_type num_words = bits / 64;
+      from -= num_words * 64;
+      destination -= num_words * 64;
+      bits -= num_words * 64;
+      funnel_words(words + destination / 64, words, from, num_words, false);
+
+      if (bits)
+        SetValPos(destination - bits,
+                  GetValPos(from - bits, bits, is_on_data),
+                  bits,
+                  is_on_data);
     }
 
     inline void shift_backward(preorder_t node,
@@ -464,7 +501,7 @@ namespace compressed_bitmap
 
     inline bool is_collapse(preorder_t node)
     {
-      if (is_collapsed_node_exp)
+      if (schema_->is_collapsed_node_exp)
         return false;
 
       return !GETBITVAL(flag_, node);
@@ -539,29 +576,11 @@ namespace compressed_bitmap
         return GetValPos(node_pos, num_children, true);
       }
       morton_t pos_left = 1 << num_children;
-      morton_t return_symbol = 0;
-
-      while (pos_left > 64)
-      {
-        uint64_t next_block = GetValPos(node_pos + return_symbol, 64, true);
-        if (next_block)
-        {
-          morton_t set_bit_count = __builtin_popcountll(next_block);
-          if (k >= set_bit_count)
-          {
-            k -= set_bit_count;
-          }
-          else if (set_bit_count > 0)
-          {
-            return return_symbol + nthset(next_block, k);
-          }
-        }
-        pos_left -= 64;
-        return_symbol += 64;
-      }
+      if (pos_left > 64)
+        return bitmap_kernels::select(data_, node_pos, pos_left, k);
 
-      uint64_t next_block = GetValPos(node_pos + return_symbol, pos_left, true);
-      return return_symbol + nthset(next_block, k);
+      uint64_t next_block = GetValPos(node_pos, pos_left, true);
+      return nthset(next_block, k);
     }
 
     inline morton_t next_symbol(morton_t symbol,
@@ -580,27 +599,19 @@ namespace compressed_bitmap
         return end_symbol_range + 1;
       }
 
+      if (symbol > end_symbol_range)
+        return end_symbol_range + 1;
       morton_t limit = end_symbol_range - symbol + 1;
-      bool over_64 = false;
       if (limit > 64)
-      {
-        limit = 64;
-        over_64 = true;
-      }
+        return symbol +
+               bitmap_kernels::find_set(data_, node_pos + symbol, limit);
+
       uint64_t next_block = GetValPos(node_pos + symbol, limit, true);
       if (next_block)
       {
         return __builtin_ctzll(next_block) + symbol;
       }
-      else
-      {
-        if (over_64)
-        {
-          return next_symbol(
-              symbol + limit, node, node_pos, end_symbol_range, num_children);
-        }
-        return end_symbol_range + 1;
-      }
+      return end_symbol_range + 1;
     }
 
     inline void shift_forward_to_collapse(preorder_t from_node,
@@ -614,16 +625,75 @@ namespace compressed_bitmap
       width_type shift_amount = (1 << num_children) - num_children;
 
       pos_type from_node_next_pos = from_node_pos + (1 << num_children);
-      bulkcopy_forward(from_node_next_pos,
-                       from_node_next_pos - shift_amount,
-                       data_size_ - from_node_next_pos,
-                       true);
-
+      if (data_size_ > from_node_next_pos)
+        bulkcopy_forward(from_node_next_pos,
+                         from_node_next_pos - shift_amount,
+                         data_size_ - from_node_next_pos,
+                         true);
+
+      // Clear the vacated tail before giving it back.
+      ClearWidth(data_size_ - shift_amount, shift_amount, true);
       decrease_bits(shift_amount, true);
-      ClearWidth(from_node_next_pos - num_children, num_children, true);
       CLRBITVAL(flag_, from_node);
     }
 
+    // Removes symbol from a node that has other children. A node left with a
+    // single child is collapsed, moving the bits after it (up to end_pos, the
+    // end of the bits in use) forward. Returns the number of bits freed.
+    inline width_type clear_symbol(preorder_t node,
+                                   pos_type node_pos,
+                                   morton_t symbol,
+                                   width_type num_children,
+                                   pos_type end_pos)
+    {
+
+      CLRBITVAL(data_, node_pos + symbol);
+      if (schema_->is_collapsed_node_exp ||
+          popcount(node_pos, 1 << num_children, true) != 1)
+      {
+        return 0;
+      }
+
+      morton_t only_symbol = get_k_th_set_bit(node, 0, node_pos, num_children);
+      width_type shift_amount = (1 << num_children) - num_children;
+      pos_type node_next_pos = node_pos + (1 << num_children);
+      if (end_pos > node_next_pos)
+      {
+        bulkcopy_forward(node_next_pos,
+                         node_next_pos - shift_amount,
+                         end_pos - node_next_pos,
+                         true);
+      }
+      ClearWidth(end_pos - shift_amount, shift_amount, true);
+      SetValPos(node_pos, only_symbol, num_children, true);
+      CLRBITVAL(flag_, node);
+      return shift_amount;
+    }
+
+    // Copies width bits at from_pos of from to to_pos of this bitmap.
+    inline void copy_bits_from(const compressed_bitmap *from,
+                               pos_type from_pos,
+                               pos_type to_pos,
+                               width_type width,
+                               bool is_on_data)
+    {
+      while (width > 64)
+      {
+        SetValPos(
+            to_pos, from->GetValPos(from_pos, 64, is_on_data), 64, is_on_data);
+        from_pos += 64;
+        to_pos += 64;
+        width -= 64;
+      }
+      if (width > 0)
+      {
+        SetValPos(to_pos,
+                  from->GetValPos(from_pos, width, is_on_data),
+                  width,
+                  is_on_data);
+      }
+    }
+
     inline void set_symbol(preorder_t node,
                            pos_type node_pos,
                            morton_t symbol,
@@ -633,7 +703,7 @@ namespace compressed_bitmap
 
       if (is_collapse(node))
       {
-        if (is_collapsed_node_exp)
+        if (schema_->is_collapsed_node_exp)
         {
           std::cout << "wrong! set symbol";
           exit(-1);
@@ -721,18 +791,115 @@ namespace compressed_bitmap
                                 preorder_t end_node_pos)
     {
       ClearWidth(start_node_pos, end_node_pos - start_node_pos, true);
-      ClearWidth(start_node, end_node + 1 - start_node, false);
+      // end_node may lie one past the last flag bit of an exactly-sized block.
+      ClearWidth(start_node,
+                 std::min<pos_type>(end_node + 1, flag_size_) - start_node,
+                 false);
     }
 
     size_type get_flag_size() { return flag_size_; }
     size_type get_data_size() { return data_size_; }
 
+    // Writes this bitmap and its words into writer's image and returns its
+    // image address.
+    uintptr_t save(snapshot_writer &writer) const
+    {
+      compressed_bitmap image = *this;
+      image.data_ = (data_type *)writer.append(
+          data_, BITS2BLOCKS(data_size_) * sizeof(data_type));
+      image.flag_ = (data_type *)writer.append(
+          flag_, BITS2BLOCKS(flag_size_) * sizeof(data_type));
+      image.data_capacity_ = BITS2BLOCKS(data_size_);
+      image.flag_capacity_ = BITS2BLOCKS(flag_size_);
+      image.arena_ = nullptr;
+      image.schema_ = (const trie_schema *)writer.schema_address_;
+      uintptr_t address = writer.append((const void *)&image, sizeof(image));
+      // image shares this bitmap's words; keep its destructor off them.
+      image.data_ = nullptr;
+      image.flag_ = nullptr;
+      return address;
+    }
+
   protected:
+    // capacity zeroed words.
+    inline data_type *allocate_words(size_type capacity, bool is_on_data)
+    {
+      auto *words = (data_type *)node_arena::allocate_in(
+          arena_, capacity * sizeof(data_type));
+      memset(words, 0, capacity * sizeof(data_type));
+      if (arena_)
+        arena_->usage().add(is_on_data ? MEMORY_DFUDS_DATA : MEMORY_DFUDS_FLAG,
+                            capacity * sizeof(data_type));
+      return words;
+    }
+
+    inline void reallocate_words(size_type new_capacity, bool is_on_data)
+    {
+      data_type *&words = is_on_data ? data_ : flag_;
+      size_type &capacity = is_on_data ? data_capacity_ : flag_capacity_;
+      new_capacity = std::max<size_type>(new_capacity, 1);
+      if (new_capacity == capacity)
+        return;
+      words = (data_type *)node_arena::reallocate_in(
+          arena_,
+          words,
+          capacity * sizeof(data_type),
+          new_capacity * sizeof(data_type));
+      if (arena_)
+        arena_->usage().add(is_on_data ? MEMORY_DFUDS_DATA : MEMORY_DFUDS_FLAG,
+                            ((int64_t)new_capacity - (int64_t)capacity) *
+                                sizeof(data_type));
+      capacity = new_capacity;
+    }
+
+    inline void release_words(bool is_on_data)
+    {
+      data_type *&words = is_on_data ? data_ : flag_;
+      size_type &capacity = is_on_data ? data_capacity_ : flag_capacity_;
+      node_arena::release_in(arena_, words, capacity * sizeof(data_type));
+      if (arena_)
+        arena_->usage().add(is_on_data ? MEMORY_DFUDS_DATA : MEMORY_DFUDS_FLAG,
+                            -(int64_t)(capacity * sizeof(data_type)));
+      words = nullptr;
+      capacity = 0;
+    }
+
+    inline void resize_bits(size_type new_size, bool is_on_data)
+    {
+      data_type *&words = is_on_data ? data_ : flag_;
+      size_type &size = is_on_data ? data_size_ : flag_size_;
+      size_type capacity = is_on_data ? data_capacity_ : flag_capacity_;
+      size_type blocks = BITS2BLOCKS(new_size);
+      if (blocks > capacity)
+        reallocate_words(std::max<size_type>(blocks, capacity + capacity / 2),
+                         is_on_data);
+      else if (blocks < capacity / 2)
+        reallocate_words(blocks + blocks / 4, is_on_data);
+
+      if (new_size > size)
+      {
+        // Clear the tail of the last word in use, then the words after it.
+        if (size % 64)
+          words[size / 64] &= low_bits_set[size % 64];
+        size_type first = BITS2BLOCKS(size);
+        if (blocks > first)
+          memset(words + first, 0, (blocks - first) * sizeof(data_type));
+      }
+      size = new_size;
+    }
+
     // Data members
     data_type *data_;
     data_type *flag_;
     size_type data_size_;
     size_type flag_size_;
+    // Words allocated behind data_ and flag_.
+    size_type data_capacity_;
+    size_type flag_capacity_;
+    const trie_schema *schema_;
+    // Where the words are allocated and counted; nullptr for the heap (and
+    // in a snapshot image).
+    node_arena *arena_ = nullptr;
   };
 } // namespace compressed_bitmap
 
@@ -3,6 +3,7 @@
 
 #include "compressed_bitmap.h"
 #include "defs.h"
+#include "trie_schema.h"
 #include <cstdlib>
 #include <cstring>
 
@@ -17,10 +18,11 @@ public:
   inline void set(point_t *coordinates)
   {
 
+    symbols_ = nullptr;
     memcpy(coordinates_, coordinates, sizeof(point_t) * DIMENSION);
   }
 
-  inline point_t get_coordinate(dimension_t index)
+  inline point_t get_coordinate(dimension_t index) const
   {
 
     return coordinates_[index];
@@ -29,6 +31,7 @@ public:
   inline void set_coordinate(dimension_t index, point_t value)
   {
 
+    symbols_ = nullptr;
     coordinates_[index] = value;
   }
 
@@ -36,30 +39,55 @@ public:
 
   inline n_leaves_t read_primary() { return primary_key_; }
 
-  inline morton_t leaf_to_symbol(level_t level)
+  inline morton_t leaf_to_symbol(level_t level, const trie_schema *schema)
   {
 
+    if (symbols_)
+      return symbols_[level];
     morton_t result = 0;
-    auto &tbl = _dim_off_table[level];
+    const symbol_gather *end = schema->gather_end(level);
+    for (const symbol_gather *g = schema->gather_begin(level); g != end; g++)
+      result |= _pdep_u64(_pext_u64(coordinates_[g->dim], g->coordinate_mask),
+                          g->symbol_mask);
+    return result;
+  }
 
-    for (uint16_t i = 0; i < tbl.size(); i++) {
+  // Computes this point's symbol at every level into symbols (room for
+  // schema->max_depth_ of them), which leaf_to_symbol then reads instead of
+  // gathering bits again, until drop_symbols or a coordinate changes. Copies
+  // of the point share symbols, which must outlive them.
+  inline void cache_symbols(morton_t *symbols, const trie_schema *schema)
+  {
 
-      auto [dim, off] = tbl[i];
+    symbols_ = nullptr;
+    for (level_t level = 0; level < schema->max_depth_; level++)
+      symbols[level] = leaf_to_symbol(level, schema);
+    symbols_ = symbols;
+  }
 
-      point_t coordinate = coordinates_[dim];
+  inline void drop_symbols() { symbols_ = nullptr; }
 
-      bool bit = GETBIT (coordinate, off);
-      result = (result << 1U) + bit;
-    }
-    
-    return result;
+  // Inverse of leaf_to_symbol: sets this point's bits at level to those of
+  // symbol.
+  inline void symbol_to_leaf(morton_t symbol,
+                             level_t level,
+                             const trie_schema *schema)
+  {
+
+    symbols_ = nullptr;
+    const symbol_gather *end = schema->gather_end(level);
+    for (const symbol_gather *g = schema->gather_begin(level); g != end; g++)
+      coordinates_[g->dim] =
+          (coordinates_[g->dim] & ~g->coordinate_mask) |
+          _pdep_u64(_pext_u64(symbol, g->symbol_mask), g->coordinate_mask);
   }
 
-  inline morton_t leaf_to_full_symbol(level_t level)
+  inline morton_t leaf_to_full_symbol(level_t level,
+                                      const trie_schema *schema)
   {
 
     morton_t result = 0;
-    auto &tbl = _dim_off_table[level];
+    auto &tbl = schema->dim_off_table[level];
 
     for (uint16_t i = 0; i < tbl.size(); i++) {
       bool bit = 1;
@@ -69,6 +97,26 @@ public:
     return result;
   }
 
+  // Whether the range from this point to end_range (as narrowed down by
+  // update_symbol) spans every symbol at level and below, i.e. covers the
+  // whole subtree of the node it reached at level.
+  inline bool covers_subtree(const data_point *end_range,
+                             level_t level,
+                             const trie_schema *schema) const
+  {
+
+    for (; level < schema->max_depth_; level++)
+    {
+      for (auto [dim, off] : schema->dim_off_table[level])
+      {
+        if (GETBIT(coordinates_[dim], off) ||
+            !GETBIT(end_range->coordinates_[dim], off))
+          return false;
+      }
+    }
+    return true;
+  }
+
   // NOT USED ANYWHERE, but
   // might need to change 32 to max_depth of trie
   uint64_t coordinate_to_raw_morton()
@@ -92,12 +140,15 @@ public:
 
   inline void update_symbol(data_point *end_range,
                             morton_t current_symbol,
-                            level_t level)
+                            level_t level,
+                            const trie_schema *schema)
   {
 
     // dimension_t dimension = DIMENSION;
+    symbols_ = nullptr;
+    end_range->symbols_ = nullptr;
     size_t visited_ct = 0;
-    auto &tbl = _dim_off_table[level];
+    auto &tbl = schema->dim_off_table[level];
     dimension_t bits_in_lvl = (dimension_t) tbl.size();
 
     for (uint16_t i = 0; i < bits_in_lvl; i++) {
@@ -107,21 +158,35 @@ public:
 
       dimension_t sym_off = bits_in_lvl - visited_ct;
 
-      bool start_bit  = GETBIT(coordinates_[dim], off);
-      bool end_bit    = GETBIT(end_range->coordinates_[dim], off);
-      bool sym_bit    = GETBIT(current_symbol, sym_off);
+      update_bit(end_range, dim, off, GETBIT(current_symbol, sym_off));
+    }
+  }
 
-      // adjust the range endpoints:
-      if (sym_bit && !start_bit) {
-          auto v = coordinates_[dim] & low_bits_unset[off];
-          SETBIT(v, off);
-          coordinates_[dim] = v;
-      }
-      if (!sym_bit && end_bit) {
-          auto v = end_range->coordinates_[dim] | low_bits_set[off];
-          CLRBIT(v, off);
-          end_range->coordinates_[dim] = v;
-      }
+  // One step of update_symbol: narrows the range from this point to
+  // end_range down to the points whose bit off of dimension dim is sym_bit.
+  // Once the higher bits of dim are fixed, the range is empty if that leaves
+  // this point's coordinate above end_range's.
+  inline void update_bit(data_point *end_range,
+                         dimension_t dim,
+                         level_t off,
+                         bool sym_bit)
+  {
+
+    symbols_ = nullptr;
+    end_range->symbols_ = nullptr;
+    bool start_bit  = GETBIT(coordinates_[dim], off);
+    bool end_bit    = GETBIT(end_range->coordinates_[dim], off);
+
+    // adjust the range endpoints:
+    if (sym_bit && !start_bit) {
+        auto v = coordinates_[dim] & low_bits_unset[off];
+        SETBIT(v, off);
+        coordinates_[dim] = v;
+    }
+    if (!sym_bit && end_bit) {
+        auto v = end_range->coordinates_[dim] | low_bits_set[off];
+        CLRBIT(v, off);
+        end_range->coordinates_[dim] = v;
     }
   }
 
@@ -146,6 +211,8 @@ private:
   // dimension_t width_;
   point_t coordinates_[DIMENSION] = {0};
   n_leaves_t primary_key_ = 0;
+  // Set by cache_symbols.
+  const morton_t *symbols_ = nullptr;
 };
 
 #endif // MD_TRIE_DATA_POINT_H
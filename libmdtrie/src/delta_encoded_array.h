@@ -20,7 +20,14 @@ namespace bitmap
     typedef uint8_t width_type;
 
     DeltaEncodedArray() = default;
-    virtual ~DeltaEncodedArray() = default;
+
+    // The bitmaps are this array's alone, as it is never copied.
+    virtual ~DeltaEncodedArray()
+    {
+      samples_.Free();
+      delta_offsets_.Free();
+      deltas_.Free();
+    }
 
   protected:
     // Get the encoding size for an delta value
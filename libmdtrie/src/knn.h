@@ -0,0 +1,140 @@
+#ifndef MD_TRIE_KNN_H
+#define MD_TRIE_KNN_H
+
+#include "data_point.h"
+#include "defs.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+template <dimension_t DIMENSION>
+class trie_node;
+
+/**
+ * knn_metric: how md_trie::knn_search measures the distance between two
+ * points: the weighted sum of the absolute differences of their coordinates
+ * (L1), or the square root of the weighted sum of their squares (L2).
+ */
+enum knn_metric : int32_t
+{
+  KNN_L1 = 0,
+  KNN_L2 = 1,
+};
+
+/**
+ * knn_distance: a knn_metric with one weight per dimension (dimensions past
+ * the end of weights_ weigh 1). L2 distances are compared squared, which
+ * orders them the same, and only rooted by report.
+ */
+struct knn_distance
+{
+  explicit knn_distance(knn_metric metric = KNN_L2,
+                        const std::vector<double> &weights = {})
+      : metric_(metric), weights_(weights)
+  {
+  }
+
+  inline double weight(dimension_t dim) const
+  {
+    return dim < weights_.size() ? weights_[dim] : 1;
+  }
+
+  inline double term(dimension_t dim, double delta) const
+  {
+    return weight(dim) * (metric_ == KNN_L2 ? delta * delta : delta);
+  }
+
+  template <dimension_t DIMENSION>
+  double to_point(const data_point<DIMENSION> &query,
+                  const data_point<DIMENSION> &point) const
+  {
+    double total = 0;
+    for (dimension_t i = 0; i < DIMENSION; i++)
+    {
+      point_t a = query.get_coordinate(i);
+      point_t b = point.get_coordinate(i);
+      total += term(i, a > b ? a - b : b - a);
+    }
+    return total;
+  }
+
+  // Distance from query to the nearest point of the box [start, end].
+  template <dimension_t DIMENSION>
+  double to_box(const data_point<DIMENSION> &query,
+                const data_point<DIMENSION> &start,
+                const data_point<DIMENSION> &end) const
+  {
+    double total = 0;
+    for (dimension_t i = 0; i < DIMENSION; i++)
+    {
+      point_t q = query.get_coordinate(i);
+      if (q < start.get_coordinate(i))
+        total += term(i, start.get_coordinate(i) - q);
+      else if (q > end.get_coordinate(i))
+        total += term(i, q - end.get_coordinate(i));
+    }
+    return total;
+  }
+
+  inline double report(double distance) const
+  {
+    return metric_ == KNN_L2 ? std::sqrt(distance) : distance;
+  }
+
+  knn_metric metric_;
+  std::vector<double> weights_;
+};
+
+template <dimension_t DIMENSION>
+struct knn_neighbor
+{
+  double distance_;
+  n_leaves_t primary_key_;
+  data_point<DIMENSION> point_;
+};
+
+/**
+ * knn_candidate: an entry of the queue md_trie::knn_search expands in order
+ * of distance. It is a trie node (trie_node_ set), a treeblock node (block_
+ * set, positioned like the arguments of tree_block::child), or a point
+ * stored under primary_key_ (neither set). start_range_ and end_range_ bound
+ * the points below it; for a point, start_range_ is the point. distance_ is
+ * the (unreported) distance from the query to that box.
+ */
+template <dimension_t DIMENSION>
+struct knn_candidate
+{
+  double distance_;
+  trie_node<DIMENSION> *trie_node_ = nullptr;
+  tree_block<DIMENSION> *block_ = nullptr;
+  preorder_t node_ = 0;
+  preorder_t node_pos_ = 0;
+  preorder_t frontier_ = 0;
+  preorder_t primary_ = 0;
+  level_t level_ = 0;
+  n_leaves_t primary_key_ = 0;
+  data_point<DIMENSION> start_range_;
+  data_point<DIMENSION> end_range_;
+
+  static bool farther(const knn_candidate &a, const knn_candidate &b)
+  {
+    return a.distance_ > b.distance_;
+  }
+
+  // heap is a min-heap by distance_.
+  static void push(std::vector<knn_candidate> &heap, knn_candidate &&candidate)
+  {
+    heap.push_back(std::move(candidate));
+    std::push_heap(heap.begin(), heap.end(), farther);
+  }
+
+  static knn_candidate pop(std::vector<knn_candidate> &heap)
+  {
+    std::pop_heap(heap.begin(), heap.end(), farther);
+    knn_candidate candidate = std::move(heap.back());
+    heap.pop_back();
+    return candidate;
+  }
+};
+
+#endif // MD_TRIE_KNN_H
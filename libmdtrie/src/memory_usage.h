@@ -0,0 +1,71 @@
+#ifndef MD_TRIE_MEMORY_USAGE_H
+#define MD_TRIE_MEMORY_USAGE_H
+
+#include <cstdint>
+
+/**
+ * memory_component: the parts of a trie whose memory md_trie accounts for
+ * separately. Allocated capacity is counted rather than the part in use:
+ * DFUDS words held in reserve, spare vector slots and so on.
+ */
+enum memory_component : int32_t
+{
+  // trie_node objects and their child arrays.
+  MEMORY_TRIE_NODES = 0,
+  // tree_block objects and the compressed_bitmap object of their DFUDS.
+  MEMORY_TREEBLOCKS = 1,
+  MEMORY_DFUDS_DATA = 2,
+  MEMORY_DFUDS_FLAG = 3,
+  MEMORY_FRONTIERS = 4,
+  // Primary key list slots, and the key lists of points sharing a leaf.
+  MEMORY_PRIMARY_KEY_LISTS = 5,
+  MEMORY_LOOKUP_INDEX = 6,
+  // The primary key to treeblock map (a CompactPtrVector).
+  MEMORY_PRIMARY_KEY_MAP = 7,
+  MEMORY_SUBTREE_DIRECTORY = 8,
+  num_memory_components = 9,
+};
+
+static const char *const memory_component_names[num_memory_components] = {
+    "trie_nodes",
+    "treeblocks",
+    "dfuds_data",
+    "dfuds_flag",
+    "frontiers",
+    "primary_key_lists",
+    "lookup_index",
+    "primary_key_map",
+    "subtree_directory",
+};
+
+/**
+ * memory_usage: bytes held per memory_component. Owners add the change in
+ * their footprint as they allocate, grow, shrink and free, so reading the
+ * totals is cheap at any time, also while inserters run (updates are
+ * relaxed atomics; a read may miss the ones in flight).
+ */
+struct memory_usage
+{
+  int64_t bytes_[num_memory_components] = {};
+
+  inline void add(memory_component component, int64_t delta)
+  {
+    if (delta)
+      __atomic_fetch_add(&bytes_[component], delta, __ATOMIC_RELAXED);
+  }
+
+  inline int64_t get(memory_component component) const
+  {
+    return __atomic_load_n(&bytes_[component], __ATOMIC_RELAXED);
+  }
+
+  int64_t total() const
+  {
+    int64_t total = 0;
+    for (int32_t c = 0; c < num_memory_components; c++)
+      total += get((memory_component)c);
+    return total;
+  }
+};
+
+#endif // MD_TRIE_MEMORY_USAGE_H
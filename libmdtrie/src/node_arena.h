@@ -0,0 +1,342 @@
+#ifndef MD_TRIE_NODE_ARENA_H
+#define MD_TRIE_NODE_ARENA_H
+
+#include "memory_usage.h"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <utility>
+#include <vector>
+
+/**
+ * node_arena_stats: how the memory of a node_arena is used. Slab bytes are
+ * either live (handed out, rounded up to their size class), on a free list
+ * (handed back, waiting to be reused) or not yet carved out of a slab.
+ * requested_bytes_ is what callers asked for, so live - requested is lost to
+ * rounding. Allocations too large for a size class are counted apart.
+ */
+struct node_arena_stats
+{
+  uint64_t slab_bytes_ = 0;
+  uint64_t live_bytes_ = 0;
+  uint64_t requested_bytes_ = 0;
+  uint64_t free_list_bytes_ = 0;
+  uint64_t live_objects_ = 0;
+  uint64_t large_bytes_ = 0;
+  uint64_t large_objects_ = 0;
+
+  // Share of the slab bytes not holding a live object.
+  double fragmentation() const
+  {
+    return slab_bytes_ ? 1 - (double)live_bytes_ / slab_bytes_ : 0;
+  }
+
+  // Share of the live bytes lost to size class rounding.
+  double rounding_overhead() const
+  {
+    return live_bytes_ ? 1 - (double)requested_bytes_ / live_bytes_ : 0;
+  }
+};
+
+/**
+ * node_arena: a slab allocator for everything one md_trie holds: its trie
+ * nodes and their child arrays, treeblocks with their bitmaps, frontier
+ * arrays, primary key lists, lookup indexes and subtree directories.
+ * Requests are rounded up to a multiple of granularity; each of those size
+ * classes carves its objects out of its own slabs and keeps the ones handed
+ * back on a free list for reuse, so the heap sees one allocation per slab
+ * rather than per object.
+ * Requests above max_class_size go to malloc, threaded on a list so they can
+ * still be released in bulk. Each size class has its own spin lock, so
+ * concurrent inserters only contend when allocating objects of the same size.
+ *
+ * release_all hands every slab and large allocation back to the heap at once
+ * without running destructors, so a trie is torn down without being walked.
+ * The few objects that own heap memory of their own are made with
+ * create_owned, whose destructors release_all does run.
+ *
+ * The arena also carries the trie's memory_usage, as everything that keeps
+ * it up to date (treeblocks, their bitmaps, md_trie) can reach the arena.
+ */
+class node_arena
+{
+public:
+  static const size_t granularity = 16;
+  static const size_t max_class_size = 1024;
+  static const size_t slab_size = 64 * 1024;
+
+  node_arena() = default;
+  node_arena(const node_arena &) = delete;
+  node_arena &operator=(const node_arena &) = delete;
+
+  ~node_arena() { release_all(); }
+
+  void *allocate(size_t bytes)
+  {
+    if (bytes > max_class_size)
+      return allocate_large(bytes);
+
+    size_class &sc = classes_[class_of(bytes)];
+    size_t rounded = (class_of(bytes) + 1) * granularity;
+    lock(sc.lock_);
+    void *p = sc.free_list_;
+    if (p)
+    {
+      memcpy(&sc.free_list_, p, sizeof(void *));
+      sc.free_objects_--;
+    }
+    else
+    {
+      if (sc.bump_ + rounded > sc.bump_end_)
+      {
+        sc.bump_ = (char *)new_slab();
+        sc.bump_end_ = sc.bump_ + slab_size;
+      }
+      p = sc.bump_;
+      sc.bump_ += rounded;
+    }
+    sc.live_objects_++;
+    sc.requested_bytes_ += bytes;
+    unlock(sc.lock_);
+    return p;
+  }
+
+  // bytes must be what p was allocated (or last reallocated) with.
+  void release(void *p, size_t bytes)
+  {
+    if (!p)
+      return;
+    if (bytes > max_class_size)
+    {
+      release_large(p);
+      return;
+    }
+
+    size_class &sc = classes_[class_of(bytes)];
+    lock(sc.lock_);
+    memcpy(p, &sc.free_list_, sizeof(void *));
+    sc.free_list_ = p;
+    sc.free_objects_++;
+    sc.live_objects_--;
+    sc.requested_bytes_ -= bytes;
+    unlock(sc.lock_);
+  }
+
+  // Like realloc; p (or nullptr) was allocated with old_bytes.
+  void *reallocate(void *p, size_t old_bytes, size_t new_bytes)
+  {
+    if (p && old_bytes <= max_class_size && new_bytes <= max_class_size &&
+        class_of(old_bytes) == class_of(new_bytes))
+    {
+      size_class &sc = classes_[class_of(old_bytes)];
+      lock(sc.lock_);
+      sc.requested_bytes_ += new_bytes - old_bytes;
+      unlock(sc.lock_);
+      return p;
+    }
+    void *q = new_bytes ? allocate(new_bytes) : nullptr;
+    if (p && q)
+      memcpy(q, p, old_bytes < new_bytes ? old_bytes : new_bytes);
+    release(p, old_bytes);
+    return q;
+  }
+
+  template <typename T, typename... Args>
+  T *create(Args &&...args)
+  {
+    return new (allocate(sizeof(T))) T(std::forward<Args>(args)...);
+  }
+
+  template <typename T>
+  void destroy(T *object)
+  {
+    if (!object)
+      return;
+    object->~T();
+    release(object, sizeof(T));
+  }
+
+  // An object destroyed by release_all if it is still live then, for the
+  // rare ones owning memory outside the arena. Freed by destroy_owned.
+  template <typename T, typename... Args>
+  T *create_owned(Args &&...args)
+  {
+    void *p = allocate_large(sizeof(T), [](void *object)
+                             { ((T *)object)->~T(); });
+    return new (p) T(std::forward<Args>(args)...);
+  }
+
+  template <typename T>
+  void destroy_owned(T *object)
+  {
+    object->~T();
+    release_large(object);
+  }
+
+  // The calls below go to arena, or to the heap when it is nullptr, for
+  // structures that also live outside a trie's arena (in a snapshot image
+  // or a trie opened from one).
+  static inline void *allocate_in(node_arena *arena, size_t bytes)
+  {
+    return arena ? arena->allocate(bytes) : malloc(bytes);
+  }
+
+  static inline void *reallocate_in(node_arena *arena,
+                                    void *p,
+                                    size_t old_bytes,
+                                    size_t new_bytes)
+  {
+    return arena ? arena->reallocate(p, old_bytes, new_bytes)
+                 : realloc(p, new_bytes);
+  }
+
+  static inline void release_in(node_arena *arena, void *p, size_t bytes)
+  {
+    if (arena)
+      arena->release(p, bytes);
+    else
+      free(p);
+  }
+
+  // Frees every slab and large allocation, live or not, after destroying
+  // the objects made by create_owned that are still live.
+  void release_all()
+  {
+    for (void *slab : slabs_)
+      free(slab);
+    slabs_.clear();
+    while (large_)
+    {
+      large_header *next = large_->next_;
+      if (large_->destroy_)
+        large_->destroy_(large_ + 1);
+      free(large_);
+      large_ = next;
+    }
+    large_bytes_ = 0;
+    large_objects_ = 0;
+    for (size_class &sc : classes_)
+      sc = size_class();
+    usage_ = memory_usage();
+  }
+
+  inline memory_usage &usage() { return usage_; }
+
+  node_arena_stats stats()
+  {
+    node_arena_stats stats;
+    lock(arena_lock_);
+    stats.slab_bytes_ = slabs_.size() * slab_size;
+    stats.large_bytes_ = large_bytes_;
+    stats.large_objects_ = large_objects_;
+    unlock(arena_lock_);
+    for (size_t c = 0; c < num_classes; c++)
+    {
+      size_class &sc = classes_[c];
+      lock(sc.lock_);
+      stats.live_objects_ += sc.live_objects_;
+      stats.live_bytes_ += sc.live_objects_ * (c + 1) * granularity;
+      stats.requested_bytes_ += sc.requested_bytes_;
+      stats.free_list_bytes_ += sc.free_objects_ * (c + 1) * granularity;
+      unlock(sc.lock_);
+    }
+    return stats;
+  }
+
+private:
+  static const size_t num_classes = max_class_size / granularity;
+
+  struct size_class
+  {
+    bool lock_ = false;
+    void *free_list_ = nullptr;
+    char *bump_ = nullptr;
+    char *bump_end_ = nullptr;
+    uint64_t live_objects_ = 0;
+    uint64_t free_objects_ = 0;
+    uint64_t requested_bytes_ = 0;
+  };
+
+  // Precedes every large allocation; 16 bytes, so the payload stays aligned.
+  struct large_header
+  {
+    large_header *prev_;
+    large_header *next_;
+    size_t bytes_;
+    // Set for objects made by create_owned.
+    void (*destroy_)(void *);
+  };
+
+  static inline size_t class_of(size_t bytes)
+  {
+    return bytes ? (bytes - 1) / granularity : 0;
+  }
+
+  static inline void lock(bool &flag)
+  {
+    while (__atomic_test_and_set(&flag, __ATOMIC_ACQUIRE))
+      ;
+  }
+
+  static inline void unlock(bool &flag)
+  {
+    __atomic_clear(&flag, __ATOMIC_RELEASE);
+  }
+
+  void *new_slab()
+  {
+    void *slab = malloc(slab_size);
+    if (!slab)
+      throw std::bad_alloc();
+    lock(arena_lock_);
+    slabs_.push_back(slab);
+    unlock(arena_lock_);
+    return slab;
+  }
+
+  void *allocate_large(size_t bytes, void (*destroy)(void *) = nullptr)
+  {
+    auto *header = (large_header *)malloc(sizeof(large_header) + bytes);
+    if (!header)
+      throw std::bad_alloc();
+    header->bytes_ = bytes;
+    header->destroy_ = destroy;
+    header->prev_ = nullptr;
+    lock(arena_lock_);
+    header->next_ = large_;
+    if (large_)
+      large_->prev_ = header;
+    large_ = header;
+    large_bytes_ += bytes;
+    large_objects_++;
+    unlock(arena_lock_);
+    return header + 1;
+  }
+
+  void release_large(void *p)
+  {
+    large_header *header = (large_header *)p - 1;
+    lock(arena_lock_);
+    if (header->prev_)
+      header->prev_->next_ = header->next_;
+    else
+      large_ = header->next_;
+    if (header->next_)
+      header->next_->prev_ = header->prev_;
+    large_bytes_ -= header->bytes_;
+    large_objects_--;
+    unlock(arena_lock_);
+    free(header);
+  }
+
+  size_class classes_[num_classes];
+  bool arena_lock_ = false;
+  std::vector<void *> slabs_;
+  large_header *large_ = nullptr;
+  uint64_t large_bytes_ = 0;
+  uint64_t large_objects_ = 0;
+  memory_usage usage_;
+};
+
+#endif // MD_TRIE_NODE_ARENA_H
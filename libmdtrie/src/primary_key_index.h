@@ -0,0 +1,237 @@
+#ifndef MD_TRIE_PRIMARY_KEY_INDEX_H
+#define MD_TRIE_PRIMARY_KEY_INDEX_H
+
+#include "defs.h"
+#include "node_arena.h"
+#include <algorithm>
+#include <cstdlib>
+
+/**
+ * primary_key_index: lets a treeblock resolve a primary key to its point
+ * without scanning its DFUDS (see tree_block::lookup_index). It has three
+ * tables, laid out right after the header in one allocation:
+ *  - the keys stored in the block, sorted, each with the ordinal of the
+ *    primary_key_list entry (leaf) holding it;
+ *  - a select directory over the leaf-level nodes: the ordinal of the first
+ *    leaf of each one, with the node's preorder and bit position, so a
+ *    leaf's node is one binary search away;
+ *  - for every node, its parent's preorder and the symbol leading to it,
+ *    so a node's path is read off by climbing to the root.
+ *
+ * The index is allocated from the block's node_arena if it has one, with
+ * room to spare in each table, and inserts into the block update the
+ * tables in place (see record_key and the others); the block drops the
+ * index when it splits, merges or deletes, to rebuild it on the next
+ * lookup.
+ */
+struct primary_key_index
+{
+  uint32_t num_keys_;
+  uint32_t num_nodes_;
+  uint32_t num_leaf_nodes_;
+  uint32_t key_capacity_;
+  uint32_t node_capacity_;
+  uint32_t leaf_node_capacity_;
+
+  // Room given to a table of n entries, so that inserts fill it in place.
+  static inline uint32_t capacity_for(uint32_t n) { return n + n / 8 + 4; }
+
+  static size_t alloc_size(uint32_t key_capacity,
+                           uint32_t node_capacity,
+                           uint32_t leaf_node_capacity)
+  {
+    return sizeof(primary_key_index) + key_capacity * sizeof(n_leaves_t) +
+           (key_capacity + 2 * node_capacity + 3 * leaf_node_capacity) *
+               sizeof(uint32_t);
+  }
+
+  static primary_key_index *create(uint32_t num_keys,
+                                   uint32_t num_nodes,
+                                   uint32_t num_leaf_nodes,
+                                   node_arena *arena)
+  {
+    uint32_t key_capacity = capacity_for(num_keys);
+    uint32_t node_capacity = capacity_for(num_nodes);
+    uint32_t leaf_node_capacity = capacity_for(num_leaf_nodes);
+    auto *index = (primary_key_index *)node_arena::allocate_in(
+        arena, alloc_size(key_capacity, node_capacity, leaf_node_capacity));
+    index->num_keys_ = num_keys;
+    index->num_nodes_ = num_nodes;
+    index->num_leaf_nodes_ = num_leaf_nodes;
+    index->key_capacity_ = key_capacity;
+    index->node_capacity_ = node_capacity;
+    index->leaf_node_capacity_ = leaf_node_capacity;
+    return index;
+  }
+
+  // Returns index if it has room for keys more keys, nodes more nodes and
+  // leaf_nodes more leaf-level nodes; otherwise frees it and returns a
+  // larger copy.
+  static primary_key_index *reserve(primary_key_index *index,
+                                    uint32_t keys,
+                                    uint32_t nodes,
+                                    uint32_t leaf_nodes,
+                                    node_arena *arena)
+  {
+    if (index->num_keys_ + keys <= index->key_capacity_ &&
+        index->num_nodes_ + nodes <= index->node_capacity_ &&
+        index->num_leaf_nodes_ + leaf_nodes <= index->leaf_node_capacity_)
+      return index;
+    auto *grown = create(index->num_keys_ + keys,
+                         index->num_nodes_ + nodes,
+                         index->num_leaf_nodes_ + leaf_nodes,
+                         arena);
+    grown->num_keys_ = index->num_keys_;
+    grown->num_nodes_ = index->num_nodes_;
+    grown->num_leaf_nodes_ = index->num_leaf_nodes_;
+    std::copy_n(index->keys(), index->num_keys_, grown->keys());
+    std::copy_n(index->key_leaves(), index->num_keys_, grown->key_leaves());
+    std::copy_n(index->node_parents(), index->num_nodes_, grown->node_parents());
+    std::copy_n(index->node_symbols(), index->num_nodes_, grown->node_symbols());
+    std::copy_n(index->leaf_node_first_leaves(),
+                index->num_leaf_nodes_,
+                grown->leaf_node_first_leaves());
+    std::copy_n(index->leaf_node_preorders(),
+                index->num_leaf_nodes_,
+                grown->leaf_node_preorders());
+    std::copy_n(index->leaf_node_positions(),
+                index->num_leaf_nodes_,
+                grown->leaf_node_positions());
+    release(index, arena);
+    return grown;
+  }
+
+  static void release(primary_key_index *index, node_arena *arena)
+  {
+    if (index)
+      node_arena::release_in(arena, index, index->size());
+  }
+
+  inline size_t size() const
+  {
+    return alloc_size(key_capacity_, node_capacity_, leaf_node_capacity_);
+  }
+
+  inline n_leaves_t *keys() { return (n_leaves_t *)(this + 1); }
+
+  inline uint32_t *key_leaves() { return (uint32_t *)(keys() + key_capacity_); }
+
+  inline uint32_t *node_parents() { return key_leaves() + key_capacity_; }
+
+  inline uint32_t *node_symbols() { return node_parents() + node_capacity_; }
+
+  inline uint32_t *leaf_node_first_leaves()
+  {
+    return node_symbols() + node_capacity_;
+  }
+
+  inline uint32_t *leaf_node_preorders()
+  {
+    return leaf_node_first_leaves() + leaf_node_capacity_;
+  }
+
+  inline uint32_t *leaf_node_positions()
+  {
+    return leaf_node_preorders() + leaf_node_capacity_;
+  }
+
+  // The updates below keep the index exact as a point is inserted into the
+  // block (see tree_block::insert); each assumes reserve made room for it.
+
+  // Adds primary_key, stored at leaf.
+  void record_key(n_leaves_t primary_key, uint32_t leaf)
+  {
+    uint32_t at =
+        std::lower_bound(keys(), keys() + num_keys_, primary_key) - keys();
+    std::copy_backward(
+        keys() + at, keys() + num_keys_, keys() + num_keys_ + 1);
+    std::copy_backward(key_leaves() + at,
+                       key_leaves() + num_keys_,
+                       key_leaves() + num_keys_ + 1);
+    keys()[at] = primary_key;
+    key_leaves()[at] = leaf;
+    num_keys_++;
+  }
+
+  // Accounts for bits added to the nodes at preorder from and after.
+  void record_bits(preorder_t from, int64_t bits)
+  {
+    for (uint32_t i = 0; i < num_leaf_nodes_; i++)
+      if (leaf_node_preorders()[i] >= from)
+        leaf_node_positions()[i] += bits;
+  }
+
+  // Accounts for a leaf added at ordinal leaf, before the leaves of the
+  // leaf-level nodes at preorder from and after.
+  void record_leaf(uint32_t leaf, preorder_t from)
+  {
+    for (uint32_t i = 0; i < num_keys_; i++)
+      if (key_leaves()[i] >= leaf)
+        key_leaves()[i]++;
+    for (uint32_t i = 0; i < num_leaf_nodes_; i++)
+      if (leaf_node_preorders()[i] >= from)
+        leaf_node_first_leaves()[i]++;
+  }
+
+  // Accounts for a path of count nodes added at preorder at below parent,
+  // taking bits bits, whose last node is a leaf-level node at position
+  // leaf_node_pos with its one leaf at ordinal leaf. The symbols leading
+  // to the new nodes are left for the caller to fill in.
+  void record_path(preorder_t parent,
+                   preorder_t at,
+                   uint32_t count,
+                   node_pos_t bits,
+                   node_pos_t leaf_node_pos,
+                   uint32_t leaf)
+  {
+    record_bits(at, bits);
+    record_leaf(leaf, at);
+    for (uint32_t i = 0; i < num_nodes_; i++)
+      if (node_parents()[i] >= at)
+        node_parents()[i] += count;
+    std::copy_backward(node_parents() + at,
+                       node_parents() + num_nodes_,
+                       node_parents() + num_nodes_ + count);
+    std::copy_backward(node_symbols() + at,
+                       node_symbols() + num_nodes_,
+                       node_symbols() + num_nodes_ + count);
+    for (uint32_t i = 0; i < count; i++)
+      node_parents()[at + i] = i == 0 ? parent : at + i - 1;
+    num_nodes_ += count;
+
+    uint32_t *preorders = leaf_node_preorders();
+    uint32_t entry =
+        std::lower_bound(preorders, preorders + num_leaf_nodes_, at) -
+        preorders;
+    for (uint32_t i = entry; i < num_leaf_nodes_; i++)
+      preorders[i] += count;
+    uint32_t *tables[3] = {
+        leaf_node_first_leaves(), preorders, leaf_node_positions()};
+    for (uint32_t *table : tables)
+      std::copy_backward(
+          table + entry, table + num_leaf_nodes_, table + num_leaf_nodes_ + 1);
+    leaf_node_first_leaves()[entry] = leaf;
+    preorders[entry] = at + count - 1;
+    leaf_node_positions()[entry] = leaf_node_pos;
+    num_leaf_nodes_++;
+  }
+
+  // Ordinal of the leaf holding primary_key, or -1 if it is not stored.
+  inline n_leaves_t find_leaf(n_leaves_t primary_key)
+  {
+    n_leaves_t *end = keys() + num_keys_;
+    n_leaves_t *it = std::lower_bound(keys(), end, primary_key);
+    if (it == end || *it != primary_key)
+      return (n_leaves_t)-1;
+    return key_leaves()[it - keys()];
+  }
+
+  // Index into the leaf_node_* tables of the leaf-level node holding leaf.
+  inline uint32_t find_leaf_node(n_leaves_t leaf)
+  {
+    uint32_t *first = leaf_node_first_leaves();
+    return std::upper_bound(first, first + num_leaf_nodes_, leaf) - first - 1;
+  }
+};
+
+#endif // MD_TRIE_PRIMARY_KEY_INDEX_H
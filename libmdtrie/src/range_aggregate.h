@@ -0,0 +1,63 @@
+#ifndef MD_TRIE_RANGE_AGGREGATE_H
+#define MD_TRIE_RANGE_AGGREGATE_H
+
+#include "data_point.h"
+#include "defs.h"
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <vector>
+
+/**
+ * range_aggregate: COUNT over the matches of a range search, and SUM, MIN and
+ * MAX of the coordinates in each of dimensions_ (all below the points'
+ * DIMENSION). Matches are counted the way range search reports them, once per
+ * primary key. Aggregates of disjoint parts of a result (e.g. of different
+ * shards) combine with merge.
+ */
+struct range_aggregate
+{
+  explicit range_aggregate(const std::vector<dimension_t> &dimensions = {})
+      : dimensions_(dimensions),
+        sum_(dimensions.size(), 0),
+        min_(dimensions.size(), std::numeric_limits<point_t>::max()),
+        max_(dimensions.size(), 0)
+  {
+  }
+
+  template <dimension_t DIMENSION>
+  inline void add(const data_point<DIMENSION> &point)
+  {
+    count_++;
+    for (size_t i = 0; i < dimensions_.size(); i++)
+    {
+      assert(dimensions_[i] < DIMENSION);
+      point_t coordinate = point.get_coordinate(dimensions_[i]);
+      sum_[i] += coordinate;
+      min_[i] = std::min(min_[i], coordinate);
+      max_[i] = std::max(max_[i], coordinate);
+    }
+  }
+
+  // Folds in an aggregate over the same dimensions.
+  void merge(const range_aggregate &other)
+  {
+    count_ += other.count_;
+    for (size_t i = 0; i < dimensions_.size(); i++)
+    {
+      sum_[i] += other.sum_[i];
+      min_[i] = std::min(min_[i], other.min_[i]);
+      max_[i] = std::max(max_[i], other.max_[i]);
+    }
+  }
+
+  n_leaves_t count_ = 0;
+  std::vector<dimension_t> dimensions_;
+  // Per entry of dimensions_; min_ and max_ are meaningless while count_ is
+  // 0.
+  std::vector<point_t> sum_;
+  std::vector<point_t> min_;
+  std::vector<point_t> max_;
+};
+
+#endif // MD_TRIE_RANGE_AGGREGATE_H
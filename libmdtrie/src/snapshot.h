@@ -0,0 +1,197 @@
+#ifndef MD_TRIE_SNAPSHOT_H
+#define MD_TRIE_SNAPSHOT_H
+
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Snapshot files hold an image of a trie (trie nodes, treeblocks with their
+ * DFUDS bitmaps, frontiers and primary key lists, the schema and the primary
+ * key to treeblock map) that md_trie::open_mmap maps back and searches in
+ * place. Every object sits at a file offset, and every pointer to it is
+ * written as base_address_ + that offset; mapping the file at base_address_
+ * makes all of them valid at once, so reopening costs no relocation or
+ * deserialization pass regardless of the trie size.
+ */
+
+const uint64_t snapshot_magic = 0x4e5345495254444dULL; // "MDTRIESN"
+const uint64_t snapshot_version = 8;
+
+// Where md_trie::save places an image by default: well clear of the heap,
+// shared libraries and the stack on x86-64 Linux, and below the 2^48 reach
+// of compact pointers. Tries saved to be opened in the same process need
+// distinct base addresses.
+const uintptr_t snapshot_base_address = 0x500000000000ULL;
+
+struct snapshot_header
+{
+  uint64_t magic_;
+  uint64_t version_;
+  uint64_t base_address_;
+  uint64_t file_size_;
+  uint64_t dimension_;
+  // Image addresses of the schema, the root trie node and the words of the
+  // primary key to treeblock map.
+  uint64_t schema_;
+  uint64_t root_;
+  uint64_t primary_key_map_;
+  uint64_t primary_key_map_elements_;
+};
+
+/**
+ * snapshot_writer: hands out space in a snapshot file being written. Space
+ * comes in 16-byte aligned chunks, as compact pointers drop the low four bits
+ * of an address, from a shared mapping of the file that grows by doubling.
+ * Objects are addressed by offset while the image is built, since growing may
+ * move the mapping.
+ */
+class snapshot_writer
+{
+public:
+  explicit snapshot_writer(uintptr_t base_address)
+      : base_address_(base_address)
+  {
+  }
+
+  ~snapshot_writer()
+  {
+    if (image_)
+      munmap(image_, capacity_);
+    if (fd_ >= 0)
+      ::close(fd_);
+  }
+
+  bool open(const std::string &path)
+  {
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0)
+      return false;
+    return grow(initial_capacity);
+  }
+
+  // Truncates the file to the space handed out and unmaps it.
+  bool close()
+  {
+    bool ok = msync(image_, size_, MS_SYNC) == 0;
+    munmap(image_, capacity_);
+    image_ = nullptr;
+    ok = ftruncate(fd_, size_) == 0 && ok;
+    ok = ::close(fd_) == 0 && ok;
+    fd_ = -1;
+    return ok;
+  }
+
+  inline bool failed() const { return failed_; }
+
+  inline uint64_t size() const { return size_; }
+
+  inline uintptr_t address(uint64_t offset) const
+  {
+    return base_address_ + offset;
+  }
+
+  // Writable view of the image at offset; only valid until the next
+  // allocate.
+  inline void *at(uint64_t offset) { return (char *)image_ + offset; }
+
+  uint64_t allocate(uint64_t bytes)
+  {
+    uint64_t offset = size_;
+    uint64_t end = offset + ((bytes + 15) & ~15ULL);
+    if (end > capacity_)
+    {
+      uint64_t capacity = capacity_;
+      while (capacity < end)
+        capacity *= 2;
+      if (!grow(capacity))
+      {
+        // Keep handing out offsets so callers can unwind; nothing more is
+        // written and the save reports failure.
+        failed_ = true;
+        size_ = end;
+        return 0;
+      }
+    }
+    size_ = end;
+    return offset;
+  }
+
+  void write(uint64_t offset, const void *src, uint64_t bytes)
+  {
+    if (!failed_ && bytes)
+      memcpy(at(offset), src, bytes);
+  }
+
+  // Copies bytes into fresh space and returns their image address.
+  uintptr_t append(const void *src, uint64_t bytes)
+  {
+    uint64_t offset = allocate(bytes);
+    write(offset, src, bytes);
+    return address(offset);
+  }
+
+  // Points the std::vector<T> object at slot (a raw copy of one, never to be
+  // destroyed) at n elements stored at image address data. Relies on the
+  // begin / end / end of storage layout shared by libstdc++ and libc++.
+  template <typename T>
+  static void set_vector(void *slot, uintptr_t data, uint64_t n)
+  {
+    static_assert(sizeof(std::vector<T>) == 3 * sizeof(T *),
+                  "unexpected std::vector layout");
+    uintptr_t words[3] = {data, data + n * sizeof(T), data + n * sizeof(T)};
+    if (!n)
+      words[0] = words[1] = words[2] = 0;
+    memcpy(slot, words, sizeof(words));
+  }
+
+  // Appends elements and a std::vector<T> object over them; returns the
+  // object's image address.
+  template <typename T>
+  uintptr_t append_vector(const T *elements, uint64_t n)
+  {
+    uintptr_t data = n ? append(elements, n * sizeof(T)) : 0;
+    alignas(std::vector<T>) unsigned char slot[sizeof(std::vector<T>)];
+    set_vector<T>(slot, data, n);
+    return append(slot, sizeof(slot));
+  }
+
+  // Image addresses of the schema every block and bitmap points to, and of
+  // the treeblocks written so far (for the primary key map).
+  uintptr_t schema_address_ = 0;
+  std::unordered_map<const void *, uintptr_t> block_address_;
+
+private:
+  static const uint64_t initial_capacity = 1ULL << 24;
+
+  bool grow(uint64_t capacity)
+  {
+    if (ftruncate(fd_, capacity) != 0)
+      return false;
+    void *image;
+    if (image_)
+      image = mremap(image_, capacity_, capacity, MREMAP_MAYMOVE);
+    else
+      image = mmap(
+          nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (image == MAP_FAILED)
+      return false;
+    image_ = image;
+    capacity_ = capacity;
+    return true;
+  }
+
+  uintptr_t base_address_;
+  int fd_ = -1;
+  void *image_ = nullptr;
+  uint64_t size_ = 0;
+  uint64_t capacity_ = 0;
+  bool failed_ = false;
+};
+
+#endif // MD_TRIE_SNAPSHOT_H
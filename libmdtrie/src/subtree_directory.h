@@ -0,0 +1,103 @@
+#ifndef MD_TRIE_SUBTREE_DIRECTORY_H
+#define MD_TRIE_SUBTREE_DIRECTORY_H
+
+#include "defs.h"
+#include "node_arena.h"
+#include <algorithm>
+#include <cstdlib>
+
+// A subtree of a treeblock: its root's preorder and what it spans.
+struct subtree_entry
+{
+  uint32_t node_;
+  uint32_t num_nodes_;
+  uint32_t num_bits_;
+  uint32_t num_frontiers_;
+  uint32_t num_primary_;
+};
+
+/**
+ * subtree_directory: lets tree_block::skip_children_subtree jump over the
+ * subtrees it has to pass instead of walking them node by node. It lists, in
+ * preorder, the nodes of a block that root at least min_nodes nodes and whose
+ * parent has more than one child (the only subtrees ever skipped whole), each
+ * with the nodes, DFUDS bits, frontiers and primary key list entries under
+ * it. A skip then walks at most about min_nodes nodes per child it passes.
+ *
+ * Entries stay exact as points are inserted (see record_insert); subtrees
+ * that grow past min_nodes are only listed once the directory is rebuilt,
+ * which stale() asks for after enough insertions.
+ */
+struct subtree_directory
+{
+  static const uint32_t min_nodes = 32;
+
+  uint32_t num_entries_;
+  uint32_t built_nodes_;
+  uint32_t inserted_nodes_;
+  uint32_t unused_;
+
+  static size_t alloc_size(uint32_t num_entries)
+  {
+    return sizeof(subtree_directory) + num_entries * sizeof(subtree_entry);
+  }
+
+  static subtree_directory *create(uint32_t num_entries,
+                                   uint32_t num_nodes,
+                                   node_arena *arena)
+  {
+    auto *directory =
+        (subtree_directory *)arena->allocate(alloc_size(num_entries));
+    directory->num_entries_ = num_entries;
+    directory->built_nodes_ = num_nodes;
+    directory->inserted_nodes_ = 0;
+    directory->unused_ = 0;
+    return directory;
+  }
+
+  inline size_t size() const { return alloc_size(num_entries_); }
+
+  inline subtree_entry *entries() { return (subtree_entry *)(this + 1); }
+
+  // Index of the first entry rooted at or after node.
+  inline uint32_t lower_bound(preorder_t node)
+  {
+    return std::lower_bound(entries(),
+                            entries() + num_entries_,
+                            node,
+                            [](const subtree_entry &entry, preorder_t node)
+                            { return entry.node_ < node; }) -
+           entries();
+  }
+
+  // Accounts for an insertion below node (before it, in preorder): nodes
+  // added at preorder at, and bits and primary key list entries added to
+  // node's subtree.
+  void record_insert(preorder_t node,
+                     preorder_t at,
+                     preorder_t nodes,
+                     node_pos_t bits,
+                     n_leaves_t primary)
+  {
+    subtree_entry *entry = entries();
+    for (uint32_t i = 0; i < num_entries_; i++, entry++)
+    {
+      if (entry->node_ <= node && node < entry->node_ + entry->num_nodes_)
+      {
+        entry->num_nodes_ += nodes;
+        entry->num_bits_ += bits;
+        entry->num_primary_ += primary;
+      }
+      else if (entry->node_ >= at)
+        entry->node_ += nodes;
+    }
+    inserted_nodes_ += nodes;
+  }
+
+  inline bool stale() const
+  {
+    return inserted_nodes_ > built_nodes_ / 2 + min_nodes;
+  }
+};
+
+#endif // MD_TRIE_SUBTREE_DIRECTORY_H
@@ -0,0 +1,185 @@
+#ifndef MD_TRIE_THREAD_POOL_H
+#define MD_TRIE_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * work_stealing_pool: a fixed set of workers, each with its own task deque.
+ * A worker pushes and pops at the back of its own deque and, when that runs
+ * dry, steals from the front of the others'. Tasks submitted from outside the
+ * pool are spread round-robin over the deques.
+ */
+
+class work_stealing_pool
+{
+public:
+  explicit work_stealing_pool(unsigned int num_threads)
+      : queues_(num_threads == 0 ? 1 : num_threads)
+  {
+    for (unsigned int i = 0; i < queues_.size(); i++)
+    {
+      workers_.emplace_back([this, i]() { worker_loop(i); });
+    }
+  }
+
+  ~work_stealing_pool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(idle_lock_);
+      stopping_ = true;
+    }
+    idle_cv_.notify_all();
+    for (auto &worker : workers_)
+      worker.join();
+  }
+
+  unsigned int num_threads() const { return queues_.size(); }
+
+  void submit(std::function<void()> task)
+  {
+    unsigned int target;
+    if (current_pool_ == this)
+      target = current_index_;
+    else
+      target = next_queue_.fetch_add(1, std::memory_order_relaxed) %
+               queues_.size();
+    {
+      std::lock_guard<std::mutex> lock(queues_[target].lock_);
+      queues_[target].tasks_.push_back(std::move(task));
+    }
+    num_queued_.fetch_add(1, std::memory_order_release);
+    {
+      // Pairs with the predicate check in worker_loop so the wakeup is not
+      // lost between that check and the wait.
+      std::lock_guard<std::mutex> lock(idle_lock_);
+    }
+    idle_cv_.notify_one();
+  }
+
+  // Runs one queued task on the calling thread, if there is any. Lets a thread
+  // that waits on its tasks help with them instead of blocking.
+  bool run_one()
+  {
+    std::function<void()> task;
+    unsigned int self = current_pool_ == this ? current_index_ : 0;
+    if (!take(self, task))
+      return false;
+    task();
+    return true;
+  }
+
+private:
+  struct task_queue
+  {
+    std::mutex lock_;
+    std::deque<std::function<void()>> tasks_;
+  };
+
+  bool take(unsigned int self, std::function<void()> &task)
+  {
+    if (num_queued_.load(std::memory_order_acquire) == 0)
+      return false;
+
+    {
+      std::lock_guard<std::mutex> lock(queues_[self].lock_);
+      if (!queues_[self].tasks_.empty())
+      {
+        task = std::move(queues_[self].tasks_.back());
+        queues_[self].tasks_.pop_back();
+        num_queued_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+      }
+    }
+    for (unsigned int i = 1; i < queues_.size(); i++)
+    {
+      task_queue &victim = queues_[(self + i) % queues_.size()];
+      std::lock_guard<std::mutex> lock(victim.lock_);
+      if (!victim.tasks_.empty())
+      {
+        task = std::move(victim.tasks_.front());
+        victim.tasks_.pop_front();
+        num_queued_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void worker_loop(unsigned int self)
+  {
+    current_pool_ = this;
+    current_index_ = self;
+
+    std::function<void()> task;
+    while (true)
+    {
+      if (take(self, task))
+      {
+        task();
+        task = nullptr;
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(idle_lock_);
+      idle_cv_.wait(lock, [this]() {
+        return stopping_ || num_queued_.load(std::memory_order_acquire) > 0;
+      });
+      if (stopping_ && num_queued_.load(std::memory_order_acquire) == 0)
+        return;
+    }
+  }
+
+  std::vector<task_queue> queues_;
+  std::vector<std::thread> workers_;
+  std::atomic<uint64_t> num_queued_{0};
+  std::atomic<unsigned int> next_queue_{0};
+
+  std::mutex idle_lock_;
+  std::condition_variable idle_cv_;
+  bool stopping_ = false;
+
+  static inline thread_local work_stealing_pool *current_pool_ = nullptr;
+  static inline thread_local unsigned int current_index_ = 0;
+};
+
+/**
+ * task_group: tracks a batch of tasks submitted to a work_stealing_pool so the
+ * submitter can wait for all of them. Tasks may add more tasks to the group.
+ */
+
+class task_group
+{
+public:
+  explicit task_group(work_stealing_pool *pool) : pool_(pool) {}
+
+  ~task_group() { wait(); }
+
+  void run(std::function<void()> task)
+  {
+    pending_.fetch_add(1, std::memory_order_relaxed);
+    pool_->submit([this, task]() {
+      task();
+      pending_.fetch_sub(1, std::memory_order_release);
+    });
+  }
+
+  void wait()
+  {
+    while (pending_.load(std::memory_order_acquire) > 0)
+    {
+      if (!pool_->run_one())
+        std::this_thread::yield();
+    }
+  }
+
+private:
+  work_stealing_pool *pool_;
+  std::atomic<uint64_t> pending_{0};
+};
+
+#endif // MD_TRIE_THREAD_POOL_H
@@ -2,12 +2,75 @@
 #define MD_TRIE_TREE_BLOCK_H
 
 #include "compact_ptr.h"
+#include "compact_ptr_list.h"
 #include "compressed_bitmap.h"
+#include "knn.h"
+#include "node_arena.h"
 #include "point_array.h"
+#include "primary_key_index.h"
+#include "subtree_directory.h"
 #include "trie_node.h"
 #include <cmath>
+#include <functional>
+#include <mutex>
 #include <sys/time.h>
 
+/**
+ * frontier_spawner: lets a range search hand off the treeblocks it reaches
+ * through frontier pointers (with the query range as narrowed so far), so they
+ * can be searched as separate tasks instead of being recursed into.
+ */
+template <dimension_t DIMENSION>
+using frontier_spawner = std::function<void(tree_block<DIMENSION> *,
+                                            level_t,
+                                            data_point<DIMENSION> *,
+                                            data_point<DIMENSION> *)>;
+
+/**
+ * range_visitor: receives range search matches one at a time, as the point's
+ * coordinates and the primary key it is stored under; a point stored under
+ * several primary keys is visited once per key. The point is only valid
+ * during the call. Returning false stops the search.
+ */
+template <dimension_t DIMENSION>
+using range_visitor =
+    std::function<bool(const data_point<DIMENSION> &, n_leaves_t)>;
+
+/**
+ * bulk_load_input: points sorted by their symbol sequence, as prepared by
+ * md_trie::bulk_load. keys_ holds key_words_ words per point: its symbols
+ * packed most significant bit first, the symbol at level starting at bit
+ * level_offset_[level]. lcp_[i] is the number of leading symbols points_[i]
+ * shares with points_[i - 1]. weight_prefix_[i] sums, over j < i, the number
+ * of trie nodes points_[j] adds below its common prefix with points_[j - 1],
+ * so the node count of any subtree is available in constant time.
+ */
+template <dimension_t DIMENSION>
+struct bulk_load_input
+{
+  data_point<DIMENSION> **points_;
+  uint64_t *keys_;
+  uint64_t key_words_;
+  uint64_t *level_offset_;
+  level_t *lcp_;
+  uint64_t *weight_prefix_;
+  const trie_schema *schema_;
+
+  morton_t symbol(n_leaves_t i, level_t level) const
+  {
+    const uint64_t *key = keys_ + i * key_words_;
+    uint64_t offset = level_offset_[level];
+    morton_t num_bits = schema_->level_to_num_children[level];
+    if (num_bits == 0)
+      return 0;
+    uint64_t shift = offset % 64;
+    uint64_t value = key[offset / 64] << shift;
+    if (shift + num_bits > 64)
+      value |= key[offset / 64 + 1] >> (64 - shift);
+    return value >> (64 - num_bits);
+  }
+};
+
 template <dimension_t DIMENSION>
 class tree_block
 {
@@ -17,31 +80,113 @@ public:
                       preorder_t node_capacity,
                       node_pos_t bit_capacity,
                       preorder_t num_nodes,
-                      level_t max_depth,
-                      preorder_t max_tree_nodes,
+                      const trie_schema *schema,
                       trie_node<DIMENSION> *parent_trie_node,
+                      node_arena *arena,
                       compressed_bitmap::compressed_bitmap *dfuds = NULL)
+      : primary_key_list(arena)
   {
     // width_ = width;
     root_depth_ = root_depth;
     node_capacity_ = node_capacity;
-    max_depth_ = max_depth;
-    max_tree_nodes_ = max_tree_nodes;
+    schema_ = schema;
+    arena_ = arena;
     num_nodes_ = num_nodes;
     total_nodes_bits_ = bit_capacity;
     if (!dfuds)
-      dfuds_ =
-          new compressed_bitmap::compressed_bitmap(node_capacity, bit_capacity);
+      dfuds_ = create_dfuds(node_capacity, bit_capacity);
     else
       dfuds_ = dfuds;
     if (parent_trie_node)
     {
       parent_combined_ptr_ = parent_trie_node;
     }
+    account(MEMORY_TREEBLOCKS, sizeof(tree_block) + sizeof(*dfuds_));
+  }
+
+  // Releases this block's own storage. Child blocks reached through
+  // frontiers_ are not owned here, nor are the lists of duplicate primary
+  // keys, which move along when blocks merge.
+  ~tree_block()
+  {
+    account(MEMORY_TREEBLOCKS,
+            -(int64_t)(sizeof(tree_block) + sizeof(*dfuds_)));
+    account(MEMORY_PRIMARY_KEY_LISTS,
+            -(int64_t)primary_key_list.allocated_bytes());
+    destroy_dfuds(dfuds_);
+    release_frontiers(frontiers_, num_frontiers_);
+    drop_lookup_index();
+    drop_subtree_directory();
+  }
+
+  // A child block, allocated from the trie's node_arena if it has one.
+  tree_block *create_block(level_t root_depth,
+                           preorder_t node_capacity,
+                           node_pos_t bit_capacity,
+                           preorder_t num_nodes,
+                           compressed_bitmap::compressed_bitmap *dfuds = NULL)
+  {
+    if (!arena_)
+      return new tree_block(root_depth,
+                            node_capacity,
+                            bit_capacity,
+                            num_nodes,
+                            schema_,
+                            NULL,
+                            nullptr,
+                            dfuds);
+    return arena_->create<tree_block>(root_depth,
+                                      node_capacity,
+                                      bit_capacity,
+                                      num_nodes,
+                                      schema_,
+                                      nullptr,
+                                      arena_,
+                                      dfuds);
+  }
+
+  // Frees block, made by create_block or md_trie, the same way.
+  static void destroy_block(tree_block *block)
+  {
+    if (!block || !block->arena_)
+      delete block;
+    else
+      block->arena_->destroy(block);
+  }
+
+  // A DFUDS bitmap for this block or a block split off it, allocated along
+  // with its words from the trie's node_arena if it has one.
+  compressed_bitmap::compressed_bitmap *create_dfuds(preorder_t node_capacity,
+                                                     node_pos_t bit_capacity)
+  {
+    if (!arena_)
+      return new compressed_bitmap::compressed_bitmap(
+          node_capacity, bit_capacity, schema_);
+    return arena_->create<compressed_bitmap::compressed_bitmap>(
+        node_capacity, bit_capacity, schema_, arena_);
+  }
+
+  void destroy_dfuds(compressed_bitmap::compressed_bitmap *dfuds)
+  {
+    if (!arena_)
+      delete dfuds;
+    else
+      arena_->destroy(dfuds);
   }
 
+  inline std::mutex &latch() { return latch_; }
+
   inline preorder_t num_frontiers() { return num_frontiers_; }
 
+  // Points stored in this block and in the blocks below it, one per primary
+  // key.
+  inline n_leaves_t num_points() const { return num_points_; }
+
+  // Counts a point that is about to be inserted into this block or below it.
+  // Called by whoever hands the insertion over to the block, while still
+  // holding the latch that leads to it (see num_points_).
+  inline void count_insertion() { num_points_++; }
+
   inline tree_block *get_pointer(preorder_t current_frontier)
   {
 
@@ -67,7 +212,8 @@ public:
 
   std::vector<bits::compact_ptr> get_primary_key_list()
   {
-    return primary_key_list;
+    return std::vector<bits::compact_ptr>(primary_key_list.begin(),
+                                          primary_key_list.end());
   }
 
   preorder_t select_subtree(preorder_t &subtree_size,
@@ -97,7 +243,7 @@ public:
     node_pos_t current_node_pos = 0;
     index_to_node[node_stack_top].preorder_ = 0;
     index_to_node[node_stack_top].n_children_ =
-        dfuds_->get_num_children(0, 0, level_to_num_children[root_depth_]);
+        dfuds_->get_num_children(0, 0, schema_->level_to_num_children[root_depth_]);
 
     node_stack_top++;
     node_to_depth[0] = root_depth_;
@@ -117,11 +263,11 @@ public:
       prev_depth = depth;
 
       node_to_depth[i] = depth;
-      if (depth == max_depth_ - 1)
+      if (depth == schema_->max_depth_ - 1)
       {
 
         node_to_primary[i] = dfuds_->get_num_children(
-            i, current_node_pos, level_to_num_children[depth]);
+            i, current_node_pos, schema_->level_to_num_children[depth]);
       }
       if (i == next_frontier_preorder)
       {
@@ -134,12 +280,12 @@ public:
         index_to_node[node_stack_top - 1].n_children_--;
       }
       //  Start searching for its children
-      else if (depth < max_depth_ - 1)
+      else if (depth < schema_->max_depth_ - 1)
       {
 
         index_to_node[node_stack_top].preorder_ = i;
         index_to_node[node_stack_top++].n_children_ = dfuds_->get_num_children(
-            i, current_node_pos, level_to_num_children[depth]);
+            i, current_node_pos, schema_->level_to_num_children[depth]);
         depth++;
       }
       //  Reached the maxDepth level
@@ -251,16 +397,16 @@ public:
                                    preorder_t &current_primary)
   {
 
-    if (current_level == max_depth_)
+    if (current_level == schema_->max_depth_)
     {
       return node;
     }
 
     int sTop = -1;
     preorder_t n_children_skip = dfuds_->get_child_skip(
-        node, node_pos, symbol, level_to_num_children[current_level]);
+        node, node_pos, symbol, schema_->level_to_num_children[current_level]);
     preorder_t n_children = dfuds_->get_num_children(
-        node, node_pos, level_to_num_children[current_level]);
+        node, node_pos, schema_->level_to_num_children[current_level]);
     preorder_t diff = n_children - n_children_skip;
     preorder_t stack[100];
     sTop++;
@@ -280,10 +426,22 @@ public:
     else
       next_frontier_preorder = get_preorder(current_frontier);
 
+    subtree_directory *directory = this->directory();
+    uint32_t cursor = directory ? directory->lower_bound(current_node) : 0;
+
     current_level++;
     while (current_node < num_nodes_ && sTop >= 0 && diff < stack[0])
     {
-      if (current_node == next_frontier_preorder)
+      bool skipped = directory && skip_listed_subtree(directory,
+                                                      cursor,
+                                                      current_node,
+                                                      current_node_pos,
+                                                      current_frontier,
+                                                      current_primary,
+                                                      next_frontier_preorder);
+      if (skipped)
+        stack[sTop]--;
+      else if (current_node == next_frontier_preorder)
       {
         current_frontier++;
         if (num_frontiers_ == 0 || current_frontier >= num_frontiers_)
@@ -295,11 +453,11 @@ public:
         current_node_pos += dfuds_->get_num_bits(current_node, current_level);
       }
       // It is "-1" because current_level is 0th indexed.
-      else if (current_level < max_depth_ - 1)
+      else if (current_level < schema_->max_depth_ - 1)
       {
         sTop++;
         stack[sTop] = dfuds_->get_num_children(
-            current_node, current_node_pos, level_to_num_children[current_level]);
+            current_node, current_node_pos, schema_->level_to_num_children[current_level]);
 
         current_node_pos += dfuds_->get_num_bits(current_node, current_level);
         current_level++;
@@ -308,17 +466,18 @@ public:
       {
         stack[sTop]--;
 
-        if (current_level == max_depth_ - 1)
+        if (current_level == schema_->max_depth_ - 1)
         {
 
           current_primary +=
               dfuds_->get_num_children(current_node,
                                        current_node_pos,
-                                       level_to_num_children[current_level]);
+                                       schema_->level_to_num_children[current_level]);
         }
         current_node_pos += dfuds_->get_num_bits(current_node, current_level);
       }
-      current_node++;
+      if (!skipped)
+        current_node++;
 
       while (sTop >= 0 && stack[sTop] == 0)
       {
@@ -350,15 +509,15 @@ public:
       preorder_t &current_primary_cont)
   {
 
-    if (current_level == max_depth_)
+    if (current_level == schema_->max_depth_)
     {
       return node;
     }
 
     preorder_t n_children_skip = dfuds_->get_child_skip(
-        node, node_pos, symbol, level_to_num_children[current_level]);
+        node, node_pos, symbol, schema_->level_to_num_children[current_level]);
     preorder_t n_children = dfuds_->get_num_children(
-        node, node_pos, level_to_num_children[current_level]);
+        node, node_pos, schema_->level_to_num_children[current_level]);
     preorder_t diff = n_children - n_children_skip;
 
     bool first_time = false;
@@ -395,6 +554,9 @@ public:
         next_frontier_preorder = get_preorder(current_frontier);
     }
 
+    subtree_directory *directory = this->directory();
+    uint32_t cursor = directory ? directory->lower_bound(current_node) : 0;
+
     current_level++;
 
     while ((current_node < num_nodes_ && sTop >= 0 && diff < stack[0]) ||
@@ -403,7 +565,16 @@ public:
 
       // First time needs to go down first.
       first_time = true;
-      if (current_node == next_frontier_preorder)
+      bool skipped = directory && skip_listed_subtree(directory,
+                                                      cursor,
+                                                      current_node,
+                                                      current_node_pos,
+                                                      current_frontier,
+                                                      current_primary,
+                                                      next_frontier_preorder);
+      if (skipped)
+        stack[sTop]--;
+      else if (current_node == next_frontier_preorder)
       {
         current_frontier++;
         if (num_frontiers_ == 0 || current_frontier >= num_frontiers_)
@@ -415,11 +586,11 @@ public:
         current_node_pos += dfuds_->get_num_bits(current_node, current_level);
       }
       // It is "-1" because current_level is 0th indexed.
-      else if (current_level < max_depth_ - 1)
+      else if (current_level < schema_->max_depth_ - 1)
       {
         sTop++;
         stack[sTop] = dfuds_->get_num_children(
-            current_node, current_node_pos, level_to_num_children[current_level]);
+            current_node, current_node_pos, schema_->level_to_num_children[current_level]);
 
         current_node_pos += dfuds_->get_num_bits(current_node, current_level);
         current_level++;
@@ -428,17 +599,18 @@ public:
       {
         stack[sTop]--;
 
-        if (current_level == max_depth_ - 1)
+        if (current_level == schema_->max_depth_ - 1)
         {
 
           current_primary +=
               dfuds_->get_num_children(current_node,
                                        current_node_pos,
-                                       level_to_num_children[current_level]);
+                                       schema_->level_to_num_children[current_level]);
         }
         current_node_pos += dfuds_->get_num_bits(current_node, current_level);
       }
-      current_node++;
+      if (!skipped)
+        current_node++;
 
       while (sTop >= 0 && stack[sTop] == 0)
       {
@@ -471,11 +643,11 @@ public:
       return null_node;
 
     auto has_child = dfuds_->has_symbol(
-        node, node_pos, symbol, level_to_num_children[current_level]);
+        node, node_pos, symbol, schema_->level_to_num_children[current_level]);
     if (!has_child)
       return null_node;
 
-    if (current_level == max_depth_ - 1)
+    if (current_level == schema_->max_depth_ - 1)
       return node;
 
     preorder_t current_node;
@@ -532,11 +704,11 @@ public:
       return null_node;
 
     auto has_child = dfuds_->has_symbol(
-        node, node_pos, symbol, level_to_num_children[current_level]);
+        node, node_pos, symbol, schema_->level_to_num_children[current_level]);
     if (!has_child)
       return null_node;
 
-    if (current_level == max_depth_ - 1)
+    if (current_level == schema_->max_depth_ - 1)
       return node;
 
     preorder_t current_node_ret;
@@ -565,17 +737,18 @@ public:
               preorder_t current_frontier,
               preorder_t current_primary,
               n_leaves_t primary_key,
-              bitmap::CompactPtrVector *p_key_to_treeblock_compact)
+              bitmap::CompactPtrVector *p_key_to_treeblock_compact,
+              std::unique_lock<std::mutex> *held_latch = nullptr)
   {
 
-    morton_t current_num_children = level_to_num_children[level];
+    morton_t current_num_children = schema_->level_to_num_children[level];
 
-    if (level == max_depth_)
+    if (level == schema_->max_depth_)
     {
 
-      current_num_children = level_to_num_children[level - 1];
+      current_num_children = schema_->level_to_num_children[level - 1];
 
-      morton_t parent_symbol = leaf_point->leaf_to_symbol(max_depth_ - 1);
+      morton_t parent_symbol = leaf_point->leaf_to_symbol(schema_->max_depth_ - 1, schema_);
       morton_t tmp_symbol = dfuds_->next_symbol(0,
                                                 node,
                                                 node_pos,
@@ -592,25 +765,22 @@ public:
         current_primary++;
       }
 
-      insert_primary_key_at_present_index(
-          current_primary, primary_key, p_key_to_treeblock_compact);
+      insert_primary_key_at_present_index(current_primary,
+                                          primary_key,
+                                          p_key_to_treeblock_compact,
+                                          held_latch != nullptr);
+      if (primary_key_index *index = lookup_index_with_room(1, 0, 0))
+        index->record_key(primary_key, current_primary);
 
       return;
     }
 
     preorder_t original_node = node;
     node_pos_t original_node_pos = node_pos;
-    preorder_t max_tree_nodes;
-
-    if (root_depth_ <= max_depth_ / 2)
-      max_tree_nodes = max_tree_nodes_ / 4;
-    else if (root_depth_ <= max_depth_ / 4 * 3)
-      max_tree_nodes = max_tree_nodes_ / 2;
-    else
-      max_tree_nodes = max_tree_nodes_;
-
-    if (no_dynamic_sizing)
-      max_tree_nodes = max_tree_nodes_;
+    preorder_t max_tree_nodes = max_tree_nodes_at_root_depth();
+    preorder_t num_nodes_before = num_nodes_;
+    node_pos_t num_bits_before = total_nodes_bits_;
+    n_leaves_t num_primary_before = primary_key_list.size();
 
     if (frontiers_ != nullptr && current_frontier < num_frontiers_ &&
         node == get_preorder(current_frontier))
@@ -618,42 +788,51 @@ public:
 
       preorder_t node_previous_bits = dfuds_->get_num_bits(node, level);
       if (dfuds_->get_num_children(
-              node, node_pos, level_to_num_children[level]) >= 1)
+              node, node_pos, schema_->level_to_num_children[level]) >= 1)
       {
         dfuds_->set_symbol(node,
                            node_pos,
-                           leaf_point->leaf_to_symbol(level),
+                           leaf_point->leaf_to_symbol(level, schema_),
                            false,
-                           level_to_num_children[level]);
+                           schema_->level_to_num_children[level]);
       }
       else
       {
         dfuds_->set_symbol(node,
                            node_pos,
-                           leaf_point->leaf_to_symbol(level),
+                           leaf_point->leaf_to_symbol(level, schema_),
                            true,
-                           level_to_num_children[level]);
+                           schema_->level_to_num_children[level]);
       }
 
       total_nodes_bits_ +=
           dfuds_->get_num_bits(node, level) - node_previous_bits;
-      get_pointer(current_frontier)
-          ->insert(0,
-                   0,
-                   leaf_point,
-                   level,
-                   0,
-                   0,
-                   primary_key,
-                   p_key_to_treeblock_compact);
+      note_insertion(
+          node, node + 1, num_nodes_before, num_bits_before, num_primary_before);
+      if (lookup_index_)
+        lookup_index_->record_bits(
+            node + 1, dfuds_->get_num_bits(node, level) - node_previous_bits);
+      tree_block<DIMENSION> *next_block = get_pointer(current_frontier);
+      next_block->count_insertion();
+      if (held_latch)
+        next_block->couple_latch(held_latch);
+      next_block->insert(0,
+                         0,
+                         leaf_point,
+                         level,
+                         0,
+                         0,
+                         primary_key,
+                         p_key_to_treeblock_compact,
+                         held_latch);
 
       return;
     }
 
-    else if (level + 1 == max_depth_)
+    else if (level + 1 == schema_->max_depth_)
     {
 
-      morton_t next_symbol = leaf_point->leaf_to_symbol(level);
+      morton_t next_symbol = leaf_point->leaf_to_symbol(level, schema_);
 
       preorder_t original_node_previous_bits =
           dfuds_->get_num_bits(original_node, level);
@@ -661,7 +840,7 @@ public:
                          original_node_pos,
                          next_symbol,
                          false,
-                         level_to_num_children[level]);
+                         schema_->level_to_num_children[level]);
       total_nodes_bits_ += dfuds_->get_num_bits(original_node, level) -
                            original_node_previous_bits;
 
@@ -682,15 +861,30 @@ public:
         current_primary++;
       }
 
-      insert_primary_key_at_index(
-          current_primary, primary_key, p_key_to_treeblock_compact);
+      insert_primary_key_at_index(current_primary,
+                                  primary_key,
+                                  p_key_to_treeblock_compact,
+                                  held_latch != nullptr);
+      note_insertion(original_node,
+                     original_node + 1,
+                     num_nodes_before,
+                     num_bits_before,
+                     num_primary_before);
+      if (primary_key_index *index = lookup_index_with_room(1, 0, 0))
+      {
+        index->record_bits(original_node + 1,
+                           dfuds_->get_num_bits(original_node, level) -
+                               original_node_previous_bits);
+        index->record_leaf(current_primary, original_node + 1);
+        index->record_key(primary_key, current_primary);
+      }
 
       return;
     }
 
-    else if (num_nodes_ + (max_depth_ - level) - 1 <= node_capacity_)
+    else if (num_nodes_ + (schema_->max_depth_ - level) - 1 <= node_capacity_)
     {
-      morton_t current_symbol = leaf_point->leaf_to_symbol(level);
+      morton_t current_symbol = leaf_point->leaf_to_symbol(level, schema_);
       node = skip_children_subtree(node,
                                    node_pos,
                                    current_symbol,
@@ -710,6 +904,10 @@ public:
                   original_node_previous_bits;
       total_nodes_bits_ += dfuds_->get_num_bits(original_node, level) -
                            original_node_previous_bits;
+      if (lookup_index_)
+        lookup_index_->record_bits(original_node + 1,
+                                   dfuds_->get_num_bits(original_node, level) -
+                                       original_node_previous_bits);
 
       preorder_t from_node = num_nodes_ - 1;
       preorder_t from_node_pos = total_nodes_bits_;
@@ -720,17 +918,17 @@ public:
 
         shifted = true;
         morton_t total_bits_to_shift = 0;
-        for (level_t i = level + 1; i < max_depth_; i++)
+        for (level_t i = level + 1; i < schema_->max_depth_; i++)
         {
-          if (is_collapsed_node_exp)
-            total_bits_to_shift += (1 << level_to_num_children[i]);
+          if (schema_->is_collapsed_node_exp)
+            total_bits_to_shift += (1 << schema_->level_to_num_children[i]);
           else
             total_bits_to_shift +=
-                level_to_num_children[i]; // Compressed Node Representation
+                schema_->level_to_num_children[i]; // Compressed Node Representation
         }
 
         dfuds_->shift_backward(
-            node, node_pos, total_bits_to_shift, max_depth_ - level - 1);
+            node, node_pos, total_bits_to_shift, schema_->max_depth_ - level - 1);
         from_node = node;
         from_node_pos = node_pos;
       }
@@ -740,27 +938,28 @@ public:
       }
 
       level++;
+      node_pos_t path_pos = from_node_pos;
 
-      for (level_t current_level = level; current_level < max_depth_;
+      for (level_t current_level = level; current_level < schema_->max_depth_;
            current_level++)
       {
 
         if (!shifted)
         {
-          if (is_collapsed_node_exp)
+          if (schema_->is_collapsed_node_exp)
             dfuds_->ClearWidth(
-                from_node_pos, (1 << level_to_num_children[current_level]), true);
+                from_node_pos, (1 << schema_->level_to_num_children[current_level]), true);
           else
             dfuds_->ClearWidth(
-                from_node_pos, level_to_num_children[current_level], true);
+                from_node_pos, schema_->level_to_num_children[current_level], true);
           dfuds_->ClearWidth(from_node, 1, false);
         }
-        morton_t next_symbol = leaf_point->leaf_to_symbol(current_level);
+        morton_t next_symbol = leaf_point->leaf_to_symbol(current_level, schema_);
         dfuds_->set_symbol(from_node,
                            from_node_pos,
                            next_symbol,
                            true,
-                           level_to_num_children[current_level]);
+                           schema_->level_to_num_children[current_level]);
 
         num_nodes_++;
         from_node_pos += dfuds_->get_num_bits(from_node, current_level);
@@ -772,32 +971,56 @@ public:
       if (frontiers_ != nullptr)
         for (preorder_t j = current_frontier; j < num_frontiers_; j++)
         {
-          set_preorder(j, get_preorder(j) + max_depth_ - level);
+          set_preorder(j, get_preorder(j) + schema_->max_depth_ - level);
           set_pointer(j, get_pointer(j)); // Prob not necessary
         }
 
-      insert_primary_key_at_index(
-          current_primary, primary_key, p_key_to_treeblock_compact);
+      insert_primary_key_at_index(current_primary,
+                                  primary_key,
+                                  p_key_to_treeblock_compact,
+                                  held_latch != nullptr);
+      note_insertion(original_node,
+                     node,
+                     num_nodes_before,
+                     num_bits_before,
+                     num_primary_before);
+      preorder_t path_nodes = schema_->max_depth_ - level;
+      if (primary_key_index *index =
+              lookup_index_with_room(1, path_nodes, 1))
+      {
+        index->record_path(original_node,
+                           node,
+                           path_nodes,
+                           from_node_pos - path_pos,
+                           from_node_pos - dfuds_->get_num_bits(
+                                               from_node - 1,
+                                               schema_->max_depth_ - 1),
+                           current_primary);
+        for (preorder_t i = 0; i < path_nodes; i++)
+          index->node_symbols()[node + i] =
+              leaf_point->leaf_to_symbol(level - 1 + i, schema_);
+        index->record_key(primary_key, current_primary);
+      }
       return;
     }
-    else if (num_nodes_ + (max_depth_ - level) - 1 <= max_tree_nodes)
+    else if (num_nodes_ + (schema_->max_depth_ - level) - 1 <= max_tree_nodes)
     {
       uint64_t total_extra_bits = 0;
-      for (unsigned int i = level; i < max_depth_; i++)
+      for (unsigned int i = level; i < schema_->max_depth_; i++)
       {
-        if (is_collapsed_node_exp)
-          total_extra_bits += (1 << level_to_num_children[i]);
+        if (schema_->is_collapsed_node_exp)
+          total_extra_bits += (1 << schema_->level_to_num_children[i]);
         else
-          total_extra_bits += level_to_num_children[i];
+          total_extra_bits += schema_->level_to_num_children[i];
       }
 
       dfuds_->keep_bits(total_nodes_bits_, true);
       dfuds_->increase_bits(total_extra_bits, true);
 
       dfuds_->keep_bits(num_nodes_, false);
-      dfuds_->increase_bits(max_depth_ - level, false);
+      dfuds_->increase_bits(schema_->max_depth_ - level, false);
 
-      node_capacity_ = num_nodes_ + (max_depth_ - level);
+      node_capacity_ = num_nodes_ + (schema_->max_depth_ - level);
 
       insert(node,
              node_pos,
@@ -806,12 +1029,15 @@ public:
              current_frontier,
              current_primary,
              primary_key,
-             p_key_to_treeblock_compact);
+             p_key_to_treeblock_compact,
+             held_latch);
       return;
     }
     else
     {
       num_treeblock_expand++;
+      drop_subtree_directory();
+      drop_lookup_index();
       preorder_t subtree_size, selected_node_depth;
       preorder_t selected_node_pos = 0;
       preorder_t num_primary = 0, selected_primary_index = 0;
@@ -829,8 +1055,7 @@ public:
       preorder_t orig_selected_node = selected_node;
       preorder_t orig_selected_node_pos = selected_node_pos;
 
-      auto *new_dfuds = new compressed_bitmap::compressed_bitmap(
-          subtree_size + 1, total_nodes_bits_);
+      auto *new_dfuds = create_dfuds(subtree_size + 1, total_nodes_bits_);
       preorder_t frontier;
 
       for (frontier = 0; frontier < num_frontiers_; frontier++)
@@ -853,8 +1078,7 @@ public:
       frontier_node<DIMENSION> *new_pointer_array = nullptr;
       if (num_frontiers_ > 0)
       {
-        new_pointer_array = (frontier_node<DIMENSION> *)malloc(
-            sizeof(frontier_node<DIMENSION>) * (num_frontiers_));
+        new_pointer_array = resize_frontiers(nullptr, 0, num_frontiers_);
       }
       preorder_t current_frontier_new_block = 0;
       preorder_t current_primary_new_block = 0;
@@ -906,7 +1130,7 @@ public:
             selected_node_pos,
             dest_node,
             dest_node_pos,
-            level_to_num_children[node_to_depth[selected_node]]);
+            schema_->level_to_num_children[node_to_depth[selected_node]]);
         subtree_bits +=
             dfuds_->get_num_bits(selected_node, node_to_depth[selected_node]);
         dest_node_pos += dfuds_->get_num_bits(
@@ -918,24 +1142,19 @@ public:
         n_nodes_copied += 1;
       }
       new_dfuds->keep_bits(dest_node_pos, true);
-      auto new_block = new tree_block<DIMENSION>(/* width_ ,*/
-                                                 selected_node_depth,  
-                                                 subtree_size,
-                                                 dest_node_pos,
-                                                 subtree_size,
-                                                 max_depth_,
-                                                 max_tree_nodes_,
-                                                 NULL,
-                                                 new_dfuds);
+      auto new_block = create_block(selected_node_depth,
+                                    subtree_size,
+                                    dest_node_pos,
+                                    subtree_size,
+                                    new_dfuds);
       //  If no pointer is copied to the new block
       if (new_pointer_index == 0)
       {
-        if (new_pointer_array != nullptr)
-          free(new_pointer_array);
+        release_frontiers(new_pointer_array, num_frontiers_);
 
         // Expand frontiers array to add one more frontier node
-        frontiers_ = (frontier_node<DIMENSION> *)realloc(
-            frontiers_, sizeof(frontier_node<DIMENSION>) * (num_frontiers_ + 1));
+        frontiers_ =
+            resize_frontiers(frontiers_, num_frontiers_, num_frontiers_ + 1);
 
         // Shift right one spot to move the pointers from flagSelectedNode + 1
         // to nPtrs
@@ -952,9 +1171,8 @@ public:
       else
       {
         //  If there are pointers copied to the new block
-        new_pointer_array = (frontier_node<DIMENSION> *)realloc(
-            new_pointer_array,
-            sizeof(frontier_node<DIMENSION>) * (new_pointer_index));
+        new_pointer_array = resize_frontiers(
+            new_pointer_array, num_frontiers_, new_pointer_index);
 
         new_block->frontiers_ = new_pointer_array;
         new_block->num_frontiers_ = new_pointer_index;
@@ -974,32 +1192,41 @@ public:
           set_preorder(j, get_preorder(frontier) - subtree_size + 1);
           set_pointer(j, get_pointer(frontier));
         }
+        preorder_t old_num_frontiers = num_frontiers_;
         num_frontiers_ = num_frontiers_ - copied_frontier + 1;
-        frontiers_ = (frontier_node<DIMENSION> *)realloc(
-            frontiers_, sizeof(frontier_node<DIMENSION>) * (num_frontiers_));
-      }
-
-      // Copy primary key to the new block
-      for (preorder_t i = selected_primary_index;
-           i < selected_primary_index + num_primary;
-           i++)
+        frontiers_ =
+            resize_frontiers(frontiers_, old_num_frontiers, num_frontiers_);
+      }
+
+      // Move the primary keys to the new block; whole chunks of the list
+      // change hands without being copied.
+      size_t old_list_bytes = primary_key_list.allocated_bytes();
+      primary_key_list.move_range_to(
+          selected_primary_index, num_primary, new_block->primary_key_list);
+      account_primary_key_list(old_list_bytes);
+      new_block->account_primary_key_list(0);
+      std::unique_lock<std::mutex> map_lock(p_key_to_treeblock_lock,
+                                            std::defer_lock);
+      if (held_latch)
+        map_lock.lock();
+      for (auto &primary_keys : new_block->primary_key_list)
       {
-
-        new_block->primary_key_list.push_back(primary_key_list[i]);
-        uint64_t primary_key_size = primary_key_list[i].size();
+        uint64_t primary_key_size = primary_keys.size();
+        new_block->num_points_ += primary_key_size;
 
         for (uint64_t j = 0; j < primary_key_size; j++)
         {
-          p_key_to_treeblock_compact->Set(primary_key_list[i].get(j),
-                                          new_block);
+          p_key_to_treeblock_compact->Set(primary_keys.get(j), new_block);
         }
       }
-
-      // Erase copied primary keys
-      primary_key_list.erase(
-          std::next(primary_key_list.begin(), selected_primary_index),
-          std::next(primary_key_list.begin(),
-                    selected_primary_index + num_primary));
+      if (held_latch)
+        map_lock.unlock();
+      for (preorder_t j = 0; j < new_block->num_frontiers_; j++)
+        new_block->num_points_ += new_block->get_pointer(j)->num_points_;
+      // The point being inserted was counted here on the way in; this block's
+      // total keeps covering everything that moved below it.
+      if (insertion_in_new_block)
+        new_block->num_points_++;
 
       // Now, delete the subtree copied to the new block
       orig_selected_node_pos += dfuds_->get_num_bits(
@@ -1032,9 +1259,9 @@ public:
         total_nodes_bits_ -= selected_node_pos - orig_selected_node_pos;
       }
 
-      if (subtree_size > max_depth_)
+      if (subtree_size > schema_->max_depth_)
       {
-        node_capacity_ -= subtree_size - max_depth_;
+        node_capacity_ -= subtree_size - schema_->max_depth_;
       }
       else
       {
@@ -1059,6 +1286,7 @@ public:
         current_primary = selected_primary_index;
       }
 
+      drop_subtree_directory();
       // If the insertion continues in the new block
       if (insertion_in_new_block)
       {
@@ -1069,7 +1297,7 @@ public:
               dfuds_->get_num_bits(insertion_node, level);
           dfuds_->set_symbol(insertion_node,
                              insertion_node_pos,
-                             leaf_point->leaf_to_symbol(level),
+                             leaf_point->leaf_to_symbol(level, schema_),
                              false,
                              dfuds_->get_num_bits(insertion_node, level));
           total_nodes_bits_ += dfuds_->get_num_bits(insertion_node, level) -
@@ -1082,7 +1310,8 @@ public:
                             current_frontier_new_block,
                             current_primary_new_block,
                             primary_key,
-                            p_key_to_treeblock_compact);
+                            p_key_to_treeblock_compact,
+                            held_latch);
         }
         else
         {
@@ -1093,7 +1322,8 @@ public:
                             current_frontier_new_block,
                             current_primary_new_block,
                             primary_key,
-                            p_key_to_treeblock_compact);
+                            p_key_to_treeblock_compact,
+                            held_latch);
         }
       }
       // If the insertion is in the old block
@@ -1106,7 +1336,8 @@ public:
                current_frontier,
                current_primary,
                primary_key,
-               p_key_to_treeblock_compact);
+               p_key_to_treeblock_compact,
+               held_latch);
       }
       return;
     }
@@ -1114,10 +1345,14 @@ public:
 
   // Traverse the current TreeBlock, going into frontier nodes as needed
   // Until it cannot traverse further and calls insertion
+  // If held_latch is given, it holds this block's latch; it is handed over to
+  // each treeblock the insertion descends into (latch coupling), so that
+  // concurrent inserters only serialize on the treeblocks they share.
   void insert_remaining(data_point<DIMENSION> *leaf_point,
                         level_t level,
                         n_leaves_t primary_key,
-                        bitmap::CompactPtrVector *p_key_to_treeblock_compact)
+                        bitmap::CompactPtrVector *p_key_to_treeblock_compact,
+                        std::unique_lock<std::mutex> *held_latch = nullptr)
   {
 
     preorder_t current_node = 0;
@@ -1128,14 +1363,14 @@ public:
     preorder_t temp_node = 0;
     preorder_t temp_node_pos = 0;
 
-    while (level < max_depth_)
+    while (level < schema_->max_depth_)
     {
       tree_block<DIMENSION> *current_treeblock = this;
 
       temp_node = child(current_treeblock,
                         current_node,
                         temp_node_pos,
-                        leaf_point->leaf_to_symbol(level),
+                        leaf_point->leaf_to_symbol(level, schema_),
                         level,
                         current_frontier,
                         current_primary);
@@ -1154,8 +1389,14 @@ public:
       {
 
         tree_block *next_block = get_pointer(current_frontier);
-        next_block->insert_remaining(
-            leaf_point, level + 1, primary_key, p_key_to_treeblock_compact);
+        next_block->count_insertion();
+        if (held_latch)
+          next_block->couple_latch(held_latch);
+        next_block->insert_remaining(leaf_point,
+                                     level + 1,
+                                     primary_key,
+                                     p_key_to_treeblock_compact,
+                                     held_latch);
 
         return;
       }
@@ -1169,11 +1410,127 @@ public:
            current_frontier,
            current_primary,
            primary_key,
-           p_key_to_treeblock_compact);
+           p_key_to_treeblock_compact,
+           held_latch);
 
     return;
   }
 
+  // Removes primary_key, stored under leaf_point, from the subtree of this
+  // block below level (see md_trie::delete_trie). Nodes left without children
+  // are pruned, an undersized child block is merged back in place of its
+  // frontier node, and the storage of this block is shrunk to fit. Returns
+  // false if primary_key is not stored here. Sets emptied if the block lost
+  // its last point, in which case it is left untouched for the caller to free.
+  bool delete_remaining(data_point<DIMENSION> *leaf_point,
+                        level_t level,
+                        n_leaves_t primary_key,
+                        bitmap::CompactPtrVector *p_key_to_treeblock_compact,
+                        bool &emptied)
+  {
+
+    emptied = false;
+    drop_lookup_index();
+
+    // Preorder and position of the node at each level of the point's path
+    preorder_t path_node[80];
+    node_pos_t path_pos[80];
+
+    preorder_t current_node = 0;
+    preorder_t current_node_pos = 0;
+    preorder_t current_frontier = 0;
+    preorder_t current_primary = 0;
+
+    while (level < schema_->max_depth_)
+    {
+      path_node[level] = current_node;
+      path_pos[level] = current_node_pos;
+
+      tree_block<DIMENSION> *current_treeblock = this;
+      preorder_t temp_node_pos = current_node_pos;
+      preorder_t temp_node = child(current_treeblock,
+                                   current_node,
+                                   temp_node_pos,
+                                   leaf_point->leaf_to_symbol(level, schema_),
+                                   level,
+                                   current_frontier,
+                                   current_primary);
+      if (temp_node == null_node || temp_node == num_nodes_)
+        return false;
+
+      current_node = temp_node;
+      current_node_pos = temp_node_pos;
+
+      if (level + 1 < schema_->max_depth_ && current_frontier < num_frontiers_ &&
+          current_node == get_preorder(current_frontier))
+      {
+        path_node[level + 1] = current_node;
+        path_pos[level + 1] = current_node_pos;
+
+        tree_block<DIMENSION> *next_block = get_pointer(current_frontier);
+        bool next_emptied;
+        if (!next_block->delete_remaining(leaf_point,
+                                          level + 1,
+                                          primary_key,
+                                          p_key_to_treeblock_compact,
+                                          next_emptied))
+          return false;
+
+        num_points_--;
+        if (next_emptied)
+        {
+          destroy_block(next_block);
+          erase_frontier(current_frontier);
+          prune_path(level + 1, true, path_node, path_pos, leaf_point, emptied);
+          return true;
+        }
+        if (next_block->num_nodes_ * 4 <=
+                next_block->max_tree_nodes_at_root_depth() &&
+            num_nodes_ + next_block->num_nodes_ - 1 <=
+                max_tree_nodes_at_root_depth())
+        {
+          merge_frontier(current_frontier,
+                         level + 1,
+                         current_node_pos,
+                         current_primary,
+                         p_key_to_treeblock_compact);
+        }
+        return true;
+      }
+      level++;
+    }
+
+    level_t leaf_level = schema_->max_depth_ - 1;
+    morton_t leaf_symbol = leaf_point->leaf_to_symbol(leaf_level, schema_);
+    n_leaves_t index =
+        current_primary +
+        dfuds_->get_child_skip(path_node[leaf_level],
+                               path_pos[leaf_level],
+                               leaf_symbol,
+                               schema_->level_to_num_children[leaf_level]);
+    if (!primary_key_list[index].check_if_present(primary_key))
+      return false;
+
+    p_key_to_treeblock_compact->Set(primary_key, nullptr);
+    num_points_--;
+    if (primary_key_list[index].size() > 1)
+    {
+      uint64_t old_size = primary_key_list[index].size_overhead();
+      primary_key_list[index].remove(primary_key, arena_);
+      account(MEMORY_PRIMARY_KEY_LISTS,
+              (int64_t)primary_key_list[index].size_overhead() - old_size);
+      return true;
+    }
+
+    size_t old_list_bytes = primary_key_list.allocated_bytes();
+    primary_key_list.erase(index);
+    if (primary_key_list.capacity() > 2 * primary_key_list.size())
+      primary_key_list.shrink_to_fit();
+    account_primary_key_list(old_list_bytes);
+    prune_path(leaf_level, false, path_node, path_pos, leaf_point, emptied);
+    return true;
+  }
+
   // This function is used for testing.
   // It differs from above as it only returns True or False.
   bool walk_tree_block(data_point<DIMENSION> *leaf_point, level_t level)
@@ -1185,9 +1542,9 @@ public:
     preorder_t temp_node = 0;
     preorder_t temp_node_pos = 0;
 
-    while (level < max_depth_)
+    while (level < schema_->max_depth_)
     {
-      morton_t current_symbol = leaf_point->leaf_to_symbol(level);
+      morton_t current_symbol = leaf_point->leaf_to_symbol(level, schema_);
 
       tree_block<DIMENSION> *current_treeblock = this;
       temp_node = child(current_treeblock,
@@ -1219,15 +1576,21 @@ public:
   void get_node_path(preorder_t node, std::vector<morton_t> &node_path)
   {
 
+    if (schema_->primary_key_index && node != 0)
+    {
+      index_node_path(node, node_path);
+      return;
+    }
+
     if (node == 0)
     {
       node_path[root_depth_] =
           dfuds_->next_symbol(0,
                               0,
                               0,
-                              (1 << level_to_num_children[root_depth_]) - 1,
-                              level_to_num_children[root_depth_]);
-      if (root_depth_ != trie_depth_)
+                              (1 << schema_->level_to_num_children[root_depth_]) - 1,
+                              schema_->level_to_num_children[root_depth_]);
+      if (root_depth_ != schema_->trie_depth_)
       {
         ((tree_block<DIMENSION> *)parent_combined_ptr_)
             ->get_node_path(treeblock_frontier_num_, node_path);
@@ -1261,11 +1624,11 @@ public:
         dfuds_->next_symbol(symbol[sTop] + 1,
                             top_node,
                             top_node_pos,
-                            (1 << level_to_num_children[root_depth_]) - 1,
-                            level_to_num_children[root_depth_]);
+                            (1 << schema_->level_to_num_children[root_depth_]) - 1,
+                            schema_->level_to_num_children[root_depth_]);
 
     stack[sTop] =
-        dfuds_->get_num_children(0, 0, level_to_num_children[root_depth_]);
+        dfuds_->get_num_children(0, 0, schema_->level_to_num_children[root_depth_]);
     sTop_to_level[sTop] = root_depth_;
 
     level_t current_level = root_depth_ + 1;
@@ -1297,8 +1660,8 @@ public:
               symbol[sTop] + 1,
               top_node,
               node_positions[top_node],
-              (1 << level_to_num_children[sTop_to_level[sTop]]) - 1,
-              level_to_num_children[sTop_to_level[sTop]]);
+              (1 << schema_->level_to_num_children[sTop_to_level[sTop]]) - 1,
+              schema_->level_to_num_children[sTop_to_level[sTop]]);
         }
         ++current_frontier;
         if (num_frontiers_ == 0 || current_frontier >= num_frontiers_)
@@ -1309,13 +1672,13 @@ public:
         --stack[sTop];
       }
       // It is "-1" because current_level is 0th indexed.
-      else if (current_level < max_depth_ - 1)
+      else if (current_level < schema_->max_depth_ - 1)
       {
         sTop++;
         stack[sTop] =
             dfuds_->get_num_children(current_node,
                                      node_positions[current_node],
-                                     level_to_num_children[current_level]);
+                                     schema_->level_to_num_children[current_level]);
         path[sTop] = current_node;
         sTop_to_level[sTop] = current_level;
 
@@ -1323,11 +1686,11 @@ public:
             symbol[sTop] + 1,
             current_node,
             node_positions[current_node],
-            (1 << level_to_num_children[sTop_to_level[sTop]]) - 1,
-            level_to_num_children[sTop_to_level[sTop]]);
+            (1 << schema_->level_to_num_children[sTop_to_level[sTop]]) - 1,
+            schema_->level_to_num_children[sTop_to_level[sTop]]);
         ++current_level;
       }
-      else if (current_level == max_depth_ - 1 && stack[sTop] > 1 &&
+      else if (current_level == schema_->max_depth_ - 1 && stack[sTop] > 1 &&
                current_node < node)
       {
         top_node = path[sTop];
@@ -1335,8 +1698,8 @@ public:
             symbol[sTop] + 1,
             top_node,
             node_positions[top_node],
-            (1 << level_to_num_children[sTop_to_level[sTop]]) - 1,
-            level_to_num_children[sTop_to_level[sTop]]);
+            (1 << schema_->level_to_num_children[sTop_to_level[sTop]]) - 1,
+            schema_->level_to_num_children[sTop_to_level[sTop]]);
         --stack[sTop];
       }
       else
@@ -1368,8 +1731,8 @@ public:
             symbol[sTop] + 1,
             top_node,
             node_positions[top_node],
-            (1 << level_to_num_children[sTop_to_level[sTop]]) - 1,
-            level_to_num_children[sTop_to_level[sTop]]);
+            (1 << schema_->level_to_num_children[sTop_to_level[sTop]]) - 1,
+            schema_->level_to_num_children[sTop_to_level[sTop]]);
       }
     }
     if (current_node == num_nodes_)
@@ -1381,7 +1744,7 @@ public:
     {
       node_path[root_depth_ + i] = symbol[i];
     }
-    if (root_depth_ != trie_depth_)
+    if (root_depth_ != schema_->trie_depth_)
     {
 
       ((tree_block<DIMENSION> *)parent_combined_ptr_)
@@ -1398,6 +1761,25 @@ public:
                                      std::vector<morton_t> &node_path)
   {
 
+    if (schema_->primary_key_index)
+    {
+      primary_key_index *index = lookup_index();
+      n_leaves_t leaf = index->find_leaf(primary_key);
+      if (leaf == (n_leaves_t)-1)
+      {
+        fprintf(stderr, "node not found!\n");
+        return 0;
+      }
+      uint32_t leaf_node = index->find_leaf_node(leaf);
+      preorder_t node = index->leaf_node_preorders()[leaf_node];
+      index_node_path(node, node_path);
+      return dfuds_->get_k_th_set_bit(
+          node,
+          leaf - index->leaf_node_first_leaves()[leaf_node],
+          index->leaf_node_positions()[leaf_node],
+          schema_->level_to_num_children[schema_->max_depth_ - 1]);
+    }
+
     preorder_t stack[64] = {};
     preorder_t path[64] = {};
     int symbol[64];
@@ -1415,10 +1797,10 @@ public:
         dfuds_->next_symbol(symbol[sTop] + 1,
                             0,
                             0,
-                            (1 << level_to_num_children[root_depth_]) - 1,
-                            level_to_num_children[root_depth_]);
+                            (1 << schema_->level_to_num_children[root_depth_]) - 1,
+                            schema_->level_to_num_children[root_depth_]);
     stack[sTop] =
-        dfuds_->get_num_children(0, 0, level_to_num_children[root_depth_]);
+        dfuds_->get_num_children(0, 0, schema_->level_to_num_children[root_depth_]);
     sTop_to_level[sTop] = root_depth_;
 
     level_t current_level = root_depth_ + 1;
@@ -1451,8 +1833,8 @@ public:
             symbol[sTop] + 1,
             top_node,
             node_positions[top_node],
-            (1 << level_to_num_children[sTop_to_level[sTop]]) - 1,
-            level_to_num_children[sTop_to_level[sTop]]);
+            (1 << schema_->level_to_num_children[sTop_to_level[sTop]]) - 1,
+            schema_->level_to_num_children[sTop_to_level[sTop]]);
         ++current_frontier;
         if (num_frontiers_ == 0 || current_frontier >= num_frontiers_)
           next_frontier_preorder = -1;
@@ -1462,13 +1844,13 @@ public:
         --stack[sTop];
       }
       // It is "-1" because current_level is 0th indexed.
-      else if (current_level < max_depth_ - 1)
+      else if (current_level < schema_->max_depth_ - 1)
       {
         sTop++;
         stack[sTop] =
             dfuds_->get_num_children(current_node,
                                      node_positions[current_node],
-                                     level_to_num_children[current_level]);
+                                     schema_->level_to_num_children[current_level]);
         path[sTop] = current_node;
         sTop_to_level[sTop] = current_level;
 
@@ -1476,21 +1858,21 @@ public:
             symbol[sTop] + 1,
             current_node,
             node_positions[current_node],
-            (1 << level_to_num_children[sTop_to_level[sTop]]) - 1,
-            level_to_num_children[sTop_to_level[sTop]]);
+            (1 << schema_->level_to_num_children[sTop_to_level[sTop]]) - 1,
+            schema_->level_to_num_children[sTop_to_level[sTop]]);
         ++current_level;
       }
       else
       {
         --stack[sTop];
-        if (current_level == max_depth_ - 1)
+        if (current_level == schema_->max_depth_ - 1)
         {
 
           preorder_t new_current_primary =
               current_primary +
               dfuds_->get_num_children(current_node,
                                        node_positions[current_node],
-                                       level_to_num_children[current_level]);
+                                       schema_->level_to_num_children[current_level]);
           bool found = false;
           for (preorder_t p = current_primary; p < new_current_primary; p++)
           {
@@ -1501,7 +1883,7 @@ public:
                   dfuds_->get_k_th_set_bit(current_node,
                                            p - current_primary /* 0-indexed*/,
                                            node_positions[current_node],
-                                           level_to_num_children[current_level]);
+                                           schema_->level_to_num_children[current_level]);
               break;
             }
           }
@@ -1514,8 +1896,8 @@ public:
                 symbol[sTop] + 1,
                 top_node,
                 node_positions[top_node],
-                (1 << level_to_num_children[sTop_to_level[sTop]]) - 1,
-                level_to_num_children[sTop_to_level[sTop]]);
+                (1 << schema_->level_to_num_children[sTop_to_level[sTop]]) - 1,
+                schema_->level_to_num_children[sTop_to_level[sTop]]);
           }
           if (found)
           {
@@ -1543,8 +1925,8 @@ public:
             symbol[sTop] + 1,
             top_node,
             node_positions[top_node],
-            (1 << level_to_num_children[sTop_to_level[sTop]]) - 1,
-            level_to_num_children[sTop_to_level[sTop]]);
+            (1 << schema_->level_to_num_children[sTop_to_level[sTop]]) - 1,
+            schema_->level_to_num_children[sTop_to_level[sTop]]);
       }
     }
     if (current_node == num_nodes_)
@@ -1556,7 +1938,7 @@ public:
     {
       node_path[root_depth_ + i] = symbol[i];
     }
-    if (root_depth_ != trie_depth_)
+    if (root_depth_ != schema_->trie_depth_)
     {
       ((tree_block<DIMENSION> *)parent_combined_ptr_)
           ->get_node_path(treeblock_frontier_num_, node_path);
@@ -1570,6 +1952,134 @@ public:
     return parent_symbol;
   }
 
+  // Resolves num_wanted primary keys, all of which map to this block, in a
+  // single preorder pass over it. wanted holds (key, destination) pairs
+  // sorted by key; a key may repeat. The symbols of the levels above this
+  // block are looked up once for all of them.
+  void lookup_primary_keys(
+      const std::pair<n_leaves_t, data_point<DIMENSION> *> *wanted,
+      size_t num_wanted)
+  {
+    const auto *wanted_end = wanted + num_wanted;
+    if (schema_->primary_key_index)
+    {
+      // No scan to share: every key is a search in the index.
+      std::vector<morton_t> node_path(schema_->max_depth_ + 1);
+      for (const auto *it = wanted; it != wanted_end; ++it)
+      {
+        node_path[schema_->max_depth_ - 1] =
+            get_node_path_primary_key(it->first, node_path);
+        node_path_to_coordinates(node_path, *it->second);
+        it->second->set_primary(it->first);
+      }
+      return;
+    }
+    std::vector<morton_t> node_path(schema_->max_depth_ + 1);
+    if (root_depth_ != schema_->trie_depth_)
+    {
+      ((tree_block<DIMENSION> *)parent_combined_ptr_)
+          ->get_node_path(treeblock_frontier_num_, node_path);
+    }
+    else
+    {
+      ((trie_node<DIMENSION> *)parent_combined_ptr_)
+          ->get_node_path(root_depth_, node_path);
+    }
+
+    // Per level on the way down: the node, its position, and its children
+    // still to be visited. node_path[level] holds the symbol being followed.
+    preorder_t stack[100];
+    preorder_t stack_node[100];
+    node_pos_t stack_node_pos[100];
+    int sTop = -1;
+
+    preorder_t current_node = 0;
+    node_pos_t current_node_pos = 0;
+    level_t current_level = root_depth_;
+    preorder_t current_frontier = 0;
+    n_leaves_t current_primary = 0;
+
+    while (current_node < num_nodes_ && num_wanted > 0)
+    {
+      morton_t num_children_bits = schema_->level_to_num_children[current_level];
+      if (current_frontier < num_frontiers_ &&
+          current_node == get_preorder(current_frontier))
+      {
+        // Its points are in the child block.
+        current_frontier++;
+      }
+      else if (current_level < schema_->max_depth_ - 1)
+      {
+        sTop++;
+        stack[sTop] = dfuds_->get_num_children(
+            current_node, current_node_pos, num_children_bits);
+        stack_node[sTop] = current_node;
+        stack_node_pos[sTop] = current_node_pos;
+        node_path[current_level] =
+            dfuds_->next_symbol(0,
+                                current_node,
+                                current_node_pos,
+                                (1 << num_children_bits) - 1,
+                                num_children_bits);
+        current_node_pos += dfuds_->get_num_bits(current_node, current_level);
+        current_node++;
+        current_level++;
+        continue;
+      }
+      else
+      {
+        preorder_t num_children = dfuds_->get_num_children(
+            current_node, current_node_pos, num_children_bits);
+        for (preorder_t k = 0; k < num_children; k++)
+        {
+          bits::compact_ptr &primary_keys = primary_key_list[current_primary + k];
+          n_leaves_t list_size = primary_keys.size();
+          for (n_leaves_t i = 0; i < list_size; i++)
+          {
+            n_leaves_t primary_key = primary_keys.get(i);
+            auto it = std::lower_bound(
+                wanted,
+                wanted_end,
+                primary_key,
+                [](const std::pair<n_leaves_t, data_point<DIMENSION> *> &entry,
+                   n_leaves_t key) { return entry.first < key; });
+            if (it == wanted_end || it->first != primary_key)
+              continue;
+            node_path[current_level] = dfuds_->get_k_th_set_bit(
+                current_node, k, current_node_pos, num_children_bits);
+            for (; it != wanted_end && it->first == primary_key; ++it)
+            {
+              node_path_to_coordinates(node_path, *it->second);
+              it->second->set_primary(primary_key);
+              num_wanted--;
+            }
+          }
+        }
+        current_primary += num_children;
+      }
+      current_node_pos += dfuds_->get_num_bits(current_node, current_level);
+      current_node++;
+
+      // Move on to the next symbol of the nearest node with children left.
+      while (sTop >= 0 && --stack[sTop] == 0)
+      {
+        sTop--;
+        current_level--;
+      }
+      if (sTop < 0)
+        break;
+      level_t parent_level = current_level - 1;
+      morton_t parent_bits = schema_->level_to_num_children[parent_level];
+      node_path[parent_level] =
+          dfuds_->next_symbol(node_path[parent_level] + 1,
+                              stack_node[sTop],
+                              stack_node_pos[sTop],
+                              (1 << parent_bits) - 1,
+                              parent_bits);
+    }
+    lookup_scanned_nodes += current_node;
+  }
+
   data_point<DIMENSION> *node_path_to_coordinates(
       std::vector<morton_t> &node_path,
       dimension_t dimension) const
@@ -1578,34 +2088,20 @@ public:
     // Will be free-ed in the benchmark code
     // auto coordinates = new data_point<DIMENSION>(width_);
     auto coordinates = new data_point<DIMENSION>();
+    node_path_to_coordinates(node_path, *coordinates);
+    return coordinates;
+  }
 
-    for (level_t lvl = 0; lvl < max_depth_; lvl++) {
-
-      auto &tbl = _dim_off_table[lvl];
-      morton_t current_symbol = node_path[lvl];
-
-      int tbl_size = tbl.size();
-      morton_t current_symbol_pos = (morton_t) tbl_size - 1;
-
-      for (uint16_t i = 0; i < tbl_size; i++) {
-
-        auto dim = tbl[i].first;
-
-        level_t current_bit = GETBIT(current_symbol, current_symbol_pos);
-        current_symbol_pos--;
+  // Writes the coordinates spelled by the symbols of node_path to point.
+  void node_path_to_coordinates(const std::vector<morton_t> &node_path,
+                                data_point<DIMENSION> &point) const
+  {
 
-        point_t coordinate = coordinates->get_coordinate(dim);
-        coordinate = (coordinate << 1) + current_bit;
-        coordinates->set_coordinate(dim, coordinate);
-      }
-    }
+    for (dimension_t i = 0; i < DIMENSION; i++)
+      point.set_coordinate(i, 0);
 
-    if (!coordinates)
-    {
-      std::cerr << "Range search failed!" << std::endl;
-      exit(-1);
-    }
-    return coordinates;
+    for (level_t lvl = 0; lvl < schema_->max_depth_; lvl++)
+      point.symbol_to_leaf(node_path[lvl], lvl, schema_);
   }
 
   std::vector<int32_t> node_path_to_coordinates_vect(
@@ -1615,30 +2111,15 @@ public:
     // Will be free-ed in the benchmark code
     std::vector<int32_t> ret_vect(dimension, 0);
 
-    for (level_t lvl = 0; lvl < max_depth_; lvl++) {
-
-      auto &tbl = _dim_off_table[lvl];
-      morton_t current_symbol = node_path[lvl];
-
-      int tbl_size = tbl.size();
-      morton_t current_symbol_pos = (morton_t) tbl_size - 1;
-
-      for (uint16_t i = 0; i < tbl_size; i++) {
-
-        auto dim = tbl[i].first;
-
-        level_t current_bit = GETBIT(current_symbol, current_symbol_pos);
-        current_symbol_pos--;
-
-        point_t coordinate = ret_vect[dim];
-        coordinate = (coordinate << 1) + current_bit;
-        ret_vect[dim] = coordinate;
-      }
-    }
+    data_point<DIMENSION> point;
+    node_path_to_coordinates(node_path, point);
+    for (dimension_t i = 0; i < dimension; i++)
+      ret_vect[i] = point.get_coordinate(i);
 
     return ret_vect;
   }
 
+  // Appends the coordinates of every match, DIMENSION values per point.
   void range_search_treeblock(data_point<DIMENSION> *start_range,
                               data_point<DIMENSION> *end_range,
                               tree_block<DIMENSION> *current_block,
@@ -1649,19 +2130,59 @@ public:
                               preorder_t prev_node_pos,
                               preorder_t current_frontier,
                               preorder_t current_primary,
-                              std::vector<int32_t> &found_points)
+                              std::vector<int32_t> &found_points,
+                              const frontier_spawner<DIMENSION>
+                                  *spawn_frontier = nullptr)
   {
+    range_search_treeblock(
+        start_range,
+        end_range,
+        current_block,
+        level,
+        current_node,
+        current_node_pos,
+        prev_node,
+        prev_node_pos,
+        current_frontier,
+        current_primary,
+        [&found_points](const data_point<DIMENSION> &point, n_leaves_t) {
+          for (dimension_t j = 0; j < DIMENSION; j++)
+            found_points.push_back(point.get_coordinate(j));
+          return true;
+        },
+        spawn_frontier);
+  }
 
-    if (level == max_depth_)
+  // Hands every match to visit as it is found. Returns false if visit
+  // stopped the search. If covered_points is given, subtrees the range
+  // covers whole are not searched: their number of points is added to
+  // *covered_points instead, and visit only sees the remaining matches.
+  bool range_search_treeblock(data_point<DIMENSION> *start_range,
+                              data_point<DIMENSION> *end_range,
+                              tree_block<DIMENSION> *current_block,
+                              level_t level,
+                              preorder_t current_node,
+                              preorder_t current_node_pos,
+                              preorder_t prev_node,
+                              preorder_t prev_node_pos,
+                              preorder_t current_frontier,
+                              preorder_t current_primary,
+                              const range_visitor<DIMENSION> &visit,
+                              const frontier_spawner<DIMENSION>
+                                  *spawn_frontier = nullptr,
+                              n_leaves_t *covered_points = nullptr)
+  {
+
+    if (level == schema_->max_depth_)
     {
 
-      morton_t parent_symbol = start_range->leaf_to_symbol(max_depth_ - 1);
+      morton_t parent_symbol = start_range->leaf_to_symbol(schema_->max_depth_ - 1, schema_);
       morton_t tmp_symbol =
           dfuds_->next_symbol(0,
                               prev_node,
                               prev_node_pos,
-                              (1 << level_to_num_children[level - 1]) - 1,
-                              level_to_num_children[level - 1]);
+                              (1 << schema_->level_to_num_children[level - 1]) - 1,
+                              schema_->level_to_num_children[level - 1]);
 
       while (tmp_symbol != parent_symbol)
       {
@@ -1669,25 +2190,35 @@ public:
             dfuds_->next_symbol(tmp_symbol + 1,
                                 prev_node,
                                 prev_node_pos,
-                                (1 << level_to_num_children[level - 1]) - 1,
-                                level_to_num_children[level - 1]);
+                                (1 << schema_->level_to_num_children[level - 1]) - 1,
+                                schema_->level_to_num_children[level - 1]);
         current_primary++;
       }
 
-      n_leaves_t list_size = primary_key_list[current_primary].size();
+      bits::compact_ptr &primary_keys = primary_key_list[current_primary];
+      n_leaves_t list_size = primary_keys.size();
       for (n_leaves_t i = 0; i < list_size; i++)
       {
-        for (dimension_t j = 0; j < DIMENSION; j++)
-        {
-          found_points.push_back(start_range->get_coordinate(j));
-        }
+        if (!visit(*start_range, primary_keys.get(i)))
+          return false;
       }
-      return;
+      return true;
     }
 
     if (current_node >= num_nodes_)
     {
-      return;
+      return true;
+    }
+
+    if (covered_points &&
+        start_range->covers_subtree(end_range, level, schema_))
+    {
+      *covered_points += subtree_points(current_node,
+                                        current_node_pos,
+                                        level,
+                                        current_frontier,
+                                        current_primary);
+      return true;
     }
 
     if (num_frontiers() > 0 && current_frontier < num_frontiers() &&
@@ -1695,24 +2226,30 @@ public:
     {
 
       tree_block<DIMENSION> *new_current_block = get_pointer(current_frontier);
+      if (spawn_frontier)
+      {
+        (*spawn_frontier)(new_current_block, level, start_range, end_range);
+        return true;
+      }
       preorder_t new_current_frontier = 0;
       preorder_t new_current_primary = 0;
-      new_current_block->range_search_treeblock(start_range,
-                                                end_range,
-                                                new_current_block,
-                                                level,
-                                                0,
-                                                0,
-                                                0,
-                                                0,
-                                                new_current_frontier,
-                                                new_current_primary,
-                                                found_points);
-      return;
+      return new_current_block->range_search_treeblock(start_range,
+                                                       end_range,
+                                                       new_current_block,
+                                                       level,
+                                                       0,
+                                                       0,
+                                                       0,
+                                                       0,
+                                                       new_current_frontier,
+                                                       new_current_primary,
+                                                       visit,
+                                                       nullptr,
+                                                       covered_points);
     }
 
-    morton_t start_range_symbol = start_range->leaf_to_symbol(level);
-    morton_t end_range_symbol = end_range->leaf_to_symbol(level);
+    morton_t start_range_symbol = start_range->leaf_to_symbol(level, schema_);
+    morton_t end_range_symbol = end_range->leaf_to_symbol(level, schema_);
     morton_t representation = start_range_symbol ^ end_range_symbol;
     morton_t neg_representation = ~representation;
 
@@ -1729,7 +2266,7 @@ public:
                                                   current_node,
                                                   current_node_pos,
                                                   end_range_symbol,
-                                                  level_to_num_children[level]);
+                                                  schema_->level_to_num_children[level]);
 
     preorder_t stack_range_search[100];
     int sTop_range_search = -1;
@@ -1745,14 +2282,14 @@ public:
     if (!query_optimization)
     {
       current_symbol = 0;
-      end_range_symbol = end_range->leaf_to_full_symbol(level);
+      end_range_symbol = end_range->leaf_to_full_symbol(level, schema_);
     }
     while (current_symbol <= end_range_symbol)
     {
       if (!dfuds_->has_symbol(current_node,
                               current_node_pos,
                               current_symbol,
-                              level_to_num_children[level]))
+                              schema_->level_to_num_children[level]))
       {
         continue;
       }
@@ -1767,7 +2304,7 @@ public:
         new_current_node_pos = current_node_pos;
 
         if (REUSE_RANGE_SEARCH_CHILD &&
-            level < max_depth_ - 1 /*At least 1 levels to the bottom*/)
+            level < schema_->max_depth_ - 1 /*At least 1 levels to the bottom*/)
         {
           new_current_node = current_block->child_range_search(
               current_node,
@@ -1793,50 +2330,278 @@ public:
                                                   new_current_frontier,
                                                   new_current_primary);
 
-        start_range->update_symbol(end_range, current_symbol, level);
-        current_block->range_search_treeblock(start_range,
-                                              end_range,
-                                              current_block,
-                                              level + 1,
-                                              new_current_node,
-                                              new_current_node_pos,
-                                              current_node,
-                                              current_node_pos,
-                                              new_current_frontier,
-                                              new_current_primary,
-                                              found_points);
+        start_range->update_symbol(end_range, current_symbol, level, schema_);
+        bool go_on = current_block->range_search_treeblock(start_range,
+                                                           end_range,
+                                                           current_block,
+                                                           level + 1,
+                                                           new_current_node,
+                                                           new_current_node_pos,
+                                                           current_node,
+                                                           current_node_pos,
+                                                           new_current_frontier,
+                                                           new_current_primary,
+                                                           visit,
+                                                           spawn_frontier,
+                                                           covered_points);
 
         (*start_range) = original_start_range;
         (*end_range) = original_end_range;
+        if (!go_on)
+          return false;
       }
       current_symbol = dfuds_->next_symbol(current_symbol + 1,
                                            current_node,
                                            current_node_pos,
                                            end_range_symbol,
-                                           level_to_num_children[level]);
+                                           schema_->level_to_num_children[level]);
+    }
+    return true;
+  }
+
+  // Pushes the children of candidate, a node of this treeblock, onto heap
+  // (see md_trie::knn_search), each with the box below it narrowed by its
+  // symbol and its distance from query. Below the last level the children are
+  // the stored points, one candidate per primary key. A frontier node is
+  // expanded in the treeblock it points to.
+  void knn_expand(const knn_candidate<DIMENSION> &candidate,
+                  const data_point<DIMENSION> &query,
+                  const knn_distance &distance,
+                  std::vector<knn_candidate<DIMENSION>> &heap)
+  {
+
+    preorder_t current_node = candidate.node_;
+    preorder_t current_node_pos = candidate.node_pos_;
+    preorder_t current_frontier = candidate.frontier_;
+    preorder_t current_primary = candidate.primary_;
+    level_t level = candidate.level_;
+
+    if (current_node >= num_nodes_)
+      return;
+
+    if (num_frontiers() > 0 && current_frontier < num_frontiers() &&
+        current_node == get_preorder(current_frontier))
+    {
+      knn_candidate<DIMENSION> root = candidate;
+      root.block_ = get_pointer(current_frontier);
+      root.node_ = 0;
+      root.node_pos_ = 0;
+      root.frontier_ = 0;
+      root.primary_ = 0;
+      root.block_->knn_expand(root, query, distance, heap);
+      return;
+    }
+
+    morton_t num_children = schema_->level_to_num_children[level];
+    morton_t last_symbol = low_bits_set[num_children];
+    bool leaf_level = level == schema_->max_depth_ - 1;
+
+    preorder_t stack_range_search[100];
+    int sTop_range_search = -1;
+    preorder_t current_node_pos_range_search = 0;
+    preorder_t current_node_range_search = 0;
+    preorder_t next_frontier_preorder_range_search = 0;
+    preorder_t current_frontier_cont = 0;
+    preorder_t current_primary_cont = 0;
+
+    morton_t current_symbol = dfuds_->next_symbol(
+        0, current_node, current_node_pos, last_symbol, num_children);
+    while (current_symbol <= last_symbol)
+    {
+      knn_candidate<DIMENSION> child;
+      child.start_range_ = candidate.start_range_;
+      child.end_range_ = candidate.end_range_;
+      child.start_range_.update_symbol(
+          &child.end_range_, current_symbol, level, schema_);
+
+      if (leaf_level)
+      {
+        child.distance_ = distance.to_point(query, child.start_range_);
+        bits::compact_ptr &primary_keys = primary_key_list[current_primary];
+        n_leaves_t list_size = primary_keys.size();
+        for (n_leaves_t i = 0; i < list_size; i++)
+        {
+          knn_candidate<DIMENSION> point = child;
+          point.primary_key_ = primary_keys.get(i);
+          knn_candidate<DIMENSION>::push(heap, std::move(point));
+        }
+        current_primary++;
+      }
+      else
+      {
+        child.block_ = this;
+        child.node_pos_ = current_node_pos;
+        child.frontier_ = current_frontier;
+        child.primary_ = current_primary;
+        child.level_ = level + 1;
+        child.node_ = child_range_search(current_node,
+                                         child.node_pos_,
+                                         current_symbol,
+                                         level,
+                                         child.frontier_,
+                                         child.primary_,
+                                         stack_range_search,
+                                         sTop_range_search,
+                                         current_node_pos_range_search,
+                                         current_node_range_search,
+                                         next_frontier_preorder_range_search,
+                                         current_frontier_cont,
+                                         current_primary_cont);
+        child.distance_ =
+            distance.to_box(query, child.start_range_, child.end_range_);
+        knn_candidate<DIMENSION>::push(heap, std::move(child));
+      }
+      current_symbol = dfuds_->next_symbol(current_symbol + 1,
+                                           current_node,
+                                           current_node_pos,
+                                           last_symbol,
+                                           num_children);
+    }
+  }
+
+  // Fills a freshly constructed (empty) treeblock with the points
+  // [start, end) of input, which share their first root_depth_ symbols.
+  // Nodes are emitted in preorder in a single pass. A child subtree is kept
+  // inline if it fits in the remaining node budget; otherwise it becomes a
+  // frontier, unless it is too large for a treeblock of its own, in which case
+  // its root is kept inline and the decision moves down to its children.
+  void bulk_load(bulk_load_input<DIMENSION> &input,
+                 n_leaves_t start,
+                 n_leaves_t end,
+                 bitmap::CompactPtrVector *p_key_to_treeblock_compact)
+  {
+    drop_lookup_index();
+    drop_subtree_directory();
+    bulk_load_builder builder;
+    builder.max_tree_nodes_ = max_tree_nodes_at_root_depth();
+    builder.child_starts_.resize(schema_->max_depth_);
+    bulk_load_node(input, builder, start, end, root_depth_);
+
+    auto *new_dfuds = create_dfuds(builder.num_nodes_, builder.num_bits_);
+    for (preorder_t i = 0; i < BITS2BLOCKS(builder.num_bits_); i++)
+      new_dfuds->SetValPos(i * 64, builder.data_[i], 64, true);
+    for (preorder_t i = 0; i < BITS2BLOCKS(builder.num_nodes_); i++)
+      new_dfuds->SetValPos(i * 64, builder.flag_[i], 64, false);
+    destroy_dfuds(dfuds_);
+    dfuds_ = new_dfuds;
+    num_nodes_ = builder.num_nodes_;
+    node_capacity_ = builder.num_nodes_;
+    total_nodes_bits_ = builder.num_bits_;
+
+    size_t old_list_bytes = primary_key_list.allocated_bytes();
+    primary_key_list.assign(builder.primary_key_list_.data(),
+                            builder.primary_key_list_.size());
+    account_primary_key_list(old_list_bytes);
+    for (preorder_t i = 0; i < primary_key_list.size(); i++)
+    {
+      account(MEMORY_PRIMARY_KEY_LISTS,
+              primary_key_list[i].size_overhead() - sizeof(bits::compact_ptr));
+      uint64_t primary_key_size = primary_key_list[i].size();
+      num_points_ += primary_key_size;
+      for (uint64_t j = 0; j < primary_key_size; j++)
+        p_key_to_treeblock_compact->Set(primary_key_list[i].get(j), this);
+    }
+
+    num_frontiers_ = builder.frontiers_.size();
+    if (num_frontiers_ > 0)
+    {
+      frontiers_ = resize_frontiers(nullptr, 0, num_frontiers_);
+    }
+    for (preorder_t j = 0; j < num_frontiers_; j++)
+    {
+      const bulk_load_frontier &frontier = builder.frontiers_[j];
+      auto *child_block =
+          create_block(frontier.level_,
+                       1 /* initial_tree_capacity_ */,
+                       1 << schema_->level_to_num_children[frontier.level_],
+                       1);
+      child_block->bulk_load(
+          input, frontier.start_, frontier.end_, p_key_to_treeblock_compact);
+      set_preorder(j, frontier.preorder_);
+      set_pointer(j, child_block);
+      num_points_ += child_block->num_points_;
+    }
+  }
+
+  // Acquires this block's latch, then releases the one held by the caller, so
+  // the block being descended into is latched before its parent is let go.
+  void couple_latch(std::unique_lock<std::mutex> *held_latch)
+  {
+    std::unique_lock<std::mutex> next_latch(latch_);
+    *held_latch = std::move(next_latch);
+  }
+
+  void set_primary_key_treeblock(
+      n_leaves_t primary_key,
+      bitmap::CompactPtrVector *p_key_to_treeblock_compact,
+      bool concurrent)
+  {
+    if (concurrent)
+    {
+      std::lock_guard<std::mutex> map_lock(p_key_to_treeblock_lock);
+      p_key_to_treeblock_compact->Set(primary_key, this);
     }
+    else
+      p_key_to_treeblock_compact->Set(primary_key, this);
   }
 
   void insert_primary_key_at_present_index(
       n_leaves_t index,
       n_leaves_t primary_key,
-      bitmap::CompactPtrVector *p_key_to_treeblock_compact)
+      bitmap::CompactPtrVector *p_key_to_treeblock_compact,
+      bool concurrent = false)
   {
 
-    p_key_to_treeblock_compact->Set(primary_key, this);
-    primary_key_list[index].push(primary_key);
+    set_primary_key_treeblock(
+        primary_key, p_key_to_treeblock_compact, concurrent);
+    uint64_t old_size = primary_key_list[index].size_overhead();
+    primary_key_list[index].push(primary_key, arena_);
+    account(MEMORY_PRIMARY_KEY_LISTS,
+            (int64_t)primary_key_list[index].size_overhead() - old_size);
   }
 
   void insert_primary_key_at_index(
       n_leaves_t index,
       n_leaves_t primary_key,
-      bitmap::CompactPtrVector *p_key_to_treeblock_compact)
+      bitmap::CompactPtrVector *p_key_to_treeblock_compact,
+      bool concurrent = false)
   {
 
-    p_key_to_treeblock_compact->Set(primary_key, this);
+    set_primary_key_treeblock(
+        primary_key, p_key_to_treeblock_compact, concurrent);
 
     auto primary_key_ptr = bits::compact_ptr(primary_key);
-    primary_key_list.insert(primary_key_list.begin() + index, primary_key_ptr);
+    size_t old_list_bytes = primary_key_list.allocated_bytes();
+    primary_key_list.insert(index, primary_key_ptr);
+    account_primary_key_list(old_list_bytes);
+  }
+
+  // Frees the lists of duplicate primary keys of a block about to be
+  // destroyed for good (rather than merged into its parent, which takes
+  // the lists over).
+  void release_primary_key_lists()
+  {
+    for (auto &primary_keys : primary_key_list)
+    {
+      account(MEMORY_PRIMARY_KEY_LISTS,
+              -(int64_t)(primary_keys.size_overhead() -
+                         sizeof(bits::compact_ptr)));
+      primary_keys.release(arena_);
+    }
+  }
+
+  // Trims the DFUDS to the nodes in use and gives back the spare words of it
+  // and of the primary key list, here and in the treeblocks below; for
+  // blocks no longer inserted into.
+  void compact()
+  {
+    shrink_to_fit();
+    dfuds_->shrink_to_fit();
+    size_t old_list_bytes = primary_key_list.allocated_bytes();
+    primary_key_list.shrink_to_fit();
+    account_primary_key_list(old_list_bytes);
+    for (preorder_t j = 0; j < num_frontiers_; j++)
+      get_pointer(j)->compact();
   }
 
   uint64_t size()
@@ -1867,11 +2632,19 @@ public:
       }
     // }
     total_size += sizeof(num_frontiers_);
+    total_size += sizeof(num_points_);
+    total_size += sizeof(lookup_index_);
+    if (lookup_index_)
+      total_size += lookup_index_->size();
+    total_size += sizeof(subtree_directory_);
+    if (subtree_directory_)
+      total_size += subtree_directory_->size();
 
     total_size += sizeof(parent_combined_ptr_);
     total_size += sizeof(treeblock_frontier_num_);
-    total_size += sizeof(primary_key_list) +
-                  primary_key_list.size() * sizeof(bits::compact_ptr);
+    total_size += sizeof(latch_);
+    total_size += sizeof(schema_);
+    total_size += sizeof(primary_key_list) + primary_key_list.allocated_bytes();
     for (preorder_t i = 0; i < primary_key_list.size(); i++)
     {
       // if (is_valid((void *) &primary_key_list[i]))
@@ -1880,8 +2653,859 @@ public:
     return total_size;
   }
 
+  // Writes this block, its bitmap, frontiers and primary key lists, and the
+  // child blocks behind its frontiers into writer's image. parent_address is
+  // the image address of the parent trie node or block. Returns the block's
+  // image address.
+  uintptr_t save(snapshot_writer &writer, uintptr_t parent_address)
+  {
+    uint64_t offset = writer.allocate(sizeof(tree_block));
+    uintptr_t address = writer.address(offset);
+    writer.block_address_[this] = address;
+
+    std::vector<frontier_node<DIMENSION>> frontiers(frontiers_,
+                                                    frontiers_ + num_frontiers_);
+    for (auto &frontier : frontiers)
+      frontier.pointer_ =
+          (tree_block<DIMENSION> *)frontier.pointer_->save(writer, address);
+
+    // Lists of duplicates are written as plain sorted vectors, whatever
+    // their in-memory encoding.
+    std::vector<bits::compact_ptr> list(primary_key_list.begin(),
+                                        primary_key_list.end());
+    std::vector<n_leaves_t> keys;
+    for (auto &ptr : list)
+    {
+      if (ptr.size() == 1)
+        continue;
+      keys.resize(ptr.size());
+      for (n_leaves_t i = 0; i < keys.size(); i++)
+        keys[i] = ptr.get(i);
+      ptr.set_vector_pointer((std::vector<n_leaves_t> *)writer.append_vector(
+          keys.data(), keys.size()));
+    }
+
+    alignas(tree_block) unsigned char image[sizeof(tree_block)];
+    memcpy(image, (const void *)this, sizeof(tree_block));
+    auto *block = (tree_block *)image;
+    block->schema_ = (const trie_schema *)writer.schema_address_;
+    block->arena_ = nullptr;
+    block->dfuds_ = (compressed_bitmap::compressed_bitmap *)dfuds_->save(writer);
+    block->frontiers_ =
+        num_frontiers_ ? (frontier_node<DIMENSION> *)writer.append(
+                             frontiers.data(),
+                             num_frontiers_ * sizeof(frontier_node<DIMENSION>))
+                       : nullptr;
+    block->parent_combined_ptr_ = (void *)parent_address;
+    block->primary_key_list.set_image(writer, list);
+    // The index is written too, as a mapped block cannot build one.
+    block->lookup_index_ =
+        schema_->primary_key_index
+            ? (primary_key_index *)writer.append(lookup_index(),
+                                                 lookup_index()->size())
+            : nullptr;
+    // Mapped blocks have no arena to build a directory with (see directory).
+    block->subtree_directory_ = nullptr;
+    new (&block->latch_) std::mutex;
+    writer.write(offset, image, sizeof(image));
+    return address;
+  }
+
 private:
+  // Resizes a frontier array of old_size entries (nullptr if 0) to new_size
+  // entries (nullptr if 0), in the trie's node_arena if it has one.
+  frontier_node<DIMENSION> *resize_frontiers(frontier_node<DIMENSION> *frontiers,
+                                             preorder_t old_size,
+                                             preorder_t new_size)
+  {
+    size_t entry = sizeof(frontier_node<DIMENSION>);
+    if (arena_)
+    {
+      account(MEMORY_FRONTIERS,
+              ((int64_t)new_size - (int64_t)old_size) * (int64_t)entry);
+      return (frontier_node<DIMENSION> *)arena_->reallocate(
+          frontiers, old_size * entry, new_size * entry);
+    }
+    if (new_size == 0)
+    {
+      free(frontiers);
+      return nullptr;
+    }
+    return (frontier_node<DIMENSION> *)realloc(frontiers, new_size * entry);
+  }
+
+  inline void release_frontiers(frontier_node<DIMENSION> *frontiers,
+                                preorder_t size)
+  {
+    resize_frontiers(frontiers, size, 0);
+  }
+
+  // The block's primary_key_index, built from a preorder pass over the block
+  // unless it has one (inserts keep it up to date). Lookups may run concurrently; the latch makes
+  // one of them build it.
+  primary_key_index *lookup_index()
+  {
+    primary_key_index *index =
+        __atomic_load_n(&lookup_index_, __ATOMIC_ACQUIRE);
+    if (index)
+      return index;
+    std::lock_guard<std::mutex> guard(latch_);
+    index = lookup_index_;
+    if (!index)
+    {
+      index = build_lookup_index();
+      account(MEMORY_LOOKUP_INDEX, index->size());
+      __atomic_store_n(&lookup_index_, index, __ATOMIC_RELEASE);
+    }
+    return index;
+  }
+
+  // The block's index, if it has one, with room for keys more keys, nodes
+  // more nodes and leaf_nodes more leaf-level nodes, for insert to record
+  // them in place.
+  inline primary_key_index *lookup_index_with_room(uint32_t keys,
+                                                   uint32_t nodes,
+                                                   uint32_t leaf_nodes)
+  {
+    if (!lookup_index_)
+      return nullptr;
+    size_t old_size = lookup_index_->size();
+    lookup_index_ = primary_key_index::reserve(
+        lookup_index_, keys, nodes, leaf_nodes, arena_);
+    account(MEMORY_LOOKUP_INDEX, (int64_t)lookup_index_->size() - old_size);
+    return lookup_index_;
+  }
+
+  // Called before the block is split, merged or deleted from; the index is
+  // rebuilt on the next lookup.
+  inline void drop_lookup_index()
+  {
+    if (lookup_index_)
+      account(MEMORY_LOOKUP_INDEX, -(int64_t)lookup_index_->size());
+    primary_key_index::release(lookup_index_, arena_);
+    lookup_index_ = nullptr;
+  }
+
+  // The block's subtree_directory when schema_->subtree_directory is set,
+  // built from a preorder pass over the block unless there is one. Readers
+  // may race to build it; one of their copies is kept. Blocks of a trie
+  // opened with open_mmap (which have no node_arena) go without.
+  subtree_directory *directory()
+  {
+    if (!schema_->subtree_directory || !arena_)
+      return nullptr;
+    subtree_directory *directory =
+        __atomic_load_n(&subtree_directory_, __ATOMIC_ACQUIRE);
+    if (directory)
+      return directory;
+    directory = build_subtree_directory();
+    subtree_directory *expected = nullptr;
+    if (!__atomic_compare_exchange_n(&subtree_directory_,
+                                     &expected,
+                                     directory,
+                                     false,
+                                     __ATOMIC_ACQ_REL,
+                                     __ATOMIC_ACQUIRE))
+    {
+      arena_->release(directory, directory->size());
+      return expected;
+    }
+    account(MEMORY_SUBTREE_DIRECTORY, directory->size());
+    return directory;
+  }
+
+  // Called before the block changes other than by an insertion the
+  // directory follows (see note_insertion); it is rebuilt on next use.
+  inline void drop_subtree_directory()
+  {
+    if (subtree_directory_)
+    {
+      account(MEMORY_SUBTREE_DIRECTORY, -(int64_t)subtree_directory_->size());
+      arena_->release(subtree_directory_, subtree_directory_->size());
+    }
+    subtree_directory_ = nullptr;
+  }
+
+  // Brings the directory up to date with an insertion below node that added
+  // nodes at preorder at; the counts before it are passed in.
+  inline void note_insertion(preorder_t node,
+                             preorder_t at,
+                             preorder_t num_nodes_before,
+                             node_pos_t num_bits_before,
+                             n_leaves_t num_primary_before)
+  {
+    if (!subtree_directory_)
+      return;
+    subtree_directory_->record_insert(
+        node,
+        at,
+        num_nodes_ - num_nodes_before,
+        total_nodes_bits_ - num_bits_before,
+        primary_key_list.size() - num_primary_before);
+    if (subtree_directory_->stale())
+      drop_subtree_directory();
+  }
+
+  // If directory lists a subtree rooted at node, moves node, node_pos,
+  // current_frontier and current_primary past it, as a walk over it would,
+  // and returns true. cursor is an index into the directory that only moves
+  // forward, as node does.
+  inline bool skip_listed_subtree(subtree_directory *directory,
+                                  uint32_t &cursor,
+                                  preorder_t &node,
+                                  node_pos_t &node_pos,
+                                  preorder_t &current_frontier,
+                                  preorder_t &current_primary,
+                                  preorder_t &next_frontier_preorder)
+  {
+    subtree_entry *entries = directory->entries();
+    while (cursor < directory->num_entries_ && entries[cursor].node_ < node)
+      cursor++;
+    if (cursor == directory->num_entries_ || entries[cursor].node_ != node)
+      return false;
+    node += entries[cursor].num_nodes_;
+    node_pos += entries[cursor].num_bits_;
+    current_primary += entries[cursor].num_primary_;
+    if (entries[cursor].num_frontiers_)
+    {
+      current_frontier += entries[cursor].num_frontiers_;
+      if (current_frontier >= num_frontiers_)
+        next_frontier_preorder = -1;
+      else
+        next_frontier_preorder = get_preorder(current_frontier);
+    }
+    return true;
+  }
+
+  subtree_directory *build_subtree_directory()
+  {
+    // Per open node on the path: where its subtree started and how many of
+    // its children are still to be visited.
+    struct open_node
+    {
+      preorder_t node_;
+      node_pos_t node_pos_;
+      preorder_t frontier_;
+      n_leaves_t primary_;
+      preorder_t children_left_;
+      bool branching_;
+    };
+    open_node stack[100];
+    int sTop = -1;
+    std::vector<subtree_entry> entries;
+
+    preorder_t current_node = 0;
+    node_pos_t current_node_pos = 0;
+    level_t current_level = root_depth_;
+    preorder_t current_frontier = 0;
+    n_leaves_t current_primary = 0;
+
+    while (current_node < num_nodes_)
+    {
+      morton_t num_children_bits = schema_->level_to_num_children[current_level];
+      node_pos_t num_bits = dfuds_->get_num_bits(current_node, current_level);
+      if (current_frontier < num_frontiers_ &&
+          get_preorder(current_frontier) == current_node)
+        current_frontier++;
+      else if (current_level == schema_->max_depth_ - 1)
+        current_primary += dfuds_->get_num_children(
+            current_node, current_node_pos, num_children_bits);
+      else
+      {
+        preorder_t num_children = dfuds_->get_num_children(
+            current_node, current_node_pos, num_children_bits);
+        stack[++sTop] = {current_node,
+                         current_node_pos,
+                         current_frontier,
+                         current_primary,
+                         num_children,
+                         num_children > 1};
+        current_node_pos += num_bits;
+        current_node++;
+        current_level++;
+        continue;
+      }
+      current_node_pos += num_bits;
+      current_node++;
+
+      // Close the subtrees this leaf was the last node of.
+      while (sTop >= 0 && --stack[sTop].children_left_ == 0)
+      {
+        open_node &closed = stack[sTop--];
+        current_level--;
+        if (sTop >= 0 && stack[sTop].branching_ &&
+            current_node - closed.node_ >= subtree_directory::min_nodes)
+          entries.push_back({(uint32_t)closed.node_,
+                             (uint32_t)(current_node - closed.node_),
+                             (uint32_t)(current_node_pos - closed.node_pos_),
+                             (uint32_t)(current_frontier - closed.frontier_),
+                             (uint32_t)(current_primary - closed.primary_)});
+      }
+    }
+
+    // Subtrees close children first; list them in preorder.
+    std::sort(entries.begin(),
+              entries.end(),
+              [](const subtree_entry &a, const subtree_entry &b)
+              { return a.node_ < b.node_; });
+    subtree_directory *directory =
+        subtree_directory::create(entries.size(), num_nodes_, arena_);
+    std::copy(entries.begin(), entries.end(), directory->entries());
+    return directory;
+  }
+
+  // Records a change of delta bytes in component of the trie's memory
+  // usage; blocks without a node_arena are not counted.
+  inline void account(memory_component component, int64_t delta)
+  {
+    if (arena_)
+      arena_->usage().add(component, delta);
+  }
+
+  // Records the change in the primary key list's footprint since it took
+  // old_bytes.
+  inline void account_primary_key_list(size_t old_bytes)
+  {
+    account(MEMORY_PRIMARY_KEY_LISTS,
+            (int64_t)primary_key_list.allocated_bytes() - (int64_t)old_bytes);
+  }
+
+  primary_key_index *build_lookup_index()
+  {
+    std::vector<uint32_t> parents(num_nodes_), symbols(num_nodes_);
+    std::vector<uint32_t> leaf_first, leaf_preorder, leaf_pos;
+    std::vector<std::pair<n_leaves_t, uint32_t>> keys;
+
+    // Per level on the way down: the node, its position, its children still
+    // to be visited and the symbol being followed.
+    preorder_t stack[100];
+    preorder_t stack_node[100];
+    node_pos_t stack_node_pos[100];
+    morton_t stack_symbol[100];
+    int sTop = -1;
+
+    preorder_t current_node = 0;
+    node_pos_t current_node_pos = 0;
+    level_t current_level = root_depth_;
+    preorder_t current_frontier = 0;
+    n_leaves_t current_primary = 0;
+    parents[0] = symbols[0] = 0;
+
+    while (current_node < num_nodes_)
+    {
+      if (sTop >= 0)
+      {
+        parents[current_node] = stack_node[sTop];
+        symbols[current_node] = stack_symbol[sTop];
+      }
+      morton_t num_children_bits = schema_->level_to_num_children[current_level];
+      if (current_frontier < num_frontiers_ &&
+          current_node == get_preorder(current_frontier))
+      {
+        current_frontier++;
+      }
+      else if (current_level < schema_->max_depth_ - 1)
+      {
+        sTop++;
+        stack[sTop] = dfuds_->get_num_children(
+            current_node, current_node_pos, num_children_bits);
+        stack_node[sTop] = current_node;
+        stack_node_pos[sTop] = current_node_pos;
+        stack_symbol[sTop] = dfuds_->next_symbol(0,
+                                                 current_node,
+                                                 current_node_pos,
+                                                 (1 << num_children_bits) - 1,
+                                                 num_children_bits);
+        current_node_pos += dfuds_->get_num_bits(current_node, current_level);
+        current_node++;
+        current_level++;
+        continue;
+      }
+      else
+      {
+        preorder_t num_children = dfuds_->get_num_children(
+            current_node, current_node_pos, num_children_bits);
+        leaf_first.push_back(current_primary);
+        leaf_preorder.push_back(current_node);
+        leaf_pos.push_back(current_node_pos);
+        for (preorder_t k = 0; k < num_children; k++)
+        {
+          bits::compact_ptr &primary_keys = primary_key_list[current_primary + k];
+          n_leaves_t list_size = primary_keys.size();
+          for (n_leaves_t i = 0; i < list_size; i++)
+            keys.emplace_back(primary_keys.get(i), current_primary + k);
+        }
+        current_primary += num_children;
+      }
+      current_node_pos += dfuds_->get_num_bits(current_node, current_level);
+      current_node++;
+
+      while (sTop >= 0 && --stack[sTop] == 0)
+      {
+        sTop--;
+        current_level--;
+      }
+      if (sTop < 0)
+        break;
+      morton_t parent_bits = schema_->level_to_num_children[current_level - 1];
+      stack_symbol[sTop] = dfuds_->next_symbol(stack_symbol[sTop] + 1,
+                                               stack_node[sTop],
+                                               stack_node_pos[sTop],
+                                               (1 << parent_bits) - 1,
+                                               parent_bits);
+    }
+
+    std::sort(keys.begin(), keys.end());
+    auto *index = primary_key_index::create(
+        keys.size(), num_nodes_, leaf_first.size(), arena_);
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+      index->keys()[i] = keys[i].first;
+      index->key_leaves()[i] = keys[i].second;
+    }
+    std::copy(parents.begin(), parents.end(), index->node_parents());
+    std::copy(symbols.begin(), symbols.end(), index->node_symbols());
+    std::copy(leaf_first.begin(), leaf_first.end(), index->leaf_node_first_leaves());
+    std::copy(leaf_preorder.begin(), leaf_preorder.end(), index->leaf_node_preorders());
+    std::copy(leaf_pos.begin(), leaf_pos.end(), index->leaf_node_positions());
+    return index;
+  }
+
+  // Fills node_path with the symbols leading to node (not the root) from
+  // this block's index, and those above the block.
+  void index_node_path(preorder_t node, std::vector<morton_t> &node_path)
+  {
+    primary_key_index *index = lookup_index();
+    morton_t symbols[100];
+    int depth = 0;
+    while (node != 0)
+    {
+      symbols[depth++] = index->node_symbols()[node];
+      node = index->node_parents()[node];
+    }
+    for (int i = 0; i < depth; i++)
+      node_path[root_depth_ + depth - 1 - i] = symbols[i];
+
+    if (root_depth_ != schema_->trie_depth_)
+    {
+      ((tree_block<DIMENSION> *)parent_combined_ptr_)
+          ->get_node_path(treeblock_frontier_num_, node_path);
+    }
+    else
+    {
+      ((trie_node<DIMENSION> *)parent_combined_ptr_)
+          ->get_node_path(root_depth_, node_path);
+    }
+  }
+
+  preorder_t max_tree_nodes_at_root_depth() const
+  {
+    if (schema_->no_dynamic_sizing)
+      return schema_->max_tree_nodes_;
+    if (root_depth_ <= schema_->max_depth_ / 2)
+      return schema_->max_tree_nodes_ / 4;
+    if (root_depth_ <= schema_->max_depth_ / 4 * 3)
+      return schema_->max_tree_nodes_ / 2;
+    return schema_->max_tree_nodes_;
+  }
+
+  // Number of points under node (at level < max_depth_). current_frontier
+  // and current_primary are the first frontier and primary key list at or
+  // after node, as child leaves them. The block root and frontier nodes are
+  // answered from num_points_; otherwise the subtree is skipped over like in
+  // skip_children_subtree, adding up the cached totals of the frontiers it
+  // holds and the sizes of the primary key lists of its leaf-level nodes.
+  n_leaves_t subtree_points(preorder_t node,
+                            node_pos_t node_pos,
+                            level_t level,
+                            preorder_t current_frontier,
+                            preorder_t current_primary)
+  {
+    if (node == 0)
+      return num_points_;
+
+    while (current_frontier < num_frontiers_ &&
+           get_preorder(current_frontier) < node)
+      current_frontier++;
+    if (current_frontier < num_frontiers_ &&
+        get_preorder(current_frontier) == node)
+      return get_pointer(current_frontier)->num_points_;
+
+    n_leaves_t points = 0;
+    n_leaves_t num_lists = 0;
+    if (level == schema_->max_depth_ - 1)
+    {
+      num_lists = dfuds_->get_num_children(
+          node, node_pos, schema_->level_to_num_children[level]);
+    }
+    else
+    {
+      preorder_t stack[100];
+      int sTop = 0;
+      stack[sTop] = dfuds_->get_num_children(
+          node, node_pos, schema_->level_to_num_children[level]);
+      node_pos_t current_node_pos =
+          node_pos + dfuds_->get_num_bits(node, level);
+      preorder_t current_node = node + 1;
+      level_t current_level = level + 1;
+
+      while (sTop >= 0)
+      {
+        if (current_frontier < num_frontiers_ &&
+            current_node == get_preorder(current_frontier))
+        {
+          points += get_pointer(current_frontier)->num_points_;
+          current_frontier++;
+          stack[sTop]--;
+          current_node_pos +=
+              dfuds_->get_num_bits(current_node, current_level);
+        }
+        else if (current_level < schema_->max_depth_ - 1)
+        {
+          sTop++;
+          stack[sTop] = dfuds_->get_num_children(
+              current_node,
+              current_node_pos,
+              schema_->level_to_num_children[current_level]);
+          current_node_pos +=
+              dfuds_->get_num_bits(current_node, current_level);
+          current_level++;
+        }
+        else
+        {
+          stack[sTop]--;
+          num_lists += dfuds_->get_num_children(
+              current_node,
+              current_node_pos,
+              schema_->level_to_num_children[current_level]);
+          current_node_pos +=
+              dfuds_->get_num_bits(current_node, current_level);
+        }
+        current_node++;
+
+        while (sTop >= 0 && stack[sTop] == 0)
+        {
+          sTop--;
+          current_level--;
+          if (sTop >= 0)
+            stack[sTop]--;
+        }
+      }
+    }
+
+    for (n_leaves_t i = 0; i < num_lists; i++)
+      points += primary_key_list[current_primary + i].size();
+    return points;
+  }
+
+  // Gives back the DFUDS capacity beyond the nodes and bits in use.
+  void shrink_to_fit()
+  {
+    dfuds_->keep_bits(total_nodes_bits_, true);
+    dfuds_->keep_bits(num_nodes_, false);
+    node_capacity_ = num_nodes_;
+  }
+
+  // Removes the symbol at level from the node at that level on the path
+  // given by path_node and path_pos (or, if drop_node, that node as a whole),
+  // together with the chain of nodes above it that this leaves without
+  // children. A frontier node in that chain must already have been erased
+  // from frontiers_. Sets emptied instead if the chain reaches the root.
+  void prune_path(level_t level,
+                  bool drop_node,
+                  preorder_t *path_node,
+                  node_pos_t *path_pos,
+                  data_point<DIMENSION> *leaf_point,
+                  bool &emptied)
+  {
+
+    drop_subtree_directory();
+    level_t top = level;
+    while (drop_node ||
+           dfuds_->get_num_children(path_node[top],
+                                    path_pos[top],
+                                    schema_->level_to_num_children[top]) == 1)
+    {
+      if (top == root_depth_)
+      {
+        emptied = true;
+        return;
+      }
+      top--;
+      drop_node = false;
+    }
+
+    // The nodes below top on the path form a contiguous run in preorder.
+    if (top < level)
+    {
+      preorder_t first_node = path_node[top + 1];
+      node_pos_t first_node_pos = path_pos[top + 1];
+      preorder_t end_node = path_node[level] + 1;
+      node_pos_t end_node_pos =
+          path_pos[level] + dfuds_->get_num_bits(path_node[level], level);
+
+      if (end_node < num_nodes_)
+        dfuds_->shift_forward(end_node, end_node_pos, first_node, first_node_pos);
+      else
+        dfuds_->bulk_clear_node(
+            first_node, first_node_pos, end_node - 1, end_node_pos);
+
+      num_nodes_ -= end_node - first_node;
+      total_nodes_bits_ -= end_node_pos - first_node_pos;
+      for (preorder_t j = 0; j < num_frontiers_; j++)
+      {
+        if (get_preorder(j) >= end_node)
+        {
+          set_preorder(j, get_preorder(j) - (end_node - first_node));
+          set_pointer(j, get_pointer(j));
+        }
+      }
+    }
+
+    total_nodes_bits_ -=
+        dfuds_->clear_symbol(path_node[top],
+                             path_pos[top],
+                             leaf_point->leaf_to_symbol(top, schema_),
+                             schema_->level_to_num_children[top],
+                             total_nodes_bits_);
+    shrink_to_fit();
+  }
+
+  void erase_frontier(preorder_t frontier)
+  {
+    drop_subtree_directory();
+    for (preorder_t j = frontier; j + 1 < num_frontiers_; j++)
+      frontiers_[j] = frontiers_[j + 1];
+    num_frontiers_--;
+    frontiers_ = resize_frontiers(frontiers_, num_frontiers_ + 1, num_frontiers_);
+  }
+
+  // Moves the nodes of the child block behind frontier into this block in
+  // place of the frontier node (at level and node_pos here), along with its
+  // frontiers and primary keys, and frees it. The frontier node is not kept
+  // in sync with the child's root, so the root's bits replace it.
+  // primary_index is where the frontier node's primary keys start.
+  void merge_frontier(preorder_t frontier,
+                      level_t level,
+                      node_pos_t node_pos,
+                      n_leaves_t primary_index,
+                      bitmap::CompactPtrVector *p_key_to_treeblock_compact)
+  {
+
+    drop_subtree_directory();
+    drop_lookup_index();
+    tree_block<DIMENSION> *child_block = get_pointer(frontier);
+    preorder_t node = get_preorder(frontier);
+    node_pos_t frontier_bits = dfuds_->get_num_bits(node, level);
+    preorder_t num_moved_nodes = child_block->num_nodes_ - 1;
+
+    if (node + 1 < num_nodes_)
+      dfuds_->shift_forward(node + 1, node_pos + frontier_bits, node, node_pos);
+    else
+      dfuds_->bulk_clear_node(node, node_pos, node, node_pos + frontier_bits);
+    num_nodes_--;
+    total_nodes_bits_ -= frontier_bits;
+    shrink_to_fit();
+
+    if (node < num_nodes_)
+      dfuds_->shift_backward(node,
+                             node_pos,
+                             child_block->total_nodes_bits_,
+                             child_block->num_nodes_);
+    else
+    {
+      dfuds_->increase_bits(child_block->total_nodes_bits_, true);
+      dfuds_->increase_bits(child_block->num_nodes_, false);
+    }
+    dfuds_->copy_bits_from(child_block->dfuds_,
+                           0,
+                           node_pos,
+                           child_block->total_nodes_bits_,
+                           true);
+    dfuds_->copy_bits_from(
+        child_block->dfuds_, 0, node, child_block->num_nodes_, false);
+    num_nodes_ += child_block->num_nodes_;
+    total_nodes_bits_ += child_block->total_nodes_bits_;
+    node_capacity_ = num_nodes_;
+
+    // The child's frontiers replace the merged one.
+    preorder_t new_num_frontiers =
+        num_frontiers_ - 1 + child_block->num_frontiers_;
+    frontier_node<DIMENSION> *new_frontiers = nullptr;
+    if (new_num_frontiers > 0)
+      new_frontiers = resize_frontiers(nullptr, 0, new_num_frontiers);
+    preorder_t j = 0;
+    for (preorder_t i = 0; i < frontier; i++)
+      new_frontiers[j++] = frontiers_[i];
+    for (preorder_t i = 0; i < child_block->num_frontiers_; i++)
+      new_frontiers[j++] = {child_block->frontiers_[i].preorder_ + node,
+                            child_block->frontiers_[i].pointer_};
+    for (preorder_t i = frontier + 1; i < num_frontiers_; i++)
+      new_frontiers[j++] = {frontiers_[i].preorder_ + num_moved_nodes,
+                            frontiers_[i].pointer_};
+    release_frontiers(frontiers_, num_frontiers_);
+    frontiers_ = new_frontiers;
+    num_frontiers_ = new_num_frontiers;
+    for (j = 0; j < num_frontiers_; j++)
+      set_pointer(j, get_pointer(j));
+
+    for (auto &primary_keys : child_block->primary_key_list)
+    {
+      for (uint64_t k = 0; k < primary_keys.size(); k++)
+        p_key_to_treeblock_compact->Set(primary_keys.get(k), this);
+    }
+    size_t old_list_bytes = primary_key_list.allocated_bytes();
+    size_t old_child_list_bytes = child_block->primary_key_list.allocated_bytes();
+    primary_key_list.splice_in(primary_index, child_block->primary_key_list);
+    account_primary_key_list(old_list_bytes);
+    child_block->account_primary_key_list(old_child_list_bytes);
+    destroy_block(child_block);
+  }
+
+  struct bulk_load_frontier
+  {
+    preorder_t preorder_;
+    level_t level_;
+    n_leaves_t start_;
+    n_leaves_t end_;
+  };
+
+  struct bulk_load_builder
+  {
+    preorder_t max_tree_nodes_;
+    preorder_t num_nodes_ = 0;
+    node_pos_t num_bits_ = 0;
+    std::vector<uint64_t> data_;
+    std::vector<uint64_t> flag_;
+    std::vector<bulk_load_frontier> frontiers_;
+    std::vector<bits::compact_ptr> primary_key_list_;
+    // child_starts_[level] holds the child boundaries of the node at level
+    // currently being built, reused across nodes.
+    std::vector<std::vector<n_leaves_t>> child_starts_;
+  };
+
+  // Number of nodes in the subtree rooted at level, holding [start, end).
+  preorder_t bulk_load_subtree_size(bulk_load_input<DIMENSION> &input,
+                                    n_leaves_t start,
+                                    n_leaves_t end,
+                                    level_t level) const
+  {
+    return (schema_->max_depth_ - level) + input.weight_prefix_[end] -
+           input.weight_prefix_[start + 1];
+  }
+
+  // Appends the bits of the node holding [start, end) at level. child_starts
+  // receives the boundaries of its children: maximal runs of points that
+  // agree on the symbol at level.
+  void bulk_load_append_node(bulk_load_input<DIMENSION> &input,
+                             bulk_load_builder &builder,
+                             n_leaves_t start,
+                             n_leaves_t end,
+                             level_t level,
+                             std::vector<n_leaves_t> &child_starts)
+  {
+    child_starts.clear();
+    for (n_leaves_t i = start; i < end; i++)
+    {
+      if (i == start || input.lcp_[i] <= level)
+        child_starts.push_back(i);
+    }
+    child_starts.push_back(end);
+    preorder_t num_children = child_starts.size() - 1;
+
+    morton_t num_symbol_bits = schema_->level_to_num_children[level];
+    bool collapsed = num_children == 1 && !schema_->is_collapsed_node_exp;
+    node_pos_t node_bits =
+        collapsed ? num_symbol_bits : (node_pos_t)1 << num_symbol_bits;
+    if (BITS2BLOCKS(builder.num_bits_ + node_bits) > builder.data_.size())
+      builder.data_.resize(
+          std::max(BITS2BLOCKS(builder.num_bits_ + node_bits),
+                   (uint64_t)builder.data_.size() * 2),
+          0);
+    if (BITS2BLOCKS(builder.num_nodes_ + 1) > builder.flag_.size())
+      builder.flag_.resize(builder.flag_.size() * 2 + 1, 0);
+    if (collapsed)
+    {
+      morton_t symbol = input.symbol(start, level);
+      for (morton_t b = 0; b < num_symbol_bits; b++)
+      {
+        if (GETBIT(symbol, b))
+          SETBITVAL(builder.data_.data(), builder.num_bits_ + b);
+      }
+    }
+    else
+    {
+      SETBITVAL(builder.flag_.data(), builder.num_nodes_);
+      for (preorder_t c = 0; c < num_children; c++)
+      {
+        morton_t symbol = input.symbol(child_starts[c], level);
+        SETBITVAL(builder.data_.data(), builder.num_bits_ + symbol);
+      }
+    }
+    builder.num_nodes_++;
+    builder.num_bits_ += node_bits;
+  }
+
+  // Appends the node holding [start, end) at level, and then its subtree.
+  void bulk_load_node(bulk_load_input<DIMENSION> &input,
+                      bulk_load_builder &builder,
+                      n_leaves_t start,
+                      n_leaves_t end,
+                      level_t level)
+  {
+    std::vector<n_leaves_t> &child_starts = builder.child_starts_[level];
+    bulk_load_append_node(input, builder, start, end, level, child_starts);
+    preorder_t num_children = child_starts.size() - 1;
+
+    if (level == schema_->max_depth_ - 1)
+    {
+      for (preorder_t c = 0; c < num_children; c++)
+      {
+        bits::compact_ptr primary_keys(
+            input.points_[child_starts[c]]->read_primary());
+        for (n_leaves_t i = child_starts[c] + 1; i < child_starts[c + 1]; i++)
+          primary_keys.push(input.points_[i]->read_primary(), arena_);
+        builder.primary_key_list_.push_back(primary_keys);
+      }
+      return;
+    }
+
+    for (preorder_t c = 0; c < num_children; c++)
+    {
+      n_leaves_t child_start = child_starts[c];
+      n_leaves_t child_end = child_starts[c + 1];
+      preorder_t subtree_size =
+          bulk_load_subtree_size(input, child_start, child_end, level + 1);
+
+      if (builder.num_nodes_ + subtree_size <= builder.max_tree_nodes_ ||
+          level + 1 == schema_->max_depth_ - 1 ||
+          (subtree_size > builder.max_tree_nodes_ &&
+           builder.num_nodes_ < builder.max_tree_nodes_))
+      {
+        bulk_load_node(input, builder, child_start, child_end, level + 1);
+      }
+      else
+      {
+        // The frontier node stays in this block too: the root of the child
+        // block is a copy of it.
+        builder.frontiers_.push_back(
+            {builder.num_nodes_, (level_t)(level + 1), child_start, child_end});
+        bulk_load_append_node(input,
+                              builder,
+                              child_start,
+                              child_end,
+                              level + 1,
+                              builder.child_starts_[level + 1]);
+      }
+    }
+  }
+
   // dimension_t width_;
+  const trie_schema *schema_;
+  // Where this block, its child blocks and everything they hold (bitmaps,
+  // frontier arrays, primary key lists, lookup indexes and directories) are
+  // allocated; nullptr for the heap (and in a snapshot image).
+  node_arena *arena_ = nullptr;
   level_t root_depth_;
   preorder_t num_nodes_;
   preorder_t total_nodes_bits_;
@@ -1889,10 +3513,24 @@ private:
   compressed_bitmap::compressed_bitmap *dfuds_{};
   frontier_node<DIMENSION> *frontiers_ = nullptr;
   preorder_t num_frontiers_ = 0;
+  // Points under this block's root: those in primary_key_list and those of
+  // every block behind frontiers_, so that a subtree a query covers whole
+  // can be counted without being walked. An inserter counts a block before
+  // it lets go of the latch leading to it, so a concurrent split of the
+  // parent block, which sums up the counts of the children it moves, never
+  // misses a point that is still on its way down.
+  n_leaves_t num_points_ = 0;
+  // Built on first use when schema_->primary_key_index is set, kept up to
+  // date by insert and dropped when the block is reshaped (see lookup_index).
+  primary_key_index *lookup_index_ = nullptr;
+  // Built on first use when schema_->subtree_directory is set, and kept up
+  // to date by insertions (see directory).
+  subtree_directory *subtree_directory_ = nullptr;
 
   void *parent_combined_ptr_ = NULL;
   preorder_t treeblock_frontier_num_ = 0;
-  std::vector<bits::compact_ptr> primary_key_list;
+  bits::compact_ptr_list primary_key_list;
+  std::mutex latch_;
 };
 
 #endif // MD_TRIE_TREE_BLOCK_H
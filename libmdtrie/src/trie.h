@@ -2,6 +2,7 @@
 #define MD_TRIE_MD_TRIE_H
 
 #include "compressed_bitmap.h"
+#include <algorithm>
 #include <cmath>
 #include <csignal>
 #include <cstdint>
@@ -9,69 +10,87 @@
 #include <cstdlib>
 #include <cstring>
 #include <ctime>
+#include <deque>
+#include <mutex>
 #include <queue>
+#include <string>
 #include <sys/stat.h>
 #include <utility>
 #include <vector>
 
 #include "data_point.h"
 #include "defs.h"
+#include "knn.h"
 #include "point_array.h"
+#include "range_aggregate.h"
+#include "snapshot.h"
+#include "thread_pool.h"
 #include "tree_block.h"
 #include "trie_node.h"
+#include "trie_schema.h"
 
 template <dimension_t DIMENSION>
 class md_trie
 {
 public:
-  explicit md_trie(dimension_t width,
-                   level_t max_depth,
-                   level_t trie_depth,
-                   preorder_t max_tree_nodes)
+  explicit md_trie(const trie_schema &schema) : schema_(schema)
   {
 
-    max_depth_ = max_depth;
-    trie_depth_ = trie_depth;
-    trie_width_ = width;
-    max_tree_nodes_ = max_tree_nodes;
-    root_ = new trie_node<DIMENSION>(false, level_to_num_children[0]);
+    root_ = create_trie_node(schema_.trie_depth_ == 0, 0);
+  }
+
+  // Occupancy of the node_arena holding this trie's nodes, treeblocks,
+  // frontier arrays and small duplicate key lists.
+  node_arena_stats arena_stats() { return arena_.stats(); }
+
+  // Bytes held by this trie per memory_component. The counters are kept up
+  // to date as the trie changes, so unlike size this walks nothing and can
+  // be called while inserters run; only MEMORY_PRIMARY_KEY_MAP is read off
+  // p_key_to_treeblock_compact. A trie opened with open_mmap counts nothing
+  // but that map.
+  memory_usage memory(bitmap::CompactPtrVector *p_key_to_treeblock_compact)
+  {
+    memory_usage usage;
+    for (int32_t c = 0; c < num_memory_components; c++)
+      usage.bytes_[c] = arena_.usage().get((memory_component)c);
+    usage.bytes_[MEMORY_PRIMARY_KEY_MAP] =
+        p_key_to_treeblock_compact->size_overhead();
+    return usage;
   }
 
   // inline dimension_t get_width() { return width_; }
 
+  inline const trie_schema &schema() const { return schema_; }
+
   inline trie_node<DIMENSION> *root() { return root_; }
 
-  tree_block<DIMENSION> *walk_trie(trie_node<DIMENSION> *current_trie_node,
-                                   data_point<DIMENSION> *leaf_point,
-                                   level_t &level) const
+  // Follows (creating as needed) the trie nodes on leaf_point's path and
+  // returns the trie leaf, whose treeblock may not exist yet.
+  trie_node<DIMENSION> *walk_trie_nodes(trie_node<DIMENSION> *current_trie_node,
+                                        data_point<DIMENSION> *leaf_point,
+                                        level_t &level) const
   {
 
     morton_t current_symbol;
 
-    while (level < trie_depth_ &&
-           current_trie_node->get_child(leaf_point->leaf_to_symbol(level)))
+    while (level < schema_.trie_depth_ &&
+           current_trie_node->get_child(
+               leaf_point->leaf_to_symbol(level, &schema_)))
     {
 
       current_trie_node =
-          current_trie_node->get_child(leaf_point->leaf_to_symbol(level));
+          current_trie_node->get_child(
+              leaf_point->leaf_to_symbol(level, &schema_));
       level++;
     }
-    while (level < trie_depth_)
+    while (level < schema_.trie_depth_)
     {
 
-      current_symbol = leaf_point->leaf_to_symbol(level);
-      if (level == trie_depth_ - 1)
-      {
-        current_trie_node->set_child(
-            current_symbol,
-            new trie_node<DIMENSION>(true, level_to_num_children[level + 1]));
-      }
-      else
-      {
-        current_trie_node->set_child(
-            current_symbol,
-            new trie_node<DIMENSION>(false, level_to_num_children[level + 1]));
-      }
+      current_symbol = leaf_point->leaf_to_symbol(level, &schema_);
+      current_trie_node->set_child(
+          current_symbol,
+          create_trie_node(level == schema_.trie_depth_ - 1, level + 1),
+          &arena_);
       current_trie_node->get_child(current_symbol)
           ->set_parent_trie_node(current_trie_node);
       current_trie_node->get_child(current_symbol)
@@ -79,19 +98,19 @@ public:
       current_trie_node = current_trie_node->get_child(current_symbol);
       level++;
     }
+    return current_trie_node;
+  }
+
+  tree_block<DIMENSION> *walk_trie(trie_node<DIMENSION> *current_trie_node,
+                                   data_point<DIMENSION> *leaf_point,
+                                   level_t &level) const
+  {
 
+    current_trie_node = walk_trie_nodes(current_trie_node, leaf_point, level);
     tree_block<DIMENSION> *current_treeblock = nullptr;
     if (current_trie_node->get_block() == nullptr)
     {
-      current_treeblock =
-          new tree_block<DIMENSION>(/* width_, */
-                                    trie_depth_,
-                                    1 /* initial_tree_capacity_ */,
-                                    1 << level_to_num_children[trie_depth_],
-                                    1,
-                                    max_depth_,
-                                    max_tree_nodes_,
-                                    current_trie_node);
+      current_treeblock = new_leaf_treeblock(current_trie_node);
       current_trie_node->set_block(current_treeblock);
     }
     else
@@ -107,42 +126,395 @@ public:
                    bitmap::CompactPtrVector *p_key_to_treeblock_compact)
   {
 
+    morton_t symbols[80];
+    leaf_point->cache_symbols(symbols, &schema_);
     level_t level = 0;
     trie_node<DIMENSION> *current_trie_node = root_;
     tree_block<DIMENSION> *current_treeblock =
         walk_trie(current_trie_node, leaf_point, level);
+    current_treeblock->count_insertion();
     current_treeblock->insert_remaining(
         leaf_point, level, primary_key, p_key_to_treeblock_compact);
+    leaf_point->drop_symbols();
+  }
+
+  // Variant of walk_trie that may run alongside other concurrent inserters.
+  // Missing trie nodes (and the treeblock under a new leaf) are built
+  // privately and published with a compare-and-swap; the loser of a race frees
+  // its copy and follows the winner's.
+  tree_block<DIMENSION> *walk_trie_concurrent(
+      trie_node<DIMENSION> *current_trie_node,
+      data_point<DIMENSION> *leaf_point,
+      level_t &level)
+  {
+
+    while (level < schema_.trie_depth_)
+    {
+
+      morton_t current_symbol = leaf_point->leaf_to_symbol(level, &schema_);
+      trie_node<DIMENSION> *next_trie_node =
+          current_trie_node->get_child_acquire(current_symbol);
+      if (!next_trie_node)
+      {
+        bool is_leaf = level == schema_.trie_depth_ - 1;
+        auto *new_trie_node = create_trie_node(is_leaf, level + 1);
+        new_trie_node->set_parent_trie_node(current_trie_node);
+        new_trie_node->set_parent_symbol(current_symbol);
+        if (is_leaf)
+          new_trie_node->set_block(new_leaf_treeblock(new_trie_node));
+
+        next_trie_node = current_trie_node->set_child_if_absent(
+            current_symbol, new_trie_node, &retired_children_, &arena_);
+        if (next_trie_node != new_trie_node)
+        {
+          if (is_leaf)
+            tree_block<DIMENSION>::destroy_block(new_trie_node->get_block());
+          destroy_trie_node(new_trie_node, is_leaf);
+        }
+      }
+      current_trie_node = next_trie_node;
+      level++;
+    }
+
+    tree_block<DIMENSION> *current_treeblock =
+        current_trie_node->get_block_acquire();
+    if (current_treeblock == nullptr)
+    {
+      // Only the root can be a leaf without a treeblock (trie_depth == 0).
+      auto *new_treeblock = new_leaf_treeblock(current_trie_node);
+      current_treeblock = current_trie_node->set_block_if_absent(new_treeblock);
+      if (current_treeblock != new_treeblock)
+        tree_block<DIMENSION>::destroy_block(new_treeblock);
+    }
+    return current_treeblock;
+  }
+
+  // Thread-safe with respect to other insert_trie_concurrent calls (but not to
+  // queries or insert_trie). Threads serialize only on the treeblocks their
+  // paths share: each holds one treeblock latch at a time, handed over from
+  // parent to child treeblock as the insertion descends frontier pointers.
+  void insert_trie_concurrent(
+      data_point<DIMENSION> *leaf_point,
+      n_leaves_t primary_key,
+      bitmap::CompactPtrVector *p_key_to_treeblock_compact)
+  {
+
+    morton_t symbols[80];
+    leaf_point->cache_symbols(symbols, &schema_);
+    level_t level = 0;
+    uint64_t epoch = retired_children_.enter();
+    tree_block<DIMENSION> *current_treeblock =
+        walk_trie_concurrent(root_, leaf_point, level);
+    retired_children_.leave(epoch, &arena_);
+    std::unique_lock<std::mutex> held_latch(current_treeblock->latch());
+    current_treeblock->count_insertion();
+    current_treeblock->insert_remaining(leaf_point,
+                                        level,
+                                        primary_key,
+                                        p_key_to_treeblock_compact,
+                                        &held_latch);
+    leaf_point->drop_symbols();
+  }
+
+  // Loads the points in [first, last) (data_point<DIMENSION>s carrying their
+  // primary key, see set_primary), which must stay in place for the call.
+  // Points are sorted by symbol sequence, and each treeblock under a trie leaf
+  // that has none yet is built bottom-up in a single pass (see
+  // tree_block::bulk_load). Points falling under an existing treeblock are
+  // inserted one by one below it, sharing the walk down the trie; if they are
+  // many compared to the points the treeblock already holds (see
+  // batch_rebuild_ratio), the treeblock is rebuilt from both instead, so its
+  // DFUDS is laid out once rather than shifted for every point. Query
+  // results match those of calling insert_trie on every point.
+  template <typename Iterator>
+  void bulk_load(Iterator first,
+                 Iterator last,
+                 bitmap::CompactPtrVector *p_key_to_treeblock_compact)
+  {
+
+    std::vector<data_point<DIMENSION> *> points;
+    for (Iterator it = first; it != last; ++it)
+      points.push_back(&(*it));
+    n_leaves_t num_points = points.size();
+    if (num_points == 0)
+      return;
+
+    std::vector<morton_t> symbols(num_points * schema_.max_depth_);
+    for (n_leaves_t i = 0; i < num_points; i++)
+      points[i]->cache_symbols(&symbols[i * schema_.max_depth_], &schema_);
+
+    // Each point's symbol sequence, packed most significant bit first, so that
+    // comparing keys word by word orders points by symbol sequence.
+    // bit_to_level maps a bit of a key back to the level of its symbol.
+    std::vector<level_t> bit_to_level;
+    std::vector<uint64_t> level_offset(schema_.max_depth_);
+    for (level_t level = 0; level < schema_.max_depth_; level++)
+    {
+      level_offset[level] = bit_to_level.size();
+      bit_to_level.insert(
+          bit_to_level.end(), schema_.level_to_num_children[level], level);
+    }
+    uint64_t key_words = BITS2BLOCKS(bit_to_level.size());
+    std::vector<uint64_t> keys(num_points * key_words, 0);
+    for (n_leaves_t i = 0; i < num_points; i++)
+    {
+      uint64_t *key = &keys[i * key_words];
+      for (level_t level = 0; level < schema_.max_depth_; level++)
+      {
+        morton_t symbol = points[i]->leaf_to_symbol(level, &schema_);
+        uint64_t bit = level_offset[level];
+        for (int b = schema_.level_to_num_children[level] - 1; b >= 0;
+             b--, bit++)
+          key[bit / 64] |= ((symbol >> b) & 1ULL) << (63 - bit % 64);
+      }
+    }
+
+    std::vector<n_leaves_t> order(num_points);
+    for (n_leaves_t i = 0; i < num_points; i++)
+      order[i] = i;
+    std::stable_sort(
+        order.begin(), order.end(), [&](n_leaves_t a, n_leaves_t b) {
+          return std::lexicographical_compare(&keys[a * key_words],
+                                              &keys[(a + 1) * key_words],
+                                              &keys[b * key_words],
+                                              &keys[(b + 1) * key_words]);
+        });
+
+    // Lay points and keys out in sorted order, so that building the
+    // treeblocks reads them sequentially.
+    std::vector<data_point<DIMENSION> *> sorted_points(num_points);
+    std::vector<uint64_t> sorted_keys(num_points * key_words);
+    for (n_leaves_t i = 0; i < num_points; i++)
+    {
+      sorted_points[i] = points[order[i]];
+      std::copy(&keys[order[i] * key_words],
+                &keys[(order[i] + 1) * key_words],
+                &sorted_keys[i * key_words]);
+    }
+    points.swap(sorted_points);
+    keys.swap(sorted_keys);
+    sorted_points = std::vector<data_point<DIMENSION> *>();
+    sorted_keys = std::vector<uint64_t>();
+    order = std::vector<n_leaves_t>();
+
+    std::vector<level_t> lcp(num_points, 0);
+    std::vector<uint64_t> weight_prefix(num_points + 1, 0);
+    for (n_leaves_t i = 1; i < num_points; i++)
+    {
+      uint64_t *key = &keys[i * key_words];
+      uint64_t *prev_key = key - key_words;
+      level_t level = schema_.max_depth_;
+      for (uint64_t w = 0; w < key_words; w++)
+      {
+        if (key[w] != prev_key[w])
+        {
+          level = bit_to_level[w * 64 + __builtin_clzll(key[w] ^ prev_key[w])];
+          break;
+        }
+      }
+      lcp[i] = level;
+      weight_prefix[i + 1] =
+          weight_prefix[i] +
+          (level < schema_.max_depth_ - 1 ? schema_.max_depth_ - 1 - level : 0);
+    }
+
+    bulk_load_input<DIMENSION> input = {points.data(),
+                                        keys.data(),
+                                        key_words,
+                                        level_offset.data(),
+                                        lcp.data(),
+                                        weight_prefix.data(),
+                                        &schema_};
+
+    n_leaves_t start = 0;
+    while (start < num_points)
+    {
+      n_leaves_t end = start + 1;
+      while (end < num_points && lcp[end] >= schema_.trie_depth_)
+        end++;
+
+      level_t level = 0;
+      trie_node<DIMENSION> *leaf_trie_node =
+          walk_trie_nodes(root_, points[start], level);
+      if (leaf_trie_node->get_block() == nullptr)
+      {
+        tree_block<DIMENSION> *current_treeblock =
+            new_leaf_treeblock(leaf_trie_node);
+        current_treeblock->bulk_load(
+            input, start, end, p_key_to_treeblock_compact);
+        leaf_trie_node->set_block(current_treeblock);
+      }
+      else if (end - start >= batch_rebuild_min_points &&
+               end - start >= leaf_trie_node->get_block()->num_points() *
+                                  batch_rebuild_ratio)
+      {
+        std::vector<data_point<DIMENSION>> merged;
+        collect_treeblock_points(leaf_trie_node->get_block(), *points[start], merged);
+        for (n_leaves_t i = start; i < end; i++)
+          merged.push_back(*points[i]);
+        release_treeblock(leaf_trie_node->get_block());
+        leaf_trie_node->set_block(nullptr);
+        bulk_load(merged.begin(), merged.end(), p_key_to_treeblock_compact);
+      }
+      else
+      {
+        // Descending order, so each point goes in ahead of those placed
+        // before it rather than past them.
+        tree_block<DIMENSION> *current_treeblock = leaf_trie_node->get_block();
+        for (n_leaves_t i = end; i-- > start;)
+        {
+          current_treeblock->count_insertion();
+          current_treeblock->insert_remaining(points[i],
+                                              schema_.trie_depth_,
+                                              points[i]->read_primary(),
+                                              p_key_to_treeblock_compact);
+        }
+      }
+      start = end;
+    }
+    for (n_leaves_t i = 0; i < num_points; i++)
+      points[i]->drop_symbols();
+  }
+
+  // Inserts points[i] under keys[i] for every i, as one bulk_load: the batch
+  // is sorted by symbol sequence, the trie is walked once per treeblock it
+  // falls under, and treeblocks are built or rebuilt whole where the batch
+  // brings enough points. Not safe alongside other inserts or queries.
+  void insert_batch(const std::vector<data_point<DIMENSION> *> &points,
+                    const std::vector<n_leaves_t> &keys,
+                    bitmap::CompactPtrVector *p_key_to_treeblock_compact)
+  {
+    std::vector<data_point<DIMENSION>> batch;
+    batch.reserve(points.size());
+    for (size_t i = 0; i < points.size(); i++)
+    {
+      batch.push_back(*points[i]);
+      batch.back().set_primary(keys[i]);
+    }
+    bulk_load(batch.begin(), batch.end(), p_key_to_treeblock_compact);
   }
 
   data_point<DIMENSION> *lookup_trie(n_leaves_t primary_key, bitmap::CompactPtrVector *p_key_to_treeblock_compact)
   {
-    std::vector<morton_t> node_path_from_primary(max_depth_ + 1);
+    std::vector<morton_t> node_path_from_primary(schema_.max_depth_ + 1);
     tree_block<DIMENSION> *t_ptr = (tree_block<DIMENSION> *)p_key_to_treeblock_compact->At(primary_key);
     morton_t parent_symbol_from_primary =
         t_ptr->get_node_path_primary_key(primary_key, node_path_from_primary);
-    node_path_from_primary[max_depth_ - 1] = parent_symbol_from_primary;
+    node_path_from_primary[schema_.max_depth_ - 1] = parent_symbol_from_primary;
     // return t_ptr->node_path_to_coordinates(node_path_from_primary, 9);
     dimension_t dimension = DIMENSION;
     return t_ptr->node_path_to_coordinates(node_path_from_primary, dimension);
   }
 
+  // Looks up the points of many primary keys at once: points[i] receives
+  // the point of keys[i]. Keys are grouped by the treeblock they map to, and
+  // each treeblock is scanned once for all of its keys (see
+  // tree_block::lookup_primary_keys) rather than once per key. Keys that are
+  // not stored leave their entry of points untouched.
+  void lookup_batch(const std::vector<n_leaves_t> &keys,
+                    std::vector<data_point<DIMENSION>> &points,
+                    bitmap::CompactPtrVector *p_key_to_treeblock_compact)
+  {
+    points.resize(keys.size());
+    struct lookup_entry
+    {
+      tree_block<DIMENSION> *block_;
+      std::pair<n_leaves_t, data_point<DIMENSION> *> wanted_;
+    };
+    std::vector<lookup_entry> entries;
+    entries.reserve(keys.size());
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+      auto *t_ptr =
+          (tree_block<DIMENSION> *)p_key_to_treeblock_compact->At(keys[i]);
+      if (t_ptr)
+        entries.push_back({t_ptr, {keys[i], &points[i]}});
+    }
+    std::sort(entries.begin(),
+              entries.end(),
+              [](const lookup_entry &a, const lookup_entry &b) {
+                return a.block_ != b.block_ ? a.block_ < b.block_
+                                            : a.wanted_.first < b.wanted_.first;
+              });
+
+    std::vector<std::pair<n_leaves_t, data_point<DIMENSION> *>> wanted;
+    for (size_t start = 0; start < entries.size();)
+    {
+      size_t end = start;
+      wanted.clear();
+      while (end < entries.size() && entries[end].block_ == entries[start].block_)
+        wanted.push_back(entries[end++].wanted_);
+      entries[start].block_->lookup_primary_keys(wanted.data(), wanted.size());
+      start = end;
+    }
+  }
+
+  // Removes the point stored under primary_key. Its treeblock nodes are
+  // pruned, and treeblocks and trie nodes left empty are freed; a child
+  // treeblock that becomes small enough is merged back into its parent.
+  // Returns false if primary_key is not stored. Must not run alongside
+  // inserts or queries.
+  bool delete_trie(n_leaves_t primary_key,
+                   bitmap::CompactPtrVector *p_key_to_treeblock_compact)
+  {
+
+    if (!p_key_to_treeblock_compact->At(primary_key))
+      return false;
+
+    data_point<DIMENSION> *leaf_point =
+        lookup_trie(primary_key, p_key_to_treeblock_compact);
+    level_t level = 0;
+    trie_node<DIMENSION> *current_trie_node = root_;
+    while (level < schema_.trie_depth_ && current_trie_node)
+    {
+      current_trie_node = current_trie_node->get_child(
+          leaf_point->leaf_to_symbol(level, &schema_));
+      level++;
+    }
+
+    bool found = false, emptied = false;
+    if (current_trie_node && current_trie_node->get_block())
+      found = current_trie_node->get_block()->delete_remaining(
+          leaf_point, level, primary_key, p_key_to_treeblock_compact, emptied);
+    delete leaf_point;
+    if (!emptied)
+      return found;
+
+    tree_block<DIMENSION>::destroy_block(current_trie_node->get_block());
+    current_trie_node->set_block(nullptr);
+    bool is_leaf = true;
+    while (current_trie_node != root_ &&
+           (is_leaf || current_trie_node->num_children() == 0))
+    {
+      trie_node<DIMENSION> *parent_trie_node =
+          current_trie_node->get_parent_trie_node();
+      parent_trie_node->erase_child(current_trie_node->get_parent_symbol(),
+                                    &arena_);
+      destroy_trie_node(current_trie_node, is_leaf);
+      current_trie_node = parent_trie_node;
+      is_leaf = false;
+    }
+    return true;
+  }
+
   bool check(data_point<DIMENSION> *leaf_point) const
   {
 
+    morton_t symbols[80];
+    leaf_point->cache_symbols(symbols, &schema_);
     level_t level = 0;
     trie_node<DIMENSION> *current_trie_node = root_;
     tree_block<DIMENSION> *current_treeblock =
         walk_trie(current_trie_node, leaf_point, level);
     bool result = current_treeblock->walk_tree_block(leaf_point, level);
+    leaf_point->drop_symbols();
     return result;
   }
 
   uint64_t size(bitmap::CompactPtrVector *p_key_to_treeblock_compact)
   {
 
-    uint64_t total_size = sizeof(root_) + sizeof(max_depth_);
-    total_size += sizeof(max_tree_nodes_);
+    uint64_t total_size = sizeof(root_);
     // total_size += sizeof(width_);
 
     std::queue<trie_node<DIMENSION> *> trie_node_queue;
@@ -160,25 +532,18 @@ public:
         trie_node<DIMENSION> *current_node = trie_node_queue.front();
         trie_node_queue.pop();
 
-        total_size +=
-            current_node->size(1 << level_to_num_children[current_level],
-                               current_level == trie_depth_);
+        total_size += current_node->size(current_level == schema_.trie_depth_);
 
-        if (current_level != trie_depth_)
+        if (current_level != schema_.trie_depth_)
         {
-          for (int i = 0; i < (1 << level_to_num_children[current_level]);
-               i++)
+          for (morton_t i = 0; i < current_node->num_children(); i++)
           {
-            // quick fix, not sure why some data is corrupted
-            // ex. current_node->get_child(i) might return 0x21 or 0x1818181818181818
-            if (current_node->get_child(i) /* && is_valid((void *) current_node->get_child(i)) */) 
-            {
-              trie_node_queue.push(current_node->get_child(i));
-            }
+            trie_node_queue.push(current_node->child_at(i));
           }
         }
-        else /* if (is_valid((void *) current_node->get_block())) */
+        else if (current_node->get_block())
         {
+          // A root leaf (trie_depth 0) has no treeblock while it is empty.
           total_size += current_node->get_block()->size();
         }
       }
@@ -187,56 +552,650 @@ public:
     // Global variables in def.h
     total_size += sizeof(total_points_count);
     total_size += sizeof(discount_factor);
-    total_size += sizeof(level_to_num_children) + max_depth_ * sizeof(morton_t);
-    total_size += sizeof(max_tree_nodes_);
-    total_size += sizeof(max_depth_);
-    total_size += sizeof(trie_depth_);
-    total_size += sizeof(trie_width_);
+    total_size += schema_.size();
 
     total_size += sizeof(p_key_to_treeblock_compact);
     total_size += p_key_to_treeblock_compact->size_overhead();
 
-    total_size += sizeof(dimension_to_num_bits) +
-                  dimension_to_num_bits.size() * sizeof(morton_t);
-    total_size += sizeof(start_dimension_bits) +
-                  start_dimension_bits.size() * sizeof(level_t);
-    total_size += sizeof(no_dynamic_sizing);
-
     return total_size;
   }
 
+  // Gives back the capacity the treeblocks hold in reserve for insertions
+  // (see tree_block::compact), e.g. once loading is done. A trie opened with
+  // open_mmap is left as it is.
+  void compact()
+  {
+    if (mapping_)
+      return;
+    compact_trie_node(root_, 0);
+  }
+
+  // Writes the trie and its entries of p_key_to_treeblock_compact to a
+  // snapshot file at path (see snapshot.h), laid out to be mapped at
+  // base_address. Returns false if the file could not be written.
+  bool save(const std::string &path,
+            bitmap::CompactPtrVector *p_key_to_treeblock_compact,
+            uintptr_t base_address = snapshot_base_address) const
+  {
+    snapshot_writer writer(base_address);
+    if (!writer.open(path))
+      return false;
+
+    uint64_t header_offset = writer.allocate(sizeof(snapshot_header));
+    snapshot_header header = {};
+    header.magic_ = snapshot_magic;
+    header.version_ = snapshot_version;
+    header.base_address_ = base_address;
+    header.dimension_ = DIMENSION;
+    header.schema_ = writer.schema_address_ = schema_.save(writer);
+    header.root_ = root_->save(writer, 0, schema_.trie_depth_);
+
+    // Entries of blocks outside this trie are left empty.
+    n_leaves_t num_elements = p_key_to_treeblock_compact->get_num_elements();
+    uint64_t map_bytes =
+        bitmap::CompactPtrVector::DataWords(num_elements) * sizeof(uint64_t);
+    uint64_t map_offset = writer.allocate(map_bytes);
+    if (!writer.failed())
+    {
+      bitmap::CompactPtrVector map((uint64_t *)writer.at(map_offset),
+                                   num_elements);
+      for (n_leaves_t i = 0; i < num_elements; i++)
+      {
+        auto it = writer.block_address_.find(p_key_to_treeblock_compact->At(i));
+        map.Set(i,
+                it == writer.block_address_.end() ? nullptr
+                                                  : (void *)it->second);
+      }
+      map.Release();
+    }
+    header.primary_key_map_ = writer.address(map_offset);
+    header.primary_key_map_elements_ = num_elements;
+    header.file_size_ = writer.size();
+    writer.write(header_offset, &header, sizeof(header));
+    return !writer.failed() && writer.close();
+  }
+
+  // Maps a snapshot written by save at the address it was laid out for and
+  // returns a trie searched in place from the mapping, so opening takes the
+  // same time whatever the trie size; pages are read in as queries touch
+  // them. *p_key_to_treeblock_compact is set to the snapshot's primary key
+  // map, which lives as long as the trie. The trie is read-only: inserts and
+  // deletes must not be run on it. Returns nullptr if the file is not a
+  // snapshot of a DIMENSION-dimensional trie or its address range is taken.
+  static md_trie *open_mmap(const std::string &path,
+                            bitmap::CompactPtrVector **p_key_to_treeblock_compact)
+  {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      return nullptr;
+    snapshot_header header;
+    if (pread(fd, &header, sizeof(header), 0) != sizeof(header) ||
+        header.magic_ != snapshot_magic ||
+        header.version_ != snapshot_version || header.dimension_ != DIMENSION)
+    {
+      close(fd);
+      return nullptr;
+    }
+    void *mapping = mmap((void *)header.base_address_,
+                         header.file_size_,
+                         PROT_READ,
+                         MAP_PRIVATE | MAP_FIXED_NOREPLACE,
+                         fd,
+                         0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+      return nullptr;
+    if ((uintptr_t)mapping != header.base_address_)
+    {
+      // Kernels without MAP_FIXED_NOREPLACE take the address as a hint.
+      munmap(mapping, header.file_size_);
+      return nullptr;
+    }
+
+    auto *trie = new md_trie(*(const trie_schema *)header.schema_,
+                             (trie_node<DIMENSION> *)header.root_);
+    trie->mapping_ = mapping;
+    trie->mapping_size_ = header.file_size_;
+    trie->mapped_primary_key_map_ = new bitmap::CompactPtrVector(
+        (uint64_t *)header.primary_key_map_, header.primary_key_map_elements_);
+    *p_key_to_treeblock_compact = trie->mapped_primary_key_map_;
+    return trie;
+  }
+
+  // A trie built in memory holds everything in its node_arena, which goes
+  // back to the heap slab by slab without the trie being walked; one opened
+  // with open_mmap releases its mapping.
+  ~md_trie()
+  {
+    if (!mapping_)
+    {
+      arena_.release_all();
+      return;
+    }
+    mapped_primary_key_map_->Release();
+    delete mapped_primary_key_map_;
+    munmap(mapping_, mapping_size_);
+  }
+
   void range_search_trie(data_point<DIMENSION> *start_range,
                          data_point<DIMENSION> *end_range,
                          trie_node<DIMENSION> *current_trie_node,
                          level_t level,
                          std::vector<int32_t> &found_points)
   {
-    if (level == trie_depth_)
+    range_search_trie(
+        start_range,
+        end_range,
+        current_trie_node,
+        level,
+        [&found_points](const data_point<DIMENSION> &point, n_leaves_t) {
+          for (dimension_t j = 0; j < DIMENSION; j++)
+            found_points.push_back(point.get_coordinate(j));
+          return true;
+        });
+  }
+
+  // Collects the primary keys of the matches, one per key a point is stored
+  // under, and, if found_points is given, their coordinates (DIMENSION values
+  // per key, in the same order). The keys come straight from the treeblocks'
+  // primary key lists, so no lookup is needed to tell which rows matched.
+  void range_search_trie(data_point<DIMENSION> *start_range,
+                         data_point<DIMENSION> *end_range,
+                         trie_node<DIMENSION> *current_trie_node,
+                         level_t level,
+                         std::vector<n_leaves_t> &found_keys,
+                         std::vector<int32_t> *found_points = nullptr)
+  {
+    range_search_trie(
+        start_range,
+        end_range,
+        current_trie_node,
+        level,
+        [&](const data_point<DIMENSION> &point, n_leaves_t primary_key) {
+          found_keys.push_back(primary_key);
+          if (found_points)
+          {
+            for (dimension_t j = 0; j < DIMENSION; j++)
+              found_points->push_back(point.get_coordinate(j));
+          }
+          return true;
+        });
+  }
+
+  // Number of matches, counted once per primary key like range_search_trie
+  // reports them. Subtrees the range covers whole are not searched; their
+  // points are counted from the totals cached in the treeblocks, so a count
+  // over a large range costs about as much as walking its boundary.
+  n_leaves_t range_count_trie(data_point<DIMENSION> *start_range,
+                              data_point<DIMENSION> *end_range,
+                              trie_node<DIMENSION> *current_trie_node,
+                              level_t level)
+  {
+    n_leaves_t count = 0;
+    range_search_trie(
+        start_range,
+        end_range,
+        current_trie_node,
+        level,
+        [&count](const data_point<DIMENSION> &, n_leaves_t) {
+          count++;
+          return true;
+        },
+        &count);
+    return count;
+  }
+
+  // Accumulates aggregate over the matches as the search finds them, without
+  // collecting any coordinates. A plain COUNT (no dimensions) goes through
+  // range_count_trie.
+  void range_aggregate_trie(data_point<DIMENSION> *start_range,
+                            data_point<DIMENSION> *end_range,
+                            trie_node<DIMENSION> *current_trie_node,
+                            level_t level,
+                            range_aggregate &aggregate)
+  {
+    if (aggregate.dimensions_.empty())
+    {
+      aggregate.count_ +=
+          range_count_trie(start_range, end_range, current_trie_node, level);
+      return;
+    }
+    range_search_trie(
+        start_range,
+        end_range,
+        current_trie_node,
+        level,
+        [&aggregate](const data_point<DIMENSION> &point, n_leaves_t) {
+          aggregate.add(point);
+          return true;
+        });
+  }
+
+  // Appends to neighbors the k stored points nearest to query under
+  // distance, nearest first, one per primary key (a point stored under
+  // several keys can fill several places); ties are broken arbitrarily.
+  // The search is best-first: trie nodes, treeblock nodes and points wait in
+  // a queue ordered by the distance from query to the box of points below
+  // them, and the nearest is expanded next, so only nodes whose box is nearer
+  // than the k-th neighbor are ever visited.
+  void knn_search(const data_point<DIMENSION> &query,
+                  size_t k,
+                  const knn_distance &distance,
+                  std::vector<knn_neighbor<DIMENSION>> &neighbors)
+  {
+    if (k == 0)
+      return;
+
+    std::vector<knn_candidate<DIMENSION>> heap;
+    knn_candidate<DIMENSION> root;
+    root.trie_node_ = root_;
+    for (dimension_t i = 0; i < DIMENSION; i++)
+    {
+      root.end_range_.set_coordinate(
+          i,
+          low_bits_set[schema_.dimension_to_num_bits[i] -
+                       schema_.start_dimension_bits[i]]);
+    }
+    root.distance_ = distance.to_box(query, root.start_range_, root.end_range_);
+    knn_candidate<DIMENSION>::push(heap, std::move(root));
+
+    size_t found = 0;
+    while (!heap.empty() && found < k)
+    {
+      knn_candidate<DIMENSION> candidate = knn_candidate<DIMENSION>::pop(heap);
+      if (candidate.block_)
+      {
+        candidate.block_->knn_expand(candidate, query, distance, heap);
+      }
+      else if (!candidate.trie_node_)
+      {
+        neighbors.push_back({distance.report(candidate.distance_),
+                             candidate.primary_key_,
+                             candidate.start_range_});
+        found++;
+      }
+      else if (candidate.level_ == schema_.trie_depth_)
+      {
+        candidate.block_ = candidate.trie_node_->get_block();
+        candidate.trie_node_ = nullptr;
+        if (candidate.block_)
+          knn_candidate<DIMENSION>::push(heap, std::move(candidate));
+      }
+      else
+      {
+        trie_node<DIMENSION> *current_trie_node = candidate.trie_node_;
+        for (morton_t i = 0; i < current_trie_node->num_children(); i++)
+        {
+          knn_candidate<DIMENSION> child;
+          child.trie_node_ = current_trie_node->child_at(i);
+          child.level_ = candidate.level_ + 1;
+          child.start_range_ = candidate.start_range_;
+          child.end_range_ = candidate.end_range_;
+          child.start_range_.update_symbol(&child.end_range_,
+                                           child.trie_node_->get_parent_symbol(),
+                                           candidate.level_,
+                                           &schema_);
+          child.distance_ =
+              distance.to_box(query, child.start_range_, child.end_range_);
+          knn_candidate<DIMENSION>::push(heap, std::move(child));
+        }
+      }
+    }
+  }
+
+  // Streaming variant of range_search_trie: matches go to visit as they are
+  // found (see range_visitor) rather than into a vector, so the caller
+  // decides what to keep and can stop early. Returns false if visit stopped
+  // the search. covered_points is passed on to
+  // tree_block::range_search_treeblock.
+  bool range_search_trie(data_point<DIMENSION> *start_range,
+                         data_point<DIMENSION> *end_range,
+                         trie_node<DIMENSION> *current_trie_node,
+                         level_t level,
+                         const range_visitor<DIMENSION> &visit,
+                         n_leaves_t *covered_points = nullptr)
+  {
+    if (covered_points &&
+        start_range->covers_subtree(end_range, level, &schema_))
+    {
+      *covered_points += trie_points(current_trie_node, level);
+      return true;
+    }
+
+    if (level == schema_.trie_depth_)
     {
 
       auto *current_treeblock =
           (tree_block<DIMENSION> *)current_trie_node->get_block();
-      current_treeblock->range_search_treeblock(start_range,
-                                                end_range,
-                                                current_treeblock,
-                                                level,
-                                                0,
-                                                0,
-                                                0,
-                                                0,
-                                                0,
-                                                0,
-                                                found_points);
-      return;
+      if (!current_treeblock)
+        return true;
+      return current_treeblock->range_search_treeblock(start_range,
+                                                       end_range,
+                                                       current_treeblock,
+                                                       level,
+                                                       0,
+                                                       0,
+                                                       0,
+                                                       0,
+                                                       0,
+                                                       0,
+                                                       visit,
+                                                       nullptr,
+                                                       covered_points);
     }
 
-    morton_t start_symbol = start_range->leaf_to_symbol(level);
-    morton_t end_symbol = end_range->leaf_to_symbol(level);
+    morton_t start_symbol = start_range->leaf_to_symbol(level, &schema_);
+    morton_t end_symbol = end_range->leaf_to_symbol(level, &schema_);
     morton_t representation = start_symbol ^ end_symbol;
     morton_t neg_representation = ~representation;
 
     struct data_point<DIMENSION> original_start_range = (*start_range);
     struct data_point<DIMENSION> original_end_range = (*end_range);
+    // Only the existing children are looked at (in symbol order), not every
+    // symbol in range: a range spanning most symbols of a wide level would
+    // otherwise cost as much as the level is wide, however few children
+    // there are.
+    morton_t num_children = current_trie_node->num_children();
+    for (morton_t i = 0; i < num_children; i++)
+    {
+      trie_node<DIMENSION> *child = current_trie_node->child_at(i);
+      morton_t current_symbol = child->get_parent_symbol();
+      if (current_symbol < start_symbol)
+        continue;
+      if (current_symbol > end_symbol)
+        break;
+
+      if ((start_symbol & neg_representation) !=
+          (current_symbol & neg_representation))
+      {
+        continue;
+      }
+
+      start_range->update_symbol(end_range, current_symbol, level, &schema_);
+
+      bool go_on = range_search_trie(start_range,
+                                     end_range,
+                                     child,
+                                     level + 1,
+                                     visit,
+                                     covered_points);
+      (*start_range) = original_start_range;
+      (*end_range) = original_end_range;
+      if (!go_on)
+        return false;
+    }
+    return true;
+  }
+
+  // Resumes a range search after a match, after and after_primary_key, that
+  // range_search_trie reported earlier: visit gets only the matches
+  // range_search_trie would report after it, in the same order (by symbol
+  // path, then primary key), so a large result can be paged through without
+  // searching again from the start. Those matches are the ones sharing after's
+  // symbols down to some level and greater at it; they form a few boxes per
+  // level, each searched with range_search_trie, deepest level first. Points
+  // inserted meanwhile are reported only if they come after after. after must
+  // lie in the range; returns false if visit stopped the search.
+  bool range_search_trie_after(data_point<DIMENSION> *start_range,
+                               data_point<DIMENSION> *end_range,
+                               data_point<DIMENSION> *after,
+                               n_leaves_t after_primary_key,
+                               const range_visitor<DIMENSION> &visit)
+  {
+    for (dimension_t i = 0; i < DIMENSION; i++)
+    {
+      if (after->get_coordinate(i) < start_range->get_coordinate(i) ||
+          after->get_coordinate(i) > end_range->get_coordinate(i))
+        return true;
+    }
+
+    // starts[level], ends[level]: the range narrowed to after's symbols above
+    // level.
+    level_t max_depth = schema_.max_depth_;
+    std::vector<data_point<DIMENSION>> starts(max_depth + 1, *start_range);
+    std::vector<data_point<DIMENSION>> ends(max_depth + 1, *end_range);
+    std::vector<morton_t> symbols(max_depth);
+    for (level_t level = 0; level < max_depth; level++)
+    {
+      symbols[level] = after->leaf_to_symbol(level, &schema_);
+      starts[level + 1] = starts[level];
+      ends[level + 1] = ends[level];
+      starts[level + 1].update_symbol(
+          &ends[level + 1], symbols[level], level, &schema_);
+    }
+
+    // after's own leaf: the primary keys above after_primary_key.
+    data_point<DIMENSION> start = starts[max_depth];
+    data_point<DIMENSION> end = ends[max_depth];
+    if (!range_search_trie(
+            &start,
+            &end,
+            root_,
+            0,
+            [&](const data_point<DIMENSION> &point, n_leaves_t primary_key) {
+              return primary_key <= after_primary_key ||
+                     visit(point, primary_key);
+            }))
+      return false;
+
+    for (level_t level = max_depth; level-- > 0;)
+    {
+      auto &tbl = schema_.dim_off_table[level];
+      dimension_t bits_in_lvl = (dimension_t)tbl.size();
+      // The box of symbols that share after's first i bits at level and have
+      // a 1 where after has a 0; the lowest such bit gives the smallest
+      // symbols, so it goes first.
+      for (dimension_t i = bits_in_lvl; i-- > 0;)
+      {
+        if (GETBIT(symbols[level], bits_in_lvl - 1 - i))
+          continue;
+        start = starts[level];
+        end = ends[level];
+        for (dimension_t j = 0; j < i; j++)
+        {
+          start.update_bit(&end,
+                           tbl[j].first,
+                           tbl[j].second,
+                           GETBIT(symbols[level], bits_in_lvl - 1 - j));
+        }
+        start.update_bit(&end, tbl[i].first, tbl[i].second, true);
+        if (start.get_coordinate(tbl[i].first) >
+            end.get_coordinate(tbl[i].first))
+          continue;
+        if (!range_search_trie(&start, &end, root_, 0, visit))
+          return false;
+      }
+    }
+    return true;
+  }
+
+  // Parallel variant of range_search_trie. The search is split into tasks on
+  // pool at every trie_node child in range and at every treeblock frontier
+  // pointer reached; each task appends to its own buffer, and the buffers are
+  // concatenated into found_points once all tasks are done (so points come out
+  // in no particular order). If first_result_time is given, it receives the
+  // time at which the first non-empty buffer was complete.
+  void range_search_trie_parallel(data_point<DIMENSION> *start_range,
+                                  data_point<DIMENSION> *end_range,
+                                  work_stealing_pool *pool,
+                                  std::vector<int32_t> &found_points,
+                                  TimeStamp *first_result_time = nullptr)
+  {
+    parallel_search_state state(pool, first_result_time);
+    state.spawn_frontier_ = [this, &state](tree_block<DIMENSION> *block,
+                                           level_t level,
+                                           data_point<DIMENSION> *start,
+                                           data_point<DIMENSION> *end) {
+      data_point<DIMENSION> task_start = *start;
+      data_point<DIMENSION> task_end = *end;
+      state.group_.run([this, &state, block, level, task_start, task_end]() {
+        search_treeblock_task(state, block, level, task_start, task_end);
+      });
+    };
+
+    data_point<DIMENSION> start = *start_range;
+    data_point<DIMENSION> end = *end_range;
+    search_trie_task(state, root_, 0, start, end);
+    state.group_.wait();
+
+    for (auto &buffer : state.buffers_)
+      found_points.insert(found_points.end(), buffer.begin(), buffer.end());
+  }
+
+private:
+  // Used by open_mmap, for a trie whose nodes already exist.
+  md_trie(const trie_schema &schema, trie_node<DIMENSION> *root)
+      : schema_(schema), root_(root)
+  {
+  }
+
+  // A treeblock receiving at least batch_rebuild_ratio times the points it
+  // already holds from a bulk_load is rebuilt rather than inserted into,
+  // unless that is fewer than batch_rebuild_min_points points.
+  static const n_leaves_t batch_rebuild_ratio = 2;
+  static const n_leaves_t batch_rebuild_min_points = 64;
+
+  // Appends the points stored in current_treeblock (a trie leaf's) and the
+  // treeblocks below it to found, one per primary key, each carrying its
+  // key. sample is any point under the trie leaf.
+  void collect_treeblock_points(tree_block<DIMENSION> *current_treeblock,
+                                const data_point<DIMENSION> &sample,
+                                std::vector<data_point<DIMENSION>> &found)
+  {
+    // The range spanning the whole trie leaf: sample's symbols above it,
+    // and every symbol below.
+    data_point<DIMENSION> start_range = sample;
+    data_point<DIMENSION> end_range = sample;
+    for (level_t level = schema_.trie_depth_; level < schema_.max_depth_; level++)
+    {
+      for (auto [dim, off] : schema_.dim_off_table[level])
+      {
+        start_range.set_coordinate(
+            dim, start_range.get_coordinate(dim) & ~(1ULL << off));
+        end_range.set_coordinate(
+            dim, end_range.get_coordinate(dim) | (1ULL << off));
+      }
+    }
+    found.reserve(found.size() + current_treeblock->num_points());
+    current_treeblock->range_search_treeblock(
+        &start_range,
+        &end_range,
+        current_treeblock,
+        schema_.trie_depth_,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        [&found](const data_point<DIMENSION> &point, n_leaves_t primary_key) {
+          found.push_back(point);
+          found.back().set_primary(primary_key);
+          return true;
+        });
+  }
+
+  // Frees current_treeblock and the treeblocks below it.
+  static void release_treeblock(tree_block<DIMENSION> *current_treeblock)
+  {
+    for (preorder_t j = 0; j < current_treeblock->num_frontiers(); j++)
+      release_treeblock(current_treeblock->get_pointer(j));
+    current_treeblock->release_primary_key_lists();
+    tree_block<DIMENSION>::destroy_block(current_treeblock);
+  }
+
+  void compact_trie_node(trie_node<DIMENSION> *current_trie_node,
+                         level_t level)
+  {
+    if (level == schema_.trie_depth_)
+    {
+      if (current_trie_node->get_block())
+        current_trie_node->get_block()->compact();
+      return;
+    }
+    for (morton_t i = 0; i < current_trie_node->num_children(); i++)
+      compact_trie_node(current_trie_node->child_at(i), level + 1);
+  }
+
+  // A trie node for level, counted in the trie's memory usage along with
+  // its child array.
+  trie_node<DIMENSION> *create_trie_node(bool is_leaf, level_t level) const
+  {
+    arena_.usage().add(MEMORY_TRIE_NODES, sizeof(trie_node<DIMENSION>));
+    return arena_.create<trie_node<DIMENSION>>(
+        is_leaf, schema_.level_to_num_children[level], &arena_);
+  }
+
+  void destroy_trie_node(trie_node<DIMENSION> *node, bool is_leaf) const
+  {
+    node->release_children(is_leaf, &arena_);
+    arena_.usage().add(MEMORY_TRIE_NODES,
+                       -(int64_t)sizeof(trie_node<DIMENSION>));
+    arena_.destroy(node);
+  }
+
+  // Points under current_trie_node (at level), summed up from the totals of
+  // the treeblocks below it.
+  n_leaves_t trie_points(trie_node<DIMENSION> *current_trie_node, level_t level)
+  {
+    if (level == schema_.trie_depth_)
+    {
+      tree_block<DIMENSION> *current_treeblock = current_trie_node->get_block();
+      return current_treeblock ? current_treeblock->num_points() : 0;
+    }
+    n_leaves_t points = 0;
+    for (morton_t i = 0; i < current_trie_node->num_children(); i++)
+      points += trie_points(current_trie_node->child_at(i), level + 1);
+    return points;
+  }
+
+  struct parallel_search_state
+  {
+    parallel_search_state(work_stealing_pool *pool,
+                          TimeStamp *first_result_time)
+        : group_(pool), first_result_time_(first_result_time)
+    {
+    }
+
+    std::vector<int32_t> *new_buffer()
+    {
+      std::lock_guard<std::mutex> lock(buffers_lock_);
+      buffers_.emplace_back();
+      return &buffers_.back();
+    }
+
+    task_group group_;
+    frontier_spawner<DIMENSION> spawn_frontier_;
+    std::mutex buffers_lock_;
+    // deque, so that a buffer stays put while others are added
+    std::deque<std::vector<int32_t>> buffers_;
+    std::atomic<bool> has_result_{false};
+    TimeStamp *first_result_time_;
+  };
+
+  void search_trie_task(parallel_search_state &state,
+                        trie_node<DIMENSION> *current_trie_node,
+                        level_t level,
+                        data_point<DIMENSION> start_range,
+                        data_point<DIMENSION> end_range)
+  {
+    if (level == schema_.trie_depth_)
+    {
+      if (!current_trie_node->get_block())
+        return;
+      search_treeblock_task(state,
+                            current_trie_node->get_block(),
+                            level,
+                            start_range,
+                            end_range);
+      return;
+    }
+
+    morton_t start_symbol = start_range.leaf_to_symbol(level, &schema_);
+    morton_t end_symbol = end_range.leaf_to_symbol(level, &schema_);
+    morton_t representation = start_symbol ^ end_symbol;
+    morton_t neg_representation = ~representation;
+
     for (morton_t current_symbol = start_symbol; current_symbol <= end_symbol;
          current_symbol++)
     {
@@ -247,27 +1206,72 @@ public:
         continue;
       }
 
-      if (!current_trie_node->get_child(current_symbol))
+      trie_node<DIMENSION> *child = current_trie_node->get_child(current_symbol);
+      if (!child)
       {
         continue;
       }
 
-      start_range->update_symbol(end_range, current_symbol, level);
-
-      range_search_trie(start_range,
-                        end_range,
-                        current_trie_node->get_child(current_symbol),
-                        level + 1,
-                        found_points);
-      (*start_range) = original_start_range;
-      (*end_range) = original_end_range;
+      data_point<DIMENSION> child_start = start_range;
+      data_point<DIMENSION> child_end = end_range;
+      child_start.update_symbol(&child_end, current_symbol, level, &schema_);
+      state.group_.run(
+          [this, &state, child, level, child_start, child_end]() {
+            search_trie_task(state, child, level + 1, child_start, child_end);
+          });
     }
   }
 
-private:
+  void search_treeblock_task(parallel_search_state &state,
+                             tree_block<DIMENSION> *current_treeblock,
+                             level_t level,
+                             data_point<DIMENSION> start_range,
+                             data_point<DIMENSION> end_range)
+  {
+    std::vector<int32_t> *buffer = state.new_buffer();
+    current_treeblock->range_search_treeblock(&start_range,
+                                              &end_range,
+                                              current_treeblock,
+                                              level,
+                                              0,
+                                              0,
+                                              0,
+                                              0,
+                                              0,
+                                              0,
+                                              *buffer,
+                                              &state.spawn_frontier_);
+    if (state.first_result_time_ && !buffer->empty() &&
+        !state.has_result_.exchange(true))
+      *state.first_result_time_ = GetTimestamp();
+  }
+
+  tree_block<DIMENSION> *new_leaf_treeblock(
+      trie_node<DIMENSION> *leaf_node) const
+  {
+    return arena_.create<tree_block<DIMENSION>>(
+        /* width_, */
+        schema_.trie_depth_,
+        1 /* initial_tree_capacity_ */,
+        1 << schema_.level_to_num_children[schema_.trie_depth_],
+        1,
+        &schema_,
+        leaf_node,
+        &arena_);
+  }
+
+  trie_schema schema_;
+  // Allocates everything the trie holds (see node_arena); mutable as
+  // walk_trie, which may add nodes, is usable from const lookups.
+  mutable node_arena arena_;
+  // Child arrays replaced by insert_trie_concurrent, until no inserter can
+  // still be reading them.
+  retired_children<DIMENSION> retired_children_;
   trie_node<DIMENSION> *root_ = nullptr;
-  level_t max_depth_;
-  preorder_t max_tree_nodes_;
+  // Set on tries opened with open_mmap.
+  void *mapping_ = nullptr;
+  size_t mapping_size_ = 0;
+  bitmap::CompactPtrVector *mapped_primary_key_map_ = nullptr;
   // dimension_t width_;
 };
 
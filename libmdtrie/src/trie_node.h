@@ -2,34 +2,339 @@
 #define MD_TRIE_TRIE_NODE_H
 
 #include "defs.h"
+#include "memory_usage.h"
+#include "node_arena.h"
 #include "tree_block.h"
 #include <cstdlib>
+#include <cstring>
 #include <sys/mman.h>
 
+template <dimension_t DIMENSION>
+class trie_node;
+
+/**
+ * trie_node_children: the children of an inner trie node, stored like a HAMT
+ * node. An occupancy bitmap over the 1 << num_dimensions symbols says which
+ * children exist, and the children themselves are kept densely, ordered by
+ * symbol. ranks_[w] counts the children before bitmap word w, so a child's
+ * slot is one popcount away. The bitmap, ranks and children are laid out
+ * right after the header in one allocation from the trie's node_arena.
+ */
+template <dimension_t DIMENSION>
+struct trie_node_children
+{
+  // Next array on the retired_children list this one waits on to be freed,
+  // after concurrent inserters replaced it; null while the array is live.
+  trie_node_children *retired_;
+  uint32_t num_words_;
+  uint32_t num_children_;
+
+  static size_t alloc_size(uint32_t num_words, uint32_t num_children)
+  {
+    return sizeof(trie_node_children) + num_words * sizeof(uint64_t) +
+           BITS2BLOCKS(num_words * 32) * sizeof(uint64_t) +
+           num_children * sizeof(trie_node<DIMENSION> *);
+  }
+
+  inline size_t size() const { return alloc_size(num_words_, num_children_); }
+
+  // Bytes held by this array and the ones after it on a retired list.
+  size_t chain_size() const
+  {
+    size_t total = 0;
+    const trie_node_children *array = this;
+    for (; array; array = array->retired_)
+      total += array->size();
+    return total;
+  }
+
+  inline uint64_t *bitmap() { return (uint64_t *)(this + 1); }
+
+  inline uint32_t *ranks() { return (uint32_t *)(bitmap() + num_words_); }
+
+  inline trie_node<DIMENSION> **children()
+  {
+    return (trie_node<DIMENSION> **)(bitmap() + num_words_ +
+                                      BITS2BLOCKS(num_words_ * 32));
+  }
+
+  // Slot of symbol among the children; present tells whether it exists.
+  inline uint32_t rank(morton_t symbol, bool &present)
+  {
+    uint64_t word = bitmap()[symbol / 64];
+    uint64_t bit = 1ULL << (symbol % 64);
+    present = word & bit;
+    return ranks()[symbol / 64] + __builtin_popcountll(word & (bit - 1));
+  }
+
+  inline trie_node<DIMENSION> *get(morton_t symbol)
+  {
+    bool present;
+    uint32_t slot = rank(symbol, present);
+    return present ? children()[slot] : nullptr;
+  }
+
+  static trie_node_children *create(dimension_t num_dimensions,
+                                    node_arena *arena)
+  {
+    uint32_t num_words = BITS2BLOCKS((uint64_t)1 << num_dimensions);
+    size_t size = alloc_size(num_words, 0);
+    auto *array = (trie_node_children *)arena->allocate(size);
+    memset(array, 0, size);
+    array->num_words_ = num_words;
+    return array;
+  }
+
+  // Returns a copy of this array with node added under symbol, which must not
+  // be present yet.
+  trie_node_children *copy_with(morton_t symbol,
+                                trie_node<DIMENSION> *node,
+                                node_arena *arena)
+  {
+    bool present;
+    uint32_t slot = rank(symbol, present);
+    auto *array = (trie_node_children *)arena->allocate(
+        alloc_size(num_words_, num_children_ + 1));
+    array->retired_ = nullptr;
+    array->num_words_ = num_words_;
+    array->num_children_ = num_children_ + 1;
+    memcpy(array->bitmap(), bitmap(), num_words_ * sizeof(uint64_t));
+    array->bitmap()[symbol / 64] |= 1ULL << (symbol % 64);
+    for (uint32_t w = 0; w < num_words_; w++)
+      array->ranks()[w] = ranks()[w] + (w > symbol / 64);
+    memcpy(array->children(), children(), slot * sizeof(node));
+    array->children()[slot] = node;
+    memcpy(array->children() + slot + 1,
+           children() + slot,
+           (num_children_ - slot) * sizeof(node));
+    return array;
+  }
+
+  // Returns a copy of this array without the child under symbol, which must
+  // be present.
+  trie_node_children *copy_without(morton_t symbol, node_arena *arena)
+  {
+    bool present;
+    uint32_t slot = rank(symbol, present);
+    auto *array = (trie_node_children *)arena->allocate(
+        alloc_size(num_words_, num_children_ - 1));
+    array->retired_ = nullptr;
+    array->num_words_ = num_words_;
+    array->num_children_ = num_children_ - 1;
+    memcpy(array->bitmap(), bitmap(), num_words_ * sizeof(uint64_t));
+    array->bitmap()[symbol / 64] &= ~(1ULL << (symbol % 64));
+    for (uint32_t w = 0; w < num_words_; w++)
+      array->ranks()[w] = ranks()[w] - (w > symbol / 64);
+    memcpy(array->children(),
+           children(),
+           slot * sizeof(trie_node<DIMENSION> *));
+    memcpy(array->children() + slot,
+           children() + slot + 1,
+           (num_children_ - slot - 1) * sizeof(trie_node<DIMENSION> *));
+    return array;
+  }
+
+  static void release(trie_node_children *array, node_arena *arena)
+  {
+    while (array)
+    {
+      trie_node_children *retired = array->retired_;
+      arena->release(array, array->size());
+      array = retired;
+    }
+  }
+};
+
+/**
+ * retired_children: child arrays replaced by concurrent inserters (see
+ * trie_node::set_child_if_absent), held until no inserter can still be
+ * reading them. Concurrent inserts never overlap queries, so inserters are
+ * the only readers to wait for. Each one enters the current epoch before
+ * walking the trie and leaves it when done; an array replaced in epoch g can
+ * only be held by inserters that entered in g or earlier, so it is freed
+ * once the epoch reaches g + 2. The epoch moves on as soon as the inserters
+ * of the one before it have left, so arrays are freed while inserts go on
+ * rather than when they stop. Arrays still queued when the trie goes away
+ * are freed with the rest of its node_arena.
+ */
+template <dimension_t DIMENSION>
+class retired_children
+{
+public:
+  retired_children() = default;
+  retired_children(const retired_children &) = delete;
+  retired_children &operator=(const retired_children &) = delete;
+
+  // Returns the epoch entered, to be handed back to leave.
+  uint64_t enter()
+  {
+    while (true)
+    {
+      uint64_t epoch = __atomic_load_n(&epoch_, __ATOMIC_SEQ_CST);
+      __atomic_add_fetch(&active_[epoch % 2], 1, __ATOMIC_SEQ_CST);
+      if (__atomic_load_n(&epoch_, __ATOMIC_SEQ_CST) == epoch)
+        return epoch;
+      __atomic_sub_fetch(&active_[epoch % 2], 1, __ATOMIC_SEQ_CST);
+    }
+  }
+
+  void leave(uint64_t epoch, node_arena *arena)
+  {
+    __atomic_sub_fetch(&active_[epoch % 2], 1, __ATOMIC_SEQ_CST);
+    advance(arena);
+  }
+
+  // Queues array, just replaced by an inserter that has entered, for
+  // freeing.
+  void retire(trie_node_children<DIMENSION> *array)
+  {
+    uint64_t epoch = __atomic_load_n(&epoch_, __ATOMIC_SEQ_CST);
+    trie_node_children<DIMENSION> **list = &lists_[epoch % 3];
+    array->retired_ = __atomic_load_n(list, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(list,
+                                        &array->retired_,
+                                        array,
+                                        true,
+                                        __ATOMIC_SEQ_CST,
+                                        __ATOMIC_RELAXED))
+      ;
+  }
+
+private:
+  // Moves the epoch on from e once no inserter of e - 1 is left, and frees
+  // the arrays retired in e - 1, whose list is the one epoch e + 1 reuses.
+  // One thread advances at a time, so that list is emptied before anything
+  // is retired into it again.
+  void advance(node_arena *arena)
+  {
+    if (__atomic_test_and_set(&advancing_, __ATOMIC_ACQUIRE))
+      return;
+    uint64_t epoch = __atomic_load_n(&epoch_, __ATOMIC_SEQ_CST);
+    if (!__atomic_load_n(&active_[(epoch + 1) % 2], __ATOMIC_SEQ_CST))
+    {
+      __atomic_store_n(&epoch_, epoch + 1, __ATOMIC_SEQ_CST);
+      release_list(__atomic_exchange_n(
+                       &lists_[(epoch + 2) % 3], nullptr, __ATOMIC_SEQ_CST),
+                   arena);
+    }
+    __atomic_clear(&advancing_, __ATOMIC_RELEASE);
+  }
+
+  static void release_list(trie_node_children<DIMENSION> *list,
+                           node_arena *arena)
+  {
+    if (!list)
+      return;
+    arena->usage().add(MEMORY_TRIE_NODES, -(int64_t)list->chain_size());
+    trie_node_children<DIMENSION>::release(list, arena);
+  }
+
+  uint64_t epoch_ = 0;
+  // Inserters in the current epoch and the one before it, by parity.
+  uint64_t active_[2] = {};
+  // Arrays retired in each of the last three epochs, by epoch % 3.
+  trie_node_children<DIMENSION> *lists_[3] = {};
+  bool advancing_ = false;
+};
+
 template <dimension_t DIMENSION>
 class trie_node
 {
 
 public:
-  explicit trie_node(bool is_leaf, dimension_t num_dimensions)
+  // The methods taking a node_arena allocate and free child arrays in it,
+  // the node's trie's, and count them in its memory usage.
+  explicit trie_node(bool is_leaf,
+                     dimension_t num_dimensions,
+                     node_arena *arena)
   {
     if (!is_leaf)
     {
-      trie_or_treeblock_ptr_ = (trie_node<DIMENSION> **)calloc(
-          sizeof(trie_node<DIMENSION> *), 1 << num_dimensions);
+      trie_or_treeblock_ptr_ =
+          trie_node_children<DIMENSION>::create(num_dimensions, arena);
+      arena->usage().add(MEMORY_TRIE_NODES, children()->size());
     }
   }
 
   inline trie_node<DIMENSION> *get_child(morton_t symbol)
   {
-    auto trie_ptr = (trie_node<DIMENSION> **)trie_or_treeblock_ptr_;
-    return trie_ptr[symbol];
+    return children()->get(symbol);
   }
 
-  inline void set_child(morton_t symbol, trie_node *node)
+  inline void set_child(morton_t symbol, trie_node *node, node_arena *arena)
+  {
+    trie_node_children<DIMENSION> *array = children();
+    bool present;
+    uint32_t slot = array->rank(symbol, present);
+    if (present)
+    {
+      array->children()[slot] = node;
+      return;
+    }
+    trie_or_treeblock_ptr_ = array->copy_with(symbol, node, arena);
+    arena->usage().add(MEMORY_TRIE_NODES,
+                       (int64_t)children()->size() -
+                           (int64_t)array->chain_size());
+    trie_node_children<DIMENSION>::release(array, arena);
+  }
+
+  // Drops the child under symbol, which must exist. Not safe alongside
+  // concurrent readers or inserters.
+  inline void erase_child(morton_t symbol, node_arena *arena)
+  {
+    trie_node_children<DIMENSION> *array = children();
+    trie_or_treeblock_ptr_ = array->copy_without(symbol, arena);
+    arena->usage().add(MEMORY_TRIE_NODES,
+                       (int64_t)children()->size() -
+                           (int64_t)array->chain_size());
+    trie_node_children<DIMENSION>::release(array, arena);
+  }
+
+  // Used by concurrent inserters: installs node under symbol unless another
+  // thread already did, and returns whichever child ended up installed.
+  // Writers serialize on children_lock_ and publish a new child array; the
+  // array it replaces goes to retired, to be freed once no other inserter
+  // can still be reading it.
+  inline trie_node<DIMENSION> *
+  set_child_if_absent(morton_t symbol,
+                      trie_node *node,
+                      retired_children<DIMENSION> *retired,
+                      node_arena *arena)
+  {
+    while (__atomic_test_and_set(&children_lock_, __ATOMIC_ACQUIRE))
+      ;
+    trie_node_children<DIMENSION> *array = children();
+    trie_node<DIMENSION> *installed = array->get(symbol);
+    if (!installed)
+    {
+      trie_node_children<DIMENSION> *new_array =
+          array->copy_with(symbol, node, arena);
+      arena->usage().add(MEMORY_TRIE_NODES, new_array->size());
+      // Sequentially consistent, so that retire reads an epoch no older
+      // than that of any inserter that saw the old array.
+      __atomic_store_n(&trie_or_treeblock_ptr_,
+                       (void *)new_array,
+                       __ATOMIC_SEQ_CST);
+      retired->retire(array);
+      installed = node;
+    }
+    __atomic_clear(&children_lock_, __ATOMIC_RELEASE);
+    return installed;
+  }
+
+  inline trie_node<DIMENSION> *get_child_acquire(morton_t symbol)
+  {
+    return ((trie_node_children<DIMENSION> *)__atomic_load_n(
+                &trie_or_treeblock_ptr_, __ATOMIC_ACQUIRE))
+        ->get(symbol);
+  }
+
+  inline morton_t num_children() { return children()->num_children_; }
+
+  // The index-th existing child, in symbol order.
+  inline trie_node<DIMENSION> *child_at(morton_t index)
   {
-    auto trie_ptr = (trie_node<DIMENSION> **)trie_or_treeblock_ptr_;
-    trie_ptr[symbol] = node;
+    return children()->children()[index];
   }
 
   inline tree_block<DIMENSION> *get_block() const
@@ -42,6 +347,39 @@ public:
     trie_or_treeblock_ptr_ = block;
   }
 
+  // Same as set_child_if_absent, for the treeblock hanging off a leaf node.
+  inline tree_block<DIMENSION> *set_block_if_absent(tree_block<DIMENSION> *block)
+  {
+    void *expected = nullptr;
+    if (__atomic_compare_exchange_n(&trie_or_treeblock_ptr_,
+                                    &expected,
+                                    (void *)block,
+                                    false,
+                                    __ATOMIC_ACQ_REL,
+                                    __ATOMIC_ACQUIRE))
+      return block;
+    return (tree_block<DIMENSION> *)expected;
+  }
+
+  inline tree_block<DIMENSION> *get_block_acquire()
+  {
+    return (tree_block<DIMENSION> *)__atomic_load_n(&trie_or_treeblock_ptr_,
+                                                    __ATOMIC_ACQUIRE);
+  }
+
+  // Frees the child array of a node being discarded: one that was never
+  // published (it lost a set_child_if_absent race), or one left without
+  // children by md_trie::delete_trie. Leaf nodes own no array.
+  void release_children(bool is_leaf, node_arena *arena)
+  {
+    if (!is_leaf)
+    {
+      arena->usage().add(MEMORY_TRIE_NODES, -(int64_t)children()->chain_size());
+      trie_node_children<DIMENSION>::release(children(), arena);
+    }
+    trie_or_treeblock_ptr_ = NULL;
+  }
+
   void get_node_path(level_t level, std::vector<morton_t> &node_path)
   {
 
@@ -64,7 +402,7 @@ public:
 
   void set_parent_symbol(morton_t symbol) { parent_symbol_ = symbol; }
 
-  uint64_t size(level_t num_children, bool is_leaf)
+  uint64_t size(bool is_leaf)
   {
     // if (is_valid((void *) this))
     //     return 0;
@@ -72,17 +410,65 @@ public:
     uint64_t total_size = sizeof(trie_or_treeblock_ptr_);
     total_size += sizeof(parent_trie_node_); // parent_trie_node_
     total_size += sizeof(parent_symbol_);    // parent_symbol_
+    total_size += sizeof(children_lock_);
 
-    if (is_leaf)
-      total_size += sizeof(trie_node<DIMENSION> *) * num_children;
+    if (!is_leaf)
+    {
+      // Only the live child array; retired ones waiting to be freed are not
+      // counted.
+      total_size += trie_node_children<DIMENSION>::alloc_size(
+          children()->num_words_, children()->num_children_);
+    }
 
     return total_size;
   }
 
+  // Writes this node and everything below it into writer's image;
+  // levels_to_leaf is 0 for a leaf node. Returns the node's image address.
+  uintptr_t save(snapshot_writer &writer,
+                 uintptr_t parent_address,
+                 level_t levels_to_leaf)
+  {
+    uint64_t offset = writer.allocate(sizeof(trie_node));
+    uintptr_t address = writer.address(offset);
+
+    trie_node image = *this;
+    image.parent_trie_node_ = (trie_node<DIMENSION> *)parent_address;
+    image.children_lock_ = false;
+    if (!levels_to_leaf)
+    {
+      image.trie_or_treeblock_ptr_ =
+          get_block() ? (void *)get_block()->save(writer, address) : nullptr;
+    }
+    else
+    {
+      // Only the live child array is written.
+      trie_node_children<DIMENSION> *array = children();
+      size_t array_size = trie_node_children<DIMENSION>::alloc_size(
+          array->num_words_, array->num_children_);
+      auto *copy = (trie_node_children<DIMENSION> *)malloc(array_size);
+      memcpy(copy, array, array_size);
+      copy->retired_ = nullptr;
+      for (uint32_t i = 0; i < array->num_children_; i++)
+        copy->children()[i] = (trie_node<DIMENSION> *)array->children()[i]->save(
+            writer, address, levels_to_leaf - 1);
+      image.trie_or_treeblock_ptr_ = (void *)writer.append(copy, array_size);
+      free(copy);
+    }
+    writer.write(offset, &image, sizeof(image));
+    return address;
+  }
+
 private:
+  inline trie_node_children<DIMENSION> *children()
+  {
+    return (trie_node_children<DIMENSION> *)trie_or_treeblock_ptr_;
+  }
+
   void *trie_or_treeblock_ptr_ = NULL;
   trie_node<DIMENSION> *parent_trie_node_ = NULL;
   morton_t parent_symbol_ = 0;
+  bool children_lock_ = false;
 };
 
 #endif // MD_TRIE_TRIE_NODE_H
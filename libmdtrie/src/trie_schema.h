@@ -0,0 +1,264 @@
+#ifndef MD_TRIE_TRIE_SCHEMA_H
+#define MD_TRIE_TRIE_SCHEMA_H
+
+#include "defs.h"
+#include "snapshot.h"
+#include <cassert>
+#include <cstring>
+#include <vector>
+
+/**
+ * symbol_gather: the bits one dimension contributes to the symbol at a level.
+ * They sit under coordinate_mask in the coordinate and under symbol_mask in
+ * the symbol, in the same order, so a PEXT by one mask and a PDEP by the other
+ * moves them across in either direction.
+ */
+struct symbol_gather
+{
+  dimension_t dim;
+  uint64_t coordinate_mask;
+  uint64_t symbol_mask;
+};
+
+/**
+ * trie_schema: the layout and tuning of one md_trie. Each md_trie owns its
+ * schema and hands a pointer to it to its treeblocks, their compressed
+ * bitmaps and the data_point symbol functions, so tries with different
+ * layouts can live side by side in one process.
+ *
+ * dimension_to_num_bits: bit width of each attribute
+ * start_dimension_bits: the level to which we start considering bits from
+ * that attribute
+ * dim_off_table: dim_off_table[level][i] = {dimension, bit offset} of the i-th
+ * bit of the symbol at that level
+ * level_to_num_children: maps level to the number of bits of the symbol at
+ * that level (a node has 1 << level_to_num_children[level] children)
+ * gather_plan: dim_off_table regrouped by dimension, one symbol_gather per
+ * dimension contributing to a level; the entries of a level start at
+ * level_to_gather_begin[level]
+ * no_dynamic_sizing: flag to indicate whether we set the treeblock size to
+ * the same value at every depth
+ * is_collapsed_node_exp: never collapse single-child nodes (experiment)
+ * primary_key_index: resolve primary keys through a per-treeblock
+ * primary_key_index instead of scanning the treeblock
+ * subtree_directory: skip large subtrees of a treeblock through a
+ * per-treeblock subtree_directory instead of walking them node by node
+ */
+
+struct trie_schema
+{
+  explicit trie_schema(const std::vector<level_t> &bit_widths,
+                       const std::vector<level_t> &start_bits,
+                       dimension_t width,
+                       level_t trie_depth,
+                       preorder_t max_tree_nodes,
+                       bool no_dynamic_sizing = false,
+                       bool is_collapsed_node_exp = false,
+                       bool primary_key_index = false,
+                       bool subtree_directory = false)
+  {
+    dimension_to_num_bits = bit_widths;
+    start_dimension_bits = start_bits;
+    trie_width_ = width;
+    trie_depth_ = trie_depth;
+    max_tree_nodes_ = max_tree_nodes;
+    this->no_dynamic_sizing = no_dynamic_sizing;
+    this->is_collapsed_node_exp = is_collapsed_node_exp;
+    this->primary_key_index = primary_key_index;
+    this->subtree_directory = subtree_directory;
+
+    create_dim_off_table();
+
+    max_depth_ = (level_t)dim_off_table.size();
+    assert(max_depth_ <= 80);
+
+    create_gather_plan();
+
+    for (level_t lvl = 0; lvl < max_depth_; lvl++)
+    {
+      level_to_num_children[lvl] = dim_off_table[lvl].size();
+    }
+
+    // sanity check
+    dimension_t num_dimensions = bit_widths.size();
+
+    uint16_t total_bits = 0;
+
+    for (dimension_t i = 0; i < num_dimensions; i++)
+    {
+      total_bits += (dimension_to_num_bits[i] - start_dimension_bits[i]);
+    }
+
+    for (level_t lvl = 0; lvl < max_depth_; lvl++)
+    {
+      total_bits -= level_to_num_children[lvl];
+    }
+
+    assert(total_bits == 0);
+  }
+
+  uint64_t size() const
+  {
+    uint64_t total_size = sizeof(trie_schema);
+    total_size += dimension_to_num_bits.size() * sizeof(level_t);
+    total_size += start_dimension_bits.size() * sizeof(level_t);
+    for (auto &lvl : dim_off_table)
+      total_size += sizeof(lvl) + lvl.size() * sizeof(lvl[0]);
+    total_size += gather_plan.size() * sizeof(symbol_gather);
+    return total_size;
+  }
+
+  // Writes this schema and its tables into writer's image and returns its
+  // image address.
+  uintptr_t save(snapshot_writer &writer) const
+  {
+    std::vector<unsigned char> levels(dim_off_table.size() *
+                                      sizeof(dim_off_table[0]));
+    for (size_t lvl = 0; lvl < dim_off_table.size(); lvl++)
+    {
+      uintptr_t data = dim_off_table[lvl].empty()
+                           ? 0
+                           : writer.append(dim_off_table[lvl].data(),
+                                           dim_off_table[lvl].size() *
+                                               sizeof(dim_off_table[lvl][0]));
+      snapshot_writer::set_vector<std::pair<dimension_t, level_t>>(
+          &levels[lvl * sizeof(dim_off_table[0])],
+          data,
+          dim_off_table[lvl].size());
+    }
+
+    alignas(trie_schema) unsigned char image[sizeof(trie_schema)];
+    memcpy(image, (const void *)this, sizeof(trie_schema));
+    auto *schema = (trie_schema *)image;
+    snapshot_writer::set_vector<level_t>(
+        &schema->dimension_to_num_bits,
+        writer.append(dimension_to_num_bits.data(),
+                      dimension_to_num_bits.size() * sizeof(level_t)),
+        dimension_to_num_bits.size());
+    snapshot_writer::set_vector<level_t>(
+        &schema->start_dimension_bits,
+        writer.append(start_dimension_bits.data(),
+                      start_dimension_bits.size() * sizeof(level_t)),
+        start_dimension_bits.size());
+    snapshot_writer::set_vector<std::vector<std::pair<dimension_t, level_t>>>(
+        &schema->dim_off_table,
+        writer.append(levels.data(), levels.size()),
+        dim_off_table.size());
+    snapshot_writer::set_vector<symbol_gather>(
+        &schema->gather_plan,
+        writer.append(gather_plan.data(),
+                      gather_plan.size() * sizeof(symbol_gather)),
+        gather_plan.size());
+    return writer.append(image, sizeof(image));
+  }
+
+  dimension_t trie_width_;
+  level_t max_depth_;
+  level_t trie_depth_;
+  preorder_t max_tree_nodes_;
+  bool no_dynamic_sizing;
+  bool is_collapsed_node_exp;
+  bool primary_key_index;
+  bool subtree_directory;
+  std::vector<level_t> dimension_to_num_bits;
+  std::vector<level_t> start_dimension_bits;
+  // for faster indexing with flexible widths
+  std::vector<std::vector<std::pair<dimension_t, level_t>>> dim_off_table;
+  morton_t level_to_num_children[80] = {0};
+  std::vector<symbol_gather> gather_plan;
+  uint32_t level_to_gather_begin[81] = {0};
+
+  inline const symbol_gather *gather_begin(level_t level) const
+  {
+    return gather_plan.data() + level_to_gather_begin[level];
+  }
+
+  inline const symbol_gather *gather_end(level_t level) const
+  {
+    return gather_plan.data() + level_to_gather_begin[level + 1];
+  }
+
+private:
+  // build a ragged 2D “dim_off” table: dim_off_table[level][i] = {dim,offset}
+  void create_dim_off_table()
+  {
+    dim_off_table.clear();
+
+    dimension_t D = (dimension_t)dimension_to_num_bits.size();
+    assert(D == dimension_t(start_dimension_bits.size()));
+    assert(trie_width_ > 0);
+
+    // compute how many bits each dim really contributes, and total
+    std::vector<level_t> rem(D);
+    uint16_t total = 0;
+    level_t max_bits = 0;
+    for (uint16_t d = 0; d < D; ++d)
+    {
+      assert(dimension_to_num_bits[d] >= start_dimension_bits[d]);
+      rem[d] = dimension_to_num_bits[d] - start_dimension_bits[d];
+      total += rem[d];
+      max_bits = std::max(max_bits, dimension_to_num_bits[d]);
+    }
+
+    // prepare the ragged 2D result
+    dim_off_table.emplace_back();
+    uint16_t in_this_level = 0;
+
+    // emit in “global bit‐rounds” order, grouping every W bits into one level
+    for (level_t g = 0; g < max_bits; ++g)
+    {
+      for (dimension_t d = 0; d < D; ++d)
+      {
+        if (g >= start_dimension_bits[d] &&
+            g < start_dimension_bits[d] + rem[d])
+        {
+          // compute offset of bit g in dimension d
+          level_t offset = dimension_to_num_bits[d] - 1 - g;
+
+          // if current level is full, start a new one
+          if (in_this_level == trie_width_)
+          {
+            dim_off_table.emplace_back();
+            in_this_level = 0;
+          }
+
+          dim_off_table.back().emplace_back(d, offset);
+          ++in_this_level;
+        }
+      }
+    }
+
+    // sanity check: we should have emitted exactly 'total' bits
+    int check = 0;
+    for (auto &lvl : dim_off_table)
+      check += int(lvl.size());
+    assert(check == total);
+  }
+
+  // Regroups each level of dim_off_table by dimension. The i-th of the n bits
+  // of a level is bit n - 1 - i of its symbol; a dimension's bits come in
+  // decreasing offset order, so its coordinate and symbol bits line up.
+  void create_gather_plan()
+  {
+    gather_plan.clear();
+    for (level_t lvl = 0; lvl < max_depth_; lvl++)
+    {
+      level_to_gather_begin[lvl] = gather_plan.size();
+      auto &tbl = dim_off_table[lvl];
+      for (size_t i = 0; i < tbl.size(); i++)
+      {
+        auto [dim, off] = tbl[i];
+        size_t g = level_to_gather_begin[lvl];
+        while (g < gather_plan.size() && gather_plan[g].dim != dim)
+          g++;
+        if (g == gather_plan.size())
+          gather_plan.push_back({dim, 0, 0});
+        gather_plan[g].coordinate_mask |= 1ULL << off;
+        gather_plan[g].symbol_mask |= 1ULL << (tbl.size() - 1 - i);
+      }
+    }
+    level_to_gather_begin[max_depth_] = gather_plan.size();
+  }
+};
+
+#endif // MD_TRIE_TRIE_SCHEMA_H
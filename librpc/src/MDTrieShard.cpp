@@ -90,6 +90,54 @@ MDTrieShard_range_search_presult::~MDTrieShard_range_search_presult() noexcept {
 }
 
 
+MDTrieShard_range_search_page_args::~MDTrieShard_range_search_page_args() noexcept {
+}
+
+
+MDTrieShard_range_search_page_pargs::~MDTrieShard_range_search_page_pargs() noexcept {
+}
+
+
+MDTrieShard_range_search_page_result::~MDTrieShard_range_search_page_result() noexcept {
+}
+
+
+MDTrieShard_range_search_page_presult::~MDTrieShard_range_search_page_presult() noexcept {
+}
+
+
+MDTrieShard_range_search_aggregate_args::~MDTrieShard_range_search_aggregate_args() noexcept {
+}
+
+
+MDTrieShard_range_search_aggregate_pargs::~MDTrieShard_range_search_aggregate_pargs() noexcept {
+}
+
+
+MDTrieShard_range_search_aggregate_result::~MDTrieShard_range_search_aggregate_result() noexcept {
+}
+
+
+MDTrieShard_range_search_aggregate_presult::~MDTrieShard_range_search_aggregate_presult() noexcept {
+}
+
+
+MDTrieShard_knn_search_args::~MDTrieShard_knn_search_args() noexcept {
+}
+
+
+MDTrieShard_knn_search_pargs::~MDTrieShard_knn_search_pargs() noexcept {
+}
+
+
+MDTrieShard_knn_search_result::~MDTrieShard_knn_search_result() noexcept {
+}
+
+
+MDTrieShard_knn_search_presult::~MDTrieShard_knn_search_presult() noexcept {
+}
+
+
 MDTrieShard_primary_key_lookup_args::~MDTrieShard_primary_key_lookup_args() noexcept {
 }
 
@@ -106,6 +154,22 @@ MDTrieShard_primary_key_lookup_presult::~MDTrieShard_primary_key_lookup_presult(
 }
 
 
+MDTrieShard_primary_key_lookup_batch_args::~MDTrieShard_primary_key_lookup_batch_args() noexcept {
+}
+
+
+MDTrieShard_primary_key_lookup_batch_pargs::~MDTrieShard_primary_key_lookup_batch_pargs() noexcept {
+}
+
+
+MDTrieShard_primary_key_lookup_batch_result::~MDTrieShard_primary_key_lookup_batch_result() noexcept {
+}
+
+
+MDTrieShard_primary_key_lookup_batch_presult::~MDTrieShard_primary_key_lookup_batch_presult() noexcept {
+}
+
+
 MDTrieShard_get_size_args::~MDTrieShard_get_size_args() noexcept {
 }
 
@@ -122,4 +186,20 @@ MDTrieShard_get_size_presult::~MDTrieShard_get_size_presult() noexcept {
 }
 
 
+MDTrieShard_get_size_breakdown_args::~MDTrieShard_get_size_breakdown_args() noexcept {
+}
+
+
+MDTrieShard_get_size_breakdown_pargs::~MDTrieShard_get_size_breakdown_pargs() noexcept {
+}
+
+
+MDTrieShard_get_size_breakdown_result::~MDTrieShard_get_size_breakdown_result() noexcept {
+}
+
+
+MDTrieShard_get_size_breakdown_presult::~MDTrieShard_get_size_breakdown_presult() noexcept {
+}
+
+
 
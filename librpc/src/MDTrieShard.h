@@ -26,9 +26,14 @@ class MDTrieShardIf {
   virtual int32_t insert(const std::vector<int32_t> & point, const int32_t primary_key) = 0;
   virtual int32_t insert_for_latency(const std::vector<int32_t> & point, const int32_t primary_key) = 0;
   virtual bool check(const std::vector<int32_t> & point) = 0;
-  virtual void range_search(std::vector<int32_t> & _return, const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range) = 0;
+  virtual void range_search(std::vector<int32_t> & _return, const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range, const int32_t result_mode) = 0;
+  virtual void range_search_page(std::vector<int32_t> & _return, const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range, const std::vector<int32_t> & resume_after, const int32_t limit, const int32_t result_mode) = 0;
+  virtual void range_search_aggregate(std::vector<int64_t> & _return, const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range, const std::vector<int32_t> & dimensions) = 0;
+  virtual void knn_search(std::vector<int32_t> & _return, const std::vector<int32_t> & point, const int32_t k, const int32_t metric, const std::vector<double> & weights) = 0;
   virtual void primary_key_lookup(std::vector<int32_t> & _return, const int32_t primary_key) = 0;
+  virtual void primary_key_lookup_batch(std::vector<int32_t> & _return, const std::vector<int32_t> & primary_keys) = 0;
   virtual int32_t get_size() = 0;
+  virtual void get_size_breakdown(std::vector<int64_t> & _return) = 0;
 };
 
 class MDTrieShardIfFactory {
@@ -74,16 +79,31 @@ class MDTrieShardNull : virtual public MDTrieShardIf {
     bool _return = false;
     return _return;
   }
-  void range_search(std::vector<int32_t> & /* _return */, const std::vector<int32_t> & /* start_range */, const std::vector<int32_t> & /* end_range */) override {
+  void range_search(std::vector<int32_t> & /* _return */, const std::vector<int32_t> & /* start_range */, const std::vector<int32_t> & /* end_range */, const int32_t /* result_mode */) override {
+    return;
+  }
+  void range_search_page(std::vector<int32_t> & /* _return */, const std::vector<int32_t> & /* start_range */, const std::vector<int32_t> & /* end_range */, const std::vector<int32_t> & /* resume_after */, const int32_t /* limit */, const int32_t /* result_mode */) override {
+    return;
+  }
+  void range_search_aggregate(std::vector<int64_t> & /* _return */, const std::vector<int32_t> & /* start_range */, const std::vector<int32_t> & /* end_range */, const std::vector<int32_t> & /* dimensions */) override {
+    return;
+  }
+  void knn_search(std::vector<int32_t> & /* _return */, const std::vector<int32_t> & /* point */, const int32_t /* k */, const int32_t /* metric */, const std::vector<double> & /* weights */) override {
     return;
   }
   void primary_key_lookup(std::vector<int32_t> & /* _return */, const int32_t /* primary_key */) override {
     return;
   }
+  void primary_key_lookup_batch(std::vector<int32_t> & /* _return */, const std::vector<int32_t> & /* primary_keys */) override {
+    return;
+  }
   int32_t get_size() override {
     int32_t _return = 0;
     return _return;
   }
+  void get_size_breakdown(std::vector<int64_t> & /* _return */) override {
+    return;
+  }
 };
 
 typedef struct _MDTrieShard_ping_args__isset {
@@ -548,9 +568,10 @@ class MDTrieShard_check_presult {
 };
 
 typedef struct _MDTrieShard_range_search_args__isset {
-  _MDTrieShard_range_search_args__isset() : start_range(false), end_range(false) {}
+  _MDTrieShard_range_search_args__isset() : start_range(false), end_range(false), result_mode(false) {}
   bool start_range :1;
   bool end_range :1;
+  bool result_mode :1;
 } _MDTrieShard_range_search_args__isset;
 
 class MDTrieShard_range_search_args {
@@ -558,12 +579,14 @@ class MDTrieShard_range_search_args {
 
   MDTrieShard_range_search_args(const MDTrieShard_range_search_args&);
   MDTrieShard_range_search_args& operator=(const MDTrieShard_range_search_args&);
-  MDTrieShard_range_search_args() noexcept {
+  MDTrieShard_range_search_args() noexcept
+                                : result_mode(0) {
   }
 
   virtual ~MDTrieShard_range_search_args() noexcept;
   std::vector<int32_t>  start_range;
   std::vector<int32_t>  end_range;
+  int32_t result_mode;
 
   _MDTrieShard_range_search_args__isset __isset;
 
@@ -571,12 +594,16 @@ class MDTrieShard_range_search_args {
 
   void __set_end_range(const std::vector<int32_t> & val);
 
+  void __set_result_mode(const int32_t val);
+
   bool operator == (const MDTrieShard_range_search_args & rhs) const
   {
     if (!(start_range == rhs.start_range))
       return false;
     if (!(end_range == rhs.end_range))
       return false;
+    if (!(result_mode == rhs.result_mode))
+      return false;
     return true;
   }
   bool operator != (const MDTrieShard_range_search_args &rhs) const {
@@ -600,6 +627,7 @@ class MDTrieShard_range_search_pargs {
   virtual ~MDTrieShard_range_search_pargs() noexcept;
   const std::vector<int32_t> * start_range;
   const std::vector<int32_t> * end_range;
+  const int32_t* result_mode;
 
   template <class Protocol_>
   uint32_t write(Protocol_* oprot) const;
@@ -664,6 +692,401 @@ class MDTrieShard_range_search_presult {
 
 };
 
+typedef struct _MDTrieShard_range_search_page_args__isset {
+  _MDTrieShard_range_search_page_args__isset() : start_range(false), end_range(false), resume_after(false), limit(false), result_mode(false) {}
+  bool start_range :1;
+  bool end_range :1;
+  bool resume_after :1;
+  bool limit :1;
+  bool result_mode :1;
+} _MDTrieShard_range_search_page_args__isset;
+
+class MDTrieShard_range_search_page_args {
+ public:
+
+  MDTrieShard_range_search_page_args(const MDTrieShard_range_search_page_args&);
+  MDTrieShard_range_search_page_args& operator=(const MDTrieShard_range_search_page_args&);
+  MDTrieShard_range_search_page_args() noexcept
+                                     : limit(0), result_mode(0) {
+  }
+
+  virtual ~MDTrieShard_range_search_page_args() noexcept;
+  std::vector<int32_t>  start_range;
+  std::vector<int32_t>  end_range;
+  std::vector<int32_t>  resume_after;
+  int32_t limit;
+  int32_t result_mode;
+
+  _MDTrieShard_range_search_page_args__isset __isset;
+
+  void __set_start_range(const std::vector<int32_t> & val);
+
+  void __set_end_range(const std::vector<int32_t> & val);
+
+  void __set_resume_after(const std::vector<int32_t> & val);
+
+  void __set_limit(const int32_t val);
+
+  void __set_result_mode(const int32_t val);
+
+  bool operator == (const MDTrieShard_range_search_page_args & rhs) const
+  {
+    if (!(start_range == rhs.start_range))
+      return false;
+    if (!(end_range == rhs.end_range))
+      return false;
+    if (!(resume_after == rhs.resume_after))
+      return false;
+    if (!(limit == rhs.limit))
+      return false;
+    if (!(result_mode == rhs.result_mode))
+      return false;
+    return true;
+  }
+  bool operator != (const MDTrieShard_range_search_page_args &rhs) const {
+    return !(*this == rhs);
+  }
+
+  bool operator < (const MDTrieShard_range_search_page_args & ) const;
+
+  template <class Protocol_>
+  uint32_t read(Protocol_* iprot);
+  template <class Protocol_>
+  uint32_t write(Protocol_* oprot) const;
+
+};
+
+
+class MDTrieShard_range_search_page_pargs {
+ public:
+
+
+  virtual ~MDTrieShard_range_search_page_pargs() noexcept;
+  const std::vector<int32_t> * start_range;
+  const std::vector<int32_t> * end_range;
+  const std::vector<int32_t> * resume_after;
+  const int32_t* limit;
+  const int32_t* result_mode;
+
+  template <class Protocol_>
+  uint32_t write(Protocol_* oprot) const;
+
+};
+
+typedef struct _MDTrieShard_range_search_page_result__isset {
+  _MDTrieShard_range_search_page_result__isset() : success(false) {}
+  bool success :1;
+} _MDTrieShard_range_search_page_result__isset;
+
+class MDTrieShard_range_search_page_result {
+ public:
+
+  MDTrieShard_range_search_page_result(const MDTrieShard_range_search_page_result&);
+  MDTrieShard_range_search_page_result& operator=(const MDTrieShard_range_search_page_result&);
+  MDTrieShard_range_search_page_result() noexcept {
+  }
+
+  virtual ~MDTrieShard_range_search_page_result() noexcept;
+  std::vector<int32_t>  success;
+
+  _MDTrieShard_range_search_page_result__isset __isset;
+
+  void __set_success(const std::vector<int32_t> & val);
+
+  bool operator == (const MDTrieShard_range_search_page_result & rhs) const
+  {
+    if (!(success == rhs.success))
+      return false;
+    return true;
+  }
+  bool operator != (const MDTrieShard_range_search_page_result &rhs) const {
+    return !(*this == rhs);
+  }
+
+  bool operator < (const MDTrieShard_range_search_page_result & ) const;
+
+  template <class Protocol_>
+  uint32_t read(Protocol_* iprot);
+  template <class Protocol_>
+  uint32_t write(Protocol_* oprot) const;
+
+};
+
+typedef struct _MDTrieShard_range_search_page_presult__isset {
+  _MDTrieShard_range_search_page_presult__isset() : success(false) {}
+  bool success :1;
+} _MDTrieShard_range_search_page_presult__isset;
+
+class MDTrieShard_range_search_page_presult {
+ public:
+
+
+  virtual ~MDTrieShard_range_search_page_presult() noexcept;
+  std::vector<int32_t> * success;
+
+  _MDTrieShard_range_search_page_presult__isset __isset;
+
+  template <class Protocol_>
+  uint32_t read(Protocol_* iprot);
+
+};
+
+typedef struct _MDTrieShard_range_search_aggregate_args__isset {
+  _MDTrieShard_range_search_aggregate_args__isset() : start_range(false), end_range(false), dimensions(false) {}
+  bool start_range :1;
+  bool end_range :1;
+  bool dimensions :1;
+} _MDTrieShard_range_search_aggregate_args__isset;
+
+class MDTrieShard_range_search_aggregate_args {
+ public:
+
+  MDTrieShard_range_search_aggregate_args(const MDTrieShard_range_search_aggregate_args&);
+  MDTrieShard_range_search_aggregate_args& operator=(const MDTrieShard_range_search_aggregate_args&);
+  MDTrieShard_range_search_aggregate_args() noexcept {
+  }
+
+  virtual ~MDTrieShard_range_search_aggregate_args() noexcept;
+  std::vector<int32_t>  start_range;
+  std::vector<int32_t>  end_range;
+  std::vector<int32_t>  dimensions;
+
+  _MDTrieShard_range_search_aggregate_args__isset __isset;
+
+  void __set_start_range(const std::vector<int32_t> & val);
+
+  void __set_end_range(const std::vector<int32_t> & val);
+
+  void __set_dimensions(const std::vector<int32_t> & val);
+
+  bool operator == (const MDTrieShard_range_search_aggregate_args & rhs) const
+  {
+    if (!(start_range == rhs.start_range))
+      return false;
+    if (!(end_range == rhs.end_range))
+      return false;
+    if (!(dimensions == rhs.dimensions))
+      return false;
+    return true;
+  }
+  bool operator != (const MDTrieShard_range_search_aggregate_args &rhs) const {
+    return !(*this == rhs);
+  }
+
+  bool operator < (const MDTrieShard_range_search_aggregate_args & ) const;
+
+  template <class Protocol_>
+  uint32_t read(Protocol_* iprot);
+  template <class Protocol_>
+  uint32_t write(Protocol_* oprot) const;
+
+};
+
+
+class MDTrieShard_range_search_aggregate_pargs {
+ public:
+
+
+  virtual ~MDTrieShard_range_search_aggregate_pargs() noexcept;
+  const std::vector<int32_t> * start_range;
+  const std::vector<int32_t> * end_range;
+  const std::vector<int32_t> * dimensions;
+
+  template <class Protocol_>
+  uint32_t write(Protocol_* oprot) const;
+
+};
+
+typedef struct _MDTrieShard_range_search_aggregate_result__isset {
+  _MDTrieShard_range_search_aggregate_result__isset() : success(false) {}
+  bool success :1;
+} _MDTrieShard_range_search_aggregate_result__isset;
+
+class MDTrieShard_range_search_aggregate_result {
+ public:
+
+  MDTrieShard_range_search_aggregate_result(const MDTrieShard_range_search_aggregate_result&);
+  MDTrieShard_range_search_aggregate_result& operator=(const MDTrieShard_range_search_aggregate_result&);
+  MDTrieShard_range_search_aggregate_result() noexcept {
+  }
+
+  virtual ~MDTrieShard_range_search_aggregate_result() noexcept;
+  std::vector<int64_t>  success;
+
+  _MDTrieShard_range_search_aggregate_result__isset __isset;
+
+  void __set_success(const std::vector<int64_t> & val);
+
+  bool operator == (const MDTrieShard_range_search_aggregate_result & rhs) const
+  {
+    if (!(success == rhs.success))
+      return false;
+    return true;
+  }
+  bool operator != (const MDTrieShard_range_search_aggregate_result &rhs) const {
+    return !(*this == rhs);
+  }
+
+  bool operator < (const MDTrieShard_range_search_aggregate_result & ) const;
+
+  template <class Protocol_>
+  uint32_t read(Protocol_* iprot);
+  template <class Protocol_>
+  uint32_t write(Protocol_* oprot) const;
+
+};
+
+typedef struct _MDTrieShard_range_search_aggregate_presult__isset {
+  _MDTrieShard_range_search_aggregate_presult__isset() : success(false) {}
+  bool success :1;
+} _MDTrieShard_range_search_aggregate_presult__isset;
+
+class MDTrieShard_range_search_aggregate_presult {
+ public:
+
+
+  virtual ~MDTrieShard_range_search_aggregate_presult() noexcept;
+  std::vector<int64_t> * success;
+
+  _MDTrieShard_range_search_aggregate_presult__isset __isset;
+
+  template <class Protocol_>
+  uint32_t read(Protocol_* iprot);
+
+};
+
+typedef struct _MDTrieShard_knn_search_args__isset {
+  _MDTrieShard_knn_search_args__isset() : point(false), k(false), metric(false), weights(false) {}
+  bool point :1;
+  bool k :1;
+  bool metric :1;
+  bool weights :1;
+} _MDTrieShard_knn_search_args__isset;
+
+class MDTrieShard_knn_search_args {
+ public:
+
+  MDTrieShard_knn_search_args(const MDTrieShard_knn_search_args&);
+  MDTrieShard_knn_search_args& operator=(const MDTrieShard_knn_search_args&);
+  MDTrieShard_knn_search_args() noexcept
+                              : k(0), metric(0) {
+  }
+
+  virtual ~MDTrieShard_knn_search_args() noexcept;
+  std::vector<int32_t>  point;
+  int32_t k;
+  int32_t metric;
+  std::vector<double>  weights;
+
+  _MDTrieShard_knn_search_args__isset __isset;
+
+  void __set_point(const std::vector<int32_t> & val);
+
+  void __set_k(const int32_t val);
+
+  void __set_metric(const int32_t val);
+
+  void __set_weights(const std::vector<double> & val);
+
+  bool operator == (const MDTrieShard_knn_search_args & rhs) const
+  {
+    if (!(point == rhs.point))
+      return false;
+    if (!(k == rhs.k))
+      return false;
+    if (!(metric == rhs.metric))
+      return false;
+    if (!(weights == rhs.weights))
+      return false;
+    return true;
+  }
+  bool operator != (const MDTrieShard_knn_search_args &rhs) const {
+    return !(*this == rhs);
+  }
+
+  bool operator < (const MDTrieShard_knn_search_args & ) const;
+
+  template <class Protocol_>
+  uint32_t read(Protocol_* iprot);
+  template <class Protocol_>
+  uint32_t write(Protocol_* oprot) const;
+
+};
+
+
+class MDTrieShard_knn_search_pargs {
+ public:
+
+
+  virtual ~MDTrieShard_knn_search_pargs() noexcept;
+  const std::vector<int32_t> * point;
+  const int32_t* k;
+  const int32_t* metric;
+  const std::vector<double> * weights;
+
+  template <class Protocol_>
+  uint32_t write(Protocol_* oprot) const;
+
+};
+
+typedef struct _MDTrieShard_knn_search_result__isset {
+  _MDTrieShard_knn_search_result__isset() : success(false) {}
+  bool success :1;
+} _MDTrieShard_knn_search_result__isset;
+
+class MDTrieShard_knn_search_result {
+ public:
+
+  MDTrieShard_knn_search_result(const MDTrieShard_knn_search_result&);
+  MDTrieShard_knn_search_result& operator=(const MDTrieShard_knn_search_result&);
+  MDTrieShard_knn_search_result() noexcept {
+  }
+
+  virtual ~MDTrieShard_knn_search_result() noexcept;
+  std::vector<int32_t>  success;
+
+  _MDTrieShard_knn_search_result__isset __isset;
+
+  void __set_success(const std::vector<int32_t> & val);
+
+  bool operator == (const MDTrieShard_knn_search_result & rhs) const
+  {
+    if (!(success == rhs.success))
+      return false;
+    return true;
+  }
+  bool operator != (const MDTrieShard_knn_search_result &rhs) const {
+    return !(*this == rhs);
+  }
+
+  bool operator < (const MDTrieShard_knn_search_result & ) const;
+
+  template <class Protocol_>
+  uint32_t read(Protocol_* iprot);
+  template <class Protocol_>
+  uint32_t write(Protocol_* oprot) const;
+
+};
+
+typedef struct _MDTrieShard_knn_search_presult__isset {
+  _MDTrieShard_knn_search_presult__isset() : success(false) {}
+  bool success :1;
+} _MDTrieShard_knn_search_presult__isset;
+
+class MDTrieShard_knn_search_presult {
+ public:
+
+
+  virtual ~MDTrieShard_knn_search_presult() noexcept;
+  std::vector<int32_t> * success;
+
+  _MDTrieShard_knn_search_presult__isset __isset;
+
+  template <class Protocol_>
+  uint32_t read(Protocol_* iprot);
+
+};
+
 typedef struct _MDTrieShard_primary_key_lookup_args__isset {
   _MDTrieShard_primary_key_lookup_args__isset() : primary_key(false) {}
   bool primary_key :1;
@@ -775,6 +1198,116 @@ class MDTrieShard_primary_key_lookup_presult {
 
 };
 
+typedef struct _MDTrieShard_primary_key_lookup_batch_args__isset {
+  _MDTrieShard_primary_key_lookup_batch_args__isset() : primary_keys(false) {}
+  bool primary_keys :1;
+} _MDTrieShard_primary_key_lookup_batch_args__isset;
+
+class MDTrieShard_primary_key_lookup_batch_args {
+ public:
+
+  MDTrieShard_primary_key_lookup_batch_args(const MDTrieShard_primary_key_lookup_batch_args&);
+  MDTrieShard_primary_key_lookup_batch_args& operator=(const MDTrieShard_primary_key_lookup_batch_args&);
+  MDTrieShard_primary_key_lookup_batch_args() noexcept {
+  }
+
+  virtual ~MDTrieShard_primary_key_lookup_batch_args() noexcept;
+  std::vector<int32_t>  primary_keys;
+
+  _MDTrieShard_primary_key_lookup_batch_args__isset __isset;
+
+  void __set_primary_keys(const std::vector<int32_t> & val);
+
+  bool operator == (const MDTrieShard_primary_key_lookup_batch_args & rhs) const
+  {
+    if (!(primary_keys == rhs.primary_keys))
+      return false;
+    return true;
+  }
+  bool operator != (const MDTrieShard_primary_key_lookup_batch_args &rhs) const {
+    return !(*this == rhs);
+  }
+
+  bool operator < (const MDTrieShard_primary_key_lookup_batch_args & ) const;
+
+  template <class Protocol_>
+  uint32_t read(Protocol_* iprot);
+  template <class Protocol_>
+  uint32_t write(Protocol_* oprot) const;
+
+};
+
+
+class MDTrieShard_primary_key_lookup_batch_pargs {
+ public:
+
+
+  virtual ~MDTrieShard_primary_key_lookup_batch_pargs() noexcept;
+  const std::vector<int32_t> * primary_keys;
+
+  template <class Protocol_>
+  uint32_t write(Protocol_* oprot) const;
+
+};
+
+typedef struct _MDTrieShard_primary_key_lookup_batch_result__isset {
+  _MDTrieShard_primary_key_lookup_batch_result__isset() : success(false) {}
+  bool success :1;
+} _MDTrieShard_primary_key_lookup_batch_result__isset;
+
+class MDTrieShard_primary_key_lookup_batch_result {
+ public:
+
+  MDTrieShard_primary_key_lookup_batch_result(const MDTrieShard_primary_key_lookup_batch_result&);
+  MDTrieShard_primary_key_lookup_batch_result& operator=(const MDTrieShard_primary_key_lookup_batch_result&);
+  MDTrieShard_primary_key_lookup_batch_result() noexcept {
+  }
+
+  virtual ~MDTrieShard_primary_key_lookup_batch_result() noexcept;
+  std::vector<int32_t>  success;
+
+  _MDTrieShard_primary_key_lookup_batch_result__isset __isset;
+
+  void __set_success(const std::vector<int32_t> & val);
+
+  bool operator == (const MDTrieShard_primary_key_lookup_batch_result & rhs) const
+  {
+    if (!(success == rhs.success))
+      return false;
+    return true;
+  }
+  bool operator != (const MDTrieShard_primary_key_lookup_batch_result &rhs) const {
+    return !(*this == rhs);
+  }
+
+  bool operator < (const MDTrieShard_primary_key_lookup_batch_result & ) const;
+
+  template <class Protocol_>
+  uint32_t read(Protocol_* iprot);
+  template <class Protocol_>
+  uint32_t write(Protocol_* oprot) const;
+
+};
+
+typedef struct _MDTrieShard_primary_key_lookup_batch_presult__isset {
+  _MDTrieShard_primary_key_lookup_batch_presult__isset() : success(false) {}
+  bool success :1;
+} _MDTrieShard_primary_key_lookup_batch_presult__isset;
+
+class MDTrieShard_primary_key_lookup_batch_presult {
+ public:
+
+
+  virtual ~MDTrieShard_primary_key_lookup_batch_presult() noexcept;
+  std::vector<int32_t> * success;
+
+  _MDTrieShard_primary_key_lookup_batch_presult__isset __isset;
+
+  template <class Protocol_>
+  uint32_t read(Protocol_* iprot);
+
+};
+
 
 class MDTrieShard_get_size_args {
  public:
@@ -874,6 +1407,104 @@ class MDTrieShard_get_size_presult {
 
 };
 
+
+class MDTrieShard_get_size_breakdown_args {
+ public:
+
+  MDTrieShard_get_size_breakdown_args(const MDTrieShard_get_size_breakdown_args&) noexcept;
+  MDTrieShard_get_size_breakdown_args& operator=(const MDTrieShard_get_size_breakdown_args&) noexcept;
+  MDTrieShard_get_size_breakdown_args() noexcept {
+  }
+
+  virtual ~MDTrieShard_get_size_breakdown_args() noexcept;
+
+  bool operator == (const MDTrieShard_get_size_breakdown_args & /* rhs */) const
+  {
+    return true;
+  }
+  bool operator != (const MDTrieShard_get_size_breakdown_args &rhs) const {
+    return !(*this == rhs);
+  }
+
+  bool operator < (const MDTrieShard_get_size_breakdown_args & ) const;
+
+  template <class Protocol_>
+  uint32_t read(Protocol_* iprot);
+  template <class Protocol_>
+  uint32_t write(Protocol_* oprot) const;
+
+};
+
+
+class MDTrieShard_get_size_breakdown_pargs {
+ public:
+
+
+  virtual ~MDTrieShard_get_size_breakdown_pargs() noexcept;
+
+  template <class Protocol_>
+  uint32_t write(Protocol_* oprot) const;
+
+};
+
+typedef struct _MDTrieShard_get_size_breakdown_result__isset {
+  _MDTrieShard_get_size_breakdown_result__isset() : success(false) {}
+  bool success :1;
+} _MDTrieShard_get_size_breakdown_result__isset;
+
+class MDTrieShard_get_size_breakdown_result {
+ public:
+
+  MDTrieShard_get_size_breakdown_result(const MDTrieShard_get_size_breakdown_result&);
+  MDTrieShard_get_size_breakdown_result& operator=(const MDTrieShard_get_size_breakdown_result&);
+  MDTrieShard_get_size_breakdown_result() noexcept {
+  }
+
+  virtual ~MDTrieShard_get_size_breakdown_result() noexcept;
+  std::vector<int64_t>  success;
+
+  _MDTrieShard_get_size_breakdown_result__isset __isset;
+
+  void __set_success(const std::vector<int64_t> & val);
+
+  bool operator == (const MDTrieShard_get_size_breakdown_result & rhs) const
+  {
+    if (!(success == rhs.success))
+      return false;
+    return true;
+  }
+  bool operator != (const MDTrieShard_get_size_breakdown_result &rhs) const {
+    return !(*this == rhs);
+  }
+
+  bool operator < (const MDTrieShard_get_size_breakdown_result & ) const;
+
+  template <class Protocol_>
+  uint32_t read(Protocol_* iprot);
+  template <class Protocol_>
+  uint32_t write(Protocol_* oprot) const;
+
+};
+
+typedef struct _MDTrieShard_get_size_breakdown_presult__isset {
+  _MDTrieShard_get_size_breakdown_presult__isset() : success(false) {}
+  bool success :1;
+} _MDTrieShard_get_size_breakdown_presult__isset;
+
+class MDTrieShard_get_size_breakdown_presult {
+ public:
+
+
+  virtual ~MDTrieShard_get_size_breakdown_presult() noexcept;
+  std::vector<int64_t> * success;
+
+  _MDTrieShard_get_size_breakdown_presult__isset __isset;
+
+  template <class Protocol_>
+  uint32_t read(Protocol_* iprot);
+
+};
+
 template <class Protocol_>
 class MDTrieShardClientT : virtual public MDTrieShardIf {
  public:
@@ -912,15 +1543,30 @@ class MDTrieShardClientT : virtual public MDTrieShardIf {
   bool check(const std::vector<int32_t> & point) override;
   void send_check(const std::vector<int32_t> & point);
   bool recv_check();
-  void range_search(std::vector<int32_t> & _return, const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range) override;
-  void send_range_search(const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range);
+  void range_search(std::vector<int32_t> & _return, const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range, const int32_t result_mode) override;
+  void send_range_search(const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range, const int32_t result_mode);
   void recv_range_search(std::vector<int32_t> & _return);
+  void range_search_page(std::vector<int32_t> & _return, const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range, const std::vector<int32_t> & resume_after, const int32_t limit, const int32_t result_mode) override;
+  void send_range_search_page(const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range, const std::vector<int32_t> & resume_after, const int32_t limit, const int32_t result_mode);
+  void recv_range_search_page(std::vector<int32_t> & _return);
+  void range_search_aggregate(std::vector<int64_t> & _return, const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range, const std::vector<int32_t> & dimensions) override;
+  void send_range_search_aggregate(const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range, const std::vector<int32_t> & dimensions);
+  void recv_range_search_aggregate(std::vector<int64_t> & _return);
+  void knn_search(std::vector<int32_t> & _return, const std::vector<int32_t> & point, const int32_t k, const int32_t metric, const std::vector<double> & weights) override;
+  void send_knn_search(const std::vector<int32_t> & point, const int32_t k, const int32_t metric, const std::vector<double> & weights);
+  void recv_knn_search(std::vector<int32_t> & _return);
   void primary_key_lookup(std::vector<int32_t> & _return, const int32_t primary_key) override;
   void send_primary_key_lookup(const int32_t primary_key);
   void recv_primary_key_lookup(std::vector<int32_t> & _return);
+  void primary_key_lookup_batch(std::vector<int32_t> & _return, const std::vector<int32_t> & primary_keys) override;
+  void send_primary_key_lookup_batch(const std::vector<int32_t> & primary_keys);
+  void recv_primary_key_lookup_batch(std::vector<int32_t> & _return);
   int32_t get_size() override;
   void send_get_size();
   int32_t recv_get_size();
+  void get_size_breakdown(std::vector<int64_t> & _return) override;
+  void send_get_size_breakdown();
+  void recv_get_size_breakdown(std::vector<int64_t> & _return);
  protected:
   std::shared_ptr< Protocol_> piprot_;
   std::shared_ptr< Protocol_> poprot_;
@@ -959,10 +1605,20 @@ class MDTrieShardProcessorT : public ::apache::thrift::TDispatchProcessorT<Proto
   void process_check(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext);
   void process_range_search(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext);
   void process_range_search(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext);
+  void process_range_search_page(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext);
+  void process_range_search_page(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext);
+  void process_range_search_aggregate(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext);
+  void process_range_search_aggregate(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext);
+  void process_knn_search(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext);
+  void process_knn_search(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext);
   void process_primary_key_lookup(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext);
   void process_primary_key_lookup(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext);
+  void process_primary_key_lookup_batch(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext);
+  void process_primary_key_lookup_batch(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext);
   void process_get_size(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext);
   void process_get_size(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext);
+  void process_get_size_breakdown(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext);
+  void process_get_size_breakdown(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext);
  public:
   MDTrieShardProcessorT(::std::shared_ptr<MDTrieShardIf> iface) :
     iface_(iface) {
@@ -981,12 +1637,27 @@ class MDTrieShardProcessorT : public ::apache::thrift::TDispatchProcessorT<Proto
     processMap_["range_search"] = ProcessFunctions(
       &MDTrieShardProcessorT::process_range_search,
       &MDTrieShardProcessorT::process_range_search);
+    processMap_["range_search_page"] = ProcessFunctions(
+      &MDTrieShardProcessorT::process_range_search_page,
+      &MDTrieShardProcessorT::process_range_search_page);
+    processMap_["range_search_aggregate"] = ProcessFunctions(
+      &MDTrieShardProcessorT::process_range_search_aggregate,
+      &MDTrieShardProcessorT::process_range_search_aggregate);
+    processMap_["knn_search"] = ProcessFunctions(
+      &MDTrieShardProcessorT::process_knn_search,
+      &MDTrieShardProcessorT::process_knn_search);
     processMap_["primary_key_lookup"] = ProcessFunctions(
       &MDTrieShardProcessorT::process_primary_key_lookup,
       &MDTrieShardProcessorT::process_primary_key_lookup);
+    processMap_["primary_key_lookup_batch"] = ProcessFunctions(
+      &MDTrieShardProcessorT::process_primary_key_lookup_batch,
+      &MDTrieShardProcessorT::process_primary_key_lookup_batch);
     processMap_["get_size"] = ProcessFunctions(
       &MDTrieShardProcessorT::process_get_size,
       &MDTrieShardProcessorT::process_get_size);
+    processMap_["get_size_breakdown"] = ProcessFunctions(
+      &MDTrieShardProcessorT::process_get_size_breakdown,
+      &MDTrieShardProcessorT::process_get_size_breakdown);
   }
 
   virtual ~MDTrieShardProcessorT() {}
@@ -1056,13 +1727,43 @@ class MDTrieShardMultiface : virtual public MDTrieShardIf {
     return ifaces_[i]->check(point);
   }
 
-  void range_search(std::vector<int32_t> & _return, const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range) override {
+  void range_search(std::vector<int32_t> & _return, const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range, const int32_t result_mode) override {
+    size_t sz = ifaces_.size();
+    size_t i = 0;
+    for (; i < (sz - 1); ++i) {
+      ifaces_[i]->range_search(_return, start_range, end_range, result_mode);
+    }
+    ifaces_[i]->range_search(_return, start_range, end_range, result_mode);
+    return;
+  }
+
+  void range_search_page(std::vector<int32_t> & _return, const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range, const std::vector<int32_t> & resume_after, const int32_t limit, const int32_t result_mode) override {
     size_t sz = ifaces_.size();
     size_t i = 0;
     for (; i < (sz - 1); ++i) {
-      ifaces_[i]->range_search(_return, start_range, end_range);
+      ifaces_[i]->range_search_page(_return, start_range, end_range, resume_after, limit, result_mode);
     }
-    ifaces_[i]->range_search(_return, start_range, end_range);
+    ifaces_[i]->range_search_page(_return, start_range, end_range, resume_after, limit, result_mode);
+    return;
+  }
+
+  void range_search_aggregate(std::vector<int64_t> & _return, const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range, const std::vector<int32_t> & dimensions) override {
+    size_t sz = ifaces_.size();
+    size_t i = 0;
+    for (; i < (sz - 1); ++i) {
+      ifaces_[i]->range_search_aggregate(_return, start_range, end_range, dimensions);
+    }
+    ifaces_[i]->range_search_aggregate(_return, start_range, end_range, dimensions);
+    return;
+  }
+
+  void knn_search(std::vector<int32_t> & _return, const std::vector<int32_t> & point, const int32_t k, const int32_t metric, const std::vector<double> & weights) override {
+    size_t sz = ifaces_.size();
+    size_t i = 0;
+    for (; i < (sz - 1); ++i) {
+      ifaces_[i]->knn_search(_return, point, k, metric, weights);
+    }
+    ifaces_[i]->knn_search(_return, point, k, metric, weights);
     return;
   }
 
@@ -1076,6 +1777,16 @@ class MDTrieShardMultiface : virtual public MDTrieShardIf {
     return;
   }
 
+  void primary_key_lookup_batch(std::vector<int32_t> & _return, const std::vector<int32_t> & primary_keys) override {
+    size_t sz = ifaces_.size();
+    size_t i = 0;
+    for (; i < (sz - 1); ++i) {
+      ifaces_[i]->primary_key_lookup_batch(_return, primary_keys);
+    }
+    ifaces_[i]->primary_key_lookup_batch(_return, primary_keys);
+    return;
+  }
+
   int32_t get_size() override {
     size_t sz = ifaces_.size();
     size_t i = 0;
@@ -1085,6 +1796,16 @@ class MDTrieShardMultiface : virtual public MDTrieShardIf {
     return ifaces_[i]->get_size();
   }
 
+  void get_size_breakdown(std::vector<int64_t> & _return) override {
+    size_t sz = ifaces_.size();
+    size_t i = 0;
+    for (; i < (sz - 1); ++i) {
+      ifaces_[i]->get_size_breakdown(_return);
+    }
+    ifaces_[i]->get_size_breakdown(_return);
+    return;
+  }
+
 };
 
 // The 'concurrent' client is a thread safe client that correctly handles
@@ -1130,15 +1851,30 @@ class MDTrieShardConcurrentClientT : virtual public MDTrieShardIf {
   bool check(const std::vector<int32_t> & point) override;
   int32_t send_check(const std::vector<int32_t> & point);
   bool recv_check(const int32_t seqid);
-  void range_search(std::vector<int32_t> & _return, const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range) override;
-  int32_t send_range_search(const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range);
+  void range_search(std::vector<int32_t> & _return, const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range, const int32_t result_mode) override;
+  int32_t send_range_search(const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range, const int32_t result_mode);
   void recv_range_search(std::vector<int32_t> & _return, const int32_t seqid);
+  void range_search_page(std::vector<int32_t> & _return, const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range, const std::vector<int32_t> & resume_after, const int32_t limit, const int32_t result_mode) override;
+  int32_t send_range_search_page(const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range, const std::vector<int32_t> & resume_after, const int32_t limit, const int32_t result_mode);
+  void recv_range_search_page(std::vector<int32_t> & _return, const int32_t seqid);
+  void range_search_aggregate(std::vector<int64_t> & _return, const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range, const std::vector<int32_t> & dimensions) override;
+  int32_t send_range_search_aggregate(const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range, const std::vector<int32_t> & dimensions);
+  void recv_range_search_aggregate(std::vector<int64_t> & _return, const int32_t seqid);
+  void knn_search(std::vector<int32_t> & _return, const std::vector<int32_t> & point, const int32_t k, const int32_t metric, const std::vector<double> & weights) override;
+  int32_t send_knn_search(const std::vector<int32_t> & point, const int32_t k, const int32_t metric, const std::vector<double> & weights);
+  void recv_knn_search(std::vector<int32_t> & _return, const int32_t seqid);
   void primary_key_lookup(std::vector<int32_t> & _return, const int32_t primary_key) override;
   int32_t send_primary_key_lookup(const int32_t primary_key);
   void recv_primary_key_lookup(std::vector<int32_t> & _return, const int32_t seqid);
+  void primary_key_lookup_batch(std::vector<int32_t> & _return, const std::vector<int32_t> & primary_keys) override;
+  int32_t send_primary_key_lookup_batch(const std::vector<int32_t> & primary_keys);
+  void recv_primary_key_lookup_batch(std::vector<int32_t> & _return, const int32_t seqid);
   int32_t get_size() override;
   int32_t send_get_size();
   int32_t recv_get_size(const int32_t seqid);
+  void get_size_breakdown(std::vector<int64_t> & _return) override;
+  int32_t send_get_size_breakdown();
+  void recv_get_size_breakdown(std::vector<int64_t> & _return, const int32_t seqid);
  protected:
   std::shared_ptr< Protocol_> piprot_;
   std::shared_ptr< Protocol_> poprot_;
@@ -898,6 +898,14 @@ uint32_t MDTrieShard_range_search_args::read(Protocol_* iprot) {
           xfer += iprot->skip(ftype);
         }
         break;
+      case 3:
+        if (ftype == ::apache::thrift::protocol::T_I32) {
+          xfer += iprot->readI32(this->result_mode);
+          this->__isset.result_mode = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
       default:
         xfer += iprot->skip(ftype);
         break;
@@ -940,6 +948,10 @@ uint32_t MDTrieShard_range_search_args::write(Protocol_* oprot) const {
   }
   xfer += oprot->writeFieldEnd();
 
+  xfer += oprot->writeFieldBegin("result_mode", ::apache::thrift::protocol::T_I32, 3);
+  xfer += oprot->writeI32(this->result_mode);
+  xfer += oprot->writeFieldEnd();
+
   xfer += oprot->writeFieldStop();
   xfer += oprot->writeStructEnd();
   return xfer;
@@ -976,6 +988,10 @@ uint32_t MDTrieShard_range_search_pargs::write(Protocol_* oprot) const {
   }
   xfer += oprot->writeFieldEnd();
 
+  xfer += oprot->writeFieldBegin("result_mode", ::apache::thrift::protocol::T_I32, 3);
+  xfer += oprot->writeI32((*(this->result_mode)));
+  xfer += oprot->writeFieldEnd();
+
   xfer += oprot->writeFieldStop();
   xfer += oprot->writeStructEnd();
   return xfer;
@@ -1118,7 +1134,7 @@ uint32_t MDTrieShard_range_search_presult::read(Protocol_* iprot) {
 
 
 template <class Protocol_>
-uint32_t MDTrieShard_primary_key_lookup_args::read(Protocol_* iprot) {
+uint32_t MDTrieShard_range_search_page_args::read(Protocol_* iprot) {
 
   ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
   uint32_t xfer = 0;
@@ -1140,9 +1156,77 @@ uint32_t MDTrieShard_primary_key_lookup_args::read(Protocol_* iprot) {
     switch (fid)
     {
       case 1:
+        if (ftype == ::apache::thrift::protocol::T_LIST) {
+          {
+            this->start_range.clear();
+            uint32_t _size46;
+            ::apache::thrift::protocol::TType _etype49;
+            xfer += iprot->readListBegin(_etype49, _size46);
+            this->start_range.resize(_size46);
+            uint32_t _i50;
+            for (_i50 = 0; _i50 < _size46; ++_i50)
+            {
+              xfer += iprot->readI32(this->start_range[_i50]);
+            }
+            xfer += iprot->readListEnd();
+          }
+          this->__isset.start_range = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      case 2:
+        if (ftype == ::apache::thrift::protocol::T_LIST) {
+          {
+            this->end_range.clear();
+            uint32_t _size51;
+            ::apache::thrift::protocol::TType _etype54;
+            xfer += iprot->readListBegin(_etype54, _size51);
+            this->end_range.resize(_size51);
+            uint32_t _i55;
+            for (_i55 = 0; _i55 < _size51; ++_i55)
+            {
+              xfer += iprot->readI32(this->end_range[_i55]);
+            }
+            xfer += iprot->readListEnd();
+          }
+          this->__isset.end_range = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      case 3:
+        if (ftype == ::apache::thrift::protocol::T_LIST) {
+          {
+            this->resume_after.clear();
+            uint32_t _size56;
+            ::apache::thrift::protocol::TType _etype59;
+            xfer += iprot->readListBegin(_etype59, _size56);
+            this->resume_after.resize(_size56);
+            uint32_t _i60;
+            for (_i60 = 0; _i60 < _size56; ++_i60)
+            {
+              xfer += iprot->readI32(this->resume_after[_i60]);
+            }
+            xfer += iprot->readListEnd();
+          }
+          this->__isset.resume_after = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      case 4:
         if (ftype == ::apache::thrift::protocol::T_I32) {
-          xfer += iprot->readI32(this->primary_key);
-          this->__isset.primary_key = true;
+          xfer += iprot->readI32(this->limit);
+          this->__isset.limit = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      case 5:
+        if (ftype == ::apache::thrift::protocol::T_I32) {
+          xfer += iprot->readI32(this->result_mode);
+          this->__isset.result_mode = true;
         } else {
           xfer += iprot->skip(ftype);
         }
@@ -1160,13 +1244,53 @@ uint32_t MDTrieShard_primary_key_lookup_args::read(Protocol_* iprot) {
 }
 
 template <class Protocol_>
-uint32_t MDTrieShard_primary_key_lookup_args::write(Protocol_* oprot) const {
+uint32_t MDTrieShard_range_search_page_args::write(Protocol_* oprot) const {
   uint32_t xfer = 0;
   ::apache::thrift::protocol::TOutputRecursionTracker tracker(*oprot);
-  xfer += oprot->writeStructBegin("MDTrieShard_primary_key_lookup_args");
+  xfer += oprot->writeStructBegin("MDTrieShard_range_search_page_args");
 
-  xfer += oprot->writeFieldBegin("primary_key", ::apache::thrift::protocol::T_I32, 1);
-  xfer += oprot->writeI32(this->primary_key);
+  xfer += oprot->writeFieldBegin("start_range", ::apache::thrift::protocol::T_LIST, 1);
+  {
+    xfer += oprot->writeListBegin(::apache::thrift::protocol::T_I32, static_cast<uint32_t>(this->start_range.size()));
+    std::vector<int32_t> ::const_iterator _iter56;
+    for (_iter56 = this->start_range.begin(); _iter56 != this->start_range.end(); ++_iter56)
+    {
+      xfer += oprot->writeI32((*_iter56));
+    }
+    xfer += oprot->writeListEnd();
+  }
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldBegin("end_range", ::apache::thrift::protocol::T_LIST, 2);
+  {
+    xfer += oprot->writeListBegin(::apache::thrift::protocol::T_I32, static_cast<uint32_t>(this->end_range.size()));
+    std::vector<int32_t> ::const_iterator _iter57;
+    for (_iter57 = this->end_range.begin(); _iter57 != this->end_range.end(); ++_iter57)
+    {
+      xfer += oprot->writeI32((*_iter57));
+    }
+    xfer += oprot->writeListEnd();
+  }
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldBegin("resume_after", ::apache::thrift::protocol::T_LIST, 3);
+  {
+    xfer += oprot->writeListBegin(::apache::thrift::protocol::T_I32, static_cast<uint32_t>(this->resume_after.size()));
+    std::vector<int32_t> ::const_iterator _iter61;
+    for (_iter61 = this->resume_after.begin(); _iter61 != this->resume_after.end(); ++_iter61)
+    {
+      xfer += oprot->writeI32((*_iter61));
+    }
+    xfer += oprot->writeListEnd();
+  }
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldBegin("limit", ::apache::thrift::protocol::T_I32, 4);
+  xfer += oprot->writeI32(this->limit);
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldBegin("result_mode", ::apache::thrift::protocol::T_I32, 5);
+  xfer += oprot->writeI32(this->result_mode);
   xfer += oprot->writeFieldEnd();
 
   xfer += oprot->writeFieldStop();
@@ -1176,13 +1300,53 @@ uint32_t MDTrieShard_primary_key_lookup_args::write(Protocol_* oprot) const {
 
 
 template <class Protocol_>
-uint32_t MDTrieShard_primary_key_lookup_pargs::write(Protocol_* oprot) const {
+uint32_t MDTrieShard_range_search_page_pargs::write(Protocol_* oprot) const {
   uint32_t xfer = 0;
   ::apache::thrift::protocol::TOutputRecursionTracker tracker(*oprot);
-  xfer += oprot->writeStructBegin("MDTrieShard_primary_key_lookup_pargs");
+  xfer += oprot->writeStructBegin("MDTrieShard_range_search_page_pargs");
 
-  xfer += oprot->writeFieldBegin("primary_key", ::apache::thrift::protocol::T_I32, 1);
-  xfer += oprot->writeI32((*(this->primary_key)));
+  xfer += oprot->writeFieldBegin("start_range", ::apache::thrift::protocol::T_LIST, 1);
+  {
+    xfer += oprot->writeListBegin(::apache::thrift::protocol::T_I32, static_cast<uint32_t>((*(this->start_range)).size()));
+    std::vector<int32_t> ::const_iterator _iter58;
+    for (_iter58 = (*(this->start_range)).begin(); _iter58 != (*(this->start_range)).end(); ++_iter58)
+    {
+      xfer += oprot->writeI32((*_iter58));
+    }
+    xfer += oprot->writeListEnd();
+  }
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldBegin("end_range", ::apache::thrift::protocol::T_LIST, 2);
+  {
+    xfer += oprot->writeListBegin(::apache::thrift::protocol::T_I32, static_cast<uint32_t>((*(this->end_range)).size()));
+    std::vector<int32_t> ::const_iterator _iter59;
+    for (_iter59 = (*(this->end_range)).begin(); _iter59 != (*(this->end_range)).end(); ++_iter59)
+    {
+      xfer += oprot->writeI32((*_iter59));
+    }
+    xfer += oprot->writeListEnd();
+  }
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldBegin("resume_after", ::apache::thrift::protocol::T_LIST, 3);
+  {
+    xfer += oprot->writeListBegin(::apache::thrift::protocol::T_I32, static_cast<uint32_t>((*(this->resume_after)).size()));
+    std::vector<int32_t> ::const_iterator _iter62;
+    for (_iter62 = (*(this->resume_after)).begin(); _iter62 != (*(this->resume_after)).end(); ++_iter62)
+    {
+      xfer += oprot->writeI32((*_iter62));
+    }
+    xfer += oprot->writeListEnd();
+  }
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldBegin("limit", ::apache::thrift::protocol::T_I32, 4);
+  xfer += oprot->writeI32((*(this->limit)));
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldBegin("result_mode", ::apache::thrift::protocol::T_I32, 5);
+  xfer += oprot->writeI32((*(this->result_mode)));
   xfer += oprot->writeFieldEnd();
 
   xfer += oprot->writeFieldStop();
@@ -1192,7 +1356,7 @@ uint32_t MDTrieShard_primary_key_lookup_pargs::write(Protocol_* oprot) const {
 
 
 template <class Protocol_>
-uint32_t MDTrieShard_primary_key_lookup_result::read(Protocol_* iprot) {
+uint32_t MDTrieShard_range_search_page_result::read(Protocol_* iprot) {
 
   ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
   uint32_t xfer = 0;
@@ -1217,14 +1381,14 @@ uint32_t MDTrieShard_primary_key_lookup_result::read(Protocol_* iprot) {
         if (ftype == ::apache::thrift::protocol::T_LIST) {
           {
             this->success.clear();
-            uint32_t _size46;
-            ::apache::thrift::protocol::TType _etype49;
-            xfer += iprot->readListBegin(_etype49, _size46);
-            this->success.resize(_size46);
-            uint32_t _i50;
-            for (_i50 = 0; _i50 < _size46; ++_i50)
+            uint32_t _size60;
+            ::apache::thrift::protocol::TType _etype63;
+            xfer += iprot->readListBegin(_etype63, _size60);
+            this->success.resize(_size60);
+            uint32_t _i64;
+            for (_i64 = 0; _i64 < _size60; ++_i64)
             {
-              xfer += iprot->readI32(this->success[_i50]);
+              xfer += iprot->readI32(this->success[_i64]);
             }
             xfer += iprot->readListEnd();
           }
@@ -1246,20 +1410,20 @@ uint32_t MDTrieShard_primary_key_lookup_result::read(Protocol_* iprot) {
 }
 
 template <class Protocol_>
-uint32_t MDTrieShard_primary_key_lookup_result::write(Protocol_* oprot) const {
+uint32_t MDTrieShard_range_search_page_result::write(Protocol_* oprot) const {
 
   uint32_t xfer = 0;
 
-  xfer += oprot->writeStructBegin("MDTrieShard_primary_key_lookup_result");
+  xfer += oprot->writeStructBegin("MDTrieShard_range_search_page_result");
 
   if (this->__isset.success) {
     xfer += oprot->writeFieldBegin("success", ::apache::thrift::protocol::T_LIST, 0);
     {
       xfer += oprot->writeListBegin(::apache::thrift::protocol::T_I32, static_cast<uint32_t>(this->success.size()));
-      std::vector<int32_t> ::const_iterator _iter51;
-      for (_iter51 = this->success.begin(); _iter51 != this->success.end(); ++_iter51)
+      std::vector<int32_t> ::const_iterator _iter65;
+      for (_iter65 = this->success.begin(); _iter65 != this->success.end(); ++_iter65)
       {
-        xfer += oprot->writeI32((*_iter51));
+        xfer += oprot->writeI32((*_iter65));
       }
       xfer += oprot->writeListEnd();
     }
@@ -1272,7 +1436,7 @@ uint32_t MDTrieShard_primary_key_lookup_result::write(Protocol_* oprot) const {
 
 
 template <class Protocol_>
-uint32_t MDTrieShard_primary_key_lookup_presult::read(Protocol_* iprot) {
+uint32_t MDTrieShard_range_search_page_presult::read(Protocol_* iprot) {
 
   ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
   uint32_t xfer = 0;
@@ -1297,14 +1461,14 @@ uint32_t MDTrieShard_primary_key_lookup_presult::read(Protocol_* iprot) {
         if (ftype == ::apache::thrift::protocol::T_LIST) {
           {
             (*(this->success)).clear();
-            uint32_t _size52;
-            ::apache::thrift::protocol::TType _etype55;
-            xfer += iprot->readListBegin(_etype55, _size52);
-            (*(this->success)).resize(_size52);
-            uint32_t _i56;
-            for (_i56 = 0; _i56 < _size52; ++_i56)
+            uint32_t _size66;
+            ::apache::thrift::protocol::TType _etype69;
+            xfer += iprot->readListBegin(_etype69, _size66);
+            (*(this->success)).resize(_size66);
+            uint32_t _i70;
+            for (_i70 = 0; _i70 < _size66; ++_i70)
             {
-              xfer += iprot->readI32((*(this->success))[_i56]);
+              xfer += iprot->readI32((*(this->success))[_i70]);
             }
             xfer += iprot->readListEnd();
           }
@@ -1327,7 +1491,7 @@ uint32_t MDTrieShard_primary_key_lookup_presult::read(Protocol_* iprot) {
 
 
 template <class Protocol_>
-uint32_t MDTrieShard_get_size_args::read(Protocol_* iprot) {
+uint32_t MDTrieShard_range_search_aggregate_args::read(Protocol_* iprot) {
 
   ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
   uint32_t xfer = 0;
@@ -1346,7 +1510,72 @@ uint32_t MDTrieShard_get_size_args::read(Protocol_* iprot) {
     if (ftype == ::apache::thrift::protocol::T_STOP) {
       break;
     }
-    xfer += iprot->skip(ftype);
+    switch (fid)
+    {
+      case 1:
+        if (ftype == ::apache::thrift::protocol::T_LIST) {
+          {
+            this->start_range.clear();
+            uint32_t _size71;
+            ::apache::thrift::protocol::TType _etype74;
+            xfer += iprot->readListBegin(_etype74, _size71);
+            this->start_range.resize(_size71);
+            uint32_t _i75;
+            for (_i75 = 0; _i75 < _size71; ++_i75)
+            {
+              xfer += iprot->readI32(this->start_range[_i75]);
+            }
+            xfer += iprot->readListEnd();
+          }
+          this->__isset.start_range = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      case 2:
+        if (ftype == ::apache::thrift::protocol::T_LIST) {
+          {
+            this->end_range.clear();
+            uint32_t _size76;
+            ::apache::thrift::protocol::TType _etype79;
+            xfer += iprot->readListBegin(_etype79, _size76);
+            this->end_range.resize(_size76);
+            uint32_t _i80;
+            for (_i80 = 0; _i80 < _size76; ++_i80)
+            {
+              xfer += iprot->readI32(this->end_range[_i80]);
+            }
+            xfer += iprot->readListEnd();
+          }
+          this->__isset.end_range = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      case 3:
+        if (ftype == ::apache::thrift::protocol::T_LIST) {
+          {
+            this->dimensions.clear();
+            uint32_t _size81;
+            ::apache::thrift::protocol::TType _etype84;
+            xfer += iprot->readListBegin(_etype84, _size81);
+            this->dimensions.resize(_size81);
+            uint32_t _i85;
+            for (_i85 = 0; _i85 < _size81; ++_i85)
+            {
+              xfer += iprot->readI32(this->dimensions[_i85]);
+            }
+            xfer += iprot->readListEnd();
+          }
+          this->__isset.dimensions = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      default:
+        xfer += iprot->skip(ftype);
+        break;
+    }
     xfer += iprot->readFieldEnd();
   }
 
@@ -1356,10 +1585,46 @@ uint32_t MDTrieShard_get_size_args::read(Protocol_* iprot) {
 }
 
 template <class Protocol_>
-uint32_t MDTrieShard_get_size_args::write(Protocol_* oprot) const {
+uint32_t MDTrieShard_range_search_aggregate_args::write(Protocol_* oprot) const {
   uint32_t xfer = 0;
   ::apache::thrift::protocol::TOutputRecursionTracker tracker(*oprot);
-  xfer += oprot->writeStructBegin("MDTrieShard_get_size_args");
+  xfer += oprot->writeStructBegin("MDTrieShard_range_search_aggregate_args");
+
+  xfer += oprot->writeFieldBegin("start_range", ::apache::thrift::protocol::T_LIST, 1);
+  {
+    xfer += oprot->writeListBegin(::apache::thrift::protocol::T_I32, static_cast<uint32_t>(this->start_range.size()));
+    std::vector<int32_t> ::const_iterator _iter86;
+    for (_iter86 = this->start_range.begin(); _iter86 != this->start_range.end(); ++_iter86)
+    {
+      xfer += oprot->writeI32((*_iter86));
+    }
+    xfer += oprot->writeListEnd();
+  }
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldBegin("end_range", ::apache::thrift::protocol::T_LIST, 2);
+  {
+    xfer += oprot->writeListBegin(::apache::thrift::protocol::T_I32, static_cast<uint32_t>(this->end_range.size()));
+    std::vector<int32_t> ::const_iterator _iter87;
+    for (_iter87 = this->end_range.begin(); _iter87 != this->end_range.end(); ++_iter87)
+    {
+      xfer += oprot->writeI32((*_iter87));
+    }
+    xfer += oprot->writeListEnd();
+  }
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldBegin("dimensions", ::apache::thrift::protocol::T_LIST, 3);
+  {
+    xfer += oprot->writeListBegin(::apache::thrift::protocol::T_I32, static_cast<uint32_t>(this->dimensions.size()));
+    std::vector<int32_t> ::const_iterator _iter88;
+    for (_iter88 = this->dimensions.begin(); _iter88 != this->dimensions.end(); ++_iter88)
+    {
+      xfer += oprot->writeI32((*_iter88));
+    }
+    xfer += oprot->writeListEnd();
+  }
+  xfer += oprot->writeFieldEnd();
 
   xfer += oprot->writeFieldStop();
   xfer += oprot->writeStructEnd();
@@ -1368,10 +1633,46 @@ uint32_t MDTrieShard_get_size_args::write(Protocol_* oprot) const {
 
 
 template <class Protocol_>
-uint32_t MDTrieShard_get_size_pargs::write(Protocol_* oprot) const {
+uint32_t MDTrieShard_range_search_aggregate_pargs::write(Protocol_* oprot) const {
   uint32_t xfer = 0;
   ::apache::thrift::protocol::TOutputRecursionTracker tracker(*oprot);
-  xfer += oprot->writeStructBegin("MDTrieShard_get_size_pargs");
+  xfer += oprot->writeStructBegin("MDTrieShard_range_search_aggregate_pargs");
+
+  xfer += oprot->writeFieldBegin("start_range", ::apache::thrift::protocol::T_LIST, 1);
+  {
+    xfer += oprot->writeListBegin(::apache::thrift::protocol::T_I32, static_cast<uint32_t>((*(this->start_range)).size()));
+    std::vector<int32_t> ::const_iterator _iter89;
+    for (_iter89 = (*(this->start_range)).begin(); _iter89 != (*(this->start_range)).end(); ++_iter89)
+    {
+      xfer += oprot->writeI32((*_iter89));
+    }
+    xfer += oprot->writeListEnd();
+  }
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldBegin("end_range", ::apache::thrift::protocol::T_LIST, 2);
+  {
+    xfer += oprot->writeListBegin(::apache::thrift::protocol::T_I32, static_cast<uint32_t>((*(this->end_range)).size()));
+    std::vector<int32_t> ::const_iterator _iter90;
+    for (_iter90 = (*(this->end_range)).begin(); _iter90 != (*(this->end_range)).end(); ++_iter90)
+    {
+      xfer += oprot->writeI32((*_iter90));
+    }
+    xfer += oprot->writeListEnd();
+  }
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldBegin("dimensions", ::apache::thrift::protocol::T_LIST, 3);
+  {
+    xfer += oprot->writeListBegin(::apache::thrift::protocol::T_I32, static_cast<uint32_t>((*(this->dimensions)).size()));
+    std::vector<int32_t> ::const_iterator _iter91;
+    for (_iter91 = (*(this->dimensions)).begin(); _iter91 != (*(this->dimensions)).end(); ++_iter91)
+    {
+      xfer += oprot->writeI32((*_iter91));
+    }
+    xfer += oprot->writeListEnd();
+  }
+  xfer += oprot->writeFieldEnd();
 
   xfer += oprot->writeFieldStop();
   xfer += oprot->writeStructEnd();
@@ -1380,7 +1681,7 @@ uint32_t MDTrieShard_get_size_pargs::write(Protocol_* oprot) const {
 
 
 template <class Protocol_>
-uint32_t MDTrieShard_get_size_result::read(Protocol_* iprot) {
+uint32_t MDTrieShard_range_search_aggregate_result::read(Protocol_* iprot) {
 
   ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
   uint32_t xfer = 0;
@@ -1402,8 +1703,20 @@ uint32_t MDTrieShard_get_size_result::read(Protocol_* iprot) {
     switch (fid)
     {
       case 0:
-        if (ftype == ::apache::thrift::protocol::T_I32) {
-          xfer += iprot->readI32(this->success);
+        if (ftype == ::apache::thrift::protocol::T_LIST) {
+          {
+            this->success.clear();
+            uint32_t _size92;
+            ::apache::thrift::protocol::TType _etype95;
+            xfer += iprot->readListBegin(_etype95, _size92);
+            this->success.resize(_size92);
+            uint32_t _i96;
+            for (_i96 = 0; _i96 < _size92; ++_i96)
+            {
+              xfer += iprot->readI64(this->success[_i96]);
+            }
+            xfer += iprot->readListEnd();
+          }
           this->__isset.success = true;
         } else {
           xfer += iprot->skip(ftype);
@@ -1422,15 +1735,23 @@ uint32_t MDTrieShard_get_size_result::read(Protocol_* iprot) {
 }
 
 template <class Protocol_>
-uint32_t MDTrieShard_get_size_result::write(Protocol_* oprot) const {
+uint32_t MDTrieShard_range_search_aggregate_result::write(Protocol_* oprot) const {
 
   uint32_t xfer = 0;
 
-  xfer += oprot->writeStructBegin("MDTrieShard_get_size_result");
+  xfer += oprot->writeStructBegin("MDTrieShard_range_search_aggregate_result");
 
   if (this->__isset.success) {
-    xfer += oprot->writeFieldBegin("success", ::apache::thrift::protocol::T_I32, 0);
-    xfer += oprot->writeI32(this->success);
+    xfer += oprot->writeFieldBegin("success", ::apache::thrift::protocol::T_LIST, 0);
+    {
+      xfer += oprot->writeListBegin(::apache::thrift::protocol::T_I64, static_cast<uint32_t>(this->success.size()));
+      std::vector<int64_t> ::const_iterator _iter97;
+      for (_iter97 = this->success.begin(); _iter97 != this->success.end(); ++_iter97)
+      {
+        xfer += oprot->writeI64((*_iter97));
+      }
+      xfer += oprot->writeListEnd();
+    }
     xfer += oprot->writeFieldEnd();
   }
   xfer += oprot->writeFieldStop();
@@ -1440,7 +1761,7 @@ uint32_t MDTrieShard_get_size_result::write(Protocol_* oprot) const {
 
 
 template <class Protocol_>
-uint32_t MDTrieShard_get_size_presult::read(Protocol_* iprot) {
+uint32_t MDTrieShard_range_search_aggregate_presult::read(Protocol_* iprot) {
 
   ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
   uint32_t xfer = 0;
@@ -1462,8 +1783,20 @@ uint32_t MDTrieShard_get_size_presult::read(Protocol_* iprot) {
     switch (fid)
     {
       case 0:
-        if (ftype == ::apache::thrift::protocol::T_I32) {
-          xfer += iprot->readI32((*(this->success)));
+        if (ftype == ::apache::thrift::protocol::T_LIST) {
+          {
+            (*(this->success)).clear();
+            uint32_t _size98;
+            ::apache::thrift::protocol::TType _etype101;
+            xfer += iprot->readListBegin(_etype101, _size98);
+            (*(this->success)).resize(_size98);
+            uint32_t _i102;
+            for (_i102 = 0; _i102 < _size98; ++_i102)
+            {
+              xfer += iprot->readI64((*(this->success))[_i102]);
+            }
+            xfer += iprot->readListEnd();
+          }
           this->__isset.success = true;
         } else {
           xfer += iprot->skip(ftype);
@@ -1481,403 +1814,1820 @@ uint32_t MDTrieShard_get_size_presult::read(Protocol_* iprot) {
   return xfer;
 }
 
-template <class Protocol_>
-bool MDTrieShardClientT<Protocol_>::ping(const int32_t dataset_idx)
-{
-  send_ping(dataset_idx);
-  return recv_ping();
-}
 
 template <class Protocol_>
-void MDTrieShardClientT<Protocol_>::send_ping(const int32_t dataset_idx)
-{
-  int32_t cseqid = 0;
-  this->oprot_->writeMessageBegin("ping", ::apache::thrift::protocol::T_CALL, cseqid);
+uint32_t MDTrieShard_knn_search_args::read(Protocol_* iprot) {
 
-  MDTrieShard_ping_pargs args;
-  args.dataset_idx = &dataset_idx;
-  args.write(this->oprot_);
+  ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
+  uint32_t xfer = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TType ftype;
+  int16_t fid;
 
-  this->oprot_->writeMessageEnd();
-  this->oprot_->getTransport()->writeEnd();
-  this->oprot_->getTransport()->flush();
-}
+  xfer += iprot->readStructBegin(fname);
 
-template <class Protocol_>
-bool MDTrieShardClientT<Protocol_>::recv_ping()
-{
+  using ::apache::thrift::protocol::TProtocolException;
 
-  int32_t rseqid = 0;
-  std::string fname;
-  ::apache::thrift::protocol::TMessageType mtype;
 
-  this->iprot_->readMessageBegin(fname, mtype, rseqid);
-  if (mtype == ::apache::thrift::protocol::T_EXCEPTION) {
-    ::apache::thrift::TApplicationException x;
-    x.read(this->iprot_);
-    this->iprot_->readMessageEnd();
-    this->iprot_->getTransport()->readEnd();
-    throw x;
-  }
-  if (mtype != ::apache::thrift::protocol::T_REPLY) {
-    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
-    this->iprot_->readMessageEnd();
-    this->iprot_->getTransport()->readEnd();
-  }
-  if (fname.compare("ping") != 0) {
-    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
-    this->iprot_->readMessageEnd();
-    this->iprot_->getTransport()->readEnd();
+  while (true)
+  {
+    xfer += iprot->readFieldBegin(fname, ftype, fid);
+    if (ftype == ::apache::thrift::protocol::T_STOP) {
+      break;
+    }
+    switch (fid)
+    {
+      case 1:
+        if (ftype == ::apache::thrift::protocol::T_LIST) {
+          {
+            this->point.clear();
+            uint32_t _size103;
+            ::apache::thrift::protocol::TType _etype106;
+            xfer += iprot->readListBegin(_etype106, _size103);
+            this->point.resize(_size103);
+            uint32_t _i107;
+            for (_i107 = 0; _i107 < _size103; ++_i107)
+            {
+              xfer += iprot->readI32(this->point[_i107]);
+            }
+            xfer += iprot->readListEnd();
+          }
+          this->__isset.point = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      case 2:
+        if (ftype == ::apache::thrift::protocol::T_I32) {
+          xfer += iprot->readI32(this->k);
+          this->__isset.k = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      case 3:
+        if (ftype == ::apache::thrift::protocol::T_I32) {
+          xfer += iprot->readI32(this->metric);
+          this->__isset.metric = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      case 4:
+        if (ftype == ::apache::thrift::protocol::T_LIST) {
+          {
+            this->weights.clear();
+            uint32_t _size108;
+            ::apache::thrift::protocol::TType _etype111;
+            xfer += iprot->readListBegin(_etype111, _size108);
+            this->weights.resize(_size108);
+            uint32_t _i112;
+            for (_i112 = 0; _i112 < _size108; ++_i112)
+            {
+              xfer += iprot->readDouble(this->weights[_i112]);
+            }
+            xfer += iprot->readListEnd();
+          }
+          this->__isset.weights = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      default:
+        xfer += iprot->skip(ftype);
+        break;
+    }
+    xfer += iprot->readFieldEnd();
   }
-  bool _return;
-  MDTrieShard_ping_presult result;
-  result.success = &_return;
-  result.read(this->iprot_);
-  this->iprot_->readMessageEnd();
-  this->iprot_->getTransport()->readEnd();
 
-  if (result.__isset.success) {
-    return _return;
-  }
-  throw ::apache::thrift::TApplicationException(::apache::thrift::TApplicationException::MISSING_RESULT, "ping failed: unknown result");
-}
+  xfer += iprot->readStructEnd();
 
-template <class Protocol_>
-int32_t MDTrieShardClientT<Protocol_>::insert(const std::vector<int32_t> & point, const int32_t primary_key)
-{
-  send_insert(point, primary_key);
-  return recv_insert();
+  return xfer;
 }
 
 template <class Protocol_>
-void MDTrieShardClientT<Protocol_>::send_insert(const std::vector<int32_t> & point, const int32_t primary_key)
-{
-  int32_t cseqid = 0;
-  this->oprot_->writeMessageBegin("insert", ::apache::thrift::protocol::T_CALL, cseqid);
-
-  MDTrieShard_insert_pargs args;
-  args.point = &point;
-  args.primary_key = &primary_key;
-  args.write(this->oprot_);
+uint32_t MDTrieShard_knn_search_args::write(Protocol_* oprot) const {
+  uint32_t xfer = 0;
+  ::apache::thrift::protocol::TOutputRecursionTracker tracker(*oprot);
+  xfer += oprot->writeStructBegin("MDTrieShard_knn_search_args");
 
-  this->oprot_->writeMessageEnd();
-  this->oprot_->getTransport()->writeEnd();
-  this->oprot_->getTransport()->flush();
-}
+  xfer += oprot->writeFieldBegin("point", ::apache::thrift::protocol::T_LIST, 1);
+  {
+    xfer += oprot->writeListBegin(::apache::thrift::protocol::T_I32, static_cast<uint32_t>(this->point.size()));
+    std::vector<int32_t> ::const_iterator _iter113;
+    for (_iter113 = this->point.begin(); _iter113 != this->point.end(); ++_iter113)
+    {
+      xfer += oprot->writeI32((*_iter113));
+    }
+    xfer += oprot->writeListEnd();
+  }
+  xfer += oprot->writeFieldEnd();
 
-template <class Protocol_>
-int32_t MDTrieShardClientT<Protocol_>::recv_insert()
-{
+  xfer += oprot->writeFieldBegin("k", ::apache::thrift::protocol::T_I32, 2);
+  xfer += oprot->writeI32(this->k);
+  xfer += oprot->writeFieldEnd();
 
-  int32_t rseqid = 0;
-  std::string fname;
-  ::apache::thrift::protocol::TMessageType mtype;
+  xfer += oprot->writeFieldBegin("metric", ::apache::thrift::protocol::T_I32, 3);
+  xfer += oprot->writeI32(this->metric);
+  xfer += oprot->writeFieldEnd();
 
-  this->iprot_->readMessageBegin(fname, mtype, rseqid);
-  if (mtype == ::apache::thrift::protocol::T_EXCEPTION) {
-    ::apache::thrift::TApplicationException x;
-    x.read(this->iprot_);
-    this->iprot_->readMessageEnd();
-    this->iprot_->getTransport()->readEnd();
-    throw x;
-  }
-  if (mtype != ::apache::thrift::protocol::T_REPLY) {
-    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
-    this->iprot_->readMessageEnd();
-    this->iprot_->getTransport()->readEnd();
-  }
-  if (fname.compare("insert") != 0) {
-    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
-    this->iprot_->readMessageEnd();
-    this->iprot_->getTransport()->readEnd();
+  xfer += oprot->writeFieldBegin("weights", ::apache::thrift::protocol::T_LIST, 4);
+  {
+    xfer += oprot->writeListBegin(::apache::thrift::protocol::T_DOUBLE, static_cast<uint32_t>(this->weights.size()));
+    std::vector<double> ::const_iterator _iter114;
+    for (_iter114 = this->weights.begin(); _iter114 != this->weights.end(); ++_iter114)
+    {
+      xfer += oprot->writeDouble((*_iter114));
+    }
+    xfer += oprot->writeListEnd();
   }
-  int32_t _return;
-  MDTrieShard_insert_presult result;
-  result.success = &_return;
-  result.read(this->iprot_);
-  this->iprot_->readMessageEnd();
-  this->iprot_->getTransport()->readEnd();
+  xfer += oprot->writeFieldEnd();
 
-  if (result.__isset.success) {
-    return _return;
-  }
-  throw ::apache::thrift::TApplicationException(::apache::thrift::TApplicationException::MISSING_RESULT, "insert failed: unknown result");
+  xfer += oprot->writeFieldStop();
+  xfer += oprot->writeStructEnd();
+  return xfer;
 }
 
-template <class Protocol_>
-int32_t MDTrieShardClientT<Protocol_>::insert_for_latency(const std::vector<int32_t> & point, const int32_t primary_key)
-{
-  send_insert_for_latency(point, primary_key);
-  return recv_insert_for_latency();
-}
 
 template <class Protocol_>
-void MDTrieShardClientT<Protocol_>::send_insert_for_latency(const std::vector<int32_t> & point, const int32_t primary_key)
-{
-  int32_t cseqid = 0;
-  this->oprot_->writeMessageBegin("insert_for_latency", ::apache::thrift::protocol::T_CALL, cseqid);
-
-  MDTrieShard_insert_for_latency_pargs args;
-  args.point = &point;
-  args.primary_key = &primary_key;
-  args.write(this->oprot_);
+uint32_t MDTrieShard_knn_search_pargs::write(Protocol_* oprot) const {
+  uint32_t xfer = 0;
+  ::apache::thrift::protocol::TOutputRecursionTracker tracker(*oprot);
+  xfer += oprot->writeStructBegin("MDTrieShard_knn_search_pargs");
 
-  this->oprot_->writeMessageEnd();
-  this->oprot_->getTransport()->writeEnd();
-  this->oprot_->getTransport()->flush();
-}
+  xfer += oprot->writeFieldBegin("point", ::apache::thrift::protocol::T_LIST, 1);
+  {
+    xfer += oprot->writeListBegin(::apache::thrift::protocol::T_I32, static_cast<uint32_t>((*(this->point)).size()));
+    std::vector<int32_t> ::const_iterator _iter115;
+    for (_iter115 = (*(this->point)).begin(); _iter115 != (*(this->point)).end(); ++_iter115)
+    {
+      xfer += oprot->writeI32((*_iter115));
+    }
+    xfer += oprot->writeListEnd();
+  }
+  xfer += oprot->writeFieldEnd();
 
-template <class Protocol_>
-int32_t MDTrieShardClientT<Protocol_>::recv_insert_for_latency()
-{
+  xfer += oprot->writeFieldBegin("k", ::apache::thrift::protocol::T_I32, 2);
+  xfer += oprot->writeI32((*(this->k)));
+  xfer += oprot->writeFieldEnd();
 
-  int32_t rseqid = 0;
-  std::string fname;
-  ::apache::thrift::protocol::TMessageType mtype;
+  xfer += oprot->writeFieldBegin("metric", ::apache::thrift::protocol::T_I32, 3);
+  xfer += oprot->writeI32((*(this->metric)));
+  xfer += oprot->writeFieldEnd();
 
-  this->iprot_->readMessageBegin(fname, mtype, rseqid);
-  if (mtype == ::apache::thrift::protocol::T_EXCEPTION) {
-    ::apache::thrift::TApplicationException x;
-    x.read(this->iprot_);
-    this->iprot_->readMessageEnd();
-    this->iprot_->getTransport()->readEnd();
-    throw x;
-  }
-  if (mtype != ::apache::thrift::protocol::T_REPLY) {
-    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
-    this->iprot_->readMessageEnd();
-    this->iprot_->getTransport()->readEnd();
-  }
-  if (fname.compare("insert_for_latency") != 0) {
-    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
-    this->iprot_->readMessageEnd();
-    this->iprot_->getTransport()->readEnd();
+  xfer += oprot->writeFieldBegin("weights", ::apache::thrift::protocol::T_LIST, 4);
+  {
+    xfer += oprot->writeListBegin(::apache::thrift::protocol::T_DOUBLE, static_cast<uint32_t>((*(this->weights)).size()));
+    std::vector<double> ::const_iterator _iter116;
+    for (_iter116 = (*(this->weights)).begin(); _iter116 != (*(this->weights)).end(); ++_iter116)
+    {
+      xfer += oprot->writeDouble((*_iter116));
+    }
+    xfer += oprot->writeListEnd();
   }
-  int32_t _return;
-  MDTrieShard_insert_for_latency_presult result;
-  result.success = &_return;
-  result.read(this->iprot_);
-  this->iprot_->readMessageEnd();
-  this->iprot_->getTransport()->readEnd();
+  xfer += oprot->writeFieldEnd();
 
-  if (result.__isset.success) {
-    return _return;
-  }
-  throw ::apache::thrift::TApplicationException(::apache::thrift::TApplicationException::MISSING_RESULT, "insert_for_latency failed: unknown result");
+  xfer += oprot->writeFieldStop();
+  xfer += oprot->writeStructEnd();
+  return xfer;
 }
 
-template <class Protocol_>
-bool MDTrieShardClientT<Protocol_>::check(const std::vector<int32_t> & point)
-{
-  send_check(point);
-  return recv_check();
-}
 
 template <class Protocol_>
-void MDTrieShardClientT<Protocol_>::send_check(const std::vector<int32_t> & point)
-{
-  int32_t cseqid = 0;
-  this->oprot_->writeMessageBegin("check", ::apache::thrift::protocol::T_CALL, cseqid);
-
-  MDTrieShard_check_pargs args;
-  args.point = &point;
-  args.write(this->oprot_);
-
-  this->oprot_->writeMessageEnd();
-  this->oprot_->getTransport()->writeEnd();
-  this->oprot_->getTransport()->flush();
-}
-
-template <class Protocol_>
-bool MDTrieShardClientT<Protocol_>::recv_check()
-{
+uint32_t MDTrieShard_knn_search_result::read(Protocol_* iprot) {
 
-  int32_t rseqid = 0;
+  ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
+  uint32_t xfer = 0;
   std::string fname;
-  ::apache::thrift::protocol::TMessageType mtype;
+  ::apache::thrift::protocol::TType ftype;
+  int16_t fid;
 
-  this->iprot_->readMessageBegin(fname, mtype, rseqid);
-  if (mtype == ::apache::thrift::protocol::T_EXCEPTION) {
-    ::apache::thrift::TApplicationException x;
-    x.read(this->iprot_);
-    this->iprot_->readMessageEnd();
-    this->iprot_->getTransport()->readEnd();
-    throw x;
-  }
-  if (mtype != ::apache::thrift::protocol::T_REPLY) {
-    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
-    this->iprot_->readMessageEnd();
-    this->iprot_->getTransport()->readEnd();
-  }
-  if (fname.compare("check") != 0) {
-    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
-    this->iprot_->readMessageEnd();
-    this->iprot_->getTransport()->readEnd();
-  }
-  bool _return;
-  MDTrieShard_check_presult result;
-  result.success = &_return;
-  result.read(this->iprot_);
-  this->iprot_->readMessageEnd();
-  this->iprot_->getTransport()->readEnd();
+  xfer += iprot->readStructBegin(fname);
 
-  if (result.__isset.success) {
-    return _return;
-  }
-  throw ::apache::thrift::TApplicationException(::apache::thrift::TApplicationException::MISSING_RESULT, "check failed: unknown result");
-}
+  using ::apache::thrift::protocol::TProtocolException;
 
-template <class Protocol_>
-void MDTrieShardClientT<Protocol_>::range_search(std::vector<int32_t> & _return, const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range)
-{
-  send_range_search(start_range, end_range);
-  recv_range_search(_return);
-}
 
-template <class Protocol_>
-void MDTrieShardClientT<Protocol_>::send_range_search(const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range)
-{
-  int32_t cseqid = 0;
-  this->oprot_->writeMessageBegin("range_search", ::apache::thrift::protocol::T_CALL, cseqid);
+  while (true)
+  {
+    xfer += iprot->readFieldBegin(fname, ftype, fid);
+    if (ftype == ::apache::thrift::protocol::T_STOP) {
+      break;
+    }
+    switch (fid)
+    {
+      case 0:
+        if (ftype == ::apache::thrift::protocol::T_LIST) {
+          {
+            this->success.clear();
+            uint32_t _size117;
+            ::apache::thrift::protocol::TType _etype120;
+            xfer += iprot->readListBegin(_etype120, _size117);
+            this->success.resize(_size117);
+            uint32_t _i121;
+            for (_i121 = 0; _i121 < _size117; ++_i121)
+            {
+              xfer += iprot->readI32(this->success[_i121]);
+            }
+            xfer += iprot->readListEnd();
+          }
+          this->__isset.success = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      default:
+        xfer += iprot->skip(ftype);
+        break;
+    }
+    xfer += iprot->readFieldEnd();
+  }
 
-  MDTrieShard_range_search_pargs args;
-  args.start_range = &start_range;
-  args.end_range = &end_range;
-  args.write(this->oprot_);
+  xfer += iprot->readStructEnd();
 
-  this->oprot_->writeMessageEnd();
-  this->oprot_->getTransport()->writeEnd();
-  this->oprot_->getTransport()->flush();
+  return xfer;
 }
 
 template <class Protocol_>
-void MDTrieShardClientT<Protocol_>::recv_range_search(std::vector<int32_t> & _return)
-{
+uint32_t MDTrieShard_knn_search_result::write(Protocol_* oprot) const {
 
-  int32_t rseqid = 0;
-  std::string fname;
-  ::apache::thrift::protocol::TMessageType mtype;
+  uint32_t xfer = 0;
 
-  this->iprot_->readMessageBegin(fname, mtype, rseqid);
-  if (mtype == ::apache::thrift::protocol::T_EXCEPTION) {
-    ::apache::thrift::TApplicationException x;
-    x.read(this->iprot_);
-    this->iprot_->readMessageEnd();
-    this->iprot_->getTransport()->readEnd();
-    throw x;
-  }
-  if (mtype != ::apache::thrift::protocol::T_REPLY) {
-    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
-    this->iprot_->readMessageEnd();
-    this->iprot_->getTransport()->readEnd();
-  }
-  if (fname.compare("range_search") != 0) {
-    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
-    this->iprot_->readMessageEnd();
-    this->iprot_->getTransport()->readEnd();
-  }
-  MDTrieShard_range_search_presult result;
-  result.success = &_return;
-  result.read(this->iprot_);
-  this->iprot_->readMessageEnd();
-  this->iprot_->getTransport()->readEnd();
+  xfer += oprot->writeStructBegin("MDTrieShard_knn_search_result");
 
-  if (result.__isset.success) {
-    // _return pointer has now been filled
-    return;
+  if (this->__isset.success) {
+    xfer += oprot->writeFieldBegin("success", ::apache::thrift::protocol::T_LIST, 0);
+    {
+      xfer += oprot->writeListBegin(::apache::thrift::protocol::T_I32, static_cast<uint32_t>(this->success.size()));
+      std::vector<int32_t> ::const_iterator _iter122;
+      for (_iter122 = this->success.begin(); _iter122 != this->success.end(); ++_iter122)
+      {
+        xfer += oprot->writeI32((*_iter122));
+      }
+      xfer += oprot->writeListEnd();
+    }
+    xfer += oprot->writeFieldEnd();
   }
-  throw ::apache::thrift::TApplicationException(::apache::thrift::TApplicationException::MISSING_RESULT, "range_search failed: unknown result");
+  xfer += oprot->writeFieldStop();
+  xfer += oprot->writeStructEnd();
+  return xfer;
 }
 
-template <class Protocol_>
-void MDTrieShardClientT<Protocol_>::primary_key_lookup(std::vector<int32_t> & _return, const int32_t primary_key)
-{
-  send_primary_key_lookup(primary_key);
-  recv_primary_key_lookup(_return);
-}
 
 template <class Protocol_>
-void MDTrieShardClientT<Protocol_>::send_primary_key_lookup(const int32_t primary_key)
-{
-  int32_t cseqid = 0;
-  this->oprot_->writeMessageBegin("primary_key_lookup", ::apache::thrift::protocol::T_CALL, cseqid);
+uint32_t MDTrieShard_knn_search_presult::read(Protocol_* iprot) {
 
-  MDTrieShard_primary_key_lookup_pargs args;
-  args.primary_key = &primary_key;
-  args.write(this->oprot_);
+  ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
+  uint32_t xfer = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TType ftype;
+  int16_t fid;
 
-  this->oprot_->writeMessageEnd();
-  this->oprot_->getTransport()->writeEnd();
-  this->oprot_->getTransport()->flush();
-}
+  xfer += iprot->readStructBegin(fname);
 
-template <class Protocol_>
-void MDTrieShardClientT<Protocol_>::recv_primary_key_lookup(std::vector<int32_t> & _return)
-{
+  using ::apache::thrift::protocol::TProtocolException;
 
-  int32_t rseqid = 0;
-  std::string fname;
-  ::apache::thrift::protocol::TMessageType mtype;
 
-  this->iprot_->readMessageBegin(fname, mtype, rseqid);
-  if (mtype == ::apache::thrift::protocol::T_EXCEPTION) {
-    ::apache::thrift::TApplicationException x;
-    x.read(this->iprot_);
-    this->iprot_->readMessageEnd();
-    this->iprot_->getTransport()->readEnd();
-    throw x;
-  }
-  if (mtype != ::apache::thrift::protocol::T_REPLY) {
-    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
-    this->iprot_->readMessageEnd();
-    this->iprot_->getTransport()->readEnd();
-  }
-  if (fname.compare("primary_key_lookup") != 0) {
-    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
-    this->iprot_->readMessageEnd();
-    this->iprot_->getTransport()->readEnd();
+  while (true)
+  {
+    xfer += iprot->readFieldBegin(fname, ftype, fid);
+    if (ftype == ::apache::thrift::protocol::T_STOP) {
+      break;
+    }
+    switch (fid)
+    {
+      case 0:
+        if (ftype == ::apache::thrift::protocol::T_LIST) {
+          {
+            (*(this->success)).clear();
+            uint32_t _size123;
+            ::apache::thrift::protocol::TType _etype126;
+            xfer += iprot->readListBegin(_etype126, _size123);
+            (*(this->success)).resize(_size123);
+            uint32_t _i127;
+            for (_i127 = 0; _i127 < _size123; ++_i127)
+            {
+              xfer += iprot->readI32((*(this->success))[_i127]);
+            }
+            xfer += iprot->readListEnd();
+          }
+          this->__isset.success = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      default:
+        xfer += iprot->skip(ftype);
+        break;
+    }
+    xfer += iprot->readFieldEnd();
   }
-  MDTrieShard_primary_key_lookup_presult result;
-  result.success = &_return;
-  result.read(this->iprot_);
-  this->iprot_->readMessageEnd();
-  this->iprot_->getTransport()->readEnd();
 
-  if (result.__isset.success) {
-    // _return pointer has now been filled
-    return;
-  }
-  throw ::apache::thrift::TApplicationException(::apache::thrift::TApplicationException::MISSING_RESULT, "primary_key_lookup failed: unknown result");
-}
+  xfer += iprot->readStructEnd();
 
-template <class Protocol_>
-int32_t MDTrieShardClientT<Protocol_>::get_size()
-{
-  send_get_size();
-  return recv_get_size();
+  return xfer;
 }
 
-template <class Protocol_>
-void MDTrieShardClientT<Protocol_>::send_get_size()
-{
-  int32_t cseqid = 0;
-  this->oprot_->writeMessageBegin("get_size", ::apache::thrift::protocol::T_CALL, cseqid);
-
-  MDTrieShard_get_size_pargs args;
-  args.write(this->oprot_);
-
-  this->oprot_->writeMessageEnd();
-  this->oprot_->getTransport()->writeEnd();
-  this->oprot_->getTransport()->flush();
-}
 
 template <class Protocol_>
-int32_t MDTrieShardClientT<Protocol_>::recv_get_size()
-{
+uint32_t MDTrieShard_primary_key_lookup_args::read(Protocol_* iprot) {
 
-  int32_t rseqid = 0;
+  ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
+  uint32_t xfer = 0;
   std::string fname;
-  ::apache::thrift::protocol::TMessageType mtype;
+  ::apache::thrift::protocol::TType ftype;
+  int16_t fid;
+
+  xfer += iprot->readStructBegin(fname);
+
+  using ::apache::thrift::protocol::TProtocolException;
+
+
+  while (true)
+  {
+    xfer += iprot->readFieldBegin(fname, ftype, fid);
+    if (ftype == ::apache::thrift::protocol::T_STOP) {
+      break;
+    }
+    switch (fid)
+    {
+      case 1:
+        if (ftype == ::apache::thrift::protocol::T_I32) {
+          xfer += iprot->readI32(this->primary_key);
+          this->__isset.primary_key = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      default:
+        xfer += iprot->skip(ftype);
+        break;
+    }
+    xfer += iprot->readFieldEnd();
+  }
+
+  xfer += iprot->readStructEnd();
+
+  return xfer;
+}
+
+template <class Protocol_>
+uint32_t MDTrieShard_primary_key_lookup_args::write(Protocol_* oprot) const {
+  uint32_t xfer = 0;
+  ::apache::thrift::protocol::TOutputRecursionTracker tracker(*oprot);
+  xfer += oprot->writeStructBegin("MDTrieShard_primary_key_lookup_args");
+
+  xfer += oprot->writeFieldBegin("primary_key", ::apache::thrift::protocol::T_I32, 1);
+  xfer += oprot->writeI32(this->primary_key);
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldStop();
+  xfer += oprot->writeStructEnd();
+  return xfer;
+}
+
+
+template <class Protocol_>
+uint32_t MDTrieShard_primary_key_lookup_pargs::write(Protocol_* oprot) const {
+  uint32_t xfer = 0;
+  ::apache::thrift::protocol::TOutputRecursionTracker tracker(*oprot);
+  xfer += oprot->writeStructBegin("MDTrieShard_primary_key_lookup_pargs");
+
+  xfer += oprot->writeFieldBegin("primary_key", ::apache::thrift::protocol::T_I32, 1);
+  xfer += oprot->writeI32((*(this->primary_key)));
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldStop();
+  xfer += oprot->writeStructEnd();
+  return xfer;
+}
+
+
+template <class Protocol_>
+uint32_t MDTrieShard_primary_key_lookup_result::read(Protocol_* iprot) {
+
+  ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
+  uint32_t xfer = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TType ftype;
+  int16_t fid;
+
+  xfer += iprot->readStructBegin(fname);
+
+  using ::apache::thrift::protocol::TProtocolException;
+
+
+  while (true)
+  {
+    xfer += iprot->readFieldBegin(fname, ftype, fid);
+    if (ftype == ::apache::thrift::protocol::T_STOP) {
+      break;
+    }
+    switch (fid)
+    {
+      case 0:
+        if (ftype == ::apache::thrift::protocol::T_LIST) {
+          {
+            this->success.clear();
+            uint32_t _size128;
+            ::apache::thrift::protocol::TType _etype131;
+            xfer += iprot->readListBegin(_etype131, _size128);
+            this->success.resize(_size128);
+            uint32_t _i132;
+            for (_i132 = 0; _i132 < _size128; ++_i132)
+            {
+              xfer += iprot->readI32(this->success[_i132]);
+            }
+            xfer += iprot->readListEnd();
+          }
+          this->__isset.success = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      default:
+        xfer += iprot->skip(ftype);
+        break;
+    }
+    xfer += iprot->readFieldEnd();
+  }
+
+  xfer += iprot->readStructEnd();
+
+  return xfer;
+}
+
+template <class Protocol_>
+uint32_t MDTrieShard_primary_key_lookup_result::write(Protocol_* oprot) const {
+
+  uint32_t xfer = 0;
+
+  xfer += oprot->writeStructBegin("MDTrieShard_primary_key_lookup_result");
+
+  if (this->__isset.success) {
+    xfer += oprot->writeFieldBegin("success", ::apache::thrift::protocol::T_LIST, 0);
+    {
+      xfer += oprot->writeListBegin(::apache::thrift::protocol::T_I32, static_cast<uint32_t>(this->success.size()));
+      std::vector<int32_t> ::const_iterator _iter133;
+      for (_iter133 = this->success.begin(); _iter133 != this->success.end(); ++_iter133)
+      {
+        xfer += oprot->writeI32((*_iter133));
+      }
+      xfer += oprot->writeListEnd();
+    }
+    xfer += oprot->writeFieldEnd();
+  }
+  xfer += oprot->writeFieldStop();
+  xfer += oprot->writeStructEnd();
+  return xfer;
+}
+
+
+template <class Protocol_>
+uint32_t MDTrieShard_primary_key_lookup_presult::read(Protocol_* iprot) {
+
+  ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
+  uint32_t xfer = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TType ftype;
+  int16_t fid;
+
+  xfer += iprot->readStructBegin(fname);
+
+  using ::apache::thrift::protocol::TProtocolException;
+
+
+  while (true)
+  {
+    xfer += iprot->readFieldBegin(fname, ftype, fid);
+    if (ftype == ::apache::thrift::protocol::T_STOP) {
+      break;
+    }
+    switch (fid)
+    {
+      case 0:
+        if (ftype == ::apache::thrift::protocol::T_LIST) {
+          {
+            (*(this->success)).clear();
+            uint32_t _size134;
+            ::apache::thrift::protocol::TType _etype137;
+            xfer += iprot->readListBegin(_etype137, _size134);
+            (*(this->success)).resize(_size134);
+            uint32_t _i138;
+            for (_i138 = 0; _i138 < _size134; ++_i138)
+            {
+              xfer += iprot->readI32((*(this->success))[_i138]);
+            }
+            xfer += iprot->readListEnd();
+          }
+          this->__isset.success = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      default:
+        xfer += iprot->skip(ftype);
+        break;
+    }
+    xfer += iprot->readFieldEnd();
+  }
+
+  xfer += iprot->readStructEnd();
+
+  return xfer;
+}
+
+
+template <class Protocol_>
+uint32_t MDTrieShard_primary_key_lookup_batch_args::read(Protocol_* iprot) {
+
+  ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
+  uint32_t xfer = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TType ftype;
+  int16_t fid;
+
+  xfer += iprot->readStructBegin(fname);
+
+  using ::apache::thrift::protocol::TProtocolException;
+
+
+  while (true)
+  {
+    xfer += iprot->readFieldBegin(fname, ftype, fid);
+    if (ftype == ::apache::thrift::protocol::T_STOP) {
+      break;
+    }
+    switch (fid)
+    {
+      case 1:
+        if (ftype == ::apache::thrift::protocol::T_LIST) {
+          {
+            this->primary_keys.clear();
+            uint32_t _size139;
+            ::apache::thrift::protocol::TType _etype142;
+            xfer += iprot->readListBegin(_etype142, _size139);
+            this->primary_keys.resize(_size139);
+            uint32_t _i143;
+            for (_i143 = 0; _i143 < _size139; ++_i143)
+            {
+              xfer += iprot->readI32(this->primary_keys[_i143]);
+            }
+            xfer += iprot->readListEnd();
+          }
+          this->__isset.primary_keys = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      default:
+        xfer += iprot->skip(ftype);
+        break;
+    }
+    xfer += iprot->readFieldEnd();
+  }
+
+  xfer += iprot->readStructEnd();
+
+  return xfer;
+}
+
+template <class Protocol_>
+uint32_t MDTrieShard_primary_key_lookup_batch_args::write(Protocol_* oprot) const {
+  uint32_t xfer = 0;
+  ::apache::thrift::protocol::TOutputRecursionTracker tracker(*oprot);
+  xfer += oprot->writeStructBegin("MDTrieShard_primary_key_lookup_batch_args");
+
+  xfer += oprot->writeFieldBegin("primary_keys", ::apache::thrift::protocol::T_LIST, 1);
+  {
+    xfer += oprot->writeListBegin(::apache::thrift::protocol::T_I32, static_cast<uint32_t>(this->primary_keys.size()));
+    std::vector<int32_t> ::const_iterator _iter144;
+    for (_iter144 = this->primary_keys.begin(); _iter144 != this->primary_keys.end(); ++_iter144)
+    {
+      xfer += oprot->writeI32((*_iter144));
+    }
+    xfer += oprot->writeListEnd();
+  }
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldStop();
+  xfer += oprot->writeStructEnd();
+  return xfer;
+}
+
+
+template <class Protocol_>
+uint32_t MDTrieShard_primary_key_lookup_batch_pargs::write(Protocol_* oprot) const {
+  uint32_t xfer = 0;
+  ::apache::thrift::protocol::TOutputRecursionTracker tracker(*oprot);
+  xfer += oprot->writeStructBegin("MDTrieShard_primary_key_lookup_batch_pargs");
+
+  xfer += oprot->writeFieldBegin("primary_keys", ::apache::thrift::protocol::T_LIST, 1);
+  {
+    xfer += oprot->writeListBegin(::apache::thrift::protocol::T_I32, static_cast<uint32_t>((*(this->primary_keys)).size()));
+    std::vector<int32_t> ::const_iterator _iter145;
+    for (_iter145 = (*(this->primary_keys)).begin(); _iter145 != (*(this->primary_keys)).end(); ++_iter145)
+    {
+      xfer += oprot->writeI32((*_iter145));
+    }
+    xfer += oprot->writeListEnd();
+  }
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldStop();
+  xfer += oprot->writeStructEnd();
+  return xfer;
+}
+
+
+template <class Protocol_>
+uint32_t MDTrieShard_primary_key_lookup_batch_result::read(Protocol_* iprot) {
+
+  ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
+  uint32_t xfer = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TType ftype;
+  int16_t fid;
+
+  xfer += iprot->readStructBegin(fname);
+
+  using ::apache::thrift::protocol::TProtocolException;
+
+
+  while (true)
+  {
+    xfer += iprot->readFieldBegin(fname, ftype, fid);
+    if (ftype == ::apache::thrift::protocol::T_STOP) {
+      break;
+    }
+    switch (fid)
+    {
+      case 0:
+        if (ftype == ::apache::thrift::protocol::T_LIST) {
+          {
+            this->success.clear();
+            uint32_t _size146;
+            ::apache::thrift::protocol::TType _etype149;
+            xfer += iprot->readListBegin(_etype149, _size146);
+            this->success.resize(_size146);
+            uint32_t _i150;
+            for (_i150 = 0; _i150 < _size146; ++_i150)
+            {
+              xfer += iprot->readI32(this->success[_i150]);
+            }
+            xfer += iprot->readListEnd();
+          }
+          this->__isset.success = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      default:
+        xfer += iprot->skip(ftype);
+        break;
+    }
+    xfer += iprot->readFieldEnd();
+  }
+
+  xfer += iprot->readStructEnd();
+
+  return xfer;
+}
+
+template <class Protocol_>
+uint32_t MDTrieShard_primary_key_lookup_batch_result::write(Protocol_* oprot) const {
+
+  uint32_t xfer = 0;
+
+  xfer += oprot->writeStructBegin("MDTrieShard_primary_key_lookup_batch_result");
+
+  if (this->__isset.success) {
+    xfer += oprot->writeFieldBegin("success", ::apache::thrift::protocol::T_LIST, 0);
+    {
+      xfer += oprot->writeListBegin(::apache::thrift::protocol::T_I32, static_cast<uint32_t>(this->success.size()));
+      std::vector<int32_t> ::const_iterator _iter151;
+      for (_iter151 = this->success.begin(); _iter151 != this->success.end(); ++_iter151)
+      {
+        xfer += oprot->writeI32((*_iter151));
+      }
+      xfer += oprot->writeListEnd();
+    }
+    xfer += oprot->writeFieldEnd();
+  }
+  xfer += oprot->writeFieldStop();
+  xfer += oprot->writeStructEnd();
+  return xfer;
+}
+
+
+template <class Protocol_>
+uint32_t MDTrieShard_primary_key_lookup_batch_presult::read(Protocol_* iprot) {
+
+  ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
+  uint32_t xfer = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TType ftype;
+  int16_t fid;
+
+  xfer += iprot->readStructBegin(fname);
+
+  using ::apache::thrift::protocol::TProtocolException;
+
+
+  while (true)
+  {
+    xfer += iprot->readFieldBegin(fname, ftype, fid);
+    if (ftype == ::apache::thrift::protocol::T_STOP) {
+      break;
+    }
+    switch (fid)
+    {
+      case 0:
+        if (ftype == ::apache::thrift::protocol::T_LIST) {
+          {
+            (*(this->success)).clear();
+            uint32_t _size152;
+            ::apache::thrift::protocol::TType _etype155;
+            xfer += iprot->readListBegin(_etype155, _size152);
+            (*(this->success)).resize(_size152);
+            uint32_t _i156;
+            for (_i156 = 0; _i156 < _size152; ++_i156)
+            {
+              xfer += iprot->readI32((*(this->success))[_i156]);
+            }
+            xfer += iprot->readListEnd();
+          }
+          this->__isset.success = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      default:
+        xfer += iprot->skip(ftype);
+        break;
+    }
+    xfer += iprot->readFieldEnd();
+  }
+
+  xfer += iprot->readStructEnd();
+
+  return xfer;
+}
+
+
+template <class Protocol_>
+uint32_t MDTrieShard_get_size_args::read(Protocol_* iprot) {
+
+  ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
+  uint32_t xfer = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TType ftype;
+  int16_t fid;
+
+  xfer += iprot->readStructBegin(fname);
+
+  using ::apache::thrift::protocol::TProtocolException;
+
+
+  while (true)
+  {
+    xfer += iprot->readFieldBegin(fname, ftype, fid);
+    if (ftype == ::apache::thrift::protocol::T_STOP) {
+      break;
+    }
+    xfer += iprot->skip(ftype);
+    xfer += iprot->readFieldEnd();
+  }
+
+  xfer += iprot->readStructEnd();
+
+  return xfer;
+}
+
+template <class Protocol_>
+uint32_t MDTrieShard_get_size_args::write(Protocol_* oprot) const {
+  uint32_t xfer = 0;
+  ::apache::thrift::protocol::TOutputRecursionTracker tracker(*oprot);
+  xfer += oprot->writeStructBegin("MDTrieShard_get_size_args");
+
+  xfer += oprot->writeFieldStop();
+  xfer += oprot->writeStructEnd();
+  return xfer;
+}
+
+
+template <class Protocol_>
+uint32_t MDTrieShard_get_size_pargs::write(Protocol_* oprot) const {
+  uint32_t xfer = 0;
+  ::apache::thrift::protocol::TOutputRecursionTracker tracker(*oprot);
+  xfer += oprot->writeStructBegin("MDTrieShard_get_size_pargs");
+
+  xfer += oprot->writeFieldStop();
+  xfer += oprot->writeStructEnd();
+  return xfer;
+}
+
+
+template <class Protocol_>
+uint32_t MDTrieShard_get_size_result::read(Protocol_* iprot) {
+
+  ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
+  uint32_t xfer = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TType ftype;
+  int16_t fid;
+
+  xfer += iprot->readStructBegin(fname);
+
+  using ::apache::thrift::protocol::TProtocolException;
+
+
+  while (true)
+  {
+    xfer += iprot->readFieldBegin(fname, ftype, fid);
+    if (ftype == ::apache::thrift::protocol::T_STOP) {
+      break;
+    }
+    switch (fid)
+    {
+      case 0:
+        if (ftype == ::apache::thrift::protocol::T_I32) {
+          xfer += iprot->readI32(this->success);
+          this->__isset.success = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      default:
+        xfer += iprot->skip(ftype);
+        break;
+    }
+    xfer += iprot->readFieldEnd();
+  }
+
+  xfer += iprot->readStructEnd();
+
+  return xfer;
+}
+
+template <class Protocol_>
+uint32_t MDTrieShard_get_size_result::write(Protocol_* oprot) const {
+
+  uint32_t xfer = 0;
+
+  xfer += oprot->writeStructBegin("MDTrieShard_get_size_result");
+
+  if (this->__isset.success) {
+    xfer += oprot->writeFieldBegin("success", ::apache::thrift::protocol::T_I32, 0);
+    xfer += oprot->writeI32(this->success);
+    xfer += oprot->writeFieldEnd();
+  }
+  xfer += oprot->writeFieldStop();
+  xfer += oprot->writeStructEnd();
+  return xfer;
+}
+
+
+template <class Protocol_>
+uint32_t MDTrieShard_get_size_presult::read(Protocol_* iprot) {
+
+  ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
+  uint32_t xfer = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TType ftype;
+  int16_t fid;
+
+  xfer += iprot->readStructBegin(fname);
+
+  using ::apache::thrift::protocol::TProtocolException;
+
+
+  while (true)
+  {
+    xfer += iprot->readFieldBegin(fname, ftype, fid);
+    if (ftype == ::apache::thrift::protocol::T_STOP) {
+      break;
+    }
+    switch (fid)
+    {
+      case 0:
+        if (ftype == ::apache::thrift::protocol::T_I32) {
+          xfer += iprot->readI32((*(this->success)));
+          this->__isset.success = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      default:
+        xfer += iprot->skip(ftype);
+        break;
+    }
+    xfer += iprot->readFieldEnd();
+  }
+
+  xfer += iprot->readStructEnd();
+
+  return xfer;
+}
+
+
+template <class Protocol_>
+uint32_t MDTrieShard_get_size_breakdown_args::read(Protocol_* iprot) {
+
+  ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
+  uint32_t xfer = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TType ftype;
+  int16_t fid;
+
+  xfer += iprot->readStructBegin(fname);
+
+  using ::apache::thrift::protocol::TProtocolException;
+
+
+  while (true)
+  {
+    xfer += iprot->readFieldBegin(fname, ftype, fid);
+    if (ftype == ::apache::thrift::protocol::T_STOP) {
+      break;
+    }
+    xfer += iprot->skip(ftype);
+    xfer += iprot->readFieldEnd();
+  }
+
+  xfer += iprot->readStructEnd();
+
+  return xfer;
+}
+
+template <class Protocol_>
+uint32_t MDTrieShard_get_size_breakdown_args::write(Protocol_* oprot) const {
+  uint32_t xfer = 0;
+  ::apache::thrift::protocol::TOutputRecursionTracker tracker(*oprot);
+  xfer += oprot->writeStructBegin("MDTrieShard_get_size_breakdown_args");
+
+  xfer += oprot->writeFieldStop();
+  xfer += oprot->writeStructEnd();
+  return xfer;
+}
+
+
+template <class Protocol_>
+uint32_t MDTrieShard_get_size_breakdown_pargs::write(Protocol_* oprot) const {
+  uint32_t xfer = 0;
+  ::apache::thrift::protocol::TOutputRecursionTracker tracker(*oprot);
+  xfer += oprot->writeStructBegin("MDTrieShard_get_size_breakdown_pargs");
+
+  xfer += oprot->writeFieldStop();
+  xfer += oprot->writeStructEnd();
+  return xfer;
+}
+
+
+template <class Protocol_>
+uint32_t MDTrieShard_get_size_breakdown_result::read(Protocol_* iprot) {
+
+  ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
+  uint32_t xfer = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TType ftype;
+  int16_t fid;
+
+  xfer += iprot->readStructBegin(fname);
+
+  using ::apache::thrift::protocol::TProtocolException;
+
+
+  while (true)
+  {
+    xfer += iprot->readFieldBegin(fname, ftype, fid);
+    if (ftype == ::apache::thrift::protocol::T_STOP) {
+      break;
+    }
+    switch (fid)
+    {
+      case 0:
+        if (ftype == ::apache::thrift::protocol::T_LIST) {
+          {
+            this->success.clear();
+            uint32_t _size157;
+            ::apache::thrift::protocol::TType _etype160;
+            xfer += iprot->readListBegin(_etype160, _size157);
+            this->success.resize(_size157);
+            uint32_t _i161;
+            for (_i161 = 0; _i161 < _size157; ++_i161)
+            {
+              xfer += iprot->readI64(this->success[_i161]);
+            }
+            xfer += iprot->readListEnd();
+          }
+          this->__isset.success = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      default:
+        xfer += iprot->skip(ftype);
+        break;
+    }
+    xfer += iprot->readFieldEnd();
+  }
+
+  xfer += iprot->readStructEnd();
+
+  return xfer;
+}
+
+template <class Protocol_>
+uint32_t MDTrieShard_get_size_breakdown_result::write(Protocol_* oprot) const {
+
+  uint32_t xfer = 0;
+
+  xfer += oprot->writeStructBegin("MDTrieShard_get_size_breakdown_result");
+
+  if (this->__isset.success) {
+    xfer += oprot->writeFieldBegin("success", ::apache::thrift::protocol::T_LIST, 0);
+    {
+      xfer += oprot->writeListBegin(::apache::thrift::protocol::T_I64, static_cast<uint32_t>(this->success.size()));
+      std::vector<int64_t> ::const_iterator _iter162;
+      for (_iter162 = this->success.begin(); _iter162 != this->success.end(); ++_iter162)
+      {
+        xfer += oprot->writeI64((*_iter162));
+      }
+      xfer += oprot->writeListEnd();
+    }
+    xfer += oprot->writeFieldEnd();
+  }
+  xfer += oprot->writeFieldStop();
+  xfer += oprot->writeStructEnd();
+  return xfer;
+}
+
+
+template <class Protocol_>
+uint32_t MDTrieShard_get_size_breakdown_presult::read(Protocol_* iprot) {
+
+  ::apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
+  uint32_t xfer = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TType ftype;
+  int16_t fid;
+
+  xfer += iprot->readStructBegin(fname);
+
+  using ::apache::thrift::protocol::TProtocolException;
+
+
+  while (true)
+  {
+    xfer += iprot->readFieldBegin(fname, ftype, fid);
+    if (ftype == ::apache::thrift::protocol::T_STOP) {
+      break;
+    }
+    switch (fid)
+    {
+      case 0:
+        if (ftype == ::apache::thrift::protocol::T_LIST) {
+          {
+            (*(this->success)).clear();
+            uint32_t _size163;
+            ::apache::thrift::protocol::TType _etype166;
+            xfer += iprot->readListBegin(_etype166, _size163);
+            (*(this->success)).resize(_size163);
+            uint32_t _i167;
+            for (_i167 = 0; _i167 < _size163; ++_i167)
+            {
+              xfer += iprot->readI64((*(this->success))[_i167]);
+            }
+            xfer += iprot->readListEnd();
+          }
+          this->__isset.success = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      default:
+        xfer += iprot->skip(ftype);
+        break;
+    }
+    xfer += iprot->readFieldEnd();
+  }
+
+  xfer += iprot->readStructEnd();
+
+  return xfer;
+}
+
+template <class Protocol_>
+bool MDTrieShardClientT<Protocol_>::ping(const int32_t dataset_idx)
+{
+  send_ping(dataset_idx);
+  return recv_ping();
+}
+
+template <class Protocol_>
+void MDTrieShardClientT<Protocol_>::send_ping(const int32_t dataset_idx)
+{
+  int32_t cseqid = 0;
+  this->oprot_->writeMessageBegin("ping", ::apache::thrift::protocol::T_CALL, cseqid);
+
+  MDTrieShard_ping_pargs args;
+  args.dataset_idx = &dataset_idx;
+  args.write(this->oprot_);
+
+  this->oprot_->writeMessageEnd();
+  this->oprot_->getTransport()->writeEnd();
+  this->oprot_->getTransport()->flush();
+}
+
+template <class Protocol_>
+bool MDTrieShardClientT<Protocol_>::recv_ping()
+{
+
+  int32_t rseqid = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TMessageType mtype;
+
+  this->iprot_->readMessageBegin(fname, mtype, rseqid);
+  if (mtype == ::apache::thrift::protocol::T_EXCEPTION) {
+    ::apache::thrift::TApplicationException x;
+    x.read(this->iprot_);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+    throw x;
+  }
+  if (mtype != ::apache::thrift::protocol::T_REPLY) {
+    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+  }
+  if (fname.compare("ping") != 0) {
+    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+  }
+  bool _return;
+  MDTrieShard_ping_presult result;
+  result.success = &_return;
+  result.read(this->iprot_);
+  this->iprot_->readMessageEnd();
+  this->iprot_->getTransport()->readEnd();
+
+  if (result.__isset.success) {
+    return _return;
+  }
+  throw ::apache::thrift::TApplicationException(::apache::thrift::TApplicationException::MISSING_RESULT, "ping failed: unknown result");
+}
+
+template <class Protocol_>
+int32_t MDTrieShardClientT<Protocol_>::insert(const std::vector<int32_t> & point, const int32_t primary_key)
+{
+  send_insert(point, primary_key);
+  return recv_insert();
+}
+
+template <class Protocol_>
+void MDTrieShardClientT<Protocol_>::send_insert(const std::vector<int32_t> & point, const int32_t primary_key)
+{
+  int32_t cseqid = 0;
+  this->oprot_->writeMessageBegin("insert", ::apache::thrift::protocol::T_CALL, cseqid);
+
+  MDTrieShard_insert_pargs args;
+  args.point = &point;
+  args.primary_key = &primary_key;
+  args.write(this->oprot_);
+
+  this->oprot_->writeMessageEnd();
+  this->oprot_->getTransport()->writeEnd();
+  this->oprot_->getTransport()->flush();
+}
+
+template <class Protocol_>
+int32_t MDTrieShardClientT<Protocol_>::recv_insert()
+{
+
+  int32_t rseqid = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TMessageType mtype;
+
+  this->iprot_->readMessageBegin(fname, mtype, rseqid);
+  if (mtype == ::apache::thrift::protocol::T_EXCEPTION) {
+    ::apache::thrift::TApplicationException x;
+    x.read(this->iprot_);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+    throw x;
+  }
+  if (mtype != ::apache::thrift::protocol::T_REPLY) {
+    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+  }
+  if (fname.compare("insert") != 0) {
+    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+  }
+  int32_t _return;
+  MDTrieShard_insert_presult result;
+  result.success = &_return;
+  result.read(this->iprot_);
+  this->iprot_->readMessageEnd();
+  this->iprot_->getTransport()->readEnd();
+
+  if (result.__isset.success) {
+    return _return;
+  }
+  throw ::apache::thrift::TApplicationException(::apache::thrift::TApplicationException::MISSING_RESULT, "insert failed: unknown result");
+}
+
+template <class Protocol_>
+int32_t MDTrieShardClientT<Protocol_>::insert_for_latency(const std::vector<int32_t> & point, const int32_t primary_key)
+{
+  send_insert_for_latency(point, primary_key);
+  return recv_insert_for_latency();
+}
+
+template <class Protocol_>
+void MDTrieShardClientT<Protocol_>::send_insert_for_latency(const std::vector<int32_t> & point, const int32_t primary_key)
+{
+  int32_t cseqid = 0;
+  this->oprot_->writeMessageBegin("insert_for_latency", ::apache::thrift::protocol::T_CALL, cseqid);
+
+  MDTrieShard_insert_for_latency_pargs args;
+  args.point = &point;
+  args.primary_key = &primary_key;
+  args.write(this->oprot_);
+
+  this->oprot_->writeMessageEnd();
+  this->oprot_->getTransport()->writeEnd();
+  this->oprot_->getTransport()->flush();
+}
+
+template <class Protocol_>
+int32_t MDTrieShardClientT<Protocol_>::recv_insert_for_latency()
+{
+
+  int32_t rseqid = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TMessageType mtype;
+
+  this->iprot_->readMessageBegin(fname, mtype, rseqid);
+  if (mtype == ::apache::thrift::protocol::T_EXCEPTION) {
+    ::apache::thrift::TApplicationException x;
+    x.read(this->iprot_);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+    throw x;
+  }
+  if (mtype != ::apache::thrift::protocol::T_REPLY) {
+    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+  }
+  if (fname.compare("insert_for_latency") != 0) {
+    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+  }
+  int32_t _return;
+  MDTrieShard_insert_for_latency_presult result;
+  result.success = &_return;
+  result.read(this->iprot_);
+  this->iprot_->readMessageEnd();
+  this->iprot_->getTransport()->readEnd();
+
+  if (result.__isset.success) {
+    return _return;
+  }
+  throw ::apache::thrift::TApplicationException(::apache::thrift::TApplicationException::MISSING_RESULT, "insert_for_latency failed: unknown result");
+}
+
+template <class Protocol_>
+bool MDTrieShardClientT<Protocol_>::check(const std::vector<int32_t> & point)
+{
+  send_check(point);
+  return recv_check();
+}
+
+template <class Protocol_>
+void MDTrieShardClientT<Protocol_>::send_check(const std::vector<int32_t> & point)
+{
+  int32_t cseqid = 0;
+  this->oprot_->writeMessageBegin("check", ::apache::thrift::protocol::T_CALL, cseqid);
+
+  MDTrieShard_check_pargs args;
+  args.point = &point;
+  args.write(this->oprot_);
+
+  this->oprot_->writeMessageEnd();
+  this->oprot_->getTransport()->writeEnd();
+  this->oprot_->getTransport()->flush();
+}
+
+template <class Protocol_>
+bool MDTrieShardClientT<Protocol_>::recv_check()
+{
+
+  int32_t rseqid = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TMessageType mtype;
+
+  this->iprot_->readMessageBegin(fname, mtype, rseqid);
+  if (mtype == ::apache::thrift::protocol::T_EXCEPTION) {
+    ::apache::thrift::TApplicationException x;
+    x.read(this->iprot_);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+    throw x;
+  }
+  if (mtype != ::apache::thrift::protocol::T_REPLY) {
+    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+  }
+  if (fname.compare("check") != 0) {
+    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+  }
+  bool _return;
+  MDTrieShard_check_presult result;
+  result.success = &_return;
+  result.read(this->iprot_);
+  this->iprot_->readMessageEnd();
+  this->iprot_->getTransport()->readEnd();
+
+  if (result.__isset.success) {
+    return _return;
+  }
+  throw ::apache::thrift::TApplicationException(::apache::thrift::TApplicationException::MISSING_RESULT, "check failed: unknown result");
+}
+
+template <class Protocol_>
+void MDTrieShardClientT<Protocol_>::range_search(std::vector<int32_t> & _return, const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range, const int32_t result_mode)
+{
+  send_range_search(start_range, end_range, result_mode);
+  recv_range_search(_return);
+}
+
+template <class Protocol_>
+void MDTrieShardClientT<Protocol_>::send_range_search(const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range, const int32_t result_mode)
+{
+  int32_t cseqid = 0;
+  this->oprot_->writeMessageBegin("range_search", ::apache::thrift::protocol::T_CALL, cseqid);
+
+  MDTrieShard_range_search_pargs args;
+  args.start_range = &start_range;
+  args.end_range = &end_range;
+  args.result_mode = &result_mode;
+  args.write(this->oprot_);
+
+  this->oprot_->writeMessageEnd();
+  this->oprot_->getTransport()->writeEnd();
+  this->oprot_->getTransport()->flush();
+}
+
+template <class Protocol_>
+void MDTrieShardClientT<Protocol_>::recv_range_search(std::vector<int32_t> & _return)
+{
+
+  int32_t rseqid = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TMessageType mtype;
+
+  this->iprot_->readMessageBegin(fname, mtype, rseqid);
+  if (mtype == ::apache::thrift::protocol::T_EXCEPTION) {
+    ::apache::thrift::TApplicationException x;
+    x.read(this->iprot_);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+    throw x;
+  }
+  if (mtype != ::apache::thrift::protocol::T_REPLY) {
+    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+  }
+  if (fname.compare("range_search") != 0) {
+    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+  }
+  MDTrieShard_range_search_presult result;
+  result.success = &_return;
+  result.read(this->iprot_);
+  this->iprot_->readMessageEnd();
+  this->iprot_->getTransport()->readEnd();
+
+  if (result.__isset.success) {
+    // _return pointer has now been filled
+    return;
+  }
+  throw ::apache::thrift::TApplicationException(::apache::thrift::TApplicationException::MISSING_RESULT, "range_search failed: unknown result");
+}
+
+template <class Protocol_>
+void MDTrieShardClientT<Protocol_>::range_search_page(std::vector<int32_t> & _return, const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range, const std::vector<int32_t> & resume_after, const int32_t limit, const int32_t result_mode)
+{
+  send_range_search_page(start_range, end_range, resume_after, limit, result_mode);
+  recv_range_search_page(_return);
+}
+
+template <class Protocol_>
+void MDTrieShardClientT<Protocol_>::send_range_search_page(const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range, const std::vector<int32_t> & resume_after, const int32_t limit, const int32_t result_mode)
+{
+  int32_t cseqid = 0;
+  this->oprot_->writeMessageBegin("range_search_page", ::apache::thrift::protocol::T_CALL, cseqid);
+
+  MDTrieShard_range_search_page_pargs args;
+  args.start_range = &start_range;
+  args.end_range = &end_range;
+  args.resume_after = &resume_after;
+  args.limit = &limit;
+  args.result_mode = &result_mode;
+  args.write(this->oprot_);
+
+  this->oprot_->writeMessageEnd();
+  this->oprot_->getTransport()->writeEnd();
+  this->oprot_->getTransport()->flush();
+}
+
+template <class Protocol_>
+void MDTrieShardClientT<Protocol_>::recv_range_search_page(std::vector<int32_t> & _return)
+{
+
+  int32_t rseqid = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TMessageType mtype;
+
+  this->iprot_->readMessageBegin(fname, mtype, rseqid);
+  if (mtype == ::apache::thrift::protocol::T_EXCEPTION) {
+    ::apache::thrift::TApplicationException x;
+    x.read(this->iprot_);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+    throw x;
+  }
+  if (mtype != ::apache::thrift::protocol::T_REPLY) {
+    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+  }
+  if (fname.compare("range_search_page") != 0) {
+    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+  }
+  MDTrieShard_range_search_page_presult result;
+  result.success = &_return;
+  result.read(this->iprot_);
+  this->iprot_->readMessageEnd();
+  this->iprot_->getTransport()->readEnd();
+
+  if (result.__isset.success) {
+    // _return pointer has now been filled
+    return;
+  }
+  throw ::apache::thrift::TApplicationException(::apache::thrift::TApplicationException::MISSING_RESULT, "range_search_page failed: unknown result");
+}
+
+template <class Protocol_>
+void MDTrieShardClientT<Protocol_>::range_search_aggregate(std::vector<int64_t> & _return, const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range, const std::vector<int32_t> & dimensions)
+{
+  send_range_search_aggregate(start_range, end_range, dimensions);
+  recv_range_search_aggregate(_return);
+}
+
+template <class Protocol_>
+void MDTrieShardClientT<Protocol_>::send_range_search_aggregate(const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range, const std::vector<int32_t> & dimensions)
+{
+  int32_t cseqid = 0;
+  this->oprot_->writeMessageBegin("range_search_aggregate", ::apache::thrift::protocol::T_CALL, cseqid);
+
+  MDTrieShard_range_search_aggregate_pargs args;
+  args.start_range = &start_range;
+  args.end_range = &end_range;
+  args.dimensions = &dimensions;
+  args.write(this->oprot_);
+
+  this->oprot_->writeMessageEnd();
+  this->oprot_->getTransport()->writeEnd();
+  this->oprot_->getTransport()->flush();
+}
+
+template <class Protocol_>
+void MDTrieShardClientT<Protocol_>::recv_range_search_aggregate(std::vector<int64_t> & _return)
+{
+
+  int32_t rseqid = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TMessageType mtype;
+
+  this->iprot_->readMessageBegin(fname, mtype, rseqid);
+  if (mtype == ::apache::thrift::protocol::T_EXCEPTION) {
+    ::apache::thrift::TApplicationException x;
+    x.read(this->iprot_);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+    throw x;
+  }
+  if (mtype != ::apache::thrift::protocol::T_REPLY) {
+    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+  }
+  if (fname.compare("range_search_aggregate") != 0) {
+    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+  }
+  MDTrieShard_range_search_aggregate_presult result;
+  result.success = &_return;
+  result.read(this->iprot_);
+  this->iprot_->readMessageEnd();
+  this->iprot_->getTransport()->readEnd();
+
+  if (result.__isset.success) {
+    // _return pointer has now been filled
+    return;
+  }
+  throw ::apache::thrift::TApplicationException(::apache::thrift::TApplicationException::MISSING_RESULT, "range_search_aggregate failed: unknown result");
+}
+
+template <class Protocol_>
+void MDTrieShardClientT<Protocol_>::knn_search(std::vector<int32_t> & _return, const std::vector<int32_t> & point, const int32_t k, const int32_t metric, const std::vector<double> & weights)
+{
+  send_knn_search(point, k, metric, weights);
+  recv_knn_search(_return);
+}
+
+template <class Protocol_>
+void MDTrieShardClientT<Protocol_>::send_knn_search(const std::vector<int32_t> & point, const int32_t k, const int32_t metric, const std::vector<double> & weights)
+{
+  int32_t cseqid = 0;
+  this->oprot_->writeMessageBegin("knn_search", ::apache::thrift::protocol::T_CALL, cseqid);
+
+  MDTrieShard_knn_search_pargs args;
+  args.point = &point;
+  args.k = &k;
+  args.metric = &metric;
+  args.weights = &weights;
+  args.write(this->oprot_);
+
+  this->oprot_->writeMessageEnd();
+  this->oprot_->getTransport()->writeEnd();
+  this->oprot_->getTransport()->flush();
+}
+
+template <class Protocol_>
+void MDTrieShardClientT<Protocol_>::recv_knn_search(std::vector<int32_t> & _return)
+{
+
+  int32_t rseqid = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TMessageType mtype;
+
+  this->iprot_->readMessageBegin(fname, mtype, rseqid);
+  if (mtype == ::apache::thrift::protocol::T_EXCEPTION) {
+    ::apache::thrift::TApplicationException x;
+    x.read(this->iprot_);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+    throw x;
+  }
+  if (mtype != ::apache::thrift::protocol::T_REPLY) {
+    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+  }
+  if (fname.compare("knn_search") != 0) {
+    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+  }
+  MDTrieShard_knn_search_presult result;
+  result.success = &_return;
+  result.read(this->iprot_);
+  this->iprot_->readMessageEnd();
+  this->iprot_->getTransport()->readEnd();
+
+  if (result.__isset.success) {
+    // _return pointer has now been filled
+    return;
+  }
+  throw ::apache::thrift::TApplicationException(::apache::thrift::TApplicationException::MISSING_RESULT, "knn_search failed: unknown result");
+}
+
+template <class Protocol_>
+void MDTrieShardClientT<Protocol_>::primary_key_lookup(std::vector<int32_t> & _return, const int32_t primary_key)
+{
+  send_primary_key_lookup(primary_key);
+  recv_primary_key_lookup(_return);
+}
+
+template <class Protocol_>
+void MDTrieShardClientT<Protocol_>::send_primary_key_lookup(const int32_t primary_key)
+{
+  int32_t cseqid = 0;
+  this->oprot_->writeMessageBegin("primary_key_lookup", ::apache::thrift::protocol::T_CALL, cseqid);
+
+  MDTrieShard_primary_key_lookup_pargs args;
+  args.primary_key = &primary_key;
+  args.write(this->oprot_);
+
+  this->oprot_->writeMessageEnd();
+  this->oprot_->getTransport()->writeEnd();
+  this->oprot_->getTransport()->flush();
+}
+
+template <class Protocol_>
+void MDTrieShardClientT<Protocol_>::recv_primary_key_lookup(std::vector<int32_t> & _return)
+{
+
+  int32_t rseqid = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TMessageType mtype;
+
+  this->iprot_->readMessageBegin(fname, mtype, rseqid);
+  if (mtype == ::apache::thrift::protocol::T_EXCEPTION) {
+    ::apache::thrift::TApplicationException x;
+    x.read(this->iprot_);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+    throw x;
+  }
+  if (mtype != ::apache::thrift::protocol::T_REPLY) {
+    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+  }
+  if (fname.compare("primary_key_lookup") != 0) {
+    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+  }
+  MDTrieShard_primary_key_lookup_presult result;
+  result.success = &_return;
+  result.read(this->iprot_);
+  this->iprot_->readMessageEnd();
+  this->iprot_->getTransport()->readEnd();
+
+  if (result.__isset.success) {
+    // _return pointer has now been filled
+    return;
+  }
+  throw ::apache::thrift::TApplicationException(::apache::thrift::TApplicationException::MISSING_RESULT, "primary_key_lookup failed: unknown result");
+}
+
+template <class Protocol_>
+void MDTrieShardClientT<Protocol_>::primary_key_lookup_batch(std::vector<int32_t> & _return, const std::vector<int32_t> & primary_keys)
+{
+  send_primary_key_lookup_batch(primary_keys);
+  recv_primary_key_lookup_batch(_return);
+}
+
+template <class Protocol_>
+void MDTrieShardClientT<Protocol_>::send_primary_key_lookup_batch(const std::vector<int32_t> & primary_keys)
+{
+  int32_t cseqid = 0;
+  this->oprot_->writeMessageBegin("primary_key_lookup_batch", ::apache::thrift::protocol::T_CALL, cseqid);
+
+  MDTrieShard_primary_key_lookup_batch_pargs args;
+  args.primary_keys = &primary_keys;
+  args.write(this->oprot_);
+
+  this->oprot_->writeMessageEnd();
+  this->oprot_->getTransport()->writeEnd();
+  this->oprot_->getTransport()->flush();
+}
+
+template <class Protocol_>
+void MDTrieShardClientT<Protocol_>::recv_primary_key_lookup_batch(std::vector<int32_t> & _return)
+{
+
+  int32_t rseqid = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TMessageType mtype;
+
+  this->iprot_->readMessageBegin(fname, mtype, rseqid);
+  if (mtype == ::apache::thrift::protocol::T_EXCEPTION) {
+    ::apache::thrift::TApplicationException x;
+    x.read(this->iprot_);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+    throw x;
+  }
+  if (mtype != ::apache::thrift::protocol::T_REPLY) {
+    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+  }
+  if (fname.compare("primary_key_lookup_batch") != 0) {
+    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+  }
+  MDTrieShard_primary_key_lookup_batch_presult result;
+  result.success = &_return;
+  result.read(this->iprot_);
+  this->iprot_->readMessageEnd();
+  this->iprot_->getTransport()->readEnd();
+
+  if (result.__isset.success) {
+    // _return pointer has now been filled
+    return;
+  }
+  throw ::apache::thrift::TApplicationException(::apache::thrift::TApplicationException::MISSING_RESULT, "primary_key_lookup_batch failed: unknown result");
+}
+
+template <class Protocol_>
+int32_t MDTrieShardClientT<Protocol_>::get_size()
+{
+  send_get_size();
+  return recv_get_size();
+}
+
+template <class Protocol_>
+void MDTrieShardClientT<Protocol_>::send_get_size()
+{
+  int32_t cseqid = 0;
+  this->oprot_->writeMessageBegin("get_size", ::apache::thrift::protocol::T_CALL, cseqid);
+
+  MDTrieShard_get_size_pargs args;
+  args.write(this->oprot_);
+
+  this->oprot_->writeMessageEnd();
+  this->oprot_->getTransport()->writeEnd();
+  this->oprot_->getTransport()->flush();
+}
+
+template <class Protocol_>
+int32_t MDTrieShardClientT<Protocol_>::recv_get_size()
+{
+
+  int32_t rseqid = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TMessageType mtype;
+
+  this->iprot_->readMessageBegin(fname, mtype, rseqid);
+  if (mtype == ::apache::thrift::protocol::T_EXCEPTION) {
+    ::apache::thrift::TApplicationException x;
+    x.read(this->iprot_);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+    throw x;
+  }
+  if (mtype != ::apache::thrift::protocol::T_REPLY) {
+    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+  }
+  if (fname.compare("get_size") != 0) {
+    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+  }
+  int32_t _return;
+  MDTrieShard_get_size_presult result;
+  result.success = &_return;
+  result.read(this->iprot_);
+  this->iprot_->readMessageEnd();
+  this->iprot_->getTransport()->readEnd();
+
+  if (result.__isset.success) {
+    return _return;
+  }
+  throw ::apache::thrift::TApplicationException(::apache::thrift::TApplicationException::MISSING_RESULT, "get_size failed: unknown result");
+}
+
+template <class Protocol_>
+void MDTrieShardClientT<Protocol_>::get_size_breakdown(std::vector<int64_t> & _return)
+{
+  send_get_size_breakdown();
+  recv_get_size_breakdown(_return);
+}
+
+template <class Protocol_>
+void MDTrieShardClientT<Protocol_>::send_get_size_breakdown()
+{
+  int32_t cseqid = 0;
+  this->oprot_->writeMessageBegin("get_size_breakdown", ::apache::thrift::protocol::T_CALL, cseqid);
+
+  MDTrieShard_get_size_breakdown_pargs args;
+  args.write(this->oprot_);
+
+  this->oprot_->writeMessageEnd();
+  this->oprot_->getTransport()->writeEnd();
+  this->oprot_->getTransport()->flush();
+}
+
+template <class Protocol_>
+void MDTrieShardClientT<Protocol_>::recv_get_size_breakdown(std::vector<int64_t> & _return)
+{
+
+  int32_t rseqid = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TMessageType mtype;
 
   this->iprot_->readMessageBegin(fname, mtype, rseqid);
   if (mtype == ::apache::thrift::protocol::T_EXCEPTION) {
@@ -1887,102 +3637,762 @@ int32_t MDTrieShardClientT<Protocol_>::recv_get_size()
     this->iprot_->getTransport()->readEnd();
     throw x;
   }
-  if (mtype != ::apache::thrift::protocol::T_REPLY) {
-    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
-    this->iprot_->readMessageEnd();
-    this->iprot_->getTransport()->readEnd();
+  if (mtype != ::apache::thrift::protocol::T_REPLY) {
+    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+  }
+  if (fname.compare("get_size_breakdown") != 0) {
+    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+    this->iprot_->readMessageEnd();
+    this->iprot_->getTransport()->readEnd();
+  }
+  MDTrieShard_get_size_breakdown_presult result;
+  result.success = &_return;
+  result.read(this->iprot_);
+  this->iprot_->readMessageEnd();
+  this->iprot_->getTransport()->readEnd();
+
+  if (result.__isset.success) {
+    // _return pointer has now been filled
+    return;
+  }
+  throw ::apache::thrift::TApplicationException(::apache::thrift::TApplicationException::MISSING_RESULT, "get_size_breakdown failed: unknown result");
+}
+
+template <class Protocol_>
+bool MDTrieShardProcessorT<Protocol_>::dispatchCall(::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, const std::string& fname, int32_t seqid, void* callContext) {
+  typename ProcessMap::iterator pfn;
+  pfn = processMap_.find(fname);
+  if (pfn == processMap_.end()) {
+    iprot->skip(::apache::thrift::protocol::T_STRUCT);
+    iprot->readMessageEnd();
+    iprot->getTransport()->readEnd();
+    ::apache::thrift::TApplicationException x(::apache::thrift::TApplicationException::UNKNOWN_METHOD, "Invalid method name: '"+fname+"'");
+    oprot->writeMessageBegin(fname, ::apache::thrift::protocol::T_EXCEPTION, seqid);
+    x.write(oprot);
+    oprot->writeMessageEnd();
+    oprot->getTransport()->writeEnd();
+    oprot->getTransport()->flush();
+    return true;
+  }
+  (this->*(pfn->second.generic))(seqid, iprot, oprot, callContext);
+  return true;
+}
+
+template <class Protocol_>
+bool MDTrieShardProcessorT<Protocol_>::dispatchCallTemplated(Protocol_* iprot, Protocol_* oprot, const std::string& fname, int32_t seqid, void* callContext) {
+  typename ProcessMap::iterator pfn;
+  pfn = processMap_.find(fname);
+  if (pfn == processMap_.end()) {
+    iprot->skip(::apache::thrift::protocol::T_STRUCT);
+    iprot->readMessageEnd();
+    iprot->getTransport()->readEnd();
+    ::apache::thrift::TApplicationException x(::apache::thrift::TApplicationException::UNKNOWN_METHOD, "Invalid method name: '"+fname+"'");
+    oprot->writeMessageBegin(fname, ::apache::thrift::protocol::T_EXCEPTION, seqid);
+    x.write(oprot);
+    oprot->writeMessageEnd();
+    oprot->getTransport()->writeEnd();
+    oprot->getTransport()->flush();
+    return true;
+  }
+  (this->*(pfn->second.specialized))(seqid, iprot, oprot, callContext);
+  return true;
+}
+
+template <class Protocol_>
+void MDTrieShardProcessorT<Protocol_>::process_ping(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext)
+{
+  void* ctx = nullptr;
+  if (this->eventHandler_.get() != nullptr) {
+    ctx = this->eventHandler_->getContext("MDTrieShard.ping", callContext);
+  }
+  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.ping");
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->preRead(ctx, "MDTrieShard.ping");
+  }
+
+  MDTrieShard_ping_args args;
+  args.read(iprot);
+  iprot->readMessageEnd();
+  uint32_t bytes = iprot->getTransport()->readEnd();
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->postRead(ctx, "MDTrieShard.ping", bytes);
+  }
+
+  MDTrieShard_ping_result result;
+  try {
+    result.success = iface_->ping(args.dataset_idx);
+    result.__isset.success = true;
+  } catch (const std::exception& e) {
+    if (this->eventHandler_.get() != nullptr) {
+      this->eventHandler_->handlerError(ctx, "MDTrieShard.ping");
+    }
+
+    ::apache::thrift::TApplicationException x(e.what());
+    oprot->writeMessageBegin("ping", ::apache::thrift::protocol::T_EXCEPTION, seqid);
+    x.write(oprot);
+    oprot->writeMessageEnd();
+    oprot->getTransport()->writeEnd();
+    oprot->getTransport()->flush();
+    return;
+  }
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->preWrite(ctx, "MDTrieShard.ping");
+  }
+
+  oprot->writeMessageBegin("ping", ::apache::thrift::protocol::T_REPLY, seqid);
+  result.write(oprot);
+  oprot->writeMessageEnd();
+  bytes = oprot->getTransport()->writeEnd();
+  oprot->getTransport()->flush();
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->postWrite(ctx, "MDTrieShard.ping", bytes);
+  }
+}
+
+template <class Protocol_>
+void MDTrieShardProcessorT<Protocol_>::process_ping(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext)
+{
+  void* ctx = nullptr;
+  if (this->eventHandler_.get() != nullptr) {
+    ctx = this->eventHandler_->getContext("MDTrieShard.ping", callContext);
+  }
+  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.ping");
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->preRead(ctx, "MDTrieShard.ping");
+  }
+
+  MDTrieShard_ping_args args;
+  args.read(iprot);
+  iprot->readMessageEnd();
+  uint32_t bytes = iprot->getTransport()->readEnd();
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->postRead(ctx, "MDTrieShard.ping", bytes);
+  }
+
+  MDTrieShard_ping_result result;
+  try {
+    result.success = iface_->ping(args.dataset_idx);
+    result.__isset.success = true;
+  } catch (const std::exception& e) {
+    if (this->eventHandler_.get() != nullptr) {
+      this->eventHandler_->handlerError(ctx, "MDTrieShard.ping");
+    }
+
+    ::apache::thrift::TApplicationException x(e.what());
+    oprot->writeMessageBegin("ping", ::apache::thrift::protocol::T_EXCEPTION, seqid);
+    x.write(oprot);
+    oprot->writeMessageEnd();
+    oprot->getTransport()->writeEnd();
+    oprot->getTransport()->flush();
+    return;
+  }
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->preWrite(ctx, "MDTrieShard.ping");
+  }
+
+  oprot->writeMessageBegin("ping", ::apache::thrift::protocol::T_REPLY, seqid);
+  result.write(oprot);
+  oprot->writeMessageEnd();
+  bytes = oprot->getTransport()->writeEnd();
+  oprot->getTransport()->flush();
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->postWrite(ctx, "MDTrieShard.ping", bytes);
+  }
+}
+
+template <class Protocol_>
+void MDTrieShardProcessorT<Protocol_>::process_insert(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext)
+{
+  void* ctx = nullptr;
+  if (this->eventHandler_.get() != nullptr) {
+    ctx = this->eventHandler_->getContext("MDTrieShard.insert", callContext);
+  }
+  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.insert");
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->preRead(ctx, "MDTrieShard.insert");
+  }
+
+  MDTrieShard_insert_args args;
+  args.read(iprot);
+  iprot->readMessageEnd();
+  uint32_t bytes = iprot->getTransport()->readEnd();
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->postRead(ctx, "MDTrieShard.insert", bytes);
+  }
+
+  MDTrieShard_insert_result result;
+  try {
+    result.success = iface_->insert(args.point, args.primary_key);
+    result.__isset.success = true;
+  } catch (const std::exception& e) {
+    if (this->eventHandler_.get() != nullptr) {
+      this->eventHandler_->handlerError(ctx, "MDTrieShard.insert");
+    }
+
+    ::apache::thrift::TApplicationException x(e.what());
+    oprot->writeMessageBegin("insert", ::apache::thrift::protocol::T_EXCEPTION, seqid);
+    x.write(oprot);
+    oprot->writeMessageEnd();
+    oprot->getTransport()->writeEnd();
+    oprot->getTransport()->flush();
+    return;
+  }
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->preWrite(ctx, "MDTrieShard.insert");
+  }
+
+  oprot->writeMessageBegin("insert", ::apache::thrift::protocol::T_REPLY, seqid);
+  result.write(oprot);
+  oprot->writeMessageEnd();
+  bytes = oprot->getTransport()->writeEnd();
+  oprot->getTransport()->flush();
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->postWrite(ctx, "MDTrieShard.insert", bytes);
+  }
+}
+
+template <class Protocol_>
+void MDTrieShardProcessorT<Protocol_>::process_insert(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext)
+{
+  void* ctx = nullptr;
+  if (this->eventHandler_.get() != nullptr) {
+    ctx = this->eventHandler_->getContext("MDTrieShard.insert", callContext);
+  }
+  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.insert");
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->preRead(ctx, "MDTrieShard.insert");
+  }
+
+  MDTrieShard_insert_args args;
+  args.read(iprot);
+  iprot->readMessageEnd();
+  uint32_t bytes = iprot->getTransport()->readEnd();
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->postRead(ctx, "MDTrieShard.insert", bytes);
+  }
+
+  MDTrieShard_insert_result result;
+  try {
+    result.success = iface_->insert(args.point, args.primary_key);
+    result.__isset.success = true;
+  } catch (const std::exception& e) {
+    if (this->eventHandler_.get() != nullptr) {
+      this->eventHandler_->handlerError(ctx, "MDTrieShard.insert");
+    }
+
+    ::apache::thrift::TApplicationException x(e.what());
+    oprot->writeMessageBegin("insert", ::apache::thrift::protocol::T_EXCEPTION, seqid);
+    x.write(oprot);
+    oprot->writeMessageEnd();
+    oprot->getTransport()->writeEnd();
+    oprot->getTransport()->flush();
+    return;
+  }
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->preWrite(ctx, "MDTrieShard.insert");
+  }
+
+  oprot->writeMessageBegin("insert", ::apache::thrift::protocol::T_REPLY, seqid);
+  result.write(oprot);
+  oprot->writeMessageEnd();
+  bytes = oprot->getTransport()->writeEnd();
+  oprot->getTransport()->flush();
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->postWrite(ctx, "MDTrieShard.insert", bytes);
+  }
+}
+
+template <class Protocol_>
+void MDTrieShardProcessorT<Protocol_>::process_insert_for_latency(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext)
+{
+  void* ctx = nullptr;
+  if (this->eventHandler_.get() != nullptr) {
+    ctx = this->eventHandler_->getContext("MDTrieShard.insert_for_latency", callContext);
+  }
+  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.insert_for_latency");
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->preRead(ctx, "MDTrieShard.insert_for_latency");
+  }
+
+  MDTrieShard_insert_for_latency_args args;
+  args.read(iprot);
+  iprot->readMessageEnd();
+  uint32_t bytes = iprot->getTransport()->readEnd();
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->postRead(ctx, "MDTrieShard.insert_for_latency", bytes);
+  }
+
+  MDTrieShard_insert_for_latency_result result;
+  try {
+    result.success = iface_->insert_for_latency(args.point, args.primary_key);
+    result.__isset.success = true;
+  } catch (const std::exception& e) {
+    if (this->eventHandler_.get() != nullptr) {
+      this->eventHandler_->handlerError(ctx, "MDTrieShard.insert_for_latency");
+    }
+
+    ::apache::thrift::TApplicationException x(e.what());
+    oprot->writeMessageBegin("insert_for_latency", ::apache::thrift::protocol::T_EXCEPTION, seqid);
+    x.write(oprot);
+    oprot->writeMessageEnd();
+    oprot->getTransport()->writeEnd();
+    oprot->getTransport()->flush();
+    return;
+  }
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->preWrite(ctx, "MDTrieShard.insert_for_latency");
+  }
+
+  oprot->writeMessageBegin("insert_for_latency", ::apache::thrift::protocol::T_REPLY, seqid);
+  result.write(oprot);
+  oprot->writeMessageEnd();
+  bytes = oprot->getTransport()->writeEnd();
+  oprot->getTransport()->flush();
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->postWrite(ctx, "MDTrieShard.insert_for_latency", bytes);
+  }
+}
+
+template <class Protocol_>
+void MDTrieShardProcessorT<Protocol_>::process_insert_for_latency(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext)
+{
+  void* ctx = nullptr;
+  if (this->eventHandler_.get() != nullptr) {
+    ctx = this->eventHandler_->getContext("MDTrieShard.insert_for_latency", callContext);
+  }
+  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.insert_for_latency");
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->preRead(ctx, "MDTrieShard.insert_for_latency");
+  }
+
+  MDTrieShard_insert_for_latency_args args;
+  args.read(iprot);
+  iprot->readMessageEnd();
+  uint32_t bytes = iprot->getTransport()->readEnd();
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->postRead(ctx, "MDTrieShard.insert_for_latency", bytes);
+  }
+
+  MDTrieShard_insert_for_latency_result result;
+  try {
+    result.success = iface_->insert_for_latency(args.point, args.primary_key);
+    result.__isset.success = true;
+  } catch (const std::exception& e) {
+    if (this->eventHandler_.get() != nullptr) {
+      this->eventHandler_->handlerError(ctx, "MDTrieShard.insert_for_latency");
+    }
+
+    ::apache::thrift::TApplicationException x(e.what());
+    oprot->writeMessageBegin("insert_for_latency", ::apache::thrift::protocol::T_EXCEPTION, seqid);
+    x.write(oprot);
+    oprot->writeMessageEnd();
+    oprot->getTransport()->writeEnd();
+    oprot->getTransport()->flush();
+    return;
+  }
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->preWrite(ctx, "MDTrieShard.insert_for_latency");
+  }
+
+  oprot->writeMessageBegin("insert_for_latency", ::apache::thrift::protocol::T_REPLY, seqid);
+  result.write(oprot);
+  oprot->writeMessageEnd();
+  bytes = oprot->getTransport()->writeEnd();
+  oprot->getTransport()->flush();
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->postWrite(ctx, "MDTrieShard.insert_for_latency", bytes);
+  }
+}
+
+template <class Protocol_>
+void MDTrieShardProcessorT<Protocol_>::process_check(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext)
+{
+  void* ctx = nullptr;
+  if (this->eventHandler_.get() != nullptr) {
+    ctx = this->eventHandler_->getContext("MDTrieShard.check", callContext);
+  }
+  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.check");
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->preRead(ctx, "MDTrieShard.check");
+  }
+
+  MDTrieShard_check_args args;
+  args.read(iprot);
+  iprot->readMessageEnd();
+  uint32_t bytes = iprot->getTransport()->readEnd();
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->postRead(ctx, "MDTrieShard.check", bytes);
+  }
+
+  MDTrieShard_check_result result;
+  try {
+    result.success = iface_->check(args.point);
+    result.__isset.success = true;
+  } catch (const std::exception& e) {
+    if (this->eventHandler_.get() != nullptr) {
+      this->eventHandler_->handlerError(ctx, "MDTrieShard.check");
+    }
+
+    ::apache::thrift::TApplicationException x(e.what());
+    oprot->writeMessageBegin("check", ::apache::thrift::protocol::T_EXCEPTION, seqid);
+    x.write(oprot);
+    oprot->writeMessageEnd();
+    oprot->getTransport()->writeEnd();
+    oprot->getTransport()->flush();
+    return;
+  }
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->preWrite(ctx, "MDTrieShard.check");
+  }
+
+  oprot->writeMessageBegin("check", ::apache::thrift::protocol::T_REPLY, seqid);
+  result.write(oprot);
+  oprot->writeMessageEnd();
+  bytes = oprot->getTransport()->writeEnd();
+  oprot->getTransport()->flush();
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->postWrite(ctx, "MDTrieShard.check", bytes);
+  }
+}
+
+template <class Protocol_>
+void MDTrieShardProcessorT<Protocol_>::process_check(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext)
+{
+  void* ctx = nullptr;
+  if (this->eventHandler_.get() != nullptr) {
+    ctx = this->eventHandler_->getContext("MDTrieShard.check", callContext);
+  }
+  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.check");
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->preRead(ctx, "MDTrieShard.check");
+  }
+
+  MDTrieShard_check_args args;
+  args.read(iprot);
+  iprot->readMessageEnd();
+  uint32_t bytes = iprot->getTransport()->readEnd();
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->postRead(ctx, "MDTrieShard.check", bytes);
+  }
+
+  MDTrieShard_check_result result;
+  try {
+    result.success = iface_->check(args.point);
+    result.__isset.success = true;
+  } catch (const std::exception& e) {
+    if (this->eventHandler_.get() != nullptr) {
+      this->eventHandler_->handlerError(ctx, "MDTrieShard.check");
+    }
+
+    ::apache::thrift::TApplicationException x(e.what());
+    oprot->writeMessageBegin("check", ::apache::thrift::protocol::T_EXCEPTION, seqid);
+    x.write(oprot);
+    oprot->writeMessageEnd();
+    oprot->getTransport()->writeEnd();
+    oprot->getTransport()->flush();
+    return;
+  }
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->preWrite(ctx, "MDTrieShard.check");
+  }
+
+  oprot->writeMessageBegin("check", ::apache::thrift::protocol::T_REPLY, seqid);
+  result.write(oprot);
+  oprot->writeMessageEnd();
+  bytes = oprot->getTransport()->writeEnd();
+  oprot->getTransport()->flush();
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->postWrite(ctx, "MDTrieShard.check", bytes);
+  }
+}
+
+template <class Protocol_>
+void MDTrieShardProcessorT<Protocol_>::process_range_search(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext)
+{
+  void* ctx = nullptr;
+  if (this->eventHandler_.get() != nullptr) {
+    ctx = this->eventHandler_->getContext("MDTrieShard.range_search", callContext);
+  }
+  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.range_search");
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->preRead(ctx, "MDTrieShard.range_search");
+  }
+
+  MDTrieShard_range_search_args args;
+  args.read(iprot);
+  iprot->readMessageEnd();
+  uint32_t bytes = iprot->getTransport()->readEnd();
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->postRead(ctx, "MDTrieShard.range_search", bytes);
+  }
+
+  MDTrieShard_range_search_result result;
+  try {
+    iface_->range_search(result.success, args.start_range, args.end_range, args.result_mode);
+    result.__isset.success = true;
+  } catch (const std::exception& e) {
+    if (this->eventHandler_.get() != nullptr) {
+      this->eventHandler_->handlerError(ctx, "MDTrieShard.range_search");
+    }
+
+    ::apache::thrift::TApplicationException x(e.what());
+    oprot->writeMessageBegin("range_search", ::apache::thrift::protocol::T_EXCEPTION, seqid);
+    x.write(oprot);
+    oprot->writeMessageEnd();
+    oprot->getTransport()->writeEnd();
+    oprot->getTransport()->flush();
+    return;
+  }
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->preWrite(ctx, "MDTrieShard.range_search");
+  }
+
+  oprot->writeMessageBegin("range_search", ::apache::thrift::protocol::T_REPLY, seqid);
+  result.write(oprot);
+  oprot->writeMessageEnd();
+  bytes = oprot->getTransport()->writeEnd();
+  oprot->getTransport()->flush();
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->postWrite(ctx, "MDTrieShard.range_search", bytes);
+  }
+}
+
+template <class Protocol_>
+void MDTrieShardProcessorT<Protocol_>::process_range_search(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext)
+{
+  void* ctx = nullptr;
+  if (this->eventHandler_.get() != nullptr) {
+    ctx = this->eventHandler_->getContext("MDTrieShard.range_search", callContext);
+  }
+  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.range_search");
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->preRead(ctx, "MDTrieShard.range_search");
   }
-  if (fname.compare("get_size") != 0) {
-    this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
-    this->iprot_->readMessageEnd();
-    this->iprot_->getTransport()->readEnd();
+
+  MDTrieShard_range_search_args args;
+  args.read(iprot);
+  iprot->readMessageEnd();
+  uint32_t bytes = iprot->getTransport()->readEnd();
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->postRead(ctx, "MDTrieShard.range_search", bytes);
   }
-  int32_t _return;
-  MDTrieShard_get_size_presult result;
-  result.success = &_return;
-  result.read(this->iprot_);
-  this->iprot_->readMessageEnd();
-  this->iprot_->getTransport()->readEnd();
 
-  if (result.__isset.success) {
-    return _return;
+  MDTrieShard_range_search_result result;
+  try {
+    iface_->range_search(result.success, args.start_range, args.end_range, args.result_mode);
+    result.__isset.success = true;
+  } catch (const std::exception& e) {
+    if (this->eventHandler_.get() != nullptr) {
+      this->eventHandler_->handlerError(ctx, "MDTrieShard.range_search");
+    }
+
+    ::apache::thrift::TApplicationException x(e.what());
+    oprot->writeMessageBegin("range_search", ::apache::thrift::protocol::T_EXCEPTION, seqid);
+    x.write(oprot);
+    oprot->writeMessageEnd();
+    oprot->getTransport()->writeEnd();
+    oprot->getTransport()->flush();
+    return;
+  }
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->preWrite(ctx, "MDTrieShard.range_search");
+  }
+
+  oprot->writeMessageBegin("range_search", ::apache::thrift::protocol::T_REPLY, seqid);
+  result.write(oprot);
+  oprot->writeMessageEnd();
+  bytes = oprot->getTransport()->writeEnd();
+  oprot->getTransport()->flush();
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->postWrite(ctx, "MDTrieShard.range_search", bytes);
   }
-  throw ::apache::thrift::TApplicationException(::apache::thrift::TApplicationException::MISSING_RESULT, "get_size failed: unknown result");
 }
 
 template <class Protocol_>
-bool MDTrieShardProcessorT<Protocol_>::dispatchCall(::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, const std::string& fname, int32_t seqid, void* callContext) {
-  typename ProcessMap::iterator pfn;
-  pfn = processMap_.find(fname);
-  if (pfn == processMap_.end()) {
-    iprot->skip(::apache::thrift::protocol::T_STRUCT);
-    iprot->readMessageEnd();
-    iprot->getTransport()->readEnd();
-    ::apache::thrift::TApplicationException x(::apache::thrift::TApplicationException::UNKNOWN_METHOD, "Invalid method name: '"+fname+"'");
-    oprot->writeMessageBegin(fname, ::apache::thrift::protocol::T_EXCEPTION, seqid);
+void MDTrieShardProcessorT<Protocol_>::process_range_search_page(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext)
+{
+  void* ctx = nullptr;
+  if (this->eventHandler_.get() != nullptr) {
+    ctx = this->eventHandler_->getContext("MDTrieShard.range_search_page", callContext);
+  }
+  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.range_search_page");
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->preRead(ctx, "MDTrieShard.range_search_page");
+  }
+
+  MDTrieShard_range_search_page_args args;
+  args.read(iprot);
+  iprot->readMessageEnd();
+  uint32_t bytes = iprot->getTransport()->readEnd();
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->postRead(ctx, "MDTrieShard.range_search_page", bytes);
+  }
+
+  MDTrieShard_range_search_page_result result;
+  try {
+    iface_->range_search_page(result.success, args.start_range, args.end_range, args.resume_after, args.limit, args.result_mode);
+    result.__isset.success = true;
+  } catch (const std::exception& e) {
+    if (this->eventHandler_.get() != nullptr) {
+      this->eventHandler_->handlerError(ctx, "MDTrieShard.range_search_page");
+    }
+
+    ::apache::thrift::TApplicationException x(e.what());
+    oprot->writeMessageBegin("range_search_page", ::apache::thrift::protocol::T_EXCEPTION, seqid);
     x.write(oprot);
     oprot->writeMessageEnd();
     oprot->getTransport()->writeEnd();
     oprot->getTransport()->flush();
-    return true;
+    return;
+  }
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->preWrite(ctx, "MDTrieShard.range_search_page");
+  }
+
+  oprot->writeMessageBegin("range_search_page", ::apache::thrift::protocol::T_REPLY, seqid);
+  result.write(oprot);
+  oprot->writeMessageEnd();
+  bytes = oprot->getTransport()->writeEnd();
+  oprot->getTransport()->flush();
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->postWrite(ctx, "MDTrieShard.range_search_page", bytes);
   }
-  (this->*(pfn->second.generic))(seqid, iprot, oprot, callContext);
-  return true;
 }
 
 template <class Protocol_>
-bool MDTrieShardProcessorT<Protocol_>::dispatchCallTemplated(Protocol_* iprot, Protocol_* oprot, const std::string& fname, int32_t seqid, void* callContext) {
-  typename ProcessMap::iterator pfn;
-  pfn = processMap_.find(fname);
-  if (pfn == processMap_.end()) {
-    iprot->skip(::apache::thrift::protocol::T_STRUCT);
-    iprot->readMessageEnd();
-    iprot->getTransport()->readEnd();
-    ::apache::thrift::TApplicationException x(::apache::thrift::TApplicationException::UNKNOWN_METHOD, "Invalid method name: '"+fname+"'");
-    oprot->writeMessageBegin(fname, ::apache::thrift::protocol::T_EXCEPTION, seqid);
+void MDTrieShardProcessorT<Protocol_>::process_range_search_page(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext)
+{
+  void* ctx = nullptr;
+  if (this->eventHandler_.get() != nullptr) {
+    ctx = this->eventHandler_->getContext("MDTrieShard.range_search_page", callContext);
+  }
+  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.range_search_page");
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->preRead(ctx, "MDTrieShard.range_search_page");
+  }
+
+  MDTrieShard_range_search_page_args args;
+  args.read(iprot);
+  iprot->readMessageEnd();
+  uint32_t bytes = iprot->getTransport()->readEnd();
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->postRead(ctx, "MDTrieShard.range_search_page", bytes);
+  }
+
+  MDTrieShard_range_search_page_result result;
+  try {
+    iface_->range_search_page(result.success, args.start_range, args.end_range, args.resume_after, args.limit, args.result_mode);
+    result.__isset.success = true;
+  } catch (const std::exception& e) {
+    if (this->eventHandler_.get() != nullptr) {
+      this->eventHandler_->handlerError(ctx, "MDTrieShard.range_search_page");
+    }
+
+    ::apache::thrift::TApplicationException x(e.what());
+    oprot->writeMessageBegin("range_search_page", ::apache::thrift::protocol::T_EXCEPTION, seqid);
     x.write(oprot);
     oprot->writeMessageEnd();
     oprot->getTransport()->writeEnd();
     oprot->getTransport()->flush();
-    return true;
+    return;
+  }
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->preWrite(ctx, "MDTrieShard.range_search_page");
+  }
+
+  oprot->writeMessageBegin("range_search_page", ::apache::thrift::protocol::T_REPLY, seqid);
+  result.write(oprot);
+  oprot->writeMessageEnd();
+  bytes = oprot->getTransport()->writeEnd();
+  oprot->getTransport()->flush();
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->postWrite(ctx, "MDTrieShard.range_search_page", bytes);
   }
-  (this->*(pfn->second.specialized))(seqid, iprot, oprot, callContext);
-  return true;
 }
 
 template <class Protocol_>
-void MDTrieShardProcessorT<Protocol_>::process_ping(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext)
+void MDTrieShardProcessorT<Protocol_>::process_range_search_aggregate(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext)
 {
   void* ctx = nullptr;
   if (this->eventHandler_.get() != nullptr) {
-    ctx = this->eventHandler_->getContext("MDTrieShard.ping", callContext);
+    ctx = this->eventHandler_->getContext("MDTrieShard.range_search_aggregate", callContext);
   }
-  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.ping");
+  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.range_search_aggregate");
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->preRead(ctx, "MDTrieShard.ping");
+    this->eventHandler_->preRead(ctx, "MDTrieShard.range_search_aggregate");
   }
 
-  MDTrieShard_ping_args args;
+  MDTrieShard_range_search_aggregate_args args;
   args.read(iprot);
   iprot->readMessageEnd();
   uint32_t bytes = iprot->getTransport()->readEnd();
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->postRead(ctx, "MDTrieShard.ping", bytes);
+    this->eventHandler_->postRead(ctx, "MDTrieShard.range_search_aggregate", bytes);
   }
 
-  MDTrieShard_ping_result result;
+  MDTrieShard_range_search_aggregate_result result;
   try {
-    result.success = iface_->ping(args.dataset_idx);
+    iface_->range_search_aggregate(result.success, args.start_range, args.end_range, args.dimensions);
     result.__isset.success = true;
   } catch (const std::exception& e) {
     if (this->eventHandler_.get() != nullptr) {
-      this->eventHandler_->handlerError(ctx, "MDTrieShard.ping");
+      this->eventHandler_->handlerError(ctx, "MDTrieShard.range_search_aggregate");
     }
 
     ::apache::thrift::TApplicationException x(e.what());
-    oprot->writeMessageBegin("ping", ::apache::thrift::protocol::T_EXCEPTION, seqid);
+    oprot->writeMessageBegin("range_search_aggregate", ::apache::thrift::protocol::T_EXCEPTION, seqid);
     x.write(oprot);
     oprot->writeMessageEnd();
     oprot->getTransport()->writeEnd();
@@ -1991,53 +4401,53 @@ void MDTrieShardProcessorT<Protocol_>::process_ping(int32_t seqid, ::apache::thr
   }
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->preWrite(ctx, "MDTrieShard.ping");
+    this->eventHandler_->preWrite(ctx, "MDTrieShard.range_search_aggregate");
   }
 
-  oprot->writeMessageBegin("ping", ::apache::thrift::protocol::T_REPLY, seqid);
+  oprot->writeMessageBegin("range_search_aggregate", ::apache::thrift::protocol::T_REPLY, seqid);
   result.write(oprot);
   oprot->writeMessageEnd();
   bytes = oprot->getTransport()->writeEnd();
   oprot->getTransport()->flush();
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->postWrite(ctx, "MDTrieShard.ping", bytes);
+    this->eventHandler_->postWrite(ctx, "MDTrieShard.range_search_aggregate", bytes);
   }
 }
 
 template <class Protocol_>
-void MDTrieShardProcessorT<Protocol_>::process_ping(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext)
+void MDTrieShardProcessorT<Protocol_>::process_range_search_aggregate(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext)
 {
   void* ctx = nullptr;
   if (this->eventHandler_.get() != nullptr) {
-    ctx = this->eventHandler_->getContext("MDTrieShard.ping", callContext);
+    ctx = this->eventHandler_->getContext("MDTrieShard.range_search_aggregate", callContext);
   }
-  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.ping");
+  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.range_search_aggregate");
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->preRead(ctx, "MDTrieShard.ping");
+    this->eventHandler_->preRead(ctx, "MDTrieShard.range_search_aggregate");
   }
 
-  MDTrieShard_ping_args args;
+  MDTrieShard_range_search_aggregate_args args;
   args.read(iprot);
   iprot->readMessageEnd();
   uint32_t bytes = iprot->getTransport()->readEnd();
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->postRead(ctx, "MDTrieShard.ping", bytes);
+    this->eventHandler_->postRead(ctx, "MDTrieShard.range_search_aggregate", bytes);
   }
 
-  MDTrieShard_ping_result result;
+  MDTrieShard_range_search_aggregate_result result;
   try {
-    result.success = iface_->ping(args.dataset_idx);
+    iface_->range_search_aggregate(result.success, args.start_range, args.end_range, args.dimensions);
     result.__isset.success = true;
   } catch (const std::exception& e) {
     if (this->eventHandler_.get() != nullptr) {
-      this->eventHandler_->handlerError(ctx, "MDTrieShard.ping");
+      this->eventHandler_->handlerError(ctx, "MDTrieShard.range_search_aggregate");
     }
 
     ::apache::thrift::TApplicationException x(e.what());
-    oprot->writeMessageBegin("ping", ::apache::thrift::protocol::T_EXCEPTION, seqid);
+    oprot->writeMessageBegin("range_search_aggregate", ::apache::thrift::protocol::T_EXCEPTION, seqid);
     x.write(oprot);
     oprot->writeMessageEnd();
     oprot->getTransport()->writeEnd();
@@ -2046,53 +4456,53 @@ void MDTrieShardProcessorT<Protocol_>::process_ping(int32_t seqid, Protocol_* ip
   }
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->preWrite(ctx, "MDTrieShard.ping");
+    this->eventHandler_->preWrite(ctx, "MDTrieShard.range_search_aggregate");
   }
 
-  oprot->writeMessageBegin("ping", ::apache::thrift::protocol::T_REPLY, seqid);
+  oprot->writeMessageBegin("range_search_aggregate", ::apache::thrift::protocol::T_REPLY, seqid);
   result.write(oprot);
   oprot->writeMessageEnd();
   bytes = oprot->getTransport()->writeEnd();
   oprot->getTransport()->flush();
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->postWrite(ctx, "MDTrieShard.ping", bytes);
+    this->eventHandler_->postWrite(ctx, "MDTrieShard.range_search_aggregate", bytes);
   }
 }
 
 template <class Protocol_>
-void MDTrieShardProcessorT<Protocol_>::process_insert(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext)
+void MDTrieShardProcessorT<Protocol_>::process_knn_search(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext)
 {
   void* ctx = nullptr;
   if (this->eventHandler_.get() != nullptr) {
-    ctx = this->eventHandler_->getContext("MDTrieShard.insert", callContext);
+    ctx = this->eventHandler_->getContext("MDTrieShard.knn_search", callContext);
   }
-  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.insert");
+  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.knn_search");
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->preRead(ctx, "MDTrieShard.insert");
+    this->eventHandler_->preRead(ctx, "MDTrieShard.knn_search");
   }
 
-  MDTrieShard_insert_args args;
+  MDTrieShard_knn_search_args args;
   args.read(iprot);
   iprot->readMessageEnd();
   uint32_t bytes = iprot->getTransport()->readEnd();
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->postRead(ctx, "MDTrieShard.insert", bytes);
+    this->eventHandler_->postRead(ctx, "MDTrieShard.knn_search", bytes);
   }
 
-  MDTrieShard_insert_result result;
+  MDTrieShard_knn_search_result result;
   try {
-    result.success = iface_->insert(args.point, args.primary_key);
+    iface_->knn_search(result.success, args.point, args.k, args.metric, args.weights);
     result.__isset.success = true;
   } catch (const std::exception& e) {
     if (this->eventHandler_.get() != nullptr) {
-      this->eventHandler_->handlerError(ctx, "MDTrieShard.insert");
+      this->eventHandler_->handlerError(ctx, "MDTrieShard.knn_search");
     }
 
     ::apache::thrift::TApplicationException x(e.what());
-    oprot->writeMessageBegin("insert", ::apache::thrift::protocol::T_EXCEPTION, seqid);
+    oprot->writeMessageBegin("knn_search", ::apache::thrift::protocol::T_EXCEPTION, seqid);
     x.write(oprot);
     oprot->writeMessageEnd();
     oprot->getTransport()->writeEnd();
@@ -2101,53 +4511,108 @@ void MDTrieShardProcessorT<Protocol_>::process_insert(int32_t seqid, ::apache::t
   }
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->preWrite(ctx, "MDTrieShard.insert");
+    this->eventHandler_->preWrite(ctx, "MDTrieShard.knn_search");
   }
 
-  oprot->writeMessageBegin("insert", ::apache::thrift::protocol::T_REPLY, seqid);
+  oprot->writeMessageBegin("knn_search", ::apache::thrift::protocol::T_REPLY, seqid);
   result.write(oprot);
   oprot->writeMessageEnd();
   bytes = oprot->getTransport()->writeEnd();
   oprot->getTransport()->flush();
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->postWrite(ctx, "MDTrieShard.insert", bytes);
+    this->eventHandler_->postWrite(ctx, "MDTrieShard.knn_search", bytes);
   }
 }
 
 template <class Protocol_>
-void MDTrieShardProcessorT<Protocol_>::process_insert(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext)
+void MDTrieShardProcessorT<Protocol_>::process_knn_search(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext)
 {
   void* ctx = nullptr;
   if (this->eventHandler_.get() != nullptr) {
-    ctx = this->eventHandler_->getContext("MDTrieShard.insert", callContext);
+    ctx = this->eventHandler_->getContext("MDTrieShard.knn_search", callContext);
   }
-  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.insert");
+  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.knn_search");
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->preRead(ctx, "MDTrieShard.insert");
+    this->eventHandler_->preRead(ctx, "MDTrieShard.knn_search");
   }
 
-  MDTrieShard_insert_args args;
+  MDTrieShard_knn_search_args args;
   args.read(iprot);
   iprot->readMessageEnd();
   uint32_t bytes = iprot->getTransport()->readEnd();
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->postRead(ctx, "MDTrieShard.insert", bytes);
+    this->eventHandler_->postRead(ctx, "MDTrieShard.knn_search", bytes);
   }
 
-  MDTrieShard_insert_result result;
+  MDTrieShard_knn_search_result result;
   try {
-    result.success = iface_->insert(args.point, args.primary_key);
+    iface_->knn_search(result.success, args.point, args.k, args.metric, args.weights);
     result.__isset.success = true;
   } catch (const std::exception& e) {
     if (this->eventHandler_.get() != nullptr) {
-      this->eventHandler_->handlerError(ctx, "MDTrieShard.insert");
+      this->eventHandler_->handlerError(ctx, "MDTrieShard.knn_search");
+    }
+
+    ::apache::thrift::TApplicationException x(e.what());
+    oprot->writeMessageBegin("knn_search", ::apache::thrift::protocol::T_EXCEPTION, seqid);
+    x.write(oprot);
+    oprot->writeMessageEnd();
+    oprot->getTransport()->writeEnd();
+    oprot->getTransport()->flush();
+    return;
+  }
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->preWrite(ctx, "MDTrieShard.knn_search");
+  }
+
+  oprot->writeMessageBegin("knn_search", ::apache::thrift::protocol::T_REPLY, seqid);
+  result.write(oprot);
+  oprot->writeMessageEnd();
+  bytes = oprot->getTransport()->writeEnd();
+  oprot->getTransport()->flush();
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->postWrite(ctx, "MDTrieShard.knn_search", bytes);
+  }
+}
+
+template <class Protocol_>
+void MDTrieShardProcessorT<Protocol_>::process_primary_key_lookup(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext)
+{
+  void* ctx = nullptr;
+  if (this->eventHandler_.get() != nullptr) {
+    ctx = this->eventHandler_->getContext("MDTrieShard.primary_key_lookup", callContext);
+  }
+  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.primary_key_lookup");
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->preRead(ctx, "MDTrieShard.primary_key_lookup");
+  }
+
+  MDTrieShard_primary_key_lookup_args args;
+  args.read(iprot);
+  iprot->readMessageEnd();
+  uint32_t bytes = iprot->getTransport()->readEnd();
+
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->postRead(ctx, "MDTrieShard.primary_key_lookup", bytes);
+  }
+
+  MDTrieShard_primary_key_lookup_result result;
+  try {
+    iface_->primary_key_lookup(result.success, args.primary_key);
+    result.__isset.success = true;
+  } catch (const std::exception& e) {
+    if (this->eventHandler_.get() != nullptr) {
+      this->eventHandler_->handlerError(ctx, "MDTrieShard.primary_key_lookup");
     }
 
     ::apache::thrift::TApplicationException x(e.what());
-    oprot->writeMessageBegin("insert", ::apache::thrift::protocol::T_EXCEPTION, seqid);
+    oprot->writeMessageBegin("primary_key_lookup", ::apache::thrift::protocol::T_EXCEPTION, seqid);
     x.write(oprot);
     oprot->writeMessageEnd();
     oprot->getTransport()->writeEnd();
@@ -2156,53 +4621,53 @@ void MDTrieShardProcessorT<Protocol_>::process_insert(int32_t seqid, Protocol_*
   }
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->preWrite(ctx, "MDTrieShard.insert");
+    this->eventHandler_->preWrite(ctx, "MDTrieShard.primary_key_lookup");
   }
 
-  oprot->writeMessageBegin("insert", ::apache::thrift::protocol::T_REPLY, seqid);
+  oprot->writeMessageBegin("primary_key_lookup", ::apache::thrift::protocol::T_REPLY, seqid);
   result.write(oprot);
   oprot->writeMessageEnd();
   bytes = oprot->getTransport()->writeEnd();
   oprot->getTransport()->flush();
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->postWrite(ctx, "MDTrieShard.insert", bytes);
+    this->eventHandler_->postWrite(ctx, "MDTrieShard.primary_key_lookup", bytes);
   }
 }
 
 template <class Protocol_>
-void MDTrieShardProcessorT<Protocol_>::process_insert_for_latency(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext)
+void MDTrieShardProcessorT<Protocol_>::process_primary_key_lookup(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext)
 {
   void* ctx = nullptr;
   if (this->eventHandler_.get() != nullptr) {
-    ctx = this->eventHandler_->getContext("MDTrieShard.insert_for_latency", callContext);
+    ctx = this->eventHandler_->getContext("MDTrieShard.primary_key_lookup", callContext);
   }
-  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.insert_for_latency");
+  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.primary_key_lookup");
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->preRead(ctx, "MDTrieShard.insert_for_latency");
+    this->eventHandler_->preRead(ctx, "MDTrieShard.primary_key_lookup");
   }
 
-  MDTrieShard_insert_for_latency_args args;
+  MDTrieShard_primary_key_lookup_args args;
   args.read(iprot);
   iprot->readMessageEnd();
   uint32_t bytes = iprot->getTransport()->readEnd();
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->postRead(ctx, "MDTrieShard.insert_for_latency", bytes);
+    this->eventHandler_->postRead(ctx, "MDTrieShard.primary_key_lookup", bytes);
   }
 
-  MDTrieShard_insert_for_latency_result result;
+  MDTrieShard_primary_key_lookup_result result;
   try {
-    result.success = iface_->insert_for_latency(args.point, args.primary_key);
+    iface_->primary_key_lookup(result.success, args.primary_key);
     result.__isset.success = true;
   } catch (const std::exception& e) {
     if (this->eventHandler_.get() != nullptr) {
-      this->eventHandler_->handlerError(ctx, "MDTrieShard.insert_for_latency");
+      this->eventHandler_->handlerError(ctx, "MDTrieShard.primary_key_lookup");
     }
 
     ::apache::thrift::TApplicationException x(e.what());
-    oprot->writeMessageBegin("insert_for_latency", ::apache::thrift::protocol::T_EXCEPTION, seqid);
+    oprot->writeMessageBegin("primary_key_lookup", ::apache::thrift::protocol::T_EXCEPTION, seqid);
     x.write(oprot);
     oprot->writeMessageEnd();
     oprot->getTransport()->writeEnd();
@@ -2211,53 +4676,53 @@ void MDTrieShardProcessorT<Protocol_>::process_insert_for_latency(int32_t seqid,
   }
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->preWrite(ctx, "MDTrieShard.insert_for_latency");
+    this->eventHandler_->preWrite(ctx, "MDTrieShard.primary_key_lookup");
   }
 
-  oprot->writeMessageBegin("insert_for_latency", ::apache::thrift::protocol::T_REPLY, seqid);
+  oprot->writeMessageBegin("primary_key_lookup", ::apache::thrift::protocol::T_REPLY, seqid);
   result.write(oprot);
   oprot->writeMessageEnd();
   bytes = oprot->getTransport()->writeEnd();
   oprot->getTransport()->flush();
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->postWrite(ctx, "MDTrieShard.insert_for_latency", bytes);
+    this->eventHandler_->postWrite(ctx, "MDTrieShard.primary_key_lookup", bytes);
   }
 }
 
 template <class Protocol_>
-void MDTrieShardProcessorT<Protocol_>::process_insert_for_latency(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext)
+void MDTrieShardProcessorT<Protocol_>::process_primary_key_lookup_batch(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext)
 {
   void* ctx = nullptr;
   if (this->eventHandler_.get() != nullptr) {
-    ctx = this->eventHandler_->getContext("MDTrieShard.insert_for_latency", callContext);
+    ctx = this->eventHandler_->getContext("MDTrieShard.primary_key_lookup_batch", callContext);
   }
-  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.insert_for_latency");
+  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.primary_key_lookup_batch");
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->preRead(ctx, "MDTrieShard.insert_for_latency");
+    this->eventHandler_->preRead(ctx, "MDTrieShard.primary_key_lookup_batch");
   }
 
-  MDTrieShard_insert_for_latency_args args;
+  MDTrieShard_primary_key_lookup_batch_args args;
   args.read(iprot);
   iprot->readMessageEnd();
   uint32_t bytes = iprot->getTransport()->readEnd();
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->postRead(ctx, "MDTrieShard.insert_for_latency", bytes);
+    this->eventHandler_->postRead(ctx, "MDTrieShard.primary_key_lookup_batch", bytes);
   }
 
-  MDTrieShard_insert_for_latency_result result;
+  MDTrieShard_primary_key_lookup_batch_result result;
   try {
-    result.success = iface_->insert_for_latency(args.point, args.primary_key);
+    iface_->primary_key_lookup_batch(result.success, args.primary_keys);
     result.__isset.success = true;
   } catch (const std::exception& e) {
     if (this->eventHandler_.get() != nullptr) {
-      this->eventHandler_->handlerError(ctx, "MDTrieShard.insert_for_latency");
+      this->eventHandler_->handlerError(ctx, "MDTrieShard.primary_key_lookup_batch");
     }
 
     ::apache::thrift::TApplicationException x(e.what());
-    oprot->writeMessageBegin("insert_for_latency", ::apache::thrift::protocol::T_EXCEPTION, seqid);
+    oprot->writeMessageBegin("primary_key_lookup_batch", ::apache::thrift::protocol::T_EXCEPTION, seqid);
     x.write(oprot);
     oprot->writeMessageEnd();
     oprot->getTransport()->writeEnd();
@@ -2266,53 +4731,53 @@ void MDTrieShardProcessorT<Protocol_>::process_insert_for_latency(int32_t seqid,
   }
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->preWrite(ctx, "MDTrieShard.insert_for_latency");
+    this->eventHandler_->preWrite(ctx, "MDTrieShard.primary_key_lookup_batch");
   }
 
-  oprot->writeMessageBegin("insert_for_latency", ::apache::thrift::protocol::T_REPLY, seqid);
+  oprot->writeMessageBegin("primary_key_lookup_batch", ::apache::thrift::protocol::T_REPLY, seqid);
   result.write(oprot);
   oprot->writeMessageEnd();
   bytes = oprot->getTransport()->writeEnd();
   oprot->getTransport()->flush();
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->postWrite(ctx, "MDTrieShard.insert_for_latency", bytes);
+    this->eventHandler_->postWrite(ctx, "MDTrieShard.primary_key_lookup_batch", bytes);
   }
 }
 
 template <class Protocol_>
-void MDTrieShardProcessorT<Protocol_>::process_check(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext)
+void MDTrieShardProcessorT<Protocol_>::process_primary_key_lookup_batch(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext)
 {
   void* ctx = nullptr;
   if (this->eventHandler_.get() != nullptr) {
-    ctx = this->eventHandler_->getContext("MDTrieShard.check", callContext);
+    ctx = this->eventHandler_->getContext("MDTrieShard.primary_key_lookup_batch", callContext);
   }
-  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.check");
+  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.primary_key_lookup_batch");
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->preRead(ctx, "MDTrieShard.check");
+    this->eventHandler_->preRead(ctx, "MDTrieShard.primary_key_lookup_batch");
   }
 
-  MDTrieShard_check_args args;
+  MDTrieShard_primary_key_lookup_batch_args args;
   args.read(iprot);
   iprot->readMessageEnd();
   uint32_t bytes = iprot->getTransport()->readEnd();
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->postRead(ctx, "MDTrieShard.check", bytes);
+    this->eventHandler_->postRead(ctx, "MDTrieShard.primary_key_lookup_batch", bytes);
   }
 
-  MDTrieShard_check_result result;
+  MDTrieShard_primary_key_lookup_batch_result result;
   try {
-    result.success = iface_->check(args.point);
+    iface_->primary_key_lookup_batch(result.success, args.primary_keys);
     result.__isset.success = true;
   } catch (const std::exception& e) {
     if (this->eventHandler_.get() != nullptr) {
-      this->eventHandler_->handlerError(ctx, "MDTrieShard.check");
+      this->eventHandler_->handlerError(ctx, "MDTrieShard.primary_key_lookup_batch");
     }
 
     ::apache::thrift::TApplicationException x(e.what());
-    oprot->writeMessageBegin("check", ::apache::thrift::protocol::T_EXCEPTION, seqid);
+    oprot->writeMessageBegin("primary_key_lookup_batch", ::apache::thrift::protocol::T_EXCEPTION, seqid);
     x.write(oprot);
     oprot->writeMessageEnd();
     oprot->getTransport()->writeEnd();
@@ -2321,53 +4786,53 @@ void MDTrieShardProcessorT<Protocol_>::process_check(int32_t seqid, ::apache::th
   }
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->preWrite(ctx, "MDTrieShard.check");
+    this->eventHandler_->preWrite(ctx, "MDTrieShard.primary_key_lookup_batch");
   }
 
-  oprot->writeMessageBegin("check", ::apache::thrift::protocol::T_REPLY, seqid);
+  oprot->writeMessageBegin("primary_key_lookup_batch", ::apache::thrift::protocol::T_REPLY, seqid);
   result.write(oprot);
   oprot->writeMessageEnd();
   bytes = oprot->getTransport()->writeEnd();
   oprot->getTransport()->flush();
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->postWrite(ctx, "MDTrieShard.check", bytes);
+    this->eventHandler_->postWrite(ctx, "MDTrieShard.primary_key_lookup_batch", bytes);
   }
 }
 
 template <class Protocol_>
-void MDTrieShardProcessorT<Protocol_>::process_check(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext)
+void MDTrieShardProcessorT<Protocol_>::process_get_size(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext)
 {
   void* ctx = nullptr;
   if (this->eventHandler_.get() != nullptr) {
-    ctx = this->eventHandler_->getContext("MDTrieShard.check", callContext);
+    ctx = this->eventHandler_->getContext("MDTrieShard.get_size", callContext);
   }
-  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.check");
+  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.get_size");
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->preRead(ctx, "MDTrieShard.check");
+    this->eventHandler_->preRead(ctx, "MDTrieShard.get_size");
   }
 
-  MDTrieShard_check_args args;
+  MDTrieShard_get_size_args args;
   args.read(iprot);
   iprot->readMessageEnd();
   uint32_t bytes = iprot->getTransport()->readEnd();
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->postRead(ctx, "MDTrieShard.check", bytes);
+    this->eventHandler_->postRead(ctx, "MDTrieShard.get_size", bytes);
   }
 
-  MDTrieShard_check_result result;
+  MDTrieShard_get_size_result result;
   try {
-    result.success = iface_->check(args.point);
+    result.success = iface_->get_size();
     result.__isset.success = true;
   } catch (const std::exception& e) {
     if (this->eventHandler_.get() != nullptr) {
-      this->eventHandler_->handlerError(ctx, "MDTrieShard.check");
+      this->eventHandler_->handlerError(ctx, "MDTrieShard.get_size");
     }
 
     ::apache::thrift::TApplicationException x(e.what());
-    oprot->writeMessageBegin("check", ::apache::thrift::protocol::T_EXCEPTION, seqid);
+    oprot->writeMessageBegin("get_size", ::apache::thrift::protocol::T_EXCEPTION, seqid);
     x.write(oprot);
     oprot->writeMessageEnd();
     oprot->getTransport()->writeEnd();
@@ -2376,53 +4841,53 @@ void MDTrieShardProcessorT<Protocol_>::process_check(int32_t seqid, Protocol_* i
   }
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->preWrite(ctx, "MDTrieShard.check");
+    this->eventHandler_->preWrite(ctx, "MDTrieShard.get_size");
   }
 
-  oprot->writeMessageBegin("check", ::apache::thrift::protocol::T_REPLY, seqid);
+  oprot->writeMessageBegin("get_size", ::apache::thrift::protocol::T_REPLY, seqid);
   result.write(oprot);
   oprot->writeMessageEnd();
   bytes = oprot->getTransport()->writeEnd();
   oprot->getTransport()->flush();
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->postWrite(ctx, "MDTrieShard.check", bytes);
+    this->eventHandler_->postWrite(ctx, "MDTrieShard.get_size", bytes);
   }
 }
 
 template <class Protocol_>
-void MDTrieShardProcessorT<Protocol_>::process_range_search(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext)
+void MDTrieShardProcessorT<Protocol_>::process_get_size(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext)
 {
   void* ctx = nullptr;
   if (this->eventHandler_.get() != nullptr) {
-    ctx = this->eventHandler_->getContext("MDTrieShard.range_search", callContext);
+    ctx = this->eventHandler_->getContext("MDTrieShard.get_size", callContext);
   }
-  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.range_search");
+  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.get_size");
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->preRead(ctx, "MDTrieShard.range_search");
+    this->eventHandler_->preRead(ctx, "MDTrieShard.get_size");
   }
 
-  MDTrieShard_range_search_args args;
+  MDTrieShard_get_size_args args;
   args.read(iprot);
   iprot->readMessageEnd();
   uint32_t bytes = iprot->getTransport()->readEnd();
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->postRead(ctx, "MDTrieShard.range_search", bytes);
+    this->eventHandler_->postRead(ctx, "MDTrieShard.get_size", bytes);
   }
 
-  MDTrieShard_range_search_result result;
+  MDTrieShard_get_size_result result;
   try {
-    iface_->range_search(result.success, args.start_range, args.end_range);
+    result.success = iface_->get_size();
     result.__isset.success = true;
   } catch (const std::exception& e) {
     if (this->eventHandler_.get() != nullptr) {
-      this->eventHandler_->handlerError(ctx, "MDTrieShard.range_search");
+      this->eventHandler_->handlerError(ctx, "MDTrieShard.get_size");
     }
 
     ::apache::thrift::TApplicationException x(e.what());
-    oprot->writeMessageBegin("range_search", ::apache::thrift::protocol::T_EXCEPTION, seqid);
+    oprot->writeMessageBegin("get_size", ::apache::thrift::protocol::T_EXCEPTION, seqid);
     x.write(oprot);
     oprot->writeMessageEnd();
     oprot->getTransport()->writeEnd();
@@ -2431,53 +4896,53 @@ void MDTrieShardProcessorT<Protocol_>::process_range_search(int32_t seqid, ::apa
   }
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->preWrite(ctx, "MDTrieShard.range_search");
+    this->eventHandler_->preWrite(ctx, "MDTrieShard.get_size");
   }
 
-  oprot->writeMessageBegin("range_search", ::apache::thrift::protocol::T_REPLY, seqid);
+  oprot->writeMessageBegin("get_size", ::apache::thrift::protocol::T_REPLY, seqid);
   result.write(oprot);
   oprot->writeMessageEnd();
   bytes = oprot->getTransport()->writeEnd();
   oprot->getTransport()->flush();
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->postWrite(ctx, "MDTrieShard.range_search", bytes);
+    this->eventHandler_->postWrite(ctx, "MDTrieShard.get_size", bytes);
   }
 }
 
 template <class Protocol_>
-void MDTrieShardProcessorT<Protocol_>::process_range_search(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext)
+void MDTrieShardProcessorT<Protocol_>::process_get_size_breakdown(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext)
 {
   void* ctx = nullptr;
   if (this->eventHandler_.get() != nullptr) {
-    ctx = this->eventHandler_->getContext("MDTrieShard.range_search", callContext);
+    ctx = this->eventHandler_->getContext("MDTrieShard.get_size_breakdown", callContext);
   }
-  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.range_search");
+  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.get_size_breakdown");
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->preRead(ctx, "MDTrieShard.range_search");
+    this->eventHandler_->preRead(ctx, "MDTrieShard.get_size_breakdown");
   }
 
-  MDTrieShard_range_search_args args;
+  MDTrieShard_get_size_breakdown_args args;
   args.read(iprot);
   iprot->readMessageEnd();
   uint32_t bytes = iprot->getTransport()->readEnd();
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->postRead(ctx, "MDTrieShard.range_search", bytes);
+    this->eventHandler_->postRead(ctx, "MDTrieShard.get_size_breakdown", bytes);
   }
 
-  MDTrieShard_range_search_result result;
+  MDTrieShard_get_size_breakdown_result result;
   try {
-    iface_->range_search(result.success, args.start_range, args.end_range);
+    iface_->get_size_breakdown(result.success);
     result.__isset.success = true;
   } catch (const std::exception& e) {
     if (this->eventHandler_.get() != nullptr) {
-      this->eventHandler_->handlerError(ctx, "MDTrieShard.range_search");
+      this->eventHandler_->handlerError(ctx, "MDTrieShard.get_size_breakdown");
     }
 
     ::apache::thrift::TApplicationException x(e.what());
-    oprot->writeMessageBegin("range_search", ::apache::thrift::protocol::T_EXCEPTION, seqid);
+    oprot->writeMessageBegin("get_size_breakdown", ::apache::thrift::protocol::T_EXCEPTION, seqid);
     x.write(oprot);
     oprot->writeMessageEnd();
     oprot->getTransport()->writeEnd();
@@ -2486,53 +4951,53 @@ void MDTrieShardProcessorT<Protocol_>::process_range_search(int32_t seqid, Proto
   }
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->preWrite(ctx, "MDTrieShard.range_search");
+    this->eventHandler_->preWrite(ctx, "MDTrieShard.get_size_breakdown");
   }
 
-  oprot->writeMessageBegin("range_search", ::apache::thrift::protocol::T_REPLY, seqid);
+  oprot->writeMessageBegin("get_size_breakdown", ::apache::thrift::protocol::T_REPLY, seqid);
   result.write(oprot);
   oprot->writeMessageEnd();
   bytes = oprot->getTransport()->writeEnd();
   oprot->getTransport()->flush();
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->postWrite(ctx, "MDTrieShard.range_search", bytes);
+    this->eventHandler_->postWrite(ctx, "MDTrieShard.get_size_breakdown", bytes);
   }
 }
 
 template <class Protocol_>
-void MDTrieShardProcessorT<Protocol_>::process_primary_key_lookup(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext)
+void MDTrieShardProcessorT<Protocol_>::process_get_size_breakdown(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext)
 {
   void* ctx = nullptr;
   if (this->eventHandler_.get() != nullptr) {
-    ctx = this->eventHandler_->getContext("MDTrieShard.primary_key_lookup", callContext);
+    ctx = this->eventHandler_->getContext("MDTrieShard.get_size_breakdown", callContext);
   }
-  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.primary_key_lookup");
+  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.get_size_breakdown");
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->preRead(ctx, "MDTrieShard.primary_key_lookup");
+    this->eventHandler_->preRead(ctx, "MDTrieShard.get_size_breakdown");
   }
 
-  MDTrieShard_primary_key_lookup_args args;
+  MDTrieShard_get_size_breakdown_args args;
   args.read(iprot);
   iprot->readMessageEnd();
   uint32_t bytes = iprot->getTransport()->readEnd();
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->postRead(ctx, "MDTrieShard.primary_key_lookup", bytes);
+    this->eventHandler_->postRead(ctx, "MDTrieShard.get_size_breakdown", bytes);
   }
 
-  MDTrieShard_primary_key_lookup_result result;
+  MDTrieShard_get_size_breakdown_result result;
   try {
-    iface_->primary_key_lookup(result.success, args.primary_key);
+    iface_->get_size_breakdown(result.success);
     result.__isset.success = true;
   } catch (const std::exception& e) {
     if (this->eventHandler_.get() != nullptr) {
-      this->eventHandler_->handlerError(ctx, "MDTrieShard.primary_key_lookup");
+      this->eventHandler_->handlerError(ctx, "MDTrieShard.get_size_breakdown");
     }
 
     ::apache::thrift::TApplicationException x(e.what());
-    oprot->writeMessageBegin("primary_key_lookup", ::apache::thrift::protocol::T_EXCEPTION, seqid);
+    oprot->writeMessageBegin("get_size_breakdown", ::apache::thrift::protocol::T_EXCEPTION, seqid);
     x.write(oprot);
     oprot->writeMessageEnd();
     oprot->getTransport()->writeEnd();
@@ -2541,209 +5006,307 @@ void MDTrieShardProcessorT<Protocol_>::process_primary_key_lookup(int32_t seqid,
   }
 
   if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->preWrite(ctx, "MDTrieShard.primary_key_lookup");
+    this->eventHandler_->preWrite(ctx, "MDTrieShard.get_size_breakdown");
   }
 
-  oprot->writeMessageBegin("primary_key_lookup", ::apache::thrift::protocol::T_REPLY, seqid);
+  oprot->writeMessageBegin("get_size_breakdown", ::apache::thrift::protocol::T_REPLY, seqid);
   result.write(oprot);
   oprot->writeMessageEnd();
   bytes = oprot->getTransport()->writeEnd();
   oprot->getTransport()->flush();
 
-  if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->postWrite(ctx, "MDTrieShard.primary_key_lookup", bytes);
-  }
+  if (this->eventHandler_.get() != nullptr) {
+    this->eventHandler_->postWrite(ctx, "MDTrieShard.get_size_breakdown", bytes);
+  }
+}
+
+template <class Protocol_>
+::std::shared_ptr< ::apache::thrift::TProcessor > MDTrieShardProcessorFactoryT<Protocol_>::getProcessor(const ::apache::thrift::TConnectionInfo& connInfo) {
+  ::apache::thrift::ReleaseHandler< MDTrieShardIfFactory > cleanup(handlerFactory_);
+  ::std::shared_ptr< MDTrieShardIf > handler(handlerFactory_->getHandler(connInfo), cleanup);
+  ::std::shared_ptr< ::apache::thrift::TProcessor > processor(new MDTrieShardProcessorT<Protocol_>(handler));
+  return processor;
+}
+
+template <class Protocol_>
+bool MDTrieShardConcurrentClientT<Protocol_>::ping(const int32_t dataset_idx)
+{
+  int32_t seqid = send_ping(dataset_idx);
+  return recv_ping(seqid);
+}
+
+template <class Protocol_>
+int32_t MDTrieShardConcurrentClientT<Protocol_>::send_ping(const int32_t dataset_idx)
+{
+  int32_t cseqid = this->sync_->generateSeqId();
+  ::apache::thrift::async::TConcurrentSendSentry sentry(this->sync_.get());
+  this->oprot_->writeMessageBegin("ping", ::apache::thrift::protocol::T_CALL, cseqid);
+
+  MDTrieShard_ping_pargs args;
+  args.dataset_idx = &dataset_idx;
+  args.write(this->oprot_);
+
+  this->oprot_->writeMessageEnd();
+  this->oprot_->getTransport()->writeEnd();
+  this->oprot_->getTransport()->flush();
+
+  sentry.commit();
+  return cseqid;
+}
+
+template <class Protocol_>
+bool MDTrieShardConcurrentClientT<Protocol_>::recv_ping(const int32_t seqid)
+{
+
+  int32_t rseqid = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TMessageType mtype;
+
+  // the read mutex gets dropped and reacquired as part of waitForWork()
+  // The destructor of this sentry wakes up other clients
+  ::apache::thrift::async::TConcurrentRecvSentry sentry(this->sync_.get(), seqid);
+
+  while(true) {
+    if(!this->sync_->getPending(fname, mtype, rseqid)) {
+      this->iprot_->readMessageBegin(fname, mtype, rseqid);
+    }
+    if(seqid == rseqid) {
+      if (mtype == ::apache::thrift::protocol::T_EXCEPTION) {
+        ::apache::thrift::TApplicationException x;
+        x.read(this->iprot_);
+        this->iprot_->readMessageEnd();
+        this->iprot_->getTransport()->readEnd();
+        sentry.commit();
+        throw x;
+      }
+      if (mtype != ::apache::thrift::protocol::T_REPLY) {
+        this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+        this->iprot_->readMessageEnd();
+        this->iprot_->getTransport()->readEnd();
+      }
+      if (fname.compare("ping") != 0) {
+        this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+        this->iprot_->readMessageEnd();
+        this->iprot_->getTransport()->readEnd();
+
+        // in a bad state, don't commit
+        using ::apache::thrift::protocol::TProtocolException;
+        throw TProtocolException(TProtocolException::INVALID_DATA);
+      }
+      bool _return;
+      MDTrieShard_ping_presult result;
+      result.success = &_return;
+      result.read(this->iprot_);
+      this->iprot_->readMessageEnd();
+      this->iprot_->getTransport()->readEnd();
+
+      if (result.__isset.success) {
+        sentry.commit();
+        return _return;
+      }
+      // in a bad state, don't commit
+      throw ::apache::thrift::TApplicationException(::apache::thrift::TApplicationException::MISSING_RESULT, "ping failed: unknown result");
+    }
+    // seqid != rseqid
+    this->sync_->updatePending(fname, mtype, rseqid);
+
+    // this will temporarily unlock the readMutex, and let other clients get work done
+    this->sync_->waitForWork(seqid);
+  } // end while(true)
+}
+
+template <class Protocol_>
+int32_t MDTrieShardConcurrentClientT<Protocol_>::insert(const std::vector<int32_t> & point, const int32_t primary_key)
+{
+  int32_t seqid = send_insert(point, primary_key);
+  return recv_insert(seqid);
+}
+
+template <class Protocol_>
+int32_t MDTrieShardConcurrentClientT<Protocol_>::send_insert(const std::vector<int32_t> & point, const int32_t primary_key)
+{
+  int32_t cseqid = this->sync_->generateSeqId();
+  ::apache::thrift::async::TConcurrentSendSentry sentry(this->sync_.get());
+  this->oprot_->writeMessageBegin("insert", ::apache::thrift::protocol::T_CALL, cseqid);
+
+  MDTrieShard_insert_pargs args;
+  args.point = &point;
+  args.primary_key = &primary_key;
+  args.write(this->oprot_);
+
+  this->oprot_->writeMessageEnd();
+  this->oprot_->getTransport()->writeEnd();
+  this->oprot_->getTransport()->flush();
+
+  sentry.commit();
+  return cseqid;
 }
 
 template <class Protocol_>
-void MDTrieShardProcessorT<Protocol_>::process_primary_key_lookup(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext)
+int32_t MDTrieShardConcurrentClientT<Protocol_>::recv_insert(const int32_t seqid)
 {
-  void* ctx = nullptr;
-  if (this->eventHandler_.get() != nullptr) {
-    ctx = this->eventHandler_->getContext("MDTrieShard.primary_key_lookup", callContext);
-  }
-  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.primary_key_lookup");
-
-  if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->preRead(ctx, "MDTrieShard.primary_key_lookup");
-  }
 
-  MDTrieShard_primary_key_lookup_args args;
-  args.read(iprot);
-  iprot->readMessageEnd();
-  uint32_t bytes = iprot->getTransport()->readEnd();
+  int32_t rseqid = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TMessageType mtype;
 
-  if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->postRead(ctx, "MDTrieShard.primary_key_lookup", bytes);
-  }
+  // the read mutex gets dropped and reacquired as part of waitForWork()
+  // The destructor of this sentry wakes up other clients
+  ::apache::thrift::async::TConcurrentRecvSentry sentry(this->sync_.get(), seqid);
 
-  MDTrieShard_primary_key_lookup_result result;
-  try {
-    iface_->primary_key_lookup(result.success, args.primary_key);
-    result.__isset.success = true;
-  } catch (const std::exception& e) {
-    if (this->eventHandler_.get() != nullptr) {
-      this->eventHandler_->handlerError(ctx, "MDTrieShard.primary_key_lookup");
+  while(true) {
+    if(!this->sync_->getPending(fname, mtype, rseqid)) {
+      this->iprot_->readMessageBegin(fname, mtype, rseqid);
     }
+    if(seqid == rseqid) {
+      if (mtype == ::apache::thrift::protocol::T_EXCEPTION) {
+        ::apache::thrift::TApplicationException x;
+        x.read(this->iprot_);
+        this->iprot_->readMessageEnd();
+        this->iprot_->getTransport()->readEnd();
+        sentry.commit();
+        throw x;
+      }
+      if (mtype != ::apache::thrift::protocol::T_REPLY) {
+        this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+        this->iprot_->readMessageEnd();
+        this->iprot_->getTransport()->readEnd();
+      }
+      if (fname.compare("insert") != 0) {
+        this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+        this->iprot_->readMessageEnd();
+        this->iprot_->getTransport()->readEnd();
 
-    ::apache::thrift::TApplicationException x(e.what());
-    oprot->writeMessageBegin("primary_key_lookup", ::apache::thrift::protocol::T_EXCEPTION, seqid);
-    x.write(oprot);
-    oprot->writeMessageEnd();
-    oprot->getTransport()->writeEnd();
-    oprot->getTransport()->flush();
-    return;
-  }
-
-  if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->preWrite(ctx, "MDTrieShard.primary_key_lookup");
-  }
+        // in a bad state, don't commit
+        using ::apache::thrift::protocol::TProtocolException;
+        throw TProtocolException(TProtocolException::INVALID_DATA);
+      }
+      int32_t _return;
+      MDTrieShard_insert_presult result;
+      result.success = &_return;
+      result.read(this->iprot_);
+      this->iprot_->readMessageEnd();
+      this->iprot_->getTransport()->readEnd();
 
-  oprot->writeMessageBegin("primary_key_lookup", ::apache::thrift::protocol::T_REPLY, seqid);
-  result.write(oprot);
-  oprot->writeMessageEnd();
-  bytes = oprot->getTransport()->writeEnd();
-  oprot->getTransport()->flush();
+      if (result.__isset.success) {
+        sentry.commit();
+        return _return;
+      }
+      // in a bad state, don't commit
+      throw ::apache::thrift::TApplicationException(::apache::thrift::TApplicationException::MISSING_RESULT, "insert failed: unknown result");
+    }
+    // seqid != rseqid
+    this->sync_->updatePending(fname, mtype, rseqid);
 
-  if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->postWrite(ctx, "MDTrieShard.primary_key_lookup", bytes);
-  }
+    // this will temporarily unlock the readMutex, and let other clients get work done
+    this->sync_->waitForWork(seqid);
+  } // end while(true)
 }
 
 template <class Protocol_>
-void MDTrieShardProcessorT<Protocol_>::process_get_size(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext)
+int32_t MDTrieShardConcurrentClientT<Protocol_>::insert_for_latency(const std::vector<int32_t> & point, const int32_t primary_key)
 {
-  void* ctx = nullptr;
-  if (this->eventHandler_.get() != nullptr) {
-    ctx = this->eventHandler_->getContext("MDTrieShard.get_size", callContext);
-  }
-  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.get_size");
-
-  if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->preRead(ctx, "MDTrieShard.get_size");
-  }
-
-  MDTrieShard_get_size_args args;
-  args.read(iprot);
-  iprot->readMessageEnd();
-  uint32_t bytes = iprot->getTransport()->readEnd();
-
-  if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->postRead(ctx, "MDTrieShard.get_size", bytes);
-  }
-
-  MDTrieShard_get_size_result result;
-  try {
-    result.success = iface_->get_size();
-    result.__isset.success = true;
-  } catch (const std::exception& e) {
-    if (this->eventHandler_.get() != nullptr) {
-      this->eventHandler_->handlerError(ctx, "MDTrieShard.get_size");
-    }
+  int32_t seqid = send_insert_for_latency(point, primary_key);
+  return recv_insert_for_latency(seqid);
+}
 
-    ::apache::thrift::TApplicationException x(e.what());
-    oprot->writeMessageBegin("get_size", ::apache::thrift::protocol::T_EXCEPTION, seqid);
-    x.write(oprot);
-    oprot->writeMessageEnd();
-    oprot->getTransport()->writeEnd();
-    oprot->getTransport()->flush();
-    return;
-  }
+template <class Protocol_>
+int32_t MDTrieShardConcurrentClientT<Protocol_>::send_insert_for_latency(const std::vector<int32_t> & point, const int32_t primary_key)
+{
+  int32_t cseqid = this->sync_->generateSeqId();
+  ::apache::thrift::async::TConcurrentSendSentry sentry(this->sync_.get());
+  this->oprot_->writeMessageBegin("insert_for_latency", ::apache::thrift::protocol::T_CALL, cseqid);
 
-  if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->preWrite(ctx, "MDTrieShard.get_size");
-  }
+  MDTrieShard_insert_for_latency_pargs args;
+  args.point = &point;
+  args.primary_key = &primary_key;
+  args.write(this->oprot_);
 
-  oprot->writeMessageBegin("get_size", ::apache::thrift::protocol::T_REPLY, seqid);
-  result.write(oprot);
-  oprot->writeMessageEnd();
-  bytes = oprot->getTransport()->writeEnd();
-  oprot->getTransport()->flush();
+  this->oprot_->writeMessageEnd();
+  this->oprot_->getTransport()->writeEnd();
+  this->oprot_->getTransport()->flush();
 
-  if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->postWrite(ctx, "MDTrieShard.get_size", bytes);
-  }
+  sentry.commit();
+  return cseqid;
 }
 
 template <class Protocol_>
-void MDTrieShardProcessorT<Protocol_>::process_get_size(int32_t seqid, Protocol_* iprot, Protocol_* oprot, void* callContext)
+int32_t MDTrieShardConcurrentClientT<Protocol_>::recv_insert_for_latency(const int32_t seqid)
 {
-  void* ctx = nullptr;
-  if (this->eventHandler_.get() != nullptr) {
-    ctx = this->eventHandler_->getContext("MDTrieShard.get_size", callContext);
-  }
-  ::apache::thrift::TProcessorContextFreer freer(this->eventHandler_.get(), ctx, "MDTrieShard.get_size");
-
-  if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->preRead(ctx, "MDTrieShard.get_size");
-  }
 
-  MDTrieShard_get_size_args args;
-  args.read(iprot);
-  iprot->readMessageEnd();
-  uint32_t bytes = iprot->getTransport()->readEnd();
+  int32_t rseqid = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TMessageType mtype;
 
-  if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->postRead(ctx, "MDTrieShard.get_size", bytes);
-  }
+  // the read mutex gets dropped and reacquired as part of waitForWork()
+  // The destructor of this sentry wakes up other clients
+  ::apache::thrift::async::TConcurrentRecvSentry sentry(this->sync_.get(), seqid);
 
-  MDTrieShard_get_size_result result;
-  try {
-    result.success = iface_->get_size();
-    result.__isset.success = true;
-  } catch (const std::exception& e) {
-    if (this->eventHandler_.get() != nullptr) {
-      this->eventHandler_->handlerError(ctx, "MDTrieShard.get_size");
+  while(true) {
+    if(!this->sync_->getPending(fname, mtype, rseqid)) {
+      this->iprot_->readMessageBegin(fname, mtype, rseqid);
     }
+    if(seqid == rseqid) {
+      if (mtype == ::apache::thrift::protocol::T_EXCEPTION) {
+        ::apache::thrift::TApplicationException x;
+        x.read(this->iprot_);
+        this->iprot_->readMessageEnd();
+        this->iprot_->getTransport()->readEnd();
+        sentry.commit();
+        throw x;
+      }
+      if (mtype != ::apache::thrift::protocol::T_REPLY) {
+        this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+        this->iprot_->readMessageEnd();
+        this->iprot_->getTransport()->readEnd();
+      }
+      if (fname.compare("insert_for_latency") != 0) {
+        this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+        this->iprot_->readMessageEnd();
+        this->iprot_->getTransport()->readEnd();
 
-    ::apache::thrift::TApplicationException x(e.what());
-    oprot->writeMessageBegin("get_size", ::apache::thrift::protocol::T_EXCEPTION, seqid);
-    x.write(oprot);
-    oprot->writeMessageEnd();
-    oprot->getTransport()->writeEnd();
-    oprot->getTransport()->flush();
-    return;
-  }
-
-  if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->preWrite(ctx, "MDTrieShard.get_size");
-  }
-
-  oprot->writeMessageBegin("get_size", ::apache::thrift::protocol::T_REPLY, seqid);
-  result.write(oprot);
-  oprot->writeMessageEnd();
-  bytes = oprot->getTransport()->writeEnd();
-  oprot->getTransport()->flush();
+        // in a bad state, don't commit
+        using ::apache::thrift::protocol::TProtocolException;
+        throw TProtocolException(TProtocolException::INVALID_DATA);
+      }
+      int32_t _return;
+      MDTrieShard_insert_for_latency_presult result;
+      result.success = &_return;
+      result.read(this->iprot_);
+      this->iprot_->readMessageEnd();
+      this->iprot_->getTransport()->readEnd();
 
-  if (this->eventHandler_.get() != nullptr) {
-    this->eventHandler_->postWrite(ctx, "MDTrieShard.get_size", bytes);
-  }
-}
+      if (result.__isset.success) {
+        sentry.commit();
+        return _return;
+      }
+      // in a bad state, don't commit
+      throw ::apache::thrift::TApplicationException(::apache::thrift::TApplicationException::MISSING_RESULT, "insert_for_latency failed: unknown result");
+    }
+    // seqid != rseqid
+    this->sync_->updatePending(fname, mtype, rseqid);
 
-template <class Protocol_>
-::std::shared_ptr< ::apache::thrift::TProcessor > MDTrieShardProcessorFactoryT<Protocol_>::getProcessor(const ::apache::thrift::TConnectionInfo& connInfo) {
-  ::apache::thrift::ReleaseHandler< MDTrieShardIfFactory > cleanup(handlerFactory_);
-  ::std::shared_ptr< MDTrieShardIf > handler(handlerFactory_->getHandler(connInfo), cleanup);
-  ::std::shared_ptr< ::apache::thrift::TProcessor > processor(new MDTrieShardProcessorT<Protocol_>(handler));
-  return processor;
+    // this will temporarily unlock the readMutex, and let other clients get work done
+    this->sync_->waitForWork(seqid);
+  } // end while(true)
 }
 
 template <class Protocol_>
-bool MDTrieShardConcurrentClientT<Protocol_>::ping(const int32_t dataset_idx)
+bool MDTrieShardConcurrentClientT<Protocol_>::check(const std::vector<int32_t> & point)
 {
-  int32_t seqid = send_ping(dataset_idx);
-  return recv_ping(seqid);
+  int32_t seqid = send_check(point);
+  return recv_check(seqid);
 }
 
 template <class Protocol_>
-int32_t MDTrieShardConcurrentClientT<Protocol_>::send_ping(const int32_t dataset_idx)
+int32_t MDTrieShardConcurrentClientT<Protocol_>::send_check(const std::vector<int32_t> & point)
 {
   int32_t cseqid = this->sync_->generateSeqId();
   ::apache::thrift::async::TConcurrentSendSentry sentry(this->sync_.get());
-  this->oprot_->writeMessageBegin("ping", ::apache::thrift::protocol::T_CALL, cseqid);
+  this->oprot_->writeMessageBegin("check", ::apache::thrift::protocol::T_CALL, cseqid);
 
-  MDTrieShard_ping_pargs args;
-  args.dataset_idx = &dataset_idx;
+  MDTrieShard_check_pargs args;
+  args.point = &point;
   args.write(this->oprot_);
 
   this->oprot_->writeMessageEnd();
@@ -2755,7 +5318,7 @@ int32_t MDTrieShardConcurrentClientT<Protocol_>::send_ping(const int32_t dataset
 }
 
 template <class Protocol_>
-bool MDTrieShardConcurrentClientT<Protocol_>::recv_ping(const int32_t seqid)
+bool MDTrieShardConcurrentClientT<Protocol_>::recv_check(const int32_t seqid)
 {
 
   int32_t rseqid = 0;
@@ -2784,7 +5347,7 @@ bool MDTrieShardConcurrentClientT<Protocol_>::recv_ping(const int32_t seqid)
         this->iprot_->readMessageEnd();
         this->iprot_->getTransport()->readEnd();
       }
-      if (fname.compare("ping") != 0) {
+      if (fname.compare("check") != 0) {
         this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
         this->iprot_->readMessageEnd();
         this->iprot_->getTransport()->readEnd();
@@ -2794,7 +5357,7 @@ bool MDTrieShardConcurrentClientT<Protocol_>::recv_ping(const int32_t seqid)
         throw TProtocolException(TProtocolException::INVALID_DATA);
       }
       bool _return;
-      MDTrieShard_ping_presult result;
+      MDTrieShard_check_presult result;
       result.success = &_return;
       result.read(this->iprot_);
       this->iprot_->readMessageEnd();
@@ -2805,7 +5368,7 @@ bool MDTrieShardConcurrentClientT<Protocol_>::recv_ping(const int32_t seqid)
         return _return;
       }
       // in a bad state, don't commit
-      throw ::apache::thrift::TApplicationException(::apache::thrift::TApplicationException::MISSING_RESULT, "ping failed: unknown result");
+      throw ::apache::thrift::TApplicationException(::apache::thrift::TApplicationException::MISSING_RESULT, "check failed: unknown result");
     }
     // seqid != rseqid
     this->sync_->updatePending(fname, mtype, rseqid);
@@ -2816,22 +5379,23 @@ bool MDTrieShardConcurrentClientT<Protocol_>::recv_ping(const int32_t seqid)
 }
 
 template <class Protocol_>
-int32_t MDTrieShardConcurrentClientT<Protocol_>::insert(const std::vector<int32_t> & point, const int32_t primary_key)
+void MDTrieShardConcurrentClientT<Protocol_>::range_search(std::vector<int32_t> & _return, const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range, const int32_t result_mode)
 {
-  int32_t seqid = send_insert(point, primary_key);
-  return recv_insert(seqid);
+  int32_t seqid = send_range_search(start_range, end_range, result_mode);
+  recv_range_search(_return, seqid);
 }
 
 template <class Protocol_>
-int32_t MDTrieShardConcurrentClientT<Protocol_>::send_insert(const std::vector<int32_t> & point, const int32_t primary_key)
+int32_t MDTrieShardConcurrentClientT<Protocol_>::send_range_search(const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range, const int32_t result_mode)
 {
   int32_t cseqid = this->sync_->generateSeqId();
   ::apache::thrift::async::TConcurrentSendSentry sentry(this->sync_.get());
-  this->oprot_->writeMessageBegin("insert", ::apache::thrift::protocol::T_CALL, cseqid);
+  this->oprot_->writeMessageBegin("range_search", ::apache::thrift::protocol::T_CALL, cseqid);
 
-  MDTrieShard_insert_pargs args;
-  args.point = &point;
-  args.primary_key = &primary_key;
+  MDTrieShard_range_search_pargs args;
+  args.start_range = &start_range;
+  args.end_range = &end_range;
+  args.result_mode = &result_mode;
   args.write(this->oprot_);
 
   this->oprot_->writeMessageEnd();
@@ -2843,7 +5407,7 @@ int32_t MDTrieShardConcurrentClientT<Protocol_>::send_insert(const std::vector<i
 }
 
 template <class Protocol_>
-int32_t MDTrieShardConcurrentClientT<Protocol_>::recv_insert(const int32_t seqid)
+void MDTrieShardConcurrentClientT<Protocol_>::recv_range_search(std::vector<int32_t> & _return, const int32_t seqid)
 {
 
   int32_t rseqid = 0;
@@ -2872,7 +5436,7 @@ int32_t MDTrieShardConcurrentClientT<Protocol_>::recv_insert(const int32_t seqid
         this->iprot_->readMessageEnd();
         this->iprot_->getTransport()->readEnd();
       }
-      if (fname.compare("insert") != 0) {
+      if (fname.compare("range_search") != 0) {
         this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
         this->iprot_->readMessageEnd();
         this->iprot_->getTransport()->readEnd();
@@ -2881,19 +5445,19 @@ int32_t MDTrieShardConcurrentClientT<Protocol_>::recv_insert(const int32_t seqid
         using ::apache::thrift::protocol::TProtocolException;
         throw TProtocolException(TProtocolException::INVALID_DATA);
       }
-      int32_t _return;
-      MDTrieShard_insert_presult result;
+      MDTrieShard_range_search_presult result;
       result.success = &_return;
       result.read(this->iprot_);
       this->iprot_->readMessageEnd();
       this->iprot_->getTransport()->readEnd();
 
       if (result.__isset.success) {
+        // _return pointer has now been filled
         sentry.commit();
-        return _return;
+        return;
       }
       // in a bad state, don't commit
-      throw ::apache::thrift::TApplicationException(::apache::thrift::TApplicationException::MISSING_RESULT, "insert failed: unknown result");
+      throw ::apache::thrift::TApplicationException(::apache::thrift::TApplicationException::MISSING_RESULT, "range_search failed: unknown result");
     }
     // seqid != rseqid
     this->sync_->updatePending(fname, mtype, rseqid);
@@ -2904,22 +5468,25 @@ int32_t MDTrieShardConcurrentClientT<Protocol_>::recv_insert(const int32_t seqid
 }
 
 template <class Protocol_>
-int32_t MDTrieShardConcurrentClientT<Protocol_>::insert_for_latency(const std::vector<int32_t> & point, const int32_t primary_key)
+void MDTrieShardConcurrentClientT<Protocol_>::range_search_page(std::vector<int32_t> & _return, const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range, const std::vector<int32_t> & resume_after, const int32_t limit, const int32_t result_mode)
 {
-  int32_t seqid = send_insert_for_latency(point, primary_key);
-  return recv_insert_for_latency(seqid);
+  int32_t seqid = send_range_search_page(start_range, end_range, resume_after, limit, result_mode);
+  recv_range_search_page(_return, seqid);
 }
 
 template <class Protocol_>
-int32_t MDTrieShardConcurrentClientT<Protocol_>::send_insert_for_latency(const std::vector<int32_t> & point, const int32_t primary_key)
+int32_t MDTrieShardConcurrentClientT<Protocol_>::send_range_search_page(const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range, const std::vector<int32_t> & resume_after, const int32_t limit, const int32_t result_mode)
 {
   int32_t cseqid = this->sync_->generateSeqId();
   ::apache::thrift::async::TConcurrentSendSentry sentry(this->sync_.get());
-  this->oprot_->writeMessageBegin("insert_for_latency", ::apache::thrift::protocol::T_CALL, cseqid);
+  this->oprot_->writeMessageBegin("range_search_page", ::apache::thrift::protocol::T_CALL, cseqid);
 
-  MDTrieShard_insert_for_latency_pargs args;
-  args.point = &point;
-  args.primary_key = &primary_key;
+  MDTrieShard_range_search_page_pargs args;
+  args.start_range = &start_range;
+  args.end_range = &end_range;
+  args.resume_after = &resume_after;
+  args.limit = &limit;
+  args.result_mode = &result_mode;
   args.write(this->oprot_);
 
   this->oprot_->writeMessageEnd();
@@ -2931,7 +5498,7 @@ int32_t MDTrieShardConcurrentClientT<Protocol_>::send_insert_for_latency(const s
 }
 
 template <class Protocol_>
-int32_t MDTrieShardConcurrentClientT<Protocol_>::recv_insert_for_latency(const int32_t seqid)
+void MDTrieShardConcurrentClientT<Protocol_>::recv_range_search_page(std::vector<int32_t> & _return, const int32_t seqid)
 {
 
   int32_t rseqid = 0;
@@ -2960,7 +5527,7 @@ int32_t MDTrieShardConcurrentClientT<Protocol_>::recv_insert_for_latency(const i
         this->iprot_->readMessageEnd();
         this->iprot_->getTransport()->readEnd();
       }
-      if (fname.compare("insert_for_latency") != 0) {
+      if (fname.compare("range_search_page") != 0) {
         this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
         this->iprot_->readMessageEnd();
         this->iprot_->getTransport()->readEnd();
@@ -2969,19 +5536,19 @@ int32_t MDTrieShardConcurrentClientT<Protocol_>::recv_insert_for_latency(const i
         using ::apache::thrift::protocol::TProtocolException;
         throw TProtocolException(TProtocolException::INVALID_DATA);
       }
-      int32_t _return;
-      MDTrieShard_insert_for_latency_presult result;
+      MDTrieShard_range_search_page_presult result;
       result.success = &_return;
       result.read(this->iprot_);
       this->iprot_->readMessageEnd();
       this->iprot_->getTransport()->readEnd();
 
       if (result.__isset.success) {
+        // _return pointer has now been filled
         sentry.commit();
-        return _return;
+        return;
       }
       // in a bad state, don't commit
-      throw ::apache::thrift::TApplicationException(::apache::thrift::TApplicationException::MISSING_RESULT, "insert_for_latency failed: unknown result");
+      throw ::apache::thrift::TApplicationException(::apache::thrift::TApplicationException::MISSING_RESULT, "range_search_page failed: unknown result");
     }
     // seqid != rseqid
     this->sync_->updatePending(fname, mtype, rseqid);
@@ -2992,21 +5559,23 @@ int32_t MDTrieShardConcurrentClientT<Protocol_>::recv_insert_for_latency(const i
 }
 
 template <class Protocol_>
-bool MDTrieShardConcurrentClientT<Protocol_>::check(const std::vector<int32_t> & point)
+void MDTrieShardConcurrentClientT<Protocol_>::range_search_aggregate(std::vector<int64_t> & _return, const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range, const std::vector<int32_t> & dimensions)
 {
-  int32_t seqid = send_check(point);
-  return recv_check(seqid);
+  int32_t seqid = send_range_search_aggregate(start_range, end_range, dimensions);
+  recv_range_search_aggregate(_return, seqid);
 }
 
 template <class Protocol_>
-int32_t MDTrieShardConcurrentClientT<Protocol_>::send_check(const std::vector<int32_t> & point)
+int32_t MDTrieShardConcurrentClientT<Protocol_>::send_range_search_aggregate(const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range, const std::vector<int32_t> & dimensions)
 {
   int32_t cseqid = this->sync_->generateSeqId();
   ::apache::thrift::async::TConcurrentSendSentry sentry(this->sync_.get());
-  this->oprot_->writeMessageBegin("check", ::apache::thrift::protocol::T_CALL, cseqid);
+  this->oprot_->writeMessageBegin("range_search_aggregate", ::apache::thrift::protocol::T_CALL, cseqid);
 
-  MDTrieShard_check_pargs args;
-  args.point = &point;
+  MDTrieShard_range_search_aggregate_pargs args;
+  args.start_range = &start_range;
+  args.end_range = &end_range;
+  args.dimensions = &dimensions;
   args.write(this->oprot_);
 
   this->oprot_->writeMessageEnd();
@@ -3018,7 +5587,7 @@ int32_t MDTrieShardConcurrentClientT<Protocol_>::send_check(const std::vector<in
 }
 
 template <class Protocol_>
-bool MDTrieShardConcurrentClientT<Protocol_>::recv_check(const int32_t seqid)
+void MDTrieShardConcurrentClientT<Protocol_>::recv_range_search_aggregate(std::vector<int64_t> & _return, const int32_t seqid)
 {
 
   int32_t rseqid = 0;
@@ -3047,7 +5616,7 @@ bool MDTrieShardConcurrentClientT<Protocol_>::recv_check(const int32_t seqid)
         this->iprot_->readMessageEnd();
         this->iprot_->getTransport()->readEnd();
       }
-      if (fname.compare("check") != 0) {
+      if (fname.compare("range_search_aggregate") != 0) {
         this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
         this->iprot_->readMessageEnd();
         this->iprot_->getTransport()->readEnd();
@@ -3056,19 +5625,19 @@ bool MDTrieShardConcurrentClientT<Protocol_>::recv_check(const int32_t seqid)
         using ::apache::thrift::protocol::TProtocolException;
         throw TProtocolException(TProtocolException::INVALID_DATA);
       }
-      bool _return;
-      MDTrieShard_check_presult result;
+      MDTrieShard_range_search_aggregate_presult result;
       result.success = &_return;
       result.read(this->iprot_);
       this->iprot_->readMessageEnd();
       this->iprot_->getTransport()->readEnd();
 
       if (result.__isset.success) {
+        // _return pointer has now been filled
         sentry.commit();
-        return _return;
+        return;
       }
       // in a bad state, don't commit
-      throw ::apache::thrift::TApplicationException(::apache::thrift::TApplicationException::MISSING_RESULT, "check failed: unknown result");
+      throw ::apache::thrift::TApplicationException(::apache::thrift::TApplicationException::MISSING_RESULT, "range_search_aggregate failed: unknown result");
     }
     // seqid != rseqid
     this->sync_->updatePending(fname, mtype, rseqid);
@@ -3079,22 +5648,24 @@ bool MDTrieShardConcurrentClientT<Protocol_>::recv_check(const int32_t seqid)
 }
 
 template <class Protocol_>
-void MDTrieShardConcurrentClientT<Protocol_>::range_search(std::vector<int32_t> & _return, const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range)
+void MDTrieShardConcurrentClientT<Protocol_>::knn_search(std::vector<int32_t> & _return, const std::vector<int32_t> & point, const int32_t k, const int32_t metric, const std::vector<double> & weights)
 {
-  int32_t seqid = send_range_search(start_range, end_range);
-  recv_range_search(_return, seqid);
+  int32_t seqid = send_knn_search(point, k, metric, weights);
+  recv_knn_search(_return, seqid);
 }
 
 template <class Protocol_>
-int32_t MDTrieShardConcurrentClientT<Protocol_>::send_range_search(const std::vector<int32_t> & start_range, const std::vector<int32_t> & end_range)
+int32_t MDTrieShardConcurrentClientT<Protocol_>::send_knn_search(const std::vector<int32_t> & point, const int32_t k, const int32_t metric, const std::vector<double> & weights)
 {
   int32_t cseqid = this->sync_->generateSeqId();
   ::apache::thrift::async::TConcurrentSendSentry sentry(this->sync_.get());
-  this->oprot_->writeMessageBegin("range_search", ::apache::thrift::protocol::T_CALL, cseqid);
+  this->oprot_->writeMessageBegin("knn_search", ::apache::thrift::protocol::T_CALL, cseqid);
 
-  MDTrieShard_range_search_pargs args;
-  args.start_range = &start_range;
-  args.end_range = &end_range;
+  MDTrieShard_knn_search_pargs args;
+  args.point = &point;
+  args.k = &k;
+  args.metric = &metric;
+  args.weights = &weights;
   args.write(this->oprot_);
 
   this->oprot_->writeMessageEnd();
@@ -3106,7 +5677,7 @@ int32_t MDTrieShardConcurrentClientT<Protocol_>::send_range_search(const std::ve
 }
 
 template <class Protocol_>
-void MDTrieShardConcurrentClientT<Protocol_>::recv_range_search(std::vector<int32_t> & _return, const int32_t seqid)
+void MDTrieShardConcurrentClientT<Protocol_>::recv_knn_search(std::vector<int32_t> & _return, const int32_t seqid)
 {
 
   int32_t rseqid = 0;
@@ -3135,7 +5706,7 @@ void MDTrieShardConcurrentClientT<Protocol_>::recv_range_search(std::vector<int3
         this->iprot_->readMessageEnd();
         this->iprot_->getTransport()->readEnd();
       }
-      if (fname.compare("range_search") != 0) {
+      if (fname.compare("knn_search") != 0) {
         this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
         this->iprot_->readMessageEnd();
         this->iprot_->getTransport()->readEnd();
@@ -3144,7 +5715,7 @@ void MDTrieShardConcurrentClientT<Protocol_>::recv_range_search(std::vector<int3
         using ::apache::thrift::protocol::TProtocolException;
         throw TProtocolException(TProtocolException::INVALID_DATA);
       }
-      MDTrieShard_range_search_presult result;
+      MDTrieShard_knn_search_presult result;
       result.success = &_return;
       result.read(this->iprot_);
       this->iprot_->readMessageEnd();
@@ -3156,7 +5727,7 @@ void MDTrieShardConcurrentClientT<Protocol_>::recv_range_search(std::vector<int3
         return;
       }
       // in a bad state, don't commit
-      throw ::apache::thrift::TApplicationException(::apache::thrift::TApplicationException::MISSING_RESULT, "range_search failed: unknown result");
+      throw ::apache::thrift::TApplicationException(::apache::thrift::TApplicationException::MISSING_RESULT, "knn_search failed: unknown result");
     }
     // seqid != rseqid
     this->sync_->updatePending(fname, mtype, rseqid);
@@ -3253,6 +5824,93 @@ void MDTrieShardConcurrentClientT<Protocol_>::recv_primary_key_lookup(std::vecto
   } // end while(true)
 }
 
+template <class Protocol_>
+void MDTrieShardConcurrentClientT<Protocol_>::primary_key_lookup_batch(std::vector<int32_t> & _return, const std::vector<int32_t> & primary_keys)
+{
+  int32_t seqid = send_primary_key_lookup_batch(primary_keys);
+  recv_primary_key_lookup_batch(_return, seqid);
+}
+
+template <class Protocol_>
+int32_t MDTrieShardConcurrentClientT<Protocol_>::send_primary_key_lookup_batch(const std::vector<int32_t> & primary_keys)
+{
+  int32_t cseqid = this->sync_->generateSeqId();
+  ::apache::thrift::async::TConcurrentSendSentry sentry(this->sync_.get());
+  this->oprot_->writeMessageBegin("primary_key_lookup_batch", ::apache::thrift::protocol::T_CALL, cseqid);
+
+  MDTrieShard_primary_key_lookup_batch_pargs args;
+  args.primary_keys = &primary_keys;
+  args.write(this->oprot_);
+
+  this->oprot_->writeMessageEnd();
+  this->oprot_->getTransport()->writeEnd();
+  this->oprot_->getTransport()->flush();
+
+  sentry.commit();
+  return cseqid;
+}
+
+template <class Protocol_>
+void MDTrieShardConcurrentClientT<Protocol_>::recv_primary_key_lookup_batch(std::vector<int32_t> & _return, const int32_t seqid)
+{
+
+  int32_t rseqid = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TMessageType mtype;
+
+  // the read mutex gets dropped and reacquired as part of waitForWork()
+  // The destructor of this sentry wakes up other clients
+  ::apache::thrift::async::TConcurrentRecvSentry sentry(this->sync_.get(), seqid);
+
+  while(true) {
+    if(!this->sync_->getPending(fname, mtype, rseqid)) {
+      this->iprot_->readMessageBegin(fname, mtype, rseqid);
+    }
+    if(seqid == rseqid) {
+      if (mtype == ::apache::thrift::protocol::T_EXCEPTION) {
+        ::apache::thrift::TApplicationException x;
+        x.read(this->iprot_);
+        this->iprot_->readMessageEnd();
+        this->iprot_->getTransport()->readEnd();
+        sentry.commit();
+        throw x;
+      }
+      if (mtype != ::apache::thrift::protocol::T_REPLY) {
+        this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+        this->iprot_->readMessageEnd();
+        this->iprot_->getTransport()->readEnd();
+      }
+      if (fname.compare("primary_key_lookup_batch") != 0) {
+        this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+        this->iprot_->readMessageEnd();
+        this->iprot_->getTransport()->readEnd();
+
+        // in a bad state, don't commit
+        using ::apache::thrift::protocol::TProtocolException;
+        throw TProtocolException(TProtocolException::INVALID_DATA);
+      }
+      MDTrieShard_primary_key_lookup_batch_presult result;
+      result.success = &_return;
+      result.read(this->iprot_);
+      this->iprot_->readMessageEnd();
+      this->iprot_->getTransport()->readEnd();
+
+      if (result.__isset.success) {
+        // _return pointer has now been filled
+        sentry.commit();
+        return;
+      }
+      // in a bad state, don't commit
+      throw ::apache::thrift::TApplicationException(::apache::thrift::TApplicationException::MISSING_RESULT, "primary_key_lookup_batch failed: unknown result");
+    }
+    // seqid != rseqid
+    this->sync_->updatePending(fname, mtype, rseqid);
+
+    // this will temporarily unlock the readMutex, and let other clients get work done
+    this->sync_->waitForWork(seqid);
+  } // end while(true)
+}
+
 template <class Protocol_>
 int32_t MDTrieShardConcurrentClientT<Protocol_>::get_size()
 {
@@ -3339,6 +5997,92 @@ int32_t MDTrieShardConcurrentClientT<Protocol_>::recv_get_size(const int32_t seq
   } // end while(true)
 }
 
+template <class Protocol_>
+void MDTrieShardConcurrentClientT<Protocol_>::get_size_breakdown(std::vector<int64_t> & _return)
+{
+  int32_t seqid = send_get_size_breakdown();
+  recv_get_size_breakdown(_return, seqid);
+}
+
+template <class Protocol_>
+int32_t MDTrieShardConcurrentClientT<Protocol_>::send_get_size_breakdown()
+{
+  int32_t cseqid = this->sync_->generateSeqId();
+  ::apache::thrift::async::TConcurrentSendSentry sentry(this->sync_.get());
+  this->oprot_->writeMessageBegin("get_size_breakdown", ::apache::thrift::protocol::T_CALL, cseqid);
+
+  MDTrieShard_get_size_breakdown_pargs args;
+  args.write(this->oprot_);
+
+  this->oprot_->writeMessageEnd();
+  this->oprot_->getTransport()->writeEnd();
+  this->oprot_->getTransport()->flush();
+
+  sentry.commit();
+  return cseqid;
+}
+
+template <class Protocol_>
+void MDTrieShardConcurrentClientT<Protocol_>::recv_get_size_breakdown(std::vector<int64_t> & _return, const int32_t seqid)
+{
+
+  int32_t rseqid = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TMessageType mtype;
+
+  // the read mutex gets dropped and reacquired as part of waitForWork()
+  // The destructor of this sentry wakes up other clients
+  ::apache::thrift::async::TConcurrentRecvSentry sentry(this->sync_.get(), seqid);
+
+  while(true) {
+    if(!this->sync_->getPending(fname, mtype, rseqid)) {
+      this->iprot_->readMessageBegin(fname, mtype, rseqid);
+    }
+    if(seqid == rseqid) {
+      if (mtype == ::apache::thrift::protocol::T_EXCEPTION) {
+        ::apache::thrift::TApplicationException x;
+        x.read(this->iprot_);
+        this->iprot_->readMessageEnd();
+        this->iprot_->getTransport()->readEnd();
+        sentry.commit();
+        throw x;
+      }
+      if (mtype != ::apache::thrift::protocol::T_REPLY) {
+        this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+        this->iprot_->readMessageEnd();
+        this->iprot_->getTransport()->readEnd();
+      }
+      if (fname.compare("get_size_breakdown") != 0) {
+        this->iprot_->skip(::apache::thrift::protocol::T_STRUCT);
+        this->iprot_->readMessageEnd();
+        this->iprot_->getTransport()->readEnd();
+
+        // in a bad state, don't commit
+        using ::apache::thrift::protocol::TProtocolException;
+        throw TProtocolException(TProtocolException::INVALID_DATA);
+      }
+      MDTrieShard_get_size_breakdown_presult result;
+      result.success = &_return;
+      result.read(this->iprot_);
+      this->iprot_->readMessageEnd();
+      this->iprot_->getTransport()->readEnd();
+
+      if (result.__isset.success) {
+        // _return pointer has now been filled
+        sentry.commit();
+        return;
+      }
+      // in a bad state, don't commit
+      throw ::apache::thrift::TApplicationException(::apache::thrift::TApplicationException::MISSING_RESULT, "get_size_breakdown failed: unknown result");
+    }
+    // seqid != rseqid
+    this->sync_->updatePending(fname, mtype, rseqid);
+
+    // this will temporarily unlock the readMutex, and let other clients get work done
+    this->sync_->waitForWork(seqid);
+  } // end while(true)
+}
+
 
 
 #endif
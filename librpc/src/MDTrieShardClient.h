@@ -9,6 +9,7 @@
 
 #include "MDTrieShard.h"
 #include "trie.h"
+#include <functional>
 #include <future>
 
 using namespace std;
@@ -133,6 +134,47 @@ public:
     shard_vector_[shard_index].recv_primary_key_lookup(return_vect);
   }
 
+  // Looks up many keys with one request per shard: each shard resolves its
+  // keys together. return_vect receives the coordinates of every key, in
+  // the order of p_keys.
+  void primary_key_lookup_batch(std::vector<int32_t> &return_vect,
+                                const std::vector<int32_t> &p_keys)
+  {
+
+    int client_count = shard_vector_.size();
+    std::vector<std::vector<int32_t>> shard_keys(client_count);
+    std::vector<std::vector<size_t>> shard_slots(client_count);
+    for (size_t i = 0; i < p_keys.size(); i++)
+    {
+      int shard_index = p_keys[i] % client_count;
+      shard_keys[shard_index].push_back(p_keys[i]);
+      shard_slots[shard_index].push_back(i);
+    }
+
+    for (int i = 0; i < client_count; i++)
+    {
+      if (shard_keys[i].empty())
+        continue;
+      shard_vector_[i].send_primary_key_lookup_batch(shard_keys[i]);
+      shard_queried_cnt_[i]++;
+    }
+
+    return_vect.clear();
+    for (int i = 0; i < client_count; i++)
+    {
+      if (shard_keys[i].empty())
+        continue;
+      std::vector<int32_t> partial;
+      shard_vector_[i].recv_primary_key_lookup_batch(partial);
+      size_t width = partial.size() / shard_keys[i].size();
+      return_vect.resize(p_keys.size() * width);
+      for (size_t k = 0; k < shard_slots[i].size(); k++)
+        std::copy(partial.begin() + k * width,
+                  partial.begin() + (k + 1) * width,
+                  return_vect.begin() + shard_slots[i][k] * width);
+    }
+  }
+
   void primary_key_lookup_send(const int32_t p_key)
   {
 
@@ -166,40 +208,46 @@ public:
     shard_vector_[shard_index].recv_primary_key_lookup(return_vect);
   }
 
+  // Each shard's matches are laid out as result_mode (a range_result_mode)
+  // asks; see append_shard_matches for how the shards' blocks are told apart
+  // when they carry primary keys.
   void range_search_trie(std::vector<int32_t> &return_vect,
                          const std::vector<int32_t> &start_range,
-                         const std::vector<int32_t> &end_range)
+                         const std::vector<int32_t> &end_range,
+                         int32_t result_mode = RANGE_RESULT_COORDINATES)
   {
 
     int client_count = shard_vector_.size();
 
     for (uint16_t i = 0; i < client_count; i++)
     {
-      shard_vector_[i].send_range_search(start_range, end_range);
+      shard_vector_[i].send_range_search(start_range, end_range, result_mode);
     }
 
     for (uint16_t i = 0; i < client_count; i++)
     {
       std::vector<int32_t> return_vect_tmp;
       shard_vector_[i].recv_range_search(return_vect_tmp);
-      return_vect.insert(
-          return_vect.end(), return_vect_tmp.begin(), return_vect_tmp.end());
+      append_shard_matches(return_vect, i, return_vect_tmp, result_mode);
     }
   }
 
   void range_search_trie_send(const std::vector<int32_t> &start_range,
-                              const std::vector<int32_t> &end_range)
+                              const std::vector<int32_t> &end_range,
+                              int32_t result_mode = RANGE_RESULT_COORDINATES)
   {
 
     int client_count = shard_vector_.size();
 
     for (uint16_t i = 0; i < client_count; i++)
     {
-      shard_vector_[i].send_range_search(start_range, end_range);
+      shard_vector_[i].send_range_search(start_range, end_range, result_mode);
     }
   }
 
-  void range_search_trie_rec(std::vector<int32_t> &return_vect)
+  // result_mode must be the one passed to range_search_trie_send.
+  void range_search_trie_rec(std::vector<int32_t> &return_vect,
+                             int32_t result_mode = RANGE_RESULT_COORDINATES)
   {
 
     int client_count = shard_vector_.size();
@@ -208,8 +256,136 @@ public:
     {
       std::vector<int32_t> return_vect_tmp;
       shard_vector_[i].recv_range_search(return_vect_tmp);
-      return_vect.insert(
-          return_vect.end(), return_vect_tmp.begin(), return_vect_tmp.end());
+      append_shard_matches(return_vect, i, return_vect_tmp, result_mode);
+    }
+  }
+
+  // Walks the result of a range search shard by shard in pages of at most
+  // page_size matches, handing each page to consume along with the index of
+  // the shard it comes from (which its primary keys belong to). Only one
+  // page is held at a time, whatever the size of the result; each page
+  // resumes the shard's search after the previous one (see
+  // range_search_page) rather than searching from the start again.
+  void range_search_trie_paged(
+      const std::vector<int32_t> &start_range,
+      const std::vector<int32_t> &end_range,
+      int32_t page_size,
+      const std::function<void(int, const std::vector<int32_t> &)> &consume,
+      int32_t result_mode = RANGE_RESULT_COORDINATES)
+  {
+
+    int client_count = shard_vector_.size();
+    std::vector<int32_t> page;
+    std::vector<int32_t> resume_after;
+
+    for (uint16_t i = 0; i < client_count; i++)
+    {
+      resume_after.clear();
+      while (true)
+      {
+        page.clear();
+        shard_vector_[i].range_search_page(
+            page, start_range, end_range, resume_after, page_size, result_mode);
+        if (page.empty())
+          break;
+        size_t token_size = page[0];
+        resume_after.assign(page.begin() + 1, page.begin() + 1 + token_size);
+        page.erase(page.begin(), page.begin() + 1 + token_size);
+        if (!page.empty())
+          consume(i, page);
+        if (resume_after.empty())
+          break;
+      }
+    }
+  }
+
+  // Aggregates a range search across shards: return_vect receives the
+  // COUNT of the matches, then SUM, MIN and MAX of each of dimensions, merged
+  // from the partial aggregates every shard computes over its own points.
+  void range_search_aggregate(std::vector<int64_t> &return_vect,
+                              const std::vector<int32_t> &start_range,
+                              const std::vector<int32_t> &end_range,
+                              const std::vector<int32_t> &dimensions)
+  {
+
+    int client_count = shard_vector_.size();
+
+    for (uint16_t i = 0; i < client_count; i++)
+    {
+      shard_vector_[i].send_range_search_aggregate(
+          start_range, end_range, dimensions);
+    }
+
+    return_vect.assign(1 + 3 * dimensions.size(), 0);
+    for (uint16_t i = 0; i < client_count; i++)
+    {
+      std::vector<int64_t> partial;
+      shard_vector_[i].recv_range_search_aggregate(partial);
+      if (partial[0] == 0)
+        continue;
+      bool first = return_vect[0] == 0;
+      return_vect[0] += partial[0];
+      for (size_t d = 0; d < dimensions.size(); d++)
+      {
+        int64_t *merged = &return_vect[1 + 3 * d];
+        const int64_t *shard = &partial[1 + 3 * d];
+        merged[0] += shard[0];
+        merged[1] = first ? shard[1] : std::min(merged[1], shard[1]);
+        merged[2] = first ? shard[2] : std::max(merged[2], shard[2]);
+      }
+    }
+  }
+
+  // The k points nearest to point across all shards, nearest first, each as
+  // the index of its shard, the primary key it is stored under there (see
+  // append_shard_matches), then its coordinates. Every shard sends its own k
+  // nearest; they are merged here by their distance to point, recomputed
+  // from the coordinates under the same metric (a knn_metric) and weights.
+  void knn_search(std::vector<int32_t> &return_vect,
+                  const std::vector<int32_t> &point,
+                  int32_t k,
+                  int32_t metric = KNN_L2,
+                  const std::vector<double> &weights = {})
+  {
+
+    int client_count = shard_vector_.size();
+
+    for (uint16_t i = 0; i < client_count; i++)
+    {
+      shard_vector_[i].send_knn_search(point, k, metric, weights);
+    }
+
+    knn_distance distance((knn_metric)metric, weights);
+    size_t match_width = 1 + point.size();
+    std::vector<int32_t> matches;
+    std::vector<std::pair<double, size_t>> order;
+    for (uint16_t i = 0; i < client_count; i++)
+    {
+      std::vector<int32_t> return_vect_tmp;
+      shard_vector_[i].recv_knn_search(return_vect_tmp);
+      for (size_t m = 0; m < return_vect_tmp.size(); m += match_width)
+      {
+        double total = 0;
+        for (size_t j = 0; j < point.size(); j++)
+        {
+          double delta = std::abs((double)return_vect_tmp[m + 1 + j] - point[j]);
+          total += distance.term(j, delta);
+        }
+        order.push_back({total, matches.size()});
+        matches.push_back(i);
+        matches.insert(matches.end(),
+                       return_vect_tmp.begin() + m,
+                       return_vect_tmp.begin() + m + match_width);
+      }
+    }
+
+    size_t n = std::min(order.size(), (size_t)std::max(k, 0));
+    std::partial_sort(order.begin(), order.begin() + n, order.end());
+    for (size_t i = 0; i < n; i++)
+    {
+      return_vect.insert(return_vect.end(),
+                         matches.begin() + order[i].second,
+                         matches.begin() + order[i].second + 1 + match_width);
     }
   }
 
@@ -226,7 +402,45 @@ public:
     return count;
   }
 
+  // Bytes per memory_component (see memory_usage.h), summed over the
+  // shards.
+  void get_size_breakdown(std::vector<int64_t> &return_vect)
+  {
+    return_vect.assign(num_memory_components, 0);
+    for (auto &shard : shard_vector_)
+      shard.send_get_size_breakdown();
+    std::vector<int64_t> shard_bytes;
+    for (auto &shard : shard_vector_)
+    {
+      shard.recv_get_size_breakdown(shard_bytes);
+      for (size_t c = 0; c < shard_bytes.size() && c < return_vect.size(); c++)
+        return_vect[c] += shard_bytes[c];
+    }
+  }
+
 private:
+  // Appends the matches shard_index sent for a range search to return_vect.
+  // A shard stores its points under its own primary keys (the order in which
+  // it received them), so keys from different shards may be equal: when the
+  // matches carry primary keys, each shard's block is preceded by the
+  // shard's index and the block's length, and shards without matches are
+  // left out.
+  static void append_shard_matches(std::vector<int32_t> &return_vect,
+                                   int shard_index,
+                                   const std::vector<int32_t> &matches,
+                                   int32_t result_mode)
+  {
+
+    if (result_mode != RANGE_RESULT_COORDINATES)
+    {
+      if (matches.empty())
+        return;
+      return_vect.push_back(shard_index);
+      return_vect.push_back(matches.size());
+    }
+    return_vect.insert(return_vect.end(), matches.begin(), matches.end());
+  }
+
   std::vector<MDTrieShardClient> shard_vector_;
   std::vector<int32_t> shard_queried_cnt_;
 };
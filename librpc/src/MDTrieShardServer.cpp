@@ -58,7 +58,8 @@ public:
       total_points_count =
           GITHUB_SIZE / (num_shards * 5) + compact_vector_extra;
       use_github_setting(GITHUB_DIMENSION, total_points_count);
-      mdtrie_ = new md_trie<DIMENSION>(max_depth, trie_depth, max_tree_node);
+      mdtrie_ =
+          new md_trie<DIMENSION>(bench_trie_schema(trie_width, max_tree_node));
       std::cout << "Github experiment started" << DIMENSION << ","
                 << total_points_count << std::endl;
     }
@@ -67,7 +68,8 @@ public:
     {
       total_points_count = TPCH_SIZE / (num_shards * 5) + compact_vector_extra;
       use_tpch_setting(TPCH_DIMENSION, total_points_count);
-      mdtrie_ = new md_trie<DIMENSION>(max_depth, trie_depth, max_tree_node);
+      mdtrie_ =
+          new md_trie<DIMENSION>(bench_trie_schema(trie_width, max_tree_node));
       std::cout << "Tpch experiment started: " << DIMENSION << ","
                 << total_points_count << std::endl;
     }
@@ -76,7 +78,8 @@ public:
     {
       total_points_count = NYC_SIZE / (num_shards * 5) + compact_vector_extra;
       use_nyc_setting(NYC_DIMENSION, total_points_count);
-      mdtrie_ = new md_trie<DIMENSION>(max_depth, trie_depth, max_tree_node);
+      mdtrie_ =
+          new md_trie<DIMENSION>(bench_trie_schema(trie_width, max_tree_node));
       std::cout << "NYC experiment started" << DIMENSION << ","
                 << total_points_count << std::endl;
     }
@@ -140,9 +143,13 @@ public:
     return inserted_points_;
   }
 
+  // Matches are reported as result_mode (a range_result_mode) asks: with
+  // primary keys, a client can tell which rows matched without a
+  // primary_key_lookup per point.
   void range_search(std::vector<int32_t> &_return,
                     const std::vector<int32_t> &start_range,
-                    const std::vector<int32_t> &end_range)
+                    const std::vector<int32_t> &end_range,
+                    const int32_t result_mode)
   {
 
     data_point<DIMENSION> start_range_point;
@@ -155,14 +162,155 @@ public:
       end_range_point.set_coordinate(i, end_range[i]);
     }
     mdtrie_->range_search_trie(
-        &start_range_point, &end_range_point, mdtrie_->root(), 0, _return);
+        &start_range_point,
+        &end_range_point,
+        mdtrie_->root(),
+        0,
+        [&](const data_point<DIMENSION> &point, n_leaves_t primary_key) {
+          append_match(_return, point, primary_key, result_mode);
+          return true;
+        });
     return;
   }
 
+  // One page of range_search: at most limit matches, in search order,
+  // preceded by the token that resumes the search after them. The token is
+  // its length (0 once the search is done, else DIMENSION + 1) followed by
+  // the coordinates and primary key of the page's last match; passing it
+  // back as resume_after (empty for the first page) continues from that
+  // match instead of searching from the start, so a client can walk a large
+  // result page by page, and points inserted meanwhile are neither repeated
+  // nor make it skip any.
+  void range_search_page(std::vector<int32_t> &_return,
+                         const std::vector<int32_t> &start_range,
+                         const std::vector<int32_t> &end_range,
+                         const std::vector<int32_t> &resume_after,
+                         const int32_t limit,
+                         const int32_t result_mode)
+  {
+
+    data_point<DIMENSION> start_range_point;
+    for (uint8_t i = 0; i < DIMENSION; i++)
+      start_range_point.set_coordinate(i, start_range[i]);
+
+    data_point<DIMENSION> end_range_point;
+    for (uint8_t i = 0; i < DIMENSION; i++)
+    {
+      end_range_point.set_coordinate(i, end_range[i]);
+    }
+    _return.push_back(0);
+    if (limit <= 0 ||
+        (!resume_after.empty() && resume_after.size() != DIMENSION + 1))
+      return;
+    int32_t matches = 0;
+    data_point<DIMENSION> last;
+    n_leaves_t last_primary_key = 0;
+    auto visit = [&](const data_point<DIMENSION> &point,
+                     n_leaves_t primary_key) {
+      append_match(_return, point, primary_key, result_mode);
+      last = point;
+      last_primary_key = primary_key;
+      return ++matches < limit;
+    };
+    if (resume_after.empty())
+    {
+      mdtrie_->range_search_trie(
+          &start_range_point, &end_range_point, mdtrie_->root(), 0, visit);
+    }
+    else
+    {
+      data_point<DIMENSION> after;
+      for (uint8_t i = 0; i < DIMENSION; i++)
+        after.set_coordinate(i, resume_after[i]);
+      mdtrie_->range_search_trie_after(&start_range_point,
+                                       &end_range_point,
+                                       &after,
+                                       resume_after[DIMENSION],
+                                       visit);
+    }
+    if (matches < limit)
+      return;
+
+    std::vector<int32_t> token;
+    for (uint8_t i = 0; i < DIMENSION; i++)
+      token.push_back(last.get_coordinate(i));
+    token.push_back(last_primary_key);
+    _return[0] = token.size();
+    _return.insert(_return.begin() + 1, token.begin(), token.end());
+  }
+
+  // COUNT of the matches, then SUM, MIN and MAX of each of dimensions, all
+  // computed during the search. MIN and MAX are 0 when nothing matched. A
+  // dimension outside [0, DIMENSION) fails the call.
+  void range_search_aggregate(std::vector<int64_t> &_return,
+                              const std::vector<int32_t> &start_range,
+                              const std::vector<int32_t> &end_range,
+                              const std::vector<int32_t> &dimensions)
+  {
+
+    data_point<DIMENSION> start_range_point;
+    for (uint8_t i = 0; i < DIMENSION; i++)
+      start_range_point.set_coordinate(i, start_range[i]);
+
+    data_point<DIMENSION> end_range_point;
+    for (uint8_t i = 0; i < DIMENSION; i++)
+    {
+      end_range_point.set_coordinate(i, end_range[i]);
+    }
+    for (int32_t dimension : dimensions)
+    {
+      if (dimension < 0 || dimension >= (int32_t)DIMENSION)
+        throw std::invalid_argument(
+            "range_search_aggregate: no dimension " +
+            std::to_string(dimension));
+    }
+    range_aggregate aggregate(
+        std::vector<dimension_t>(dimensions.begin(), dimensions.end()));
+    mdtrie_->range_aggregate_trie(
+        &start_range_point, &end_range_point, mdtrie_->root(), 0, aggregate);
+
+    _return.push_back(aggregate.count_);
+    for (size_t i = 0; i < dimensions.size(); i++)
+    {
+      _return.push_back(aggregate.sum_[i]);
+      _return.push_back(aggregate.count_ ? aggregate.min_[i] : 0);
+      _return.push_back(aggregate.max_[i]);
+    }
+  }
+
+  // The k stored points nearest to point under metric (a knn_metric) and
+  // weights, nearest first: each as the primary key it is stored under
+  // followed by its coordinates.
+  void knn_search(std::vector<int32_t> &_return,
+                  const std::vector<int32_t> &point,
+                  const int32_t k,
+                  const int32_t metric,
+                  const std::vector<double> &weights)
+  {
+
+    data_point<DIMENSION> query;
+    for (uint8_t i = 0; i < DIMENSION; i++)
+      query.set_coordinate(i, point[i]);
+
+    if (k <= 0)
+      return;
+    std::vector<knn_neighbor<DIMENSION>> neighbors;
+    mdtrie_->knn_search(
+        query, k, knn_distance((knn_metric)metric, weights), neighbors);
+    for (auto &neighbor : neighbors)
+    {
+      append_match(_return,
+                   neighbor.point_,
+                   neighbor.primary_key_,
+                   RANGE_RESULT_PRIMARY_KEYS_AND_COORDINATES);
+    }
+  }
+
   void primary_key_lookup(std::vector<int32_t> &_return,
                           const int32_t primary_key)
   {
 
+    level_t max_depth = mdtrie_->schema().max_depth_;
     std::vector<morton_t> node_path_from_primary(max_depth + 1);
     tree_block<DIMENSION> *t_ptr =
         (tree_block<DIMENSION> *)(p_key_to_treeblock_compact_->At(
@@ -174,9 +322,53 @@ public:
         t_ptr->node_path_to_coordinates_vect(node_path_from_primary, DIMENSION);
   }
 
+  // primary_key_lookup for many keys in one call: DIMENSION coordinates per
+  // key, in the order of primary_keys. The keys are resolved together, one
+  // scan per treeblock they fall in (see md_trie::lookup_batch).
+  void primary_key_lookup_batch(std::vector<int32_t> &_return,
+                                const std::vector<int32_t> &primary_keys)
+  {
+
+    std::vector<n_leaves_t> keys;
+    keys.reserve(primary_keys.size());
+    for (int32_t primary_key : primary_keys)
+      keys.push_back(primary_key % inserted_points_);
+    std::vector<data_point<DIMENSION>> points;
+    mdtrie_->lookup_batch(keys, points, p_key_to_treeblock_compact_);
+
+    _return.reserve(points.size() * DIMENSION);
+    for (auto &point : points)
+    {
+      for (dimension_t i = 0; i < DIMENSION; i++)
+        _return.push_back(point.get_coordinate(i));
+    }
+  }
+
   int32_t get_size() { return mdtrie_->size(p_key_to_treeblock_compact_); }
 
+  // Bytes per memory_component (see memory_usage.h), from counters the trie
+  // keeps current; cheap enough to call while the shard serves inserts.
+  void get_size_breakdown(std::vector<int64_t> &_return)
+  {
+    memory_usage usage = mdtrie_->memory(p_key_to_treeblock_compact_);
+    _return.assign(usage.bytes_, usage.bytes_ + num_memory_components);
+  }
+
 protected:
+  static void append_match(std::vector<int32_t> &found,
+                           const data_point<DIMENSION> &point,
+                           n_leaves_t primary_key,
+                           int32_t result_mode)
+  {
+    if (result_mode != RANGE_RESULT_COORDINATES)
+      found.push_back(primary_key);
+    if (result_mode != RANGE_RESULT_PRIMARY_KEYS)
+    {
+      for (dimension_t j = 0; j < DIMENSION; j++)
+        found.push_back(point.get_coordinate(j));
+    }
+  }
+
   md_trie<DIMENSION> *mdtrie_;
   bitmap::CompactPtrVector *p_key_to_treeblock_compact_;
   uint64_t inserted_points_ = 0;
@@ -9,9 +9,19 @@ service MDTrieShard {
 
     bool check(1:list<i32> point),
 
-    list<i32> range_search(1:list<i32> start_range, 2:list<i32> end_range),
+    list<i32> range_search(1:list<i32> start_range, 2:list<i32> end_range, 3:i32 result_mode),
+
+    list<i32> range_search_page(1:list<i32> start_range, 2:list<i32> end_range, 3:list<i32> resume_after, 4:i32 limit, 5:i32 result_mode),
+
+    list<i64> range_search_aggregate(1:list<i32> start_range, 2:list<i32> end_range, 3:list<i32> dimensions),
+
+    list<i32> knn_search(1:list<i32> point, 2:i32 k, 3:i32 metric, 4:list<double> weights),
 
     list<i32> primary_key_lookup(1:i32 primary_key),
 
+    list<i32> primary_key_lookup_batch(1:list<i32> primary_keys),
+
     i32 get_size(),
+
+    list<i64> get_size_breakdown(),
 }